@@ -78,6 +78,9 @@ void mpz_set_64(mpz_t dest, uint64 src)
 {
 
 #if GMP_LIMB_BITS == 64
+	// gmp 6.2+ doesn't allocate any limbs in mpz_init
+	if (dest->_mp_alloc < 1)
+		mpz_realloc2(dest, 64);
 	dest->_mp_d[0] = src;
 	dest->_mp_size = (src ? 1 : 0);
 #else
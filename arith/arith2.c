@@ -332,6 +332,7 @@ int zPrimorial(uint32 n, z *w)
 	//return n# = p1 * p2 * p3 ... all the primes < n
 	uint32 i;
 	fp_digit q;
+	uint64 *primes, num_p;
 	int approx_words = (int)(10*n/DEC_DIGIT_PER_WORD);  
 	//same approximation as in factorial.  this will be overkill...
 
@@ -339,16 +340,13 @@ int zPrimorial(uint32 n, z *w)
 	if (w->alloc < approx_words)
 		zGrow(w,approx_words);
 
-	free(PRIMES);
-	PRIMES = soe_wrapper(spSOEprimes, szSOEp, 0, n, 0, &NUM_P);
-	P_MIN = PRIMES[0];
-	P_MAX = PRIMES[NUM_P-1];
+	primes = get_prime_cache(n, &num_p);
 	w->size = 1;
 	w->val[0] = 1;
 	//naive (but simple) method
-	for (i=0; PRIMES[i] <= n; i++)
+	for (i=0; (i < num_p) && (primes[i] <= n); i++)
 	{
-		q = (fp_digit)PRIMES[i];
+		q = (fp_digit)primes[i];
 		zShortMul(w,q,w);
 	}
 
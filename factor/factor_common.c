@@ -164,7 +164,6 @@ enum factorization_state {
 
 // local functions to do state based factorization
 double get_qs_time_estimate(fact_obj_t *fobj, mpz_t b);
-double get_gnfs_time_estimate(fact_obj_t *fobj, mpz_t b);
 void do_work(enum factorization_state method, factor_work_t *fwork, mpz_t b, fact_obj_t *fobj);
 enum factorization_state schedule_work(factor_work_t *fwork, mpz_t b, fact_obj_t *fobj);
 int check_if_done(fact_obj_t *fobj, mpz_t N);
@@ -180,20 +179,77 @@ void interp_and_set_curves(factor_work_t *fwork, fact_obj_t *fobj,
 	enum factorization_state state, double work_done,
 	double target_digits, int log_results);
 
+// pretest savefile: pm1/pp1/ecm work survives an interrupted factor()
+void save_pretest_work(fact_obj_t *fobj, factor_work_t *fwork, mpz_t n,
+	enum factorization_state active_state, uint32 active_curves);
+int load_pretest_work(fact_obj_t *fobj, factor_work_t *fwork, mpz_t n);
+uint32 get_pretest_curves_done(factor_work_t *fwork, enum factorization_state state);
+const char *get_pretest_method_name(enum factorization_state state);
+
+// portfolio mode: group methods run in helper threads while ecm
+// continues on the remaining threads
+typedef struct
+{
+	enum factorization_state method;
+	factor_work_t fwork;		// private copy of the work record
+	fact_obj_t *fobj;			// private object, so factors land in their own list
+	mpz_t b;
+	uint32 prev_curves;			// work recorded for this method before launch
+	double t_time;
+	volatile int done;
+
+#if defined(WIN32) || defined(_WIN64)
+	HANDLE thread_id;
+#else
+	pthread_t thread_id;
+#endif
+
+} portfolio_job_t;
+
+void do_portfolio_work(enum factorization_state method, factor_work_t *fwork, 
+	mpz_t b, fact_obj_t *fobj);
+int is_portfolio_state(enum factorization_state state);
+uint32 *get_group_curves_ptr(factor_work_t *fwork, enum factorization_state state);
+#if defined(WIN32) || defined(_WIN64)
+DWORD WINAPI portfolio_worker_main(LPVOID thread_data);
+#else
+void *portfolio_worker_main(void *thread_data);
+#endif
+
+
+void fobj_watch_sigint(fact_obj_t *fobj)
+{
+	// called along with installing a SIGINT handler: a ctrl-c from now on
+	// aborts this job
+	fobj->sigint_mark = SIGINT_COUNT;
+	return;
+}
+
+int fobj_aborted(fact_obj_t *fobj)
+{
+	return (fobj->abort || 
+		((fobj->sigint_mark >= 0) && (SIGINT_COUNT != fobj->sigint_mark)));
+}
 
 void init_factobj(fact_obj_t *fobj)
 {
 	// get space for everything
 	alloc_factobj(fobj);
 
-	// initialize global stuff in fobj
-	fobj->seed1 = g_rand.low;
-	fobj->seed2 = g_rand.hi;
+	// initialize global stuff in fobj.  each object draws its own seeds,
+	// so objects made in one process (e.g., factor()'s portfolio helpers) 
+	// don't all share one
+	fobj->seed1 = get_rand(&g_rand.low, &g_rand.hi);
+	fobj->seed2 = get_rand(&g_rand.low, &g_rand.hi);
 	yafu_get_cache_sizes(&fobj->cache_size1,&fobj->cache_size2);
 	fobj->flags = 0;
-	fobj->num_threads = 1;		//read from input arguments	
+	fobj->num_threads = THREADS;	//read from input arguments
 	strcpy(fobj->flogname,"factor.log");	
 	fobj->do_logging = 1;
+	fobj->stop_flag = 0;
+	fobj->stop = &fobj->stop_flag;
+	fobj->abort = 0;
+	fobj->sigint_mark = -1;
 
 	// initialize stuff for rho	
 	fobj->rho_obj.iterations = 1000;		
@@ -232,6 +288,8 @@ void init_factobj(fact_obj_t *fobj)
 	// an external binary
 	strcpy(fobj->ecm_obj.ecm_path,"");
 	fobj->ecm_obj.use_external = 0;
+	fobj->ecm_obj.use_tinyecm = 0;
+	fobj->ecm_obj.tiny_plan = NULL;
 	fobj->ecm_obj.ecm_ext_xover = 40000;
 
 	// initialize stuff for squfof
@@ -242,6 +300,8 @@ void init_factobj(fact_obj_t *fobj)
 	fobj->qs_obj.gbl_override_B = 0;
 	fobj->qs_obj.gbl_override_blocks_flag = 0;
 	fobj->qs_obj.gbl_override_blocks = 0 ;
+	fobj->qs_obj.gbl_override_blocksize_flag = 0;
+	fobj->qs_obj.gbl_override_blocksize = 0;
 	fobj->qs_obj.gbl_override_lpmult_flag = 0;
 	fobj->qs_obj.gbl_override_lpmult = 0;
 	fobj->qs_obj.gbl_override_rel_flag = 0;
@@ -256,6 +316,11 @@ void init_factobj(fact_obj_t *fobj)
 	fobj->qs_obj.qs_multiplier = 0;
 	fobj->qs_obj.qs_tune_freq = 0;
 	fobj->qs_obj.no_small_cutoff_opt = 0;
+	fobj->qs_obj.mult_test = 0;
+	fobj->qs_obj.stripe_bound = 0;
+	fobj->qs_obj.mem_budget = 0;
+	fobj->qs_obj.hugepages = 1;
+	fobj->qs_obj.batch_size = 0;
 	strcpy(fobj->qs_obj.siqs_savefile,"siqs.dat");
 	init_lehman();
 
@@ -284,6 +349,7 @@ void init_factobj(fact_obj_t *fobj)
 	fobj->nfs_obj.sq_side = 0;					//default = algebraic
 	fobj->nfs_obj.timeout = 0;					//default, not used
 	strcpy(fobj->nfs_obj.job_infile,"nfs.job");			//default
+	strcpy(fobj->nfs_obj.cachefile,"nfs.cache");			//default
 	fobj->nfs_obj.poly_option = 0;					//default = fast search
 										//1 = wide
 									//2 = deep
@@ -314,6 +380,8 @@ void init_factobj(fact_obj_t *fobj)
 	fobj->autofact_obj.no_ecm = 0;
 	fobj->autofact_obj.target_pretest_ratio = 4.0 / 13.0;
 	fobj->autofact_obj.initial_work = 0.0;
+	strcpy(fobj->autofact_obj.pretest_savefile,"pretest.dat");
+	fobj->autofact_obj.active_work = NULL;
 	fobj->autofact_obj.has_snfs_form = -1;		// not checked yet
 
 	//pretesting plan used by factor()
@@ -321,6 +389,8 @@ void init_factobj(fact_obj_t *fobj)
 	strcpy(fobj->autofact_obj.plan_str,"normal");
 	fobj->autofact_obj.only_pretest = 0;
 	fobj->autofact_obj.autofact_active = 0;
+	fobj->autofact_obj.portfolio = 0;
+	fobj->autofact_obj.portfolio_helper = 0;
 
 	// if a number is <= aprcl_prove_cutoff, we will prove it prime or composite
 	fobj->aprcl_prove_cutoff = 500;
@@ -818,7 +888,7 @@ double get_qs_time_estimate(fact_obj_t *fobj, mpz_t b)
 	//adjust for multi-threaded qs
 	//if we assume threading is perfect, we'll get a smaller estimate for
 	//qs than we can really achieve, resulting in less ECM, so fudge it a bit
-	if (THREADS > 1)
+	if (fobj->num_threads > 1)
 	{
 		switch (cpu)
 		{
@@ -831,15 +901,15 @@ double get_qs_time_estimate(fact_obj_t *fobj, mpz_t b)
 		case 6:
 		case 7:
 		case 8:
-			estimate = estimate / ((double)THREADS * 0.75);
+			estimate = estimate / ((double)fobj->num_threads * 0.75);
 			break;
 		case 9:
 		case 10:
-			estimate = estimate / ((double)THREADS * 0.90);
+			estimate = estimate / ((double)fobj->num_threads * 0.90);
 			break;
 
 		default:
-			estimate = estimate / ((double)THREADS * 0.75);
+			estimate = estimate / ((double)fobj->num_threads * 0.75);
 			break;
 		}
 	}
@@ -868,7 +938,7 @@ double get_gnfs_time_estimate(fact_obj_t *fobj, mpz_t b)
 	//adjust for multi-threaded nfs
 	//if we assume threading is perfect, we'll get a smaller estimate for
 	//nfs than we can really achieve, resulting in less ECM, so fudge it a bit
-	if (THREADS > 1)
+	if (fobj->num_threads > 1)
 	{
 		switch (cpu)
 		{
@@ -881,15 +951,15 @@ double get_gnfs_time_estimate(fact_obj_t *fobj, mpz_t b)
 		case 6:
 		case 7:
 		case 8:
-			estimate = estimate / ((double)THREADS * 0.75);
+			estimate = estimate / ((double)fobj->num_threads * 0.75);
 			break;
 		case 9:
 		case 10:
-			estimate = estimate / ((double)THREADS * 0.90);
+			estimate = estimate / ((double)fobj->num_threads * 0.90);
 			break;
 
 		default:
-			estimate = estimate / ((double)THREADS * 0.75);
+			estimate = estimate / ((double)fobj->num_threads * 0.75);
 			break;
 		}
 	}
@@ -900,6 +970,33 @@ double get_gnfs_time_estimate(fact_obj_t *fobj, mpz_t b)
 	return estimate;
 }
 
+static void report_thread_time(fact_obj_t *fobj, char *method, 
+	double wall_time, double thread_time)
+{
+	// compare the wall clock time of a threaded pm1/pp1 run with the 
+	// summed time of its threads (about what one thread would have 
+	// taken), on screen at -v and always in the logfile
+	FILE *flog;
+
+	if (VFLAG > 0)
+		printf("fac: %s used %d threads: %1.2f sec wall clock for %1.2f sec of work\n",
+			method, fobj->num_threads, wall_time, thread_time);
+
+	flog = fopen(fobj->flogname,"a");
+	if (flog == NULL)
+	{
+		printf("fopen error: %s\n", strerror(errno));
+		printf("could not open %s for appending\n",fobj->flogname);
+		return;
+	}
+	logprint(flog,"%s on %d threads: %1.2f sec wall clock, %1.2f sec thread time "
+		"(%1.2fx)\n", method, fobj->num_threads, wall_time, thread_time,
+		(wall_time > 0) ? thread_time / wall_time : 1.0);
+	fclose(flog);
+
+	return;
+}
+
 void do_work(enum factorization_state method, factor_work_t *fwork, 
 	mpz_t b, fact_obj_t *fobj)
 {
@@ -1026,6 +1123,7 @@ void do_work(enum factorization_state method, factor_work_t *fwork,
 		fobj->pp1_obj.B2 = fwork->B2;
 		mpz_set(fobj->pp1_obj.gmp_n,b);
 		fobj->pp1_obj.numbases = fwork->curves;
+		fobj->pp1_obj.ttime = 0;
 		williams_loop(fobj);
 		mpz_set(b,fobj->pp1_obj.gmp_n);
 		fobj->pp1_obj.B1 = tmp1;
@@ -1045,6 +1143,10 @@ void do_work(enum factorization_state method, factor_work_t *fwork,
 		t_time = ((double)difference->secs + (double)difference->usecs / 1000000);
 		free(difference);
 
+		// pp1_obj.ttime sums the time spent in each thread
+		if (fobj->num_threads > 1)
+			report_thread_time(fobj, "pp1", t_time, fobj->pp1_obj.ttime);
+
 		fwork->pp1_time += t_time;
 		fwork->total_time += t_time;
 		break;
@@ -1057,6 +1159,7 @@ void do_work(enum factorization_state method, factor_work_t *fwork,
 		fobj->pm1_obj.B1 = fwork->B1;
 		fobj->pm1_obj.B2 = fwork->B2;
 		mpz_set(fobj->pm1_obj.gmp_n,b);
+		fobj->pm1_obj.ttime = 0;
 		pollard_loop(fobj);
 		mpz_set(b,fobj->pm1_obj.gmp_n);
 		fobj->pm1_obj.B1 = tmp1;
@@ -1076,6 +1179,10 @@ void do_work(enum factorization_state method, factor_work_t *fwork,
 		t_time = ((double)difference->secs + (double)difference->usecs / 1000000);
 		free(difference);
 
+		// pm1_obj.ttime sums the time spent in each thread
+		if (fobj->num_threads > 1)
+			report_thread_time(fobj, "pm1", t_time, fobj->pm1_obj.ttime);
+
 		fwork->pm1_time += t_time;
 		fwork->total_time += t_time;
 		break;
@@ -1122,6 +1229,237 @@ void do_work(enum factorization_state method, factor_work_t *fwork,
 	return;
 }
 
+int is_portfolio_state(enum factorization_state state)
+{
+	// the pm1/pp1 levels are single threaded, so they are the ones
+	// worth running alongside ecm
+	return ((state >= state_pp1_lvl1) && (state <= state_pm1_lvl3));
+}
+
+static int is_pp1_state(enum factorization_state state)
+{
+	return ((state >= state_pp1_lvl1) && (state <= state_pp1_lvl3));
+}
+
+uint32 *get_group_curves_ptr(factor_work_t *fwork, enum factorization_state state)
+{
+	switch (state)
+	{
+	case state_pp1_lvl1:
+		return &fwork->pp1_lvl1_curves;
+	case state_pp1_lvl2:
+		return &fwork->pp1_lvl2_curves;
+	case state_pp1_lvl3:
+		return &fwork->pp1_lvl3_curves;
+	case state_pm1_lvl1:
+		return &fwork->pm1_lvl1_curves;
+	case state_pm1_lvl2:
+		return &fwork->pm1_lvl2_curves;
+	case state_pm1_lvl3:
+		return &fwork->pm1_lvl3_curves;
+	default:
+		return NULL;
+	}
+}
+
+#if defined(WIN32) || defined(_WIN64)
+DWORD WINAPI portfolio_worker_main(LPVOID thread_data) {
+#else
+void *portfolio_worker_main(void *thread_data) {
+#endif
+	portfolio_job_t *job = (portfolio_job_t *)thread_data;
+	double t_start = job->fwork.total_time;
+
+	do_work(job->method, &job->fwork, job->b, job->fobj);
+	job->t_time = job->fwork.total_time - t_start;
+
+	// a split anywhere ends the round for everyone
+	if (job->fobj->num_factors > 0)
+		*job->fobj->stop = 1;
+
+	job->done = 1;
+
+#if defined(WIN32) || defined(_WIN64)
+	return 0;
+#else
+	return NULL;
+#endif
+}
+
+void do_portfolio_work(enum factorization_state method, factor_work_t *fwork, 
+	mpz_t b, fact_obj_t *fobj)
+{
+	// run the requested group method on a helper thread, along with any
+	// further group methods the scheduler asks for next while threads remain.
+	// the main thread meanwhile runs ecm with the leftover threads for as long
+	// as the helpers are busy.  as soon as anyone finds a factor everything 
+	// else is stopped, unfinished work is uncredited, and the normal 
+	// scheduler takes over again with the cofactor.
+	portfolio_job_t *jobs;
+	enum factorization_state next_state = method;
+	int i, j, k, num_jobs = 0, busy;
+	int tmp_threads = fobj->num_threads;
+	uint32 num_factors = fobj->num_factors;
+	uint32 *curves;
+	double tmp_total = fwork->total_time;
+	struct timeval tstart, tstop;
+	TIME_DIFF *	difference;
+	mpz_t g;
+
+	gettimeofday(&tstart, NULL);
+
+	*fobj->stop = 0;
+	jobs = (portfolio_job_t *)malloc((fobj->num_threads - 1) * sizeof(portfolio_job_t));
+
+	while (is_portfolio_state(next_state) && (num_jobs < (fobj->num_threads - 1)))
+	{
+		portfolio_job_t *job;
+
+		// at most one level of each method at a time: a higher level
+		// waits for the lower one to finish (and to be credited) instead
+		// of repeating its stage 1 concurrently
+		for (i = 0; i < num_jobs; i++)
+			if (is_pp1_state(jobs[i].method) == is_pp1_state(next_state))
+				break;
+
+		if (i < num_jobs)
+			break;
+
+		job = &jobs[num_jobs++];
+
+		job->method = next_state;
+		job->fwork = *fwork;
+		job->t_time = 0;
+		job->done = 0;
+		job->fobj = (fact_obj_t *)malloc(sizeof(fact_obj_t));
+		init_factobj(job->fobj);
+		strcpy(job->fobj->flogname, fobj->flogname);
+		job->fobj->num_threads = 1;
+		job->fobj->autofact_obj.portfolio_helper = 1;
+		job->fobj->stop = fobj->stop;
+
+		// the user's pm1/pp1 settings, minus the private mpz's
+		job->fobj->pm1_obj.B1 = fobj->pm1_obj.B1;
+		job->fobj->pm1_obj.B2 = fobj->pm1_obj.B2;
+		job->fobj->pm1_obj.stg2_is_default = fobj->pm1_obj.stg2_is_default;
+		job->fobj->pm1_obj.base = fobj->pm1_obj.base;
+		job->fobj->pm1_obj.pm1_exponent = fobj->pm1_obj.pm1_exponent;
+		job->fobj->pm1_obj.pm1_multiplier = fobj->pm1_obj.pm1_multiplier;
+		job->fobj->pm1_obj.pm1_tune_freq = fobj->pm1_obj.pm1_tune_freq;
+		job->fobj->pp1_obj.B1 = fobj->pp1_obj.B1;
+		job->fobj->pp1_obj.B2 = fobj->pp1_obj.B2;
+		job->fobj->pp1_obj.stg2_is_default = fobj->pp1_obj.stg2_is_default;
+		job->fobj->pp1_obj.base = fobj->pp1_obj.base;
+		job->fobj->pp1_obj.numbases = fobj->pp1_obj.numbases;
+		job->fobj->pp1_obj.pp1_exponent = fobj->pp1_obj.pp1_exponent;
+		job->fobj->pp1_obj.pp1_multiplier = fobj->pp1_obj.pp1_multiplier;
+		job->fobj->pp1_obj.pp1_tune_freq = fobj->pp1_obj.pp1_tune_freq;
+		mpz_init(job->b);
+		mpz_set(job->b, b);
+
+		// provisionally mark this state complete so the scheduler moves past it
+		curves = get_group_curves_ptr(fwork, next_state);
+		job->prev_curves = *curves;
+		*curves = fwork->curves;
+
+#if defined(WIN32) || defined(_WIN64)
+		job->thread_id = CreateThread(NULL, 0, portfolio_worker_main, job, 0, NULL);
+#else
+		pthread_create(&job->thread_id, NULL, portfolio_worker_main, job);
+#endif
+
+		next_state = schedule_work(fwork, b, fobj);
+	}
+
+	if (VFLAG > 0)
+		printf("fac: running %d pm1/pp1 job(s) alongside ecm on %d thread(s)\n",
+			num_jobs, tmp_threads - num_jobs);
+
+	// keep the leftover threads busy with ecm until the helpers are done
+	fobj->num_threads = tmp_threads - num_jobs;
+	while ((next_state >= state_ecm_15digit) && (next_state <= state_ecm_65digit) 
+		&& !*fobj->stop)
+	{
+		do_work(next_state, fwork, b, fobj);
+
+		if (fobj->num_factors > num_factors)
+		{
+			*fobj->stop = 1;
+			break;
+		}
+
+		for (i = 0, busy = 0; i < num_jobs; i++)
+			busy += !jobs[i].done;
+
+		if (busy == 0)
+			break;
+
+		next_state = schedule_work(fwork, b, fobj);
+	}
+	fobj->num_threads = tmp_threads;
+
+	for (i = 0; i < num_jobs; i++)
+	{
+#if defined(WIN32) || defined(_WIN64)
+		WaitForSingleObject(jobs[i].thread_id, INFINITE);
+		CloseHandle(jobs[i].thread_id);
+#else
+		pthread_join(jobs[i].thread_id, NULL);
+#endif
+	}
+
+	mpz_init(g);
+	for (i = 0; i < num_jobs; i++)
+	{
+		portfolio_job_t *job = &jobs[i];
+
+		// work cut short by a split elsewhere is not credited.  it
+		// will be rescheduled on the cofactor if it is still needed.
+		if (*fobj->stop && (job->fobj->num_factors == 0))
+		{
+			curves = get_group_curves_ptr(fwork, job->method);
+			*curves = job->prev_curves;
+		}
+
+		// the helper worked on the input as it was at launch, so only
+		// take the part of each factor which hasn't already been removed.
+		for (j = 0; j < job->fobj->num_factors; j++)
+		{
+			for (k = 0; k < job->fobj->fobj_factors[j].count; k++)
+			{
+				mpz_gcd(g, job->fobj->fobj_factors[j].factor, b);
+				if (mpz_cmp_ui(g, 1) > 0)
+				{
+					mpz_tdiv_q(b, b, g);
+					add_to_factor_list(fobj, g);
+				}
+			}
+		}
+
+		if ((job->method == state_pp1_lvl1) || (job->method == state_pp1_lvl2) ||
+			(job->method == state_pp1_lvl3))
+			fwork->pp1_time += job->t_time;
+		else
+			fwork->pm1_time += job->t_time;
+
+		free_factobj(job->fobj);
+		free(job->fobj);
+		mpz_clear(job->b);
+	}
+	mpz_clear(g);
+	free(jobs);
+	*fobj->stop = 0;
+
+	// the work above overlapped, so charge the round its wall clock time
+	gettimeofday(&tstop, NULL);
+	difference = my_difftime(&tstart, &tstop);
+	fwork->total_time = tmp_total + 
+		((double)difference->secs + (double)difference->usecs / 1000000);
+	free(difference);
+
+	return;
+}
+
 int check_if_done(fact_obj_t *fobj, mpz_t N)
 {
 	int i, done = 0;
@@ -1592,6 +1930,180 @@ double compute_ecm_work_done(factor_work_t *fwork, int disp_levels)
 
 }
 
+uint32 get_pretest_curves_done(factor_work_t *fwork, enum factorization_state state)
+{
+	uint32 *curves = get_group_curves_ptr(fwork, state);
+
+	if (curves != NULL)
+		return *curves;
+	else
+		return get_ecm_curves_done(fwork, state);
+}
+
+const char *get_pretest_method_name(enum factorization_state state)
+{
+	if ((state == state_pp1_lvl1) || (state == state_pp1_lvl2) ||
+		(state == state_pp1_lvl3))
+		return "pp1";
+	else if ((state == state_pm1_lvl1) || (state == state_pm1_lvl2) ||
+		(state == state_pm1_lvl3))
+		return "pm1";
+	else
+		return "ecm";
+}
+
+void save_pretest_work(fact_obj_t *fobj, factor_work_t *fwork, mpz_t n,
+	enum factorization_state active_state, uint32 active_curves)
+{
+	// record the pm1/pp1/ecm work done on n so far, one line per
+	// method and B1.  active_curves are credited to active_state on top
+	// of what fwork already holds, for a level that is still running.
+	// the record is written to a temporary file and then renamed over 
+	// the old one, so an interruption at any point leaves either the 
+	// old record or the new one intact.
+	FILE *out;
+	char tmpname[1024 + 8];
+	factor_work_t params;
+	enum factorization_state k;
+	uint32 curves;
+
+	sprintf(tmpname, "%s.tmp", fobj->autofact_obj.pretest_savefile);
+	out = fopen(tmpname, "w");
+	if (out == NULL)
+	{
+		printf("fopen error: %s\n", strerror(errno));
+		printf("could not open %s for writing\n", tmpname);
+		return;
+	}
+
+	gmp_fprintf(out, "N 0x%Zx\n", n);
+
+	params = *fwork;
+	for (k = state_pp1_lvl1; k <= state_ecm_65digit; k++)
+	{
+		curves = get_pretest_curves_done(fwork, k);
+		if (k == active_state)
+			curves += active_curves;
+
+		if (curves == 0)
+			continue;
+
+		set_work_params(&params, k);
+		fprintf(out, "%s %u %u\n", get_pretest_method_name(k), params.B1, curves);
+	}
+
+	if (fclose(out) != 0)
+	{
+		printf(" ***Error: problem closing file %s\n", tmpname);
+		remove(tmpname);
+		return;
+	}
+
+#if defined(WIN32) || defined(_WIN64)
+	// rename won't replace an existing file on windows
+	remove(fobj->autofact_obj.pretest_savefile);
+#endif
+	rename(tmpname, fobj->autofact_obj.pretest_savefile);
+
+	return;
+}
+
+int load_pretest_work(fact_obj_t *fobj, factor_work_t *fwork, mpz_t n)
+{
+	// credit fwork with the work recorded in the pretest savefile, if 
+	// there is one for this input.  a level is credited with the larger
+	// of the recorded curves and any already preloaded from initial_work.
+	// returns the number of levels credited.
+	FILE *in;
+	char tmpstr[GSTR_MAXSIZE];
+	char method[8];
+	factor_work_t params;
+	enum factorization_state k;
+	uint32 B1, curves, *group_curves;
+	mpz_t tmpz, g;
+	int num_levels = 0;
+
+	in = fopen(fobj->autofact_obj.pretest_savefile, "r");
+	if (in == NULL)
+		return 0;
+
+	mpz_init(tmpz);
+	mpz_init(g);
+
+	if ((fgets(tmpstr, GSTR_MAXSIZE, in) == NULL) ||
+		(mpz_set_str(tmpz, tmpstr + 2, 0) != 0))
+		mpz_set_ui(tmpz, 0);
+
+	// work on n itself or on any cofactor of it carries over
+	if (resume_check_input_match(tmpz, n, g))
+	{
+		params = *fwork;
+		while (fgets(tmpstr, GSTR_MAXSIZE, in) != NULL)
+		{
+			if (sscanf(tmpstr, "%7s %u %u", method, &B1, &curves) != 3)
+				continue;
+
+			for (k = state_pp1_lvl1; k <= state_ecm_65digit; k++)
+			{
+				set_work_params(&params, k);
+				if ((params.B1 == B1) && 
+					(strcmp(method, get_pretest_method_name(k)) == 0))
+					break;
+			}
+
+			if (k > state_ecm_65digit)
+			{
+				if (VFLAG > 0)
+					printf("fac: ignoring unrecognized pretest record: %s", tmpstr);
+				continue;
+			}
+
+			if (curves <= get_pretest_curves_done(fwork, k))
+				continue;
+
+			group_curves = get_group_curves_ptr(fwork, k);
+			if (group_curves != NULL)
+				*group_curves = curves;
+			else
+				set_ecm_curves_done(fwork, k, curves);
+			num_levels++;
+		}
+	}
+
+	mpz_clear(tmpz);
+	mpz_clear(g);
+	fclose(in);
+
+	return num_levels;
+}
+
+void checkpoint_pretest_work(fact_obj_t *fobj, int curves_run)
+{
+	// called by ecm_loop while factor() is running a level, to save
+	// the curves finished so far on that level
+	factor_work_t *fwork = (factor_work_t *)fobj->autofact_obj.active_work;
+	factor_work_t params;
+	enum factorization_state k;
+
+	if ((fwork == NULL) || !fobj->autofact_obj.autofact_active)
+		return;
+
+	params = *fwork;
+	for (k = state_ecm_15digit; k <= state_ecm_65digit; k++)
+	{
+		set_work_params(&params, k);
+		if (params.B1 == fobj->ecm_obj.B1)
+			break;
+	}
+
+	if (k > state_ecm_65digit)
+		return;
+
+	save_pretest_work(fobj, fwork, fobj->ecm_obj.gmp_n, k, curves_run);
+
+	return;
+}
+
 enum factorization_state schedule_work(factor_work_t *fwork, mpz_t b, fact_obj_t *fobj)
 {
 	int have_tune;
@@ -2094,6 +2606,8 @@ void factor(fact_obj_t *fobj)
 	FILE *data;
 	char tmpstr[GSTR_MAXSIZE];
 	int quit_after_sieve_method = 0;
+	int have_pretest_savefile = 0;
+	int complete = 0;
 
 	//factor() always ignores user specified B2 values
 	fobj->ecm_obj.stg2_is_default = 1;
@@ -2218,6 +2732,21 @@ void factor(fact_obj_t *fobj)
 
 	init_factor_work(&fwork, fobj);
 
+	// credit any pm1/pp1/ecm work saved by an earlier, interrupted run
+	if (load_pretest_work(fobj, &fwork, b) > 0)
+	{
+		have_pretest_savefile = 1;
+		if (VFLAG >= 0)
+			printf("fac: found pretest savefile, resuming from t%1.2f\n",
+				compute_ecm_work_done(&fwork, 0));
+
+		flog = fopen(fobj->flogname,"a");
+		logprint(flog,"resuming from pretest savefile, prior work t%1.2f\n",
+			compute_ecm_work_done(&fwork, 0));
+		fclose(flog);
+	}
+	fobj->autofact_obj.active_work = &fwork;
+
 	//starting point of factorization effort
 	fact_state = state_trialdiv;
 
@@ -2308,9 +2837,26 @@ void factor(fact_obj_t *fobj)
 	// state machine to factor the number using a variety of methods
 	while (fact_state != state_done)
 	{	
-		do_work(fact_state, &fwork, b, fobj);
+		if (fobj->autofact_obj.portfolio && (fobj->num_threads > 1) &&
+			is_portfolio_state(fact_state))
+		{
+			// group levels are provisionally credited while they run,
+			// so only checkpoint once the round has settled
+			fobj->autofact_obj.active_work = NULL;
+			do_portfolio_work(fact_state, &fwork, b, fobj);
+			fobj->autofact_obj.active_work = &fwork;
+		}
+		else
+			do_work(fact_state, &fwork, b, fobj);
+
+		if ((fact_state >= state_pp1_lvl1) && (fact_state <= state_ecm_65digit))
+		{
+			save_pretest_work(fobj, &fwork, b, state_idle, 0);
+			have_pretest_savefile = 1;
+		}
 
-		if (check_if_done(fobj, origN) || 
+		complete = check_if_done(fobj, origN);
+		if (complete || 
 			(quit_after_sieve_method && 
 			((fact_state == state_qs) ||
 			(fact_state == state_nfs))) ||
@@ -2321,6 +2867,11 @@ void factor(fact_obj_t *fobj)
 		if (fact_state != state_done)
 			fact_state = schedule_work(&fwork, b, fobj);		
 	}
+	fobj->autofact_obj.active_work = NULL;
+
+	// the pretest record is only useful while the input is unfactored
+	if (have_pretest_savefile && complete)
+		remove(fobj->autofact_obj.pretest_savefile);
 
 	// optionally record output in one or more file formats
 	if (fobj->num_factors >= 1) 
@@ -24,6 +24,12 @@ code to the public domain.
 #include "calc.h"
 #include "yafu_string.h"
 
+#if !defined(WIN32)
+	#include <sys/wait.h>
+	#include <fcntl.h>
+	#include <poll.h>
+#endif
+
 int ecm_loop(fact_obj_t *fobj)
 {
 	//expects the input in ecm_obj->gmp_n
@@ -58,7 +64,7 @@ int ecm_loop(fact_obj_t *fobj)
 
 	//initialize the flag to watch for interrupts, and set the
 	//pointer to the function to call if we see a user interrupt
-	ECM_ABORT = 0;
+	fobj_watch_sigint(fobj);
 	signal(SIGINT,ecmexit);
 
 	//init ecm process
@@ -68,8 +74,8 @@ int ecm_loop(fact_obj_t *fobj)
 	mpz_init(d);
 	mpz_init(t);
 
-	thread_data = (ecm_thread_data_t *)malloc(THREADS * sizeof(ecm_thread_data_t));
-	for (i=0; i<THREADS; i++)
+	thread_data = (ecm_thread_data_t *)malloc(fobj->ecm_obj.num_threads * sizeof(ecm_thread_data_t));
+	for (i=0; i<fobj->ecm_obj.num_threads; i++)
 	{
 		thread_data[i].fobj = fobj;
 		thread_data[i].thread_num = i;
@@ -79,12 +85,12 @@ int ecm_loop(fact_obj_t *fobj)
 	//round numcurves up so that each thread has something to do every iteration.
 	//this prevents a single threaded "cleanup" round after the multi-threaded rounds
 	//to finish the leftover requested curves.
-	fobj->ecm_obj.num_curves += ((fobj->ecm_obj.num_curves % THREADS) ? 
-		(THREADS - (fobj->ecm_obj.num_curves % THREADS)) : 0);
+	fobj->ecm_obj.num_curves += ((fobj->ecm_obj.num_curves % fobj->ecm_obj.num_threads) ? 
+		(fobj->ecm_obj.num_threads - (fobj->ecm_obj.num_curves % fobj->ecm_obj.num_threads)) : 0);
 
 	if (VFLAG >= 0)
 	{
-		for (i=0, total_curves_run=0; i<THREADS; i++)
+		for (i=0, total_curves_run=0; i<fobj->ecm_obj.num_threads; i++)
             total_curves_run += thread_data[i].curves_run;
 
 		printf("ecm: %d/%d curves on C%d, ",
@@ -98,7 +104,7 @@ int ecm_loop(fact_obj_t *fobj)
 	/* activate the threads one at a time. The last is the
 	   master thread (i.e. not a thread at all). */
 
-	for (i = 0; i < THREADS - 1; i++)
+	for (i = 0; i < fobj->ecm_obj.num_threads - 1; i++)
 		ecm_start_worker_thread(thread_data + i, 0);
 
 	ecm_start_worker_thread(thread_data + i, 1);
@@ -106,26 +112,35 @@ int ecm_loop(fact_obj_t *fobj)
 	//split the requested curves up among the specified number of threads. 
 	num_batches = 0;
 	t_time = 0.0;
-	for (j=0; j < fobj->ecm_obj.num_curves / THREADS; j++)
+	for (j=0; j < fobj->ecm_obj.num_curves / fobj->ecm_obj.num_threads; j++)
 	{
 		//watch for an abort
-		if (ECM_ABORT)
+		if (fobj_aborted(fobj))
 		{
+			//save the finished curves so factor() can resume from them
+			for (i=0, total_curves_run=0; i<fobj->ecm_obj.num_threads; i++)
+				total_curves_run += thread_data[i].curves_run;
+			checkpoint_pretest_work(fobj, total_curves_run);
+
 			print_factors(fobj);
 			exit(1);
 		}
 
+		//or for a request to stop from concurrent work in factor()
+		if (*fobj->stop)
+			break;
+
 		// start a counter for this batch of curves
 		// for larger B1s
 		if (fobj->ecm_obj.B1 > 48000)
 			gettimeofday(&start, NULL);
 
 		//do work on different sigmas
-		for (i=0; i<THREADS; i++)
+		for (i=0; i<fobj->ecm_obj.num_threads; i++)
 		{
 			ecm_get_sigma(&thread_data[i]);
 
-			if (i == THREADS - 1) {
+			if (i == fobj->ecm_obj.num_threads - 1) {
 				ecm_do_one_curve(&thread_data[i]);
 			}
 			else {
@@ -140,9 +155,9 @@ int ecm_loop(fact_obj_t *fobj)
 		}
 
 		//wait for threads to finish
-		for (i=0; i<THREADS; i++)
+		for (i=0; i<fobj->ecm_obj.num_threads; i++)
 		{
-			if (i < THREADS - 1) {
+			if (i < fobj->ecm_obj.num_threads - 1) {
 #if defined(WIN32) || defined(_WIN64)
 				WaitForSingleObject(thread_data[i].finish_event, INFINITE);
 #else
@@ -153,7 +168,7 @@ int ecm_loop(fact_obj_t *fobj)
 			}
 		}
 
-		for (i=0; i<THREADS; i++)
+		for (i=0; i<fobj->ecm_obj.num_threads; i++)
 		{
 			//look at the result of each curve and see if we're done
 			if ((mpz_cmp_ui(thread_data[i].gmp_factor, 1) > 0)
@@ -184,22 +199,44 @@ int ecm_loop(fact_obj_t *fobj)
 						//the user has specified to keep going with ECM until the 
 						//curve counts are finished thus:
 						//we need to re-initialize with a different modulus.  this is
-						//independant of the thread data initialization
+						//independant of the thread data initialization.
+						//the thread pool is already sized, so keep its count
+						//(the smaller input can only switch to tinyecm, 
+						//which runs on any number of threads)
+						int nt = fobj->ecm_obj.num_threads;
 						ecm_process_free(fobj);
 						ecm_process_init(fobj);
+						fobj->ecm_obj.num_threads = nt;
 					}
 				}
 			}
+			else if (*fobj->stop || (thread_data[i].stagefound < 0))
+			{
+				//this curve was cut short, or lost with its external 
+				//ecm process, don't count it
+				continue;
+			}
 
 			thread_data[i].curves_run++;
 		}
 
+		if (*fobj->stop)
+			bail = 1;
+
 		if (bail)
 			goto done;
 
+		//batches at larger B1s are long enough to be worth a checkpoint
+		if (fobj->ecm_obj.B1 > 48000)
+		{
+			for (i=0, total_curves_run=0; i<fobj->ecm_obj.num_threads; i++)
+				total_curves_run += thread_data[i].curves_run;
+			checkpoint_pretest_work(fobj, total_curves_run);
+		}
+
 		if (VFLAG >= 0)
 		{
-			for (i=0, total_curves_run=0; i<THREADS; i++)
+			for (i=0, total_curves_run=0; i<fobj->ecm_obj.num_threads; i++)
 				total_curves_run += thread_data[i].curves_run;			
 
 			printf("ecm: %d/%d curves on C%d, ",
@@ -219,7 +256,7 @@ int ecm_loop(fact_obj_t *fobj)
 				num_batches++;
 				t_time += batch_time;
 				avg_batch_time = t_time / (double)num_batches;
-				est_time = (double)(fobj->ecm_obj.num_curves / THREADS - j) * avg_batch_time;
+				est_time = (double)(fobj->ecm_obj.num_curves / fobj->ecm_obj.num_threads - j) * avg_batch_time;
 
 				if (est_time > 3600)
 					printf(", ETA: %1.2f hrs ", est_time / 3600);
@@ -246,7 +283,7 @@ done:
 		return 0;
 	}
 
-	for (i=0, total_curves_run=0; i<THREADS; i++)
+	for (i=0, total_curves_run=0; i<fobj->ecm_obj.num_threads; i++)
 		total_curves_run += thread_data[i].curves_run;
 
 	logprint(flog,"Finished %d curves using Lenstra ECM method on C%d input, ",
@@ -258,13 +295,13 @@ done:
 	fclose(flog);
 
 	//stop worker threads
-	for (i=0; i<THREADS - 1; i++)
+	for (i=0; i<fobj->ecm_obj.num_threads - 1; i++)
 	{
 		ecm_stop_worker_thread(thread_data + i, 0);
 	}
 	ecm_stop_worker_thread(thread_data + i, 1);
 
-	for (i=0; i<THREADS; i++)
+	for (i=0; i<fobj->ecm_obj.num_threads; i++)
 		ecm_thread_free(&thread_data[i]);
 	free(thread_data);
 
@@ -527,25 +564,39 @@ void ecm_process_init(fact_obj_t *fobj)
 {
 	//initialize things which all threads will need when using
 	//GMP-ECM
-	TMP_THREADS = THREADS;
-	TMP_STG2_MAX = fobj->ecm_obj.B2;
+	fobj->ecm_obj.num_threads = fobj->num_threads;
 
 	if (strcmp(fobj->ecm_obj.ecm_path, "") != 0)
 		fobj->ecm_obj.use_external = 1;
+
+	// small inputs run on the built-in ecm, which is thread safe and so 
+	// doesn't need an external binary to use all of the threads
+	fobj->ecm_obj.use_tinyecm = 0;
+	if ((mpz_sizeinbase(fobj->ecm_obj.gmp_n, 2) <= TINYECM_MAXBITS) &&
+		tinyecm_plan(fobj, fobj->ecm_obj.B1, tinyecm_B2(fobj)))
+	{
+		if (fobj->ecm_obj.use_external && (VFLAG > 0))
+			printf("ecm: using the built-in ecm on this C%d instead of %s\n",
+				(int)mpz_sizeinbase(fobj->ecm_obj.gmp_n, 10), fobj->ecm_obj.ecm_path);
+
+		fobj->ecm_obj.use_tinyecm = 1;
+		fobj->ecm_obj.use_external = 0;
+		return;
+	}
 	
-	if (THREADS > 1)
+	if (fobj->ecm_obj.num_threads > 1)
 	{
 		if (!fobj->ecm_obj.use_external)
 		{
 			if (VFLAG >= 2)
 				printf("GMP-ECM does not support multiple threads... running single threaded\n");
-			THREADS = 1;
+			fobj->ecm_obj.num_threads = 1;
 		}
 		else
 		{
 			if (fobj->ecm_obj.B1 < fobj->ecm_obj.ecm_ext_xover || fobj->ecm_obj.num_curves == 1)
 			{
-				THREADS = 1;
+				fobj->ecm_obj.num_threads = 1;
 				fobj->ecm_obj.use_external = 0;
 			}
 		}
@@ -565,10 +616,24 @@ void ecm_thread_init(ecm_thread_data_t *tdata)
 	mpz_init(tdata->gmp_n);
 	mpz_init(tdata->gmp_factor);
 	ecm_init(tdata->params);
-	gmp_randseed_ui(tdata->params->rng, get_rand(&g_rand.low, &g_rand.hi));
+	gmp_randseed_ui(tdata->params->rng, get_rand(&tdata->fobj->seed1, &tdata->fobj->seed2));
 	mpz_set(tdata->gmp_n, tdata->fobj->ecm_obj.gmp_n);
 	tdata->params->method = ECM_ECM;
-	tdata->curves_run = 0;
+	tdata->params->stop_asap = &ecm_stop_asap;
+	tdata->curves_run = 0;
+	tdata->tiny = NULL;
+	if (tdata->fobj->ecm_obj.use_tinyecm)
+		tdata->tiny = tinyecm_init();
+
+#if !defined(WIN32)
+	// with an external binary, keep one ecm process per thread running
+	// for the whole batch instead of a system() call per curve.  a fixed
+	// sigma can't be handed to a running process, so that still goes 
+	// through system().
+	tdata->ext_pid = 0;
+	if (tdata->fobj->ecm_obj.use_external && (tdata->fobj->ecm_obj.sigma == 0))
+		ecm_ext_start(tdata);
+#endif
 		
 	return;
 }
@@ -578,7 +643,13 @@ void ecm_thread_free(ecm_thread_data_t *tdata)
 	ecm_clear(tdata->params);
 	mpz_clear(tdata->gmp_n);
 	mpz_clear(tdata->gmp_factor);
+	tinyecm_free(tdata->tiny);
 
+#if !defined(WIN32)
+	// even if use_external has since been turned off for a smaller cofactor
+	ecm_ext_stop(tdata);
+#endif
+
 	if (tdata->fobj->ecm_obj.use_external)
 	{
 		// remove temp file specific to this thread num
@@ -591,18 +662,337 @@ void ecm_thread_free(ecm_thread_data_t *tdata)
 
 void ecm_process_free(fact_obj_t *fobj)
 {
-	THREADS = TMP_THREADS;
-	fobj->ecm_obj.B2 = TMP_STG2_MAX;
+	tinyecm_plan_free(fobj);
+	return;
+}
+
+#if !defined(WIN32)
+// SIGPIPE is ignored while any external ecm worker is running and put 
+// back the way it was when the last one stops
+static pthread_mutex_t ecm_ext_sigpipe_lock = PTHREAD_MUTEX_INITIALIZER;
+static void (*ecm_ext_old_sigpipe)(int);
+static int ecm_ext_running = 0;
+
+// milliseconds to wait for a factor report after ecm's last step
+#define ECM_EXT_FACTOR_WAIT 2
+
+int ecm_ext_start(ecm_thread_data_t *tdata)
+{
+	// start the external ecm on a pair of pipes.  with -c 1, it runs one
+	// curve per number read from stdin and reports it in its usual verbose
+	// form, which says which sigma was used and which stage found a factor.
+	// returns 0 if the process could not be started, in which case curves 
+	// go through system() as before.
+	fact_obj_t *fobj = tdata->fobj;
+	int to_ecm[2], from_ecm[2];
+	char b1str[32], b2str[32];
+	pid_t pid;
+
+	tdata->ext_pid = 0;
+	tdata->ext_buf = NULL;
+	tdata->ext_len = 0;
+	tdata->ext_used = 0;
+	tdata->ext_alloc = 0;
+	tdata->ext_sigma = 0;
+
+	if (pipe(to_ecm) != 0)
+		return 0;
+
+	if (pipe(from_ecm) != 0)
+	{
+		close(to_ecm[0]);
+		close(to_ecm[1]);
+		return 0;
+	}
+
+	// our ends of the pipes must not leak into the other threads' ecm 
+	// processes, or they would never see end of input
+	fcntl(to_ecm[1], F_SETFD, FD_CLOEXEC);
+	fcntl(from_ecm[0], F_SETFD, FD_CLOEXEC);
+
+	sprintf(b1str, "%u", fobj->ecm_obj.B1);
+	sprintf(b2str, "%" PRIu64 "", fobj->ecm_obj.B2);
+
+	fflush(NULL);
+	pid = fork();
+	if (pid < 0)
+	{
+		printf("fork error: %s\n", strerror(errno));
+		close(to_ecm[0]);
+		close(to_ecm[1]);
+		close(from_ecm[0]);
+		close(from_ecm[1]);
+		return 0;
+	}
+	else if (pid == 0)
+	{
+		// child: become ecm, reading from and writing to the pipes
+		dup2(to_ecm[0], 0);
+		dup2(from_ecm[1], 1);
+		close(to_ecm[0]);
+		close(from_ecm[1]);
+
+		if (fobj->ecm_obj.stg2_is_default == 0)
+			execl(fobj->ecm_obj.ecm_path, fobj->ecm_obj.ecm_path, 
+				"-c", "1", b1str, b2str, (char *)NULL);
+		else
+			execl(fobj->ecm_obj.ecm_path, fobj->ecm_obj.ecm_path, 
+				"-c", "1", b1str, (char *)NULL);
+		_exit(127);
+	}
+
+	close(to_ecm[0]);
+	close(from_ecm[1]);
+
+	// a worker that dies shows up as end of file on its output, not as 
+	// SIGPIPE on its input
+	pthread_mutex_lock(&ecm_ext_sigpipe_lock);
+	if (ecm_ext_running++ == 0)
+		ecm_ext_old_sigpipe = signal(SIGPIPE, SIG_IGN);
+	pthread_mutex_unlock(&ecm_ext_sigpipe_lock);
+
+	// the output is read straight from the pipe, so that what ecm has 
+	// written so far can be polled for without blocking
+	tdata->ext_in = fdopen(to_ecm[1], "w");
+	tdata->ext_fd = from_ecm[0];
+	tdata->ext_pid = pid;
+
+	return 1;
+}
+
+static void ecm_ext_close(ecm_thread_data_t *tdata, int *status)
+{
+	// ecm quits at the end of its input
+	fclose(tdata->ext_in);
+	close(tdata->ext_fd);
+	waitpid(tdata->ext_pid, status, 0);
+	tdata->ext_pid = -1;
+	free(tdata->ext_buf);
+	tdata->ext_buf = NULL;
+	tdata->ext_len = 0;
+	tdata->ext_used = 0;
+	tdata->ext_alloc = 0;
+
+	return;
+}
+
+void ecm_ext_stop(ecm_thread_data_t *tdata)
+{
+	int status;
+
+	if (tdata->ext_pid == 0)
+		return;
+
+	// a worker that died mid-batch was closed when that was noticed, 
+	// but still holds its place in the SIGPIPE count
+	if (tdata->ext_pid > 0)
+		ecm_ext_close(tdata, &status);
+	tdata->ext_pid = 0;
+
+	pthread_mutex_lock(&ecm_ext_sigpipe_lock);
+	if (--ecm_ext_running == 0)
+		signal(SIGPIPE, ecm_ext_old_sigpipe);
+	pthread_mutex_unlock(&ecm_ext_sigpipe_lock);
+
 	return;
 }
 
+static char *ecm_ext_getline(ecm_thread_data_t *tdata, int wait_ms)
+{
+	// return the next complete line of ecm output, or NULL at end of 
+	// file.  with wait_ms >= 0, also NULL if no more output arrives 
+	// within that many milliseconds.
+	char *eol;
+	ssize_t got;
+
+	// drop the line handed back last time
+	if (tdata->ext_used > 0)
+	{
+		tdata->ext_len -= tdata->ext_used;
+		memmove(tdata->ext_buf, tdata->ext_buf + tdata->ext_used, tdata->ext_len);
+		tdata->ext_used = 0;
+	}
+
+	while (1)
+	{
+		eol = memchr(tdata->ext_buf, '\n', tdata->ext_len);
+		if (eol != NULL)
+		{
+			*eol = '\0';
+			tdata->ext_used = (int)(eol - tdata->ext_buf) + 1;
+			return tdata->ext_buf;
+		}
+
+		if (wait_ms >= 0)
+		{
+			struct pollfd pfd;
+
+			pfd.fd = tdata->ext_fd;
+			pfd.events = POLLIN;
+			if (poll(&pfd, 1, wait_ms) <= 0)
+				return NULL;
+		}
+
+		if (tdata->ext_len == tdata->ext_alloc)
+		{
+			tdata->ext_alloc = 2 * tdata->ext_alloc + 1024;
+			tdata->ext_buf = (char *)realloc(tdata->ext_buf, 
+				tdata->ext_alloc * sizeof(char));
+		}
+
+		got = read(tdata->ext_fd, tdata->ext_buf + tdata->ext_len, 
+			tdata->ext_alloc - tdata->ext_len);
+		if ((got < 0) && (errno == EINTR))
+			continue;
+		if (got <= 0)
+			return NULL;
+
+		tdata->ext_len += (int)got;
+	}
+}
+
+void ecm_ext_curve(ecm_thread_data_t *thread_data)
+{
+	// run one curve on this thread's external ecm process.  its report
+	// on one input looks like
+	//   Input number is <n> (<d> digits)
+	//   Using B1=..., B2=..., polynomial ..., sigma=<param>:<sigma>
+	//   Step 1 took <t>ms
+	//   Step 2 took <t>ms
+	//   ********** Factor found in step <k>: <f>
+	//   Found prime factor of <d> digits: <f>
+	//   Prime cofactor <c> has <d> digits
+	// where the step 2 line is missing if step 1 found the factor.  
+	// nothing but the next input line marks the end of a report without a
+	// factor, so once step 2 is done, factor lines are waited for only 
+	// briefly.  any that ecm writes later than that are picked up on the
+	// next curve, and credited with this curve's sigma.
+	fact_obj_t *fobj = thread_data->fobj;
+	char *line, *ptr;
+	int status;
+	int seen_input = 0, in_factor = 0, done_steps = 0;
+	int last_step;
+	uint32 sigma = 0;
+	mpz_t f;
+
+	thread_data->sigma = 0;
+	thread_data->stagefound = 0;
+	mpz_set_ui(thread_data->gmp_factor, 1);
+
+	// ecm skips step 2 when B2 isn't larger than B1
+	last_step = 2;
+	if ((fobj->ecm_obj.stg2_is_default == 0) && 
+		(fobj->ecm_obj.B2 <= (uint64)fobj->ecm_obj.B1))
+		last_step = 1;
+
+	gmp_fprintf(thread_data->ext_in, "%Zd\n", fobj->ecm_obj.gmp_n);
+	fflush(thread_data->ext_in);
+
+	mpz_init(f);
+	while (1)
+	{
+		// wait for output until this input's steps are done, and for 
+		// the rest of a factor report once it has begun
+		line = ecm_ext_getline(thread_data, 
+			(!done_steps || in_factor) ? -1 : ECM_EXT_FACTOR_WAIT);
+
+		if (line == NULL)
+		{
+			if (done_steps && !in_factor)
+				break;
+
+			// the process is gone.  a ctrl-c reaches ecm too, so if that's
+			// what killed it, abort the way the interrupt handler would.
+			// the curve didn't finish, so it isn't counted.
+			ecm_ext_close(thread_data, &status);
+			mpz_set_ui(thread_data->gmp_factor, 1);
+			thread_data->stagefound = -1;
+
+			if (WIFSIGNALED(status) && (WTERMSIG(status) == SIGINT))
+				fobj->abort = 1;
+			else if (VFLAG >= 0)
+				printf("\necm: external ecm on thread %d exited with status %d, "
+					"continuing with one process per curve\n", 
+					thread_data->thread_num, 
+					WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+			break;
+		}
+
+		if (strncmp(line, "Input number is", 15) == 0)
+		{
+			seen_input = 1;
+		}
+		else if (seen_input && ((ptr = strstr(line, "sigma=")) != NULL))
+		{
+			// newer versions prefix the sigma with its parametrization
+			char *colon;
+
+			ptr += 6;
+			colon = (char *)memchr(ptr, ':', strcspn(ptr, ", \t\r"));
+			if (colon != NULL)
+				ptr = colon + 1;
+			sigma = (uint32)strtoul(ptr, NULL, 10);
+		}
+		else if (seen_input && (strncmp(line, "Step ", 5) == 0) && 
+			(atoi(line + 5) == last_step))
+		{
+			done_steps = 1;
+		}
+		else if ((strstr(line, "**********") != NULL) && 
+			((ptr = strstr(line, ":")) != NULL))
+		{
+			// found a factor.  the character prior to the : is the stage, 
+			// and the rest of the line after it is the factor.  lines 
+			// before this input's report finish the last curve's.
+			in_factor = 1;
+			if ((mpz_set_str(f, ptr + 1 + strspn(ptr + 1, " "), 10) == 0) &&
+				(mpz_cmp_ui(f, 1) > 0) && 
+				(mpz_cmp(f, fobj->ecm_obj.gmp_n) < 0) &&
+				mpz_divisible_p(fobj->ecm_obj.gmp_n, f))
+			{
+				mpz_set(thread_data->gmp_factor, f);
+				sscanf(ptr - 2, "%d", &thread_data->stagefound);
+				thread_data->sigma = seen_input ? sigma : thread_data->ext_sigma;
+			}
+		}
+		else if ((strstr(line, "cofactor") != NULL) || 
+			(strncmp(line, "Found input number", 18) == 0))
+		{
+			// end of a factor report
+			in_factor = 0;
+			if (seen_input)
+				done_steps = 1;
+		}
+	}
+	mpz_clear(f);
+
+	thread_data->ext_sigma = sigma;
+
+	return;
+}
+#endif
+
 void *ecm_do_one_curve(void *ptr)
 {
 	//unpack the data structure and stuff inside it
 	ecm_thread_data_t *thread_data = (ecm_thread_data_t *)ptr;
 	fact_obj_t *fobj = thread_data->fobj;
 
-	if (!fobj->ecm_obj.use_external)
+	if (fobj->ecm_obj.use_tinyecm)
+	{
+		// set the thread local copy of n
+		mpz_set(thread_data->gmp_n, fobj->ecm_obj.gmp_n);
+
+		if (thread_data->tiny == NULL)
+			thread_data->tiny = tinyecm_init();
+
+		// the curve stops when its job does
+		ecm_stop = fobj->stop;
+		thread_data->stagefound = tinyecm_curve(thread_data->tiny, 
+			fobj->ecm_obj.tiny_plan, thread_data->gmp_factor, thread_data->gmp_n, thread_data->sigma);
+		ecm_stop = NULL;
+	}
+	else if (!fobj->ecm_obj.use_external)
 	{
 		int status;
 
@@ -622,8 +1012,10 @@ void *ecm_do_one_curve(void *ptr)
 			uint64_2gmp(fobj->ecm_obj.B2, thread_data->params->B2);
 		}
 
+		ecm_stop = fobj->stop;
 		status = ecm_factor(thread_data->gmp_factor, thread_data->gmp_n,
-				fobj->ecm_obj.B1, thread_data->params);		
+				fobj->ecm_obj.B1, thread_data->params);		
+		ecm_stop = NULL;
 
 		//printf ("used B2: ");
 		//mpz_out_str (stdout, 10, thread_data->params->B2);
@@ -647,6 +1039,19 @@ void *ecm_do_one_curve(void *ptr)
 		char *tmpstr = NULL;
 		int retcode;
 
+#if !defined(WIN32)
+		if (thread_data->ext_pid > 0)
+		{
+			ecm_ext_curve(thread_data);
+			return 0;
+		}
+#endif
+
+		// nothing found unless the output says so.  this also clears the
+		// mark left by a curve lost with an external ecm process.
+		thread_data->stagefound = 0;
+		mpz_set_ui(thread_data->gmp_factor, 1);
+
 		// let mpz figure out and allocate the string
 		tmpstr = mpz_get_str(tmpstr, 10, thread_data->gmp_n);
 
@@ -671,7 +1076,7 @@ void *ecm_do_one_curve(void *ptr)
 
 		// this is what I observed ecm returning on ctrl-c.  hopefully it is portable.
 		if (retcode == 33280)
-			ECM_ABORT = 1;
+			fobj->abort = 1;
 		
 		// parse output file
 		fid = fopen(thread_data->tmp_output, "r");
@@ -711,10 +1116,18 @@ void *ecm_do_one_curve(void *ptr)
 }
 
 // function definitions
+THREAD_LOCAL volatile int *ecm_stop = NULL;
+
+int ecm_stop_asap(void)
+{
+	// polled by gmp-ecm during a curve
+	return ((ecm_stop != NULL) && *ecm_stop);
+}
+
 void ecmexit(int sig)
 {
 	printf("\nAborting...\n");
-	ECM_ABORT = 1;
+	SIGINT_COUNT++;
 	return;
 }
 
@@ -723,7 +1136,11 @@ int print_B1B2(fact_obj_t *fobj, FILE *fid)
 	int i;
 	char suffix;
 	char stg1str[20];
-	char stg2str[20];
+	char stg2str[32];
+	uint64 B2 = fobj->ecm_obj.B2;
+
+	if (fobj->ecm_obj.use_tinyecm)
+		B2 = tinyecm_B2(fobj);
 
 	if (fobj->ecm_obj.B1 % 1000000000 == 0)
 	{
@@ -745,26 +1162,26 @@ int print_B1B2(fact_obj_t *fobj, FILE *fid)
 		sprintf(stg1str,"%u",fobj->ecm_obj.B1);
 	}
 
-	if (fobj->ecm_obj.stg2_is_default == 0)
+	if ((fobj->ecm_obj.stg2_is_default == 0) || fobj->ecm_obj.use_tinyecm)
 	{
-		if (fobj->ecm_obj.B2 % 1000000000 == 0)
+		if (B2 % 1000000000 == 0)
 		{
 			suffix = 'B';
-			sprintf(stg2str,"%" PRIu64 "%c",fobj->ecm_obj.B2 / 1000000000, suffix);
+			sprintf(stg2str,"%" PRIu64 "%c",B2 / 1000000000, suffix);
 		}
-		else if (fobj->ecm_obj.B2 % 1000000 == 0)
+		else if (B2 % 1000000 == 0)
 		{
 			suffix = 'M';
-			sprintf(stg2str,"%" PRIu64 "%c",fobj->ecm_obj.B2 / 1000000, suffix);
+			sprintf(stg2str,"%" PRIu64 "%c",B2 / 1000000, suffix);
 		}
-		else if (fobj->ecm_obj.B2 % 1000 == 0)
+		else if (B2 % 1000 == 0)
 		{
 			suffix = 'K';
-			sprintf(stg2str,"%" PRIu64 "%c",fobj->ecm_obj.B2 / 1000, suffix);
+			sprintf(stg2str,"%" PRIu64 "%c",B2 / 1000, suffix);
 		}
 		else
 		{
-			sprintf(stg2str,"%" PRIu64 "",fobj->ecm_obj.B2);
+			sprintf(stg2str,"%" PRIu64 "",B2);
 		}
 	}
 	else
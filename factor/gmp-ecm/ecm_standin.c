@@ -0,0 +1,259 @@
+/*----------------------------------------------------------------------
+This source distribution is placed in the public domain by its author,
+Ben Buhrow. You may use it for any purpose, free of charge,
+without having to notify anyone. I disclaim any responsibility for any
+errors.
+
+Optionally, please be nice and tell me if you find this source to be
+useful. Again optionally, if you add to the functionality present here
+please consider making those additions public too, so that others may
+benefit from your work.
+
+Some parts of the code (and also this header), included in this
+distribution have been reused from other sources. In particular I
+have benefitted greatly from the work of Jason Papadopoulos's msieve @
+www.boo.net/~jasonp, Scott Contini's mpqs implementation, and Tom St.
+Denis Tom's Fast Math library.  Many thanks to their kind donation of
+code to the public domain.
+       				   --bbuhrow@gmail.com 12/6/2012
+----------------------------------------------------------------------*/
+
+/*
+a stand-in for the gmp-ecm binary, for testing -ecm_path without one.  it
+takes the same command line as yafu gives ecm ([-q] [-c <curves>]
+[-sigma <s>] <B1> [<B2>]), reads numbers from stdin one per line, and
+reports on each in gmp-ecm's verbose format, one line at a time.  the
+"curve" is really a p-1 run from a base derived from sigma, which finds
+p when p-1 is B1-smooth (step 1) or B1-smooth times one prime up to B2
+(step 2).  B2 defaults to 100*B1.
+
+two environment variables make it misbehave on purpose:
+ECM_STANDIN_LATE=<ms>	pause this long after "Step 2 took" before
+						reporting a factor found in step 2
+ECM_STANDIN_DIE=<k>		exit with status 3, without answering, on reading
+						input number k+1
+and with ECM_STANDIN_LOG=<file>, "<sigma> <step>" is appended to the file
+for every curve (step 0 if nothing was found), so that what the caller 
+made of the output can be checked.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <gmp.h>
+
+static unsigned long *primes;
+static int num_primes;
+
+static void make_primes(unsigned long bound)
+{
+	char *sieve = (char *)calloc(bound + 1, sizeof(char));
+	unsigned long i, j;
+
+	primes = (unsigned long *)malloc((bound / 2 + 2) * sizeof(unsigned long));
+	num_primes = 0;
+	for (i = 2; i <= bound; i++)
+	{
+		if (sieve[i])
+			continue;
+		primes[num_primes++] = i;
+		for (j = i * i; j <= bound; j += i)
+			sieve[j] = 1;
+	}
+	free(sieve);
+	return;
+}
+
+static int run_curve(mpz_t f, mpz_t n, unsigned long sigma,
+	unsigned long B1, unsigned long B2, int quiet, int late_ms)
+{
+	// returns the step a factor was found in, or 0
+	mpz_t a, acc, t;
+	int i, stage = 0;
+	clock_t start;
+
+	mpz_init(a);
+	mpz_init(acc);
+	mpz_init(t);
+
+	if (!quiet)
+		printf("Using B1=%lu, B2=%lu, polynomial x^1, sigma=1:%lu\n",
+			B1, B2, sigma);
+
+	start = clock();
+	mpz_set_ui(a, sigma);
+	mpz_add_ui(a, a, 2);
+	mpz_mod(a, a, n);
+	for (i = 0; (i < num_primes) && (primes[i] <= B1); i++)
+	{
+		unsigned long q = primes[i];
+
+		while (q <= B1 / primes[i])
+			q *= primes[i];
+		mpz_powm_ui(a, a, q, n);
+	}
+
+	mpz_sub_ui(t, a, 1);
+	mpz_gcd(f, t, n);
+	if ((mpz_cmp_ui(f, 1) > 0) && (mpz_cmp(f, n) < 0))
+		stage = 1;
+
+	if (!quiet)
+		printf("Step 1 took %dms\n",
+			(int)((clock() - start) * 1000 / CLOCKS_PER_SEC));
+
+	if ((stage == 0) && (B2 > B1))
+	{
+		start = clock();
+		mpz_set_ui(acc, 1);
+		for (; (i < num_primes) && (primes[i] <= B2); i++)
+		{
+			mpz_powm_ui(t, a, primes[i], n);
+			mpz_sub_ui(t, t, 1);
+			mpz_mul(acc, acc, t);
+			mpz_mod(acc, acc, n);
+		}
+
+		mpz_gcd(f, acc, n);
+		if ((mpz_cmp_ui(f, 1) > 0) && (mpz_cmp(f, n) < 0))
+			stage = 2;
+
+		if (!quiet)
+			printf("Step 2 took %dms\n",
+				(int)((clock() - start) * 1000 / CLOCKS_PER_SEC));
+
+		if ((stage == 2) && (late_ms > 0))
+		{
+			fflush(stdout);
+			usleep(late_ms * 1000);
+		}
+	}
+
+	if (stage > 0)
+	{
+		mpz_divexact(t, n, f);
+		if (quiet)
+		{
+			gmp_printf("%Zd %Zd\n", f, t);
+		}
+		else
+		{
+			gmp_printf("********** Factor found in step %d: %Zd\n", stage, f);
+			gmp_printf("Found %s factor of %d digits: %Zd\n",
+				mpz_probab_prime_p(f, 20) ? "prime" : "composite",
+				(int)mpz_sizeinbase(f, 10), f);
+			gmp_printf("%s cofactor %Zd has %d digits\n",
+				mpz_probab_prime_p(t, 20) ? "Probable prime" : "Composite",
+				t, (int)mpz_sizeinbase(t, 10));
+		}
+	}
+	else if (quiet)
+	{
+		gmp_printf("%Zd\n", n);
+	}
+
+	mpz_clear(a);
+	mpz_clear(acc);
+	mpz_clear(t);
+	return stage;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long B1 = 0, B2 = 0, sigma = 0;
+	int curves = 1, quiet = 0, late_ms = 0, die_after = -1, inputs = 0;
+	int i, found = 0;
+	FILE *trace = NULL;
+	char *line;
+	size_t len = 1 << 16;
+	mpz_t n, f;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-q") == 0)
+			quiet = 1;
+		else if ((strcmp(argv[i], "-c") == 0) && (i + 1 < argc))
+			curves = atoi(argv[++i]);
+		else if ((strcmp(argv[i], "-sigma") == 0) && (i + 1 < argc))
+			sigma = strtoul(argv[++i], NULL, 10);
+		else if (B1 == 0)
+			B1 = strtoul(argv[i], NULL, 10);
+		else
+			B2 = strtoul(argv[i], NULL, 10);
+	}
+
+	if (B1 == 0)
+	{
+		fprintf(stderr, "usage: %s [-q] [-c curves] [-sigma s] B1 [B2]\n", argv[0]);
+		return 1;
+	}
+
+	if (B2 == 0)
+		B2 = 100 * B1;
+
+	if (getenv("ECM_STANDIN_LATE") != NULL)
+		late_ms = atoi(getenv("ECM_STANDIN_LATE"));
+	if (getenv("ECM_STANDIN_DIE") != NULL)
+		die_after = atoi(getenv("ECM_STANDIN_DIE"));
+	if (getenv("ECM_STANDIN_LOG") != NULL)
+		trace = fopen(getenv("ECM_STANDIN_LOG"), "a");
+
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	make_primes(B2);
+	srand((unsigned int)time(NULL) ^ ((unsigned int)getpid() << 8));
+
+	if (!quiet)
+		printf("GMP-ECM 7.0.4 (yafu stand-in) [configured with GMP %s] [ECM]\n",
+			gmp_version);
+
+	line = (char *)malloc(len * sizeof(char));
+	mpz_init(n);
+	mpz_init(f);
+	while (fgets(line, len, stdin) != NULL)
+	{
+		line[strcspn(line, "\r\n")] = '\0';
+		if (mpz_set_str(n, line + strspn(line, " \t"), 10) != 0)
+			continue;
+
+		if (inputs++ == die_after)
+			return 3;
+
+		if (!quiet)
+			gmp_printf("Input number is %Zd (%d digits)\n", n,
+				(int)mpz_sizeinbase(n, 10));
+
+		for (i = 0; i < curves; i++)
+		{
+			unsigned long s = sigma;
+			int stage;
+
+			while (s < 6)
+				s = (((unsigned long)rand() << 16) ^ (unsigned long)rand()) & 0xffffffff;
+
+			stage = run_curve(f, n, s, B1, B2, quiet, late_ms);
+			if (trace != NULL)
+			{
+				fprintf(trace, "%lu %d\n", s, stage);
+				fflush(trace);
+			}
+
+			if (stage > 0)
+			{
+				found = 1;
+				break;
+			}
+		}
+	}
+
+	mpz_clear(n);
+	mpz_clear(f);
+	free(line);
+	free(primes);
+	if (trace != NULL)
+		fclose(trace);
+
+	// like gmp-ecm, exit status 0 means nothing was found
+	return found ? 8 : 0;
+}
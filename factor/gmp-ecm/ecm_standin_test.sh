@@ -0,0 +1,70 @@
+#!/bin/sh
+# runs yafu's ecm against ecm_standin over the pipe protocol used with
+# -ecm_path, and checks that factors come back with the sigma and step
+# the stand-in actually used, that a late factor report is still picked
+# up, and that a curve lost with its worker process isn't counted.
+#
+# usage: ecm_standin_test.sh <yafu binary> <ecm_standin binary>
+
+case "$1" in /*) YAFU="$1" ;; *) YAFU="$PWD/$1" ;; esac
+case "$2" in /*) STANDIN="$2" ;; *) STANDIN="$PWD/$2" ;; esac
+
+# p-1 of the first prime is 2000-smooth, of the second 2000-smooth times
+# 24481.  C77 is a product of two primes neither method finds.
+P1=76372637859660062666198807
+P2=27486468793721551901259443
+C77=37936422101615805067929941623591926346561058972839465500297145488997966520371
+N1=2897304626857907995122186203871226763389541090268959188215894552962031619109076175378935044299101397397
+N2=1042738282241511398369629224024891028919065779074247280134273886232977042442889939927213149703215613353
+
+DIR=`mktemp -d` || exit 1
+trap 'rm -rf "$DIR"' 0
+FAIL=0
+
+run()
+{
+	# run() <input> [VAR=value ...]: 3 curves at B1=2000 on the stand-in
+	rm -f "$DIR/factor.log" "$DIR/trace"
+	N=$1
+	shift
+	(cd "$DIR" && echo "$N" | env ECM_STANDIN_LOG="$DIR/trace" "$@" \
+		"$YAFU" "ecm(@,3)" -ecm_path "$STANDIN" -ext_ecm 1000 -B1ecm 2000 \
+		> "$DIR/out" 2>&1)
+}
+
+check_factor()
+{
+	# check_factor <name> <factor> <step>: the logged sigma and step must
+	# be the ones of the stand-in's curve that found the factor
+	LOGGED=`sed -n "s/.*= $2 (curve [0-9]* stg\([0-9]\) B1=[0-9]* sigma=\([0-9]*\).*/\2 \1/p" "$DIR/factor.log"`
+	FOUND=`grep " $3\$" "$DIR/trace" | head -1`
+	if [ -z "$LOGGED" ] || [ "$LOGGED" != "$FOUND" ]; then
+		echo "FAIL $1: logged '$LOGGED', stand-in found '$FOUND'"
+		FAIL=1
+	else
+		echo "ok   $1: sigma and step $LOGGED"
+	fi
+}
+
+run $N1
+check_factor "step 1 factor" $P1 1
+
+run $N2
+check_factor "step 2 factor" $P2 2
+
+run $N2 ECM_STANDIN_LATE=200
+check_factor "late step 2 factor" $P2 2
+
+# the worker dies on its second input; the third curve goes through
+# system() instead
+run $C77 ECM_STANDIN_DIE=1
+if grep "exited with status 3" "$DIR/out" > /dev/null &&
+	grep "Finished 2 curves" "$DIR/factor.log" > /dev/null; then
+	echo "ok   lost curve: not counted"
+else
+	echo "FAIL lost curve:"
+	grep "exited\|Finished" "$DIR/out" "$DIR/factor.log"
+	FAIL=1
+fi
+
+exit $FAIL
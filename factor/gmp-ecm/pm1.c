@@ -27,17 +27,6 @@ code to the public domain.
 #include <ecm.h>
 
 
-// these are used by the top level function, so both YAFU and GMP-ECM
-// paths must use these prototypes
-void pm1_init(fact_obj_t *fobj);
-void pm1_finalize(fact_obj_t *fobj);
-void pm1exit(int sig);
-int pm1_wrapper(fact_obj_t *fobj);
-void pm1_print_B1_B2(fact_obj_t *fobj, FILE *flog);
-
-
-uint64 TMP_STG2_MAX;
-
 typedef struct
 {
 	mpz_t gmp_n, gmp_factor;
@@ -47,56 +36,69 @@ typedef struct
 
 } ecm_pm1_data_t;
 
-ecm_pm1_data_t pm1_data;
+// these are used by the top level function, so both YAFU and GMP-ECM
+// paths must use these prototypes
+void pm1_init(fact_obj_t *fobj, ecm_pm1_data_t *pm1_data);
+void pm1_finalize(fact_obj_t *fobj, ecm_pm1_data_t *pm1_data);
+void pm1exit(int sig);
+int pm1_wrapper(fact_obj_t *fobj, ecm_pm1_data_t *pm1_data);
+int pm1_wrapper_threaded(fact_obj_t *fobj, ecm_pm1_data_t *pm1_data);
+void pm1_print_B1_B2(fact_obj_t *fobj, FILE *flog);
 
-void pm1_init(fact_obj_t *fobj)
+void pm1_init(fact_obj_t *fobj, ecm_pm1_data_t *pm1_data)
 {
-	mpz_init(pm1_data.gmp_n);
-	mpz_init(pm1_data.gmp_factor);
-	ecm_init(pm1_data.params);
-	//gmp_randseed_ui(tdata->params->rng, 
+	mpz_init(pm1_data->gmp_n);
+	mpz_init(pm1_data->gmp_factor);
+	ecm_init(pm1_data->params);
+	//gmp_randseed_ui(tdata->params->rng, 
 	//	get_rand(&obj->seed1, &obj->seed2));
 
-	pm1_data.params->method = ECM_PM1;
-	//pm1_data.params->verbose = 1;
-
-	TMP_STG2_MAX = fobj->pm1_obj.B2;
+	pm1_data->params->method = ECM_PM1;
+	pm1_data->params->stop_asap = &ecm_stop_asap;
+	//pm1_data->params->verbose = 1;
 
 	return;
 }
 
-void pm1_finalize(fact_obj_t *fobj)
+void pm1_finalize(fact_obj_t *fobj, ecm_pm1_data_t *pm1_data)
 {
-	ecm_clear(pm1_data.params);
-	mpz_clear(pm1_data.gmp_n);
-	mpz_clear(pm1_data.gmp_factor);
-
-	fobj->pm1_obj.B2 = TMP_STG2_MAX;
+	ecm_clear(pm1_data->params);
+	mpz_clear(pm1_data->gmp_n);
+	mpz_clear(pm1_data->gmp_factor);
 	
 	return;
 }
 
-int pm1_wrapper(fact_obj_t *fobj)
+int pm1_wrapper(fact_obj_t *fobj, ecm_pm1_data_t *pm1_data)
 {
 	int status;
+	struct timeval tstart, tstop;
+	TIME_DIFF *	difference;
 
-	mpz_set(pm1_data.gmp_n, fobj->pm1_obj.gmp_n);
+	mpz_set(pm1_data->gmp_n, fobj->pm1_obj.gmp_n);
+
+	pm1_data->params->B1done = 1.0 + floor (1 * 128.) / 134217728.;
+	if (VFLAG >= 3)
+		pm1_data->params->verbose = VFLAG - 2;		
+
+	if (fobj->pm1_obj.stg2_is_default == 0)
+	{
+		//not default, tell gmp-ecm to use the requested B2
+		//printf("using requested B2 value\n");
+		uint64_2gmp(fobj->pm1_obj.B2, pm1_data->params->B2);
+	}
 
-	pm1_data.params->B1done = 1.0 + floor (1 * 128.) / 134217728.;
-	if (VFLAG >= 3)
-		pm1_data.params->verbose = VFLAG - 2;		
-
-	if (fobj->pm1_obj.stg2_is_default == 0)
-	{
-		//not default, tell gmp-ecm to use the requested B2
-		//printf("using requested B2 value\n");
-		uint64_2gmp(fobj->pm1_obj.B2, pm1_data.params->B2);
-	}
-
-	status = ecm_factor(pm1_data.gmp_factor, pm1_data.gmp_n,
-			fobj->pm1_obj.B1, pm1_data.params);
+	gettimeofday(&tstart, NULL);
+	ecm_stop = fobj->stop;
+	status = ecm_factor(pm1_data->gmp_factor, pm1_data->gmp_n,
+			fobj->pm1_obj.B1, pm1_data->params);
+	ecm_stop = NULL;
+	gettimeofday(&tstop, NULL);
+	difference = my_difftime(&tstart, &tstop);
+	fobj->pm1_obj.ttime = ((double)difference->secs + (double)difference->usecs / 1000000);
+	free(difference);
 
-	mpz_set(fobj->pm1_obj.gmp_n, pm1_data.gmp_n);
+	mpz_set(fobj->pm1_obj.gmp_n, pm1_data->gmp_n);
 
 	//NOTE: this required a modification to the GMP-ECM source code in pp1.c
 	//in order to get the automatically computed B2 value out of the
@@ -104,14 +106,222 @@ int pm1_wrapper(fact_obj_t *fobj)
 	//gmp2mp(pp1_data.params->B2,f);
 	//WILL_STG2_MAX = z264(f);
 
-	mpz_set(fobj->pm1_obj.gmp_f, pm1_data.gmp_factor);
+	mpz_set(fobj->pm1_obj.gmp_f, pm1_data->gmp_factor);
 
 	//the return value is the stage the factor was found in, if no error
-	pm1_data.stagefound = status;
+	pm1_data->stagefound = status;
 
 	return status;
 }
 
+// p-1 stage 2 is split over threads once B1 is large enough for the
+// per-thread stage 2 setup to be noise
+#define PM1_THREADED_MIN_B1 1000000
+
+// one thread's share of a split stage 2
+typedef struct
+{
+	fact_obj_t *fobj;
+	ecm_pm1_data_t data;
+	mpz_t x;			// stage 1 residue
+	mpz_t B2min, B2;	// this thread's subrange
+	volatile int *stop;	// shared by the threads of one call
+	int status;
+	double t_time;
+
+#if defined(WIN32) || defined(_WIN64)
+	HANDLE thread_id;
+#else
+	pthread_t thread_id;
+#endif
+
+} pm1_stg2_thread_t;
+
+// gmp-ecm's stop_asap callback takes no arguments, so each stage 2
+// thread points this at the stop flag of the call it is working for
+static THREAD_LOCAL volatile int *pm1_stop = NULL;
+
+static int pm1_stop_asap(void)
+{
+	// polled by gmp-ecm: stop on a request from factor() or once
+	// another thread's subrange has turned up a factor
+	return (ecm_stop_asap() || ((pm1_stop != NULL) && *pm1_stop));
+}
+
+#if defined(WIN32) || defined(_WIN64)
+DWORD WINAPI pm1_stg2_worker(LPVOID thread_data) {
+#else
+void *pm1_stg2_worker(void *thread_data) {
+#endif
+	pm1_stg2_thread_t *t = (pm1_stg2_thread_t *)thread_data;
+	struct timeval tstart, tstop;
+	TIME_DIFF *	difference;
+
+	gettimeofday(&tstart, NULL);
+	pm1_stop = t->stop;
+	ecm_stop = t->fobj->stop;
+
+	// stage 1 is already done, so gmp-ecm goes straight to stage 2 
+	// from the residue, over [B2min, B2]
+	t->data.params->B1done = (double)t->fobj->pm1_obj.B1;
+	mpz_set(t->data.params->x, t->x);
+	mpz_set(t->data.params->B2min, t->B2min);
+	mpz_set(t->data.params->B2, t->B2);
+	t->data.params->stop_asap = &pm1_stop_asap;
+
+	t->status = ecm_factor(t->data.gmp_factor, t->data.gmp_n,
+		(double)t->fobj->pm1_obj.B1, t->data.params);
+
+	if (t->status > 0)
+		*t->stop = 1;
+	pm1_stop = NULL;
+	ecm_stop = NULL;
+
+	gettimeofday(&tstop, NULL);
+	difference = my_difftime(&tstart, &tstop);
+	t->t_time = ((double)difference->secs + (double)difference->usecs / 1000000);
+	free(difference);
+
+#if defined(WIN32) || defined(_WIN64)
+	return 0;
+#else
+	return NULL;
+#endif
+}
+
+int pm1_wrapper_threaded(fact_obj_t *fobj, ecm_pm1_data_t *pm1_data)
+{
+	// stage 1 on this thread, then stage 2 over disjoint subranges of 
+	// [B1, B2], one per thread.
+	pm1_stg2_thread_t *threads;
+	int i, status, nthreads = fobj->num_threads;
+	struct timeval tstart, tstop;
+	TIME_DIFF *	difference;
+	mpz_t B2, width;
+	volatile int stop = 0;
+
+	mpz_init(B2);
+	mpz_init(width);
+
+	if (fobj->pm1_obj.stg2_is_default == 0)
+		uint64_2gmp(fobj->pm1_obj.B2, B2);
+	else
+	{
+		// the same default gmp-ecm picks for its fast p-1 stage 2:
+		// (B1 * cost)^exponent with cost 1/6 and exponent 1.7
+		mpz_set_d(B2, pow((double)fobj->pm1_obj.B1 / 6.0, 1.7));
+	}
+
+	mpz_set(pm1_data->gmp_n, fobj->pm1_obj.gmp_n);
+	pm1_data->params->B1done = 1.0 + floor (1 * 128.) / 134217728.;
+	if (VFLAG >= 3)
+		pm1_data->params->verbose = VFLAG - 2;
+
+	// stage 1 only: a B2 below B2min (which defaults to B1) skips stage 2
+	mpz_set_ui(pm1_data->params->B2, 1);
+
+	gettimeofday(&tstart, NULL);
+	ecm_stop = fobj->stop;
+	status = ecm_factor(pm1_data->gmp_factor, pm1_data->gmp_n,
+			fobj->pm1_obj.B1, pm1_data->params);
+	ecm_stop = NULL;
+	gettimeofday(&tstop, NULL);
+	difference = my_difftime(&tstart, &tstop);
+	fobj->pm1_obj.ttime = ((double)difference->secs + (double)difference->usecs / 1000000);
+	free(difference);
+
+	if ((status > 0) || *fobj->stop || fobj_aborted(fobj) ||
+		(mpz_cmp_ui(B2, fobj->pm1_obj.B1) <= 0))
+	{
+		mpz_set(fobj->pm1_obj.gmp_f, pm1_data->gmp_factor);
+		pm1_data->stagefound = status;
+		mpz_clear(B2);
+		mpz_clear(width);
+		return status;
+	}
+
+	if (VFLAG > 0)
+		gmp_printf("pm1: splitting stage 2 up to B2 = %Zd over %d threads\n", B2, nthreads);
+
+	// equal subranges; the last one absorbs the rounding
+	mpz_sub_ui(width, B2, fobj->pm1_obj.B1);
+	mpz_tdiv_q_ui(width, width, nthreads);
+
+	threads = (pm1_stg2_thread_t *)malloc(nthreads * sizeof(pm1_stg2_thread_t));
+	for (i = 0; i < nthreads; i++)
+	{
+		pm1_stg2_thread_t *t = &threads[i];
+
+		t->fobj = fobj;
+		t->stop = &stop;
+		t->status = 0;
+		t->t_time = 0;
+		pm1_init(fobj, &t->data);
+		if (VFLAG >= 3)
+			t->data.params->verbose = VFLAG - 2;
+		mpz_set(t->data.gmp_n, fobj->pm1_obj.gmp_n);
+		mpz_init_set(t->x, pm1_data->params->x);
+		mpz_init(t->B2min);
+		mpz_init(t->B2);
+
+		mpz_mul_ui(t->B2min, width, i);
+		mpz_add_ui(t->B2min, t->B2min, fobj->pm1_obj.B1);
+		if (i == nthreads - 1)
+			mpz_set(t->B2, B2);
+		else
+		{
+			mpz_add(t->B2, t->B2min, width);
+			mpz_sub_ui(t->B2, t->B2, 1);
+		}
+	}
+
+	// the main thread takes the first subrange itself
+	for (i = 1; i < nthreads; i++)
+	{
+#if defined(WIN32) || defined(_WIN64)
+		threads[i].thread_id = CreateThread(NULL, 0, pm1_stg2_worker, &threads[i], 0, NULL);
+#else
+		pthread_create(&threads[i].thread_id, NULL, pm1_stg2_worker, &threads[i]);
+#endif
+	}
+
+	pm1_stg2_worker(&threads[0]);
+
+	for (i = 1; i < nthreads; i++)
+	{
+#if defined(WIN32) || defined(_WIN64)
+		WaitForSingleObject(threads[i].thread_id, INFINITE);
+		CloseHandle(threads[i].thread_id);
+#else
+		pthread_join(threads[i].thread_id, NULL);
+#endif
+	}
+
+	// report the first subrange that found something
+	mpz_set_ui(fobj->pm1_obj.gmp_f, 0);
+	pm1_data->stagefound = 0;
+	for (i = 0; i < nthreads; i++)
+	{
+		pm1_stg2_thread_t *t = &threads[i];
+
+		fobj->pm1_obj.ttime += t->t_time;
+		if ((t->status > 0) && (pm1_data->stagefound == 0))
+		{
+			mpz_set(fobj->pm1_obj.gmp_f, t->data.gmp_factor);
+			pm1_data->stagefound = t->status;
+		}
+
+		mpz_clear(t->x);
+		mpz_clear(t->B2min);
+		mpz_clear(t->B2);
+		pm1_finalize(fobj, &t->data);
+	}
+	free(threads);
+
+	mpz_clear(B2);
+	mpz_clear(width);
+	return pm1_data->stagefound;
+}
 
 // top level routine: the only one visible to the rest of the program
 void pollard_loop(fact_obj_t *fobj)
@@ -123,6 +333,7 @@ void pollard_loop(fact_obj_t *fobj)
 	FILE *flog;
 	clock_t start, stop;
 	double tt;
+	ecm_pm1_data_t pm1_data;
 		
 	//check for trivial cases
 	if ((mpz_cmp_ui(fobj->pm1_obj.gmp_n, 1) == 0) || (mpz_cmp_ui(fobj->pm1_obj.gmp_n, 0) == 0))
@@ -158,17 +369,24 @@ void pollard_loop(fact_obj_t *fobj)
 
 	//initialize the flag to watch for interrupts, and set the
 	//pointer to the function to call if we see a user interrupt
-	PM1_ABORT = 0;
-	signal(SIGINT,pm1exit);
+	//(a helper thread in factor()'s portfolio mode leaves this to the main thread)
+	if (!fobj->autofact_obj.portfolio_helper)
+	{
+		fobj_watch_sigint(fobj);
+		signal(SIGINT,pm1exit);
+	}
 
 	//initialize some local args
 	mpz_init(d);
 	mpz_init(t);	
 
-	pm1_init(fobj);
+	pm1_init(fobj, &pm1_data);
 		
 	pm1_print_B1_B2(fobj,flog);
-	pm1_wrapper(fobj);
+	if ((fobj->num_threads > 1) && (fobj->pm1_obj.B1 >= PM1_THREADED_MIN_B1))
+		pm1_wrapper_threaded(fobj, &pm1_data);
+	else
+		pm1_wrapper(fobj, &pm1_data);
 		
 	//check to see if 'f' is non-trivial
 	if ((mpz_cmp_ui(fobj->pm1_obj.gmp_f, 1) > 0)
@@ -210,16 +428,17 @@ void pollard_loop(fact_obj_t *fobj)
 
 	fclose(flog);
 
-	pm1_finalize(fobj);
+	pm1_finalize(fobj, &pm1_data);
 
 	//watch for an abort
-	if (PM1_ABORT)
+	if (fobj_aborted(fobj))
 	{
 		print_factors(fobj);
 		exit(1);
 	}
 
-	signal(SIGINT,NULL);
+	if (!fobj->autofact_obj.portfolio_helper)
+		signal(SIGINT,NULL);
 	mpz_clear(d);
 	mpz_clear(t);
 
@@ -297,7 +516,7 @@ void pm1_print_B1_B2(fact_obj_t *fobj, FILE *flog)
 void pm1exit(int sig)
 {
 	printf("\nAborting...\n");
-	PM1_ABORT = 1;
+	SIGINT_COUNT++;
 	return;
 }
 
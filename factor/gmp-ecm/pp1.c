@@ -26,15 +26,6 @@ code to the public domain.
 #include <gmp_xface.h>
 #include <ecm.h>
 
-// these are used by the top level function, so both YAFU and GMP-ECM
-// paths must use these prototypes
-void pp1_init(fact_obj_t *fobj);
-void pp1_finalize(fact_obj_t *fobj);
-void pp1_print_B1_B2(fact_obj_t *fobj, FILE *flog);
-int pp1_wrapper(fact_obj_t *fobj);
-void pp1exit(int sig);
-uint64 TMP_STG2_MAX;
-
 typedef struct
 {
 	mpz_t gmp_n, gmp_factor;
@@ -44,76 +35,277 @@ typedef struct
 
 } ecm_pp1_data_t;
 
-ecm_pp1_data_t pp1_data;
+// these are used by the top level function, so both YAFU and GMP-ECM
+// paths must use these prototypes
+void pp1_init(fact_obj_t *fobj, ecm_pp1_data_t *pp1_data);
+void pp1_finalize(fact_obj_t *fobj, ecm_pp1_data_t *pp1_data);
+void pp1_print_B1_B2(fact_obj_t *fobj, FILE *flog);
+int pp1_wrapper(fact_obj_t *fobj, ecm_pp1_data_t *pp1_data);
+int pp1_seeds_threaded(fact_obj_t *fobj, FILE *flog, int nseeds);
+void pp1_report_factor(fact_obj_t *fobj, FILE *flog);
+void pp1exit(int sig);
 
-void pp1_init(fact_obj_t *fobj)
+void pp1_init(fact_obj_t *fobj, ecm_pp1_data_t *pp1_data)
 {
-	mpz_init(pp1_data.gmp_n);
-	mpz_init(pp1_data.gmp_factor);
-	ecm_init(pp1_data.params);
+	mpz_init(pp1_data->gmp_n);
+	mpz_init(pp1_data->gmp_factor);
+	ecm_init(pp1_data->params);
 	//gmp_randseed_ui(tdata->params->rng, 
 	//	get_rand(&obj->seed1, &obj->seed2));
 
-	pp1_data.params->method = ECM_PP1;
+	pp1_data->params->method = ECM_PP1;
+	pp1_data->params->stop_asap = &ecm_stop_asap;
 	//pp1_data.params->verbose = 1;
 
-	TMP_STG2_MAX = fobj->pp1_obj.B2; //WILL_STG2_MAX;
-
-	PP1_ABORT = 0;
-	signal(SIGINT,pp1exit);
+	if (!fobj->autofact_obj.portfolio_helper)
+		signal(SIGINT,pp1exit);
 
 	return;
 }
 
-void pp1_finalize(fact_obj_t *fobj)
+void pp1_finalize(fact_obj_t *fobj, ecm_pp1_data_t *pp1_data)
 {
-	ecm_clear(pp1_data.params);
-	mpz_clear(pp1_data.gmp_n);
-	mpz_clear(pp1_data.gmp_factor);
+	ecm_clear(pp1_data->params);
+	mpz_clear(pp1_data->gmp_n);
+	mpz_clear(pp1_data->gmp_factor);
 
-	//WILL_STG2_MAX = TMP_STG2_MAX;
-	fobj->pp1_obj.B2 = TMP_STG2_MAX;
-	signal(SIGINT,NULL);
+	if (!fobj->autofact_obj.portfolio_helper)
+		signal(SIGINT,NULL);
 
 	return;
 }
 
-int pp1_wrapper(fact_obj_t *fobj)
+int pp1_wrapper(fact_obj_t *fobj, ecm_pp1_data_t *pp1_data)
 {
 	int status;
+	struct timeval tstart, tstop;
+	TIME_DIFF *	difference;
 
-	mpz_set(pp1_data.gmp_n, fobj->pp1_obj.gmp_n);
+	mpz_set(pp1_data->gmp_n, fobj->pp1_obj.gmp_n);
 
-	pp1_data.params->B1done = 1.0 + floor (1 * 128.) / 134217728.;
+	pp1_data->params->B1done = 1.0 + floor (1 * 128.) / 134217728.;
 	if (VFLAG >= 3)
-		pp1_data.params->verbose = VFLAG - 2;		
+		pp1_data->params->verbose = VFLAG - 2;		
 
 	if (fobj->pp1_obj.stg2_is_default == 0)
 	{
 		//not default, tell gmp-ecm to use the requested B2
 		//printf("using requested B2 value\n");
-		uint64_2gmp(fobj->pp1_obj.B2, pp1_data.params->B2);
+		uint64_2gmp(fobj->pp1_obj.B2, pp1_data->params->B2);
 	}
 
-	status = ecm_factor(pp1_data.gmp_factor, pp1_data.gmp_n,
-			fobj->pp1_obj.B1, pp1_data.params);
-
-	mpz_set(fobj->pp1_obj.gmp_n, pp1_data.gmp_n);
+	gettimeofday(&tstart, NULL);
+	ecm_stop = fobj->stop;
+	status = ecm_factor(pp1_data->gmp_factor, pp1_data->gmp_n,
+			fobj->pp1_obj.B1, pp1_data->params);
+	ecm_stop = NULL;
+	gettimeofday(&tstop, NULL);
+	difference = my_difftime(&tstart, &tstop);
+	fobj->pp1_obj.ttime += ((double)difference->secs + (double)difference->usecs / 1000000);
+	free(difference);
+
+	mpz_set(fobj->pp1_obj.gmp_n, pp1_data->gmp_n);
 
 	//NOTE: this required a modification to the GMP-ECM source code in pp1.c
 	//in order to get the automatically computed B2 value out of the
 	//library
-	//gmp2mp(pp1_data.params->B2,f);
+	//gmp2mp(pp1_data->params->B2,f);
 	//WILL_STG2_MAX = z264(f);
 
-	mpz_set(fobj->pp1_obj.gmp_f, pp1_data.gmp_factor);
+	mpz_set(fobj->pp1_obj.gmp_f, pp1_data->gmp_factor);
 
 	//the return value is the stage the factor was found in, if no error
-	pp1_data.stagefound = status;
+	pp1_data->stagefound = status;
 
 	return status;
 }
 
+// one concurrently running p+1 seed
+typedef struct
+{
+	fact_obj_t *fobj;
+	ecm_pp1_data_t data;
+	uint32 base;
+	volatile int *stop;	// shared by the seeds of one call
+	int status;
+	double t_time;
+
+#if defined(WIN32) || defined(_WIN64)
+	HANDLE thread_id;
+#else
+	pthread_t thread_id;
+#endif
+
+} pp1_seed_thread_t;
+
+// gmp-ecm's stop_asap callback takes no arguments, so each seed 
+// thread points this at the stop flag of the call it is working for
+static THREAD_LOCAL volatile int *pp1_stop = NULL;
+
+static int pp1_stop_asap(void)
+{
+	// polled by gmp-ecm: stop on a request from factor() or once
+	// another seed has turned up a factor
+	return (ecm_stop_asap() || ((pp1_stop != NULL) && *pp1_stop));
+}
+
+#if defined(WIN32) || defined(_WIN64)
+DWORD WINAPI pp1_seed_worker(LPVOID thread_data) {
+#else
+void *pp1_seed_worker(void *thread_data) {
+#endif
+	pp1_seed_thread_t *t = (pp1_seed_thread_t *)thread_data;
+	struct timeval tstart, tstop;
+	TIME_DIFF *	difference;
+
+	gettimeofday(&tstart, NULL);
+	pp1_stop = t->stop;
+	ecm_stop = t->fobj->stop;
+
+	t->status = ecm_factor(t->data.gmp_factor, t->data.gmp_n,
+		(double)t->fobj->pp1_obj.B1, t->data.params);
+
+	if (t->status > 0)
+		*t->stop = 1;
+	pp1_stop = NULL;
+	ecm_stop = NULL;
+
+	gettimeofday(&tstop, NULL);
+	difference = my_difftime(&tstart, &tstop);
+	t->t_time = ((double)difference->secs + (double)difference->usecs / 1000000);
+	free(difference);
+
+#if defined(WIN32) || defined(_WIN64)
+	return 0;
+#else
+	return NULL;
+#endif
+}
+
+int pp1_seeds_threaded(fact_obj_t *fobj, FILE *flog, int nseeds)
+{
+	// run nseeds p+1 curves with different random bases at once, one 
+	// per thread.  returns the number of factors recorded.
+	pp1_seed_thread_t *threads;
+	int i, found = 0;
+	volatile int stop = 0;
+
+	if (nseeds < 1)
+		return 0;
+
+	threads = (pp1_seed_thread_t *)malloc(nseeds * sizeof(pp1_seed_thread_t));
+	for (i = 0; i < nseeds; i++)
+	{
+		pp1_seed_thread_t *t = &threads[i];
+
+		t->fobj = fobj;
+		t->stop = &stop;
+		t->status = 0;
+		t->t_time = 0;
+
+		// spRand isn't thread safe, so pick the bases here
+		t->base = spRand(3,MAX_DIGIT);
+		pp1_init(fobj, &t->data);
+		mpz_set(t->data.gmp_n, fobj->pp1_obj.gmp_n);
+		mpz_set_ui(t->data.params->x, t->base);
+		t->data.params->B1done = 1.0 + floor (1 * 128.) / 134217728.;
+		t->data.params->stop_asap = &pp1_stop_asap;
+		if (VFLAG >= 3)
+			t->data.params->verbose = VFLAG - 2;
+		if (fobj->pp1_obj.stg2_is_default == 0)
+			uint64_2gmp(fobj->pp1_obj.B2, t->data.params->B2);
+	}
+	fobj->pp1_obj.base = threads[nseeds - 1].base;
+
+	if (VFLAG > 0)
+		printf("pp1: running %d seeds concurrently\n", nseeds);
+
+	// the main thread runs the first seed itself
+	for (i = 1; i < nseeds; i++)
+	{
+#if defined(WIN32) || defined(_WIN64)
+		threads[i].thread_id = CreateThread(NULL, 0, pp1_seed_worker, &threads[i], 0, NULL);
+#else
+		pthread_create(&threads[i].thread_id, NULL, pp1_seed_worker, &threads[i]);
+#endif
+	}
+
+	pp1_seed_worker(&threads[0]);
+
+	for (i = 1; i < nseeds; i++)
+	{
+#if defined(WIN32) || defined(_WIN64)
+		WaitForSingleObject(threads[i].thread_id, INFINITE);
+		CloseHandle(threads[i].thread_id);
+#else
+		pthread_join(threads[i].thread_id, NULL);
+#endif
+	}
+
+	// different seeds can find different factors, so record everything
+	// that still divides what's left of the input
+	for (i = 0; i < nseeds; i++)
+	{
+		pp1_seed_thread_t *t = &threads[i];
+
+		fobj->pp1_obj.ttime += t->t_time;
+		if (t->status > 0)
+		{
+			mpz_gcd(fobj->pp1_obj.gmp_f, t->data.gmp_factor, fobj->pp1_obj.gmp_n);
+			if ((mpz_cmp_ui(fobj->pp1_obj.gmp_f, 1) > 0)
+				&& (mpz_cmp(fobj->pp1_obj.gmp_f, fobj->pp1_obj.gmp_n) < 0))
+			{
+				pp1_report_factor(fobj, flog);
+				found++;
+			}
+		}
+
+		pp1_finalize(fobj, &t->data);
+	}
+	free(threads);
+
+	// pp1_finalize resets the handler
+	if (!fobj->autofact_obj.portfolio_helper)
+		signal(SIGINT,pp1exit);
+
+	return found;
+}
+
+void pp1_report_factor(fact_obj_t *fobj, FILE *flog)
+{
+	// record the non-trivial factor in pp1_obj.gmp_f and divide it out
+	//check if the factor is prime
+	if (is_mpz_prp(fobj->pp1_obj.gmp_f))
+	{
+		add_to_factor_list(fobj, fobj->pp1_obj.gmp_f);
+
+		if (VFLAG > 0)
+			gmp_printf("pp1: found prp%d factor = %Zd\n",
+			gmp_base10(fobj->pp1_obj.gmp_f),fobj->pp1_obj.gmp_f);
+
+		logprint(flog,"prp%d = %s\n",
+			gmp_base10(fobj->pp1_obj.gmp_f),
+			mpz_conv2str(&gstr1.s, 10, fobj->pp1_obj.gmp_f));
+	}
+	else
+	{
+		add_to_factor_list(fobj, fobj->pp1_obj.gmp_f);
+
+		if (VFLAG > 0)
+			gmp_printf("pp1: found c%d factor = %Zd\n",
+			gmp_base10(fobj->pp1_obj.gmp_f),fobj->pp1_obj.gmp_f);
+
+		logprint(flog,"c%d = %s\n",
+			gmp_base10(fobj->pp1_obj.gmp_f),
+			mpz_conv2str(&gstr1.s, 10, fobj->pp1_obj.gmp_f));
+	}
+
+	//reduce input
+	mpz_tdiv_q(fobj->pp1_obj.gmp_n, fobj->pp1_obj.gmp_n, fobj->pp1_obj.gmp_f);
+
+	return;
+}
+
 void williams_loop(fact_obj_t *fobj)
 {
 	//use william's p+1 algorithm 'trials' times on n.
@@ -125,6 +317,7 @@ void williams_loop(fact_obj_t *fobj)
 	FILE *flog;
 	clock_t start, stop;
 	double tt;
+	ecm_pp1_data_t pp1_data;
 		
 	//check for trivial cases
 	if ((mpz_cmp_ui(fobj->pp1_obj.gmp_n, 1) == 0) || (mpz_cmp_ui(fobj->pp1_obj.gmp_n, 0) == 0))
@@ -144,25 +337,34 @@ void williams_loop(fact_obj_t *fobj)
 
 	//initialize the flag to watch for interrupts, and set the
 	//pointer to the function to call if we see a user interrupt
-	PP1_ABORT = 0;
-	signal(SIGINT,pp1exit);
+	//(a helper thread in factor()'s portfolio mode leaves this to the main thread)
+	if (!fobj->autofact_obj.portfolio_helper)
+	{
+		fobj_watch_sigint(fobj);
+		signal(SIGINT,pp1exit);
+	}
 
 	//initialize some local args
 	mpz_init(d);
 	mpz_init(t);	
 
-	pp1_init(fobj);
+	pp1_init(fobj, &pp1_data);
+	fobj->pp1_obj.ttime = 0;
 
 	i=0;
 	while (i < trials)
 	{
 		//watch for an abort
-		if (PP1_ABORT)
+		if (fobj_aborted(fobj))
 		{
 			print_factors(fobj);
 			exit(1);
 		}
 
+		//or for a request to stop from concurrent work in factor()
+		if (*fobj->stop)
+			break;
+
 		start = clock();
 		if (is_mpz_prp(fobj->pp1_obj.gmp_n))
 		{
@@ -176,12 +378,25 @@ void williams_loop(fact_obj_t *fobj)
 			mpz_set_ui(fobj->pp1_obj.gmp_n, 1);
 			break;
 		}
+
+		//with threads to spare, run the remaining seeds in batches
+		if ((fobj->num_threads > 1) && ((trials - i) > 1))
+		{
+			int nseeds = MIN(fobj->num_threads, trials - i);
+
+			pp1_print_B1_B2(fobj,flog);
+			it = pp1_seeds_threaded(fobj, flog, nseeds);
+			i += nseeds;
+			if (it > 0)
+				break;
+			continue;
+		}
 		
 		fobj->pp1_obj.base = spRand(3,MAX_DIGIT);
 
 		pp1_print_B1_B2(fobj,flog);
 
-		it = pp1_wrapper(fobj);
+		it = pp1_wrapper(fobj, &pp1_data);
 		
 		//check to see if 'f' is non-trivial
 		if ((mpz_cmp_ui(fobj->pp1_obj.gmp_f, 1) > 0)
@@ -191,36 +406,9 @@ void williams_loop(fact_obj_t *fobj)
 			stop = clock();
 			tt = (double)(stop - start)/(double)CLOCKS_PER_SEC;
 
-			//check if the factor is prime
-			if (is_mpz_prp(fobj->pp1_obj.gmp_f))
-			{
-				add_to_factor_list(fobj, fobj->pp1_obj.gmp_f);
-
-				if (VFLAG > 0)
-					gmp_printf("pp1: found prp%d factor = %Zd\n",
-					gmp_base10(fobj->pp1_obj.gmp_f),fobj->pp1_obj.gmp_f);
-
-				logprint(flog,"prp%d = %s\n",
-					gmp_base10(fobj->pp1_obj.gmp_f),
-					mpz_conv2str(&gstr1.s, 10, fobj->pp1_obj.gmp_f));
-			}
-			else
-			{
-				add_to_factor_list(fobj, fobj->pp1_obj.gmp_f);
-
-				if (VFLAG > 0)
-					gmp_printf("pp1: found c%d factor = %Zd\n",
-					gmp_base10(fobj->pp1_obj.gmp_f),fobj->pp1_obj.gmp_f);
-
-				logprint(flog,"c%d = %s\n",
-					gmp_base10(fobj->pp1_obj.gmp_f),
-					mpz_conv2str(&gstr1.s, 10, fobj->pp1_obj.gmp_f));
-			}
+			pp1_report_factor(fobj, flog);
 			start = clock();
 
-			//reduce input
-			mpz_tdiv_q(fobj->pp1_obj.gmp_n, fobj->pp1_obj.gmp_n, fobj->pp1_obj.gmp_f);
-
 			i++;
 			break;
 		}
@@ -230,8 +418,9 @@ void williams_loop(fact_obj_t *fobj)
 
 	fclose(flog);
 
-	pp1_finalize(fobj);
-	signal(SIGINT,NULL);
+	pp1_finalize(fobj, &pp1_data);
+	if (!fobj->autofact_obj.portfolio_helper)
+		signal(SIGINT,NULL);
 	mpz_clear(d);
 	mpz_clear(t);
 
@@ -309,7 +498,7 @@ void pp1_print_B1_B2(fact_obj_t *fobj, FILE *flog)
 void pp1exit(int sig)
 {
 	printf("\nAborting...\n");
-	PP1_ABORT = 1;
+	SIGINT_COUNT++;
 	return;
 }
 
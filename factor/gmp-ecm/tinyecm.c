@@ -0,0 +1,662 @@
+/*----------------------------------------------------------------------
+This source distribution is placed in the public domain by its author,
+Ben Buhrow. You may use it for any purpose, free of charge,
+without having to notify anyone. I disclaim any responsibility for any
+errors.
+
+Optionally, please be nice and tell me if you find this source to be
+useful. Again optionally, if you add to the functionality present here
+please consider making those additions public too, so that others may
+benefit from your work.
+
+Some parts of the code (and also this header), included in this
+distribution have been reused from other sources. In particular I
+have benefitted greatly from the work of Jason Papadopoulos's msieve @
+www.boo.net/~jasonp, Scott Contini's mpqs implementation, and Tom St.
+Denis Tom's Fast Math library.  Many thanks to their kind donation of
+code to the public domain.
+       				   --bbuhrow@gmail.com 12/6/2012
+----------------------------------------------------------------------*/
+
+#include "yafu_ecm.h"
+#include "factor.h"
+#include "yafu.h"
+#include "soe.h"
+
+/*
+a native ecm for small inputs.  gmp-ecm spends much of each curve on setup
+that only pays off for large numbers and large B2, and the library isn't
+thread safe.  here every curve uses fixed width montgomery arithmetic on
+a few limbs (the reduction is the same word-by-word loop as tfm's
+fp_montgomery_reduce_small, on top of gmp's mpn layer) with Montgomery
+curves in Suyama's parameterization, so a factor reported with sigma s can
+be reproduced with gmp-ecm -sigma s.  stage 1 is a single ladder over the
+precomputed product of all prime powers <= B1, stage 2 is a baby-step
+giant-step standard continuation.  the stage 1 exponent and the stage 2 
+prime pairing are computed once per B1/B2 by ecm_process_init, kept in
+the ecm_obj of the run, and shared by all of its threads.
+*/
+
+// residue slots in a tinyecm_t, followed by 3 per baby step point
+enum tecm_slots {
+	T_A24, T_XP, T_ONE,
+	T_T1, T_T2, T_T3, T_T4,
+	T_L0X, T_L0Z, T_L1X, T_L1Z,
+	T_XQ, T_ZQ, T_XQ2, T_ZQ2,
+	T_XR0, T_ZR0, T_XR1, T_ZR1,
+	T_XG, T_ZG, T_XC, T_ZC, T_XN, T_ZN, T_XW, T_ZW,
+	T_XZG, T_ACC,
+	T_NUMSLOTS
+};
+
+#define TECM_MAXBABY 240
+#define TECM_MAXLIMBS ((TINYECM_MAXBITS + GMP_LIMB_BITS - 1) / GMP_LIMB_BITS)
+
+// residue i of the tinyecm_t t in scope, and the baby step points
+#define RES(i) (t->r + (i) * TECM_MAXLIMBS)
+#define XB(i) RES(T_NUMSLOTS + (i))
+#define ZB(i) RES(T_NUMSLOTS + TECM_MAXBABY + (i))
+#define XZB(i) RES(T_NUMSLOTS + 2 * TECM_MAXBABY + (i))
+
+typedef struct tinyecm_plan
+{
+	uint32 B1;
+	uint64 B2;
+	mpz_t s;				//product of prime powers <= B1
+	int D;					//giant step size
+	int nbaby;				//number of j < D/2 with gcd(j,D) = 1
+	int *jidx;				//baby step index of each j < D/2, or -1
+	uint32 kstart;			//first and last giant steps
+	uint32 kend;
+	uint32 *pairs;			//bit (k-kstart)*nbaby+i set if k*D +/- j(i) is prime
+} tecm_plan_t;
+
+// primes for the stage 2 pairing are sieved this many at a time
+#define TECM_PAIR_RANGE (1 << 24)
+
+tinyecm_t *tinyecm_init(void)
+{
+	tinyecm_t *t;
+
+	t = (tinyecm_t *)malloc(sizeof(tinyecm_t));
+	t->nr = T_NUMSLOTS + 3 * TECM_MAXBABY;
+	t->r = (mp_limb_t *)calloc(t->nr * TECM_MAXLIMBS, sizeof(mp_limb_t));
+	t->n = (mp_limb_t *)calloc(TECM_MAXLIMBS, sizeof(mp_limb_t));
+	t->t = (mp_limb_t *)calloc(2 * TECM_MAXLIMBS + 2, sizeof(mp_limb_t));
+	t->nd = 1;
+
+	return t;
+}
+
+void tinyecm_free(tinyecm_t *t)
+{
+	if (t == NULL)
+		return;
+
+	free(t->r);
+	free(t->n);
+	free(t->t);
+	free(t);
+	return;
+}
+
+/********************* fixed width residue arithmetic **********************/
+// all residues are exactly nd limbs, reduced mod n, in montgomery
+// representation x*b^nd mod n.
+
+static void tecm_setup(tinyecm_t *t, mpz_t n)
+{
+	mp_limb_t inv;
+	int i;
+
+	t->nd = (int)mpz_size(n);
+	for (i = 0; i < t->nd; i++)
+		t->n[i] = mpz_getlimbn(n, i);
+
+	// newton iteration for 1/n mod b; each step doubles the correct bits
+	inv = t->n[0];
+	for (i = 0; i < 6; i++)
+		inv *= 2 - t->n[0] * inv;
+	t->rho = -inv;
+
+	return;
+}
+
+static void tecm_redc(tinyecm_t *t, mp_limb_t *c)
+{
+	// c = t/b^nd mod n, for the 2*nd limb product t
+	mp_limb_t *up = t->t;
+	mp_limb_t cy;
+	int i, nd = t->nd;
+
+	for (i = 0; i < nd; i++)
+	{
+		// the low limb becomes zero, store the carry out in its place
+		cy = mpn_addmul_1(up, t->n, nd, up[0] * t->rho);
+		up[0] = cy;
+		up++;
+	}
+
+	cy = mpn_add_n(c, up, up - nd, nd);
+	if (cy || (mpn_cmp(c, t->n, nd) >= 0))
+		mpn_sub_n(c, c, t->n, nd);
+
+	return;
+}
+
+static void tecm_mulmod(tinyecm_t *t, mp_limb_t *a, mp_limb_t *b, mp_limb_t *c)
+{
+	mpn_mul_n(t->t, a, b, t->nd);
+	tecm_redc(t, c);
+	return;
+}
+
+static void tecm_sqrmod(tinyecm_t *t, mp_limb_t *a, mp_limb_t *c)
+{
+	mpn_sqr(t->t, a, t->nd);
+	tecm_redc(t, c);
+	return;
+}
+
+static void tecm_addmod(tinyecm_t *t, mp_limb_t *a, mp_limb_t *b, mp_limb_t *c)
+{
+	if (mpn_add_n(c, a, b, t->nd) || (mpn_cmp(c, t->n, t->nd) >= 0))
+		mpn_sub_n(c, c, t->n, t->nd);
+	return;
+}
+
+static void tecm_submod(tinyecm_t *t, mp_limb_t *a, mp_limb_t *b, mp_limb_t *c)
+{
+	if (mpn_sub_n(c, a, b, t->nd))
+		mpn_add_n(c, c, t->n, t->nd);
+	return;
+}
+
+static void tecm_copy(tinyecm_t *t, mp_limb_t *a, mp_limb_t *b)
+{
+	memcpy(b, a, t->nd * sizeof(mp_limb_t));
+	return;
+}
+
+// a mod n into montgomery representation in r
+static void tecm_set(tinyecm_t *t, mp_limb_t *r, mpz_t a, mpz_t n, mpz_t tmp)
+{
+	int i;
+
+	mpz_mul_2exp(tmp, a, t->nd * GMP_LIMB_BITS);
+	mpz_mod(tmp, tmp, n);
+	for (i = 0; i < t->nd; i++)
+		r[i] = mpz_getlimbn(tmp, i);
+	return;
+}
+
+// gcd of a residue with n.  montgomery representation doesn't change it.
+static void tecm_gcd(tinyecm_t *t, mpz_t f, mp_limb_t *r, mpz_t n)
+{
+	mpz_import(f, t->nd, -1, sizeof(mp_limb_t), 0, 0, r);
+	mpz_gcd(f, f, n);
+	return;
+}
+
+/********************* Montgomery curve arithmetic **********************/
+
+// (Xo:Zo) = 2(X:Z)
+static void tecm_dbl(tinyecm_t *t, mp_limb_t *X, mp_limb_t *Z, 
+	mp_limb_t *Xo, mp_limb_t *Zo)
+{
+	tecm_addmod(t, X, Z, RES(T_T1));
+	tecm_sqrmod(t, RES(T_T1), RES(T_T1));
+	tecm_submod(t, X, Z, RES(T_T2));
+	tecm_sqrmod(t, RES(T_T2), RES(T_T2));
+	tecm_submod(t, RES(T_T1), RES(T_T2), RES(T_T3));
+	tecm_mulmod(t, RES(T_T1), RES(T_T2), Xo);
+	tecm_mulmod(t, RES(T_A24), RES(T_T3), RES(T_T1));
+	tecm_addmod(t, RES(T_T1), RES(T_T2), RES(T_T1));
+	tecm_mulmod(t, RES(T_T1), RES(T_T3), Zo);
+	return;
+}
+
+// (Xo:Zo) = (X1:Z1) + (X2:Z2), given their difference (Xd:Zd).  Zd == NULL
+// means the difference is normalized to Z = 1.  the output may overlap
+// any of the inputs.
+static void tecm_add(tinyecm_t *t, mp_limb_t *X1, mp_limb_t *Z1, 
+	mp_limb_t *X2, mp_limb_t *Z2, mp_limb_t *Xd, mp_limb_t *Zd, 
+	mp_limb_t *Xo, mp_limb_t *Zo)
+{
+	tecm_submod(t, X1, Z1, RES(T_T1));
+	tecm_addmod(t, X2, Z2, RES(T_T2));
+	tecm_mulmod(t, RES(T_T1), RES(T_T2), RES(T_T3));
+	tecm_addmod(t, X1, Z1, RES(T_T1));
+	tecm_submod(t, X2, Z2, RES(T_T2));
+	tecm_mulmod(t, RES(T_T1), RES(T_T2), RES(T_T4));
+	tecm_addmod(t, RES(T_T3), RES(T_T4), RES(T_T1));
+	tecm_submod(t, RES(T_T3), RES(T_T4), RES(T_T2));
+	tecm_sqrmod(t, RES(T_T1), RES(T_T1));
+	tecm_sqrmod(t, RES(T_T2), RES(T_T2));
+	if (Zd != NULL)
+		tecm_mulmod(t, RES(T_T1), Zd, RES(T_T1));
+	tecm_mulmod(t, RES(T_T2), Xd, Zo);
+	tecm_copy(t, RES(T_T1), Xo);
+	return;
+}
+
+// (Xo:Zo) = k(Xp:Zp) by the montgomery ladder.  returns 0 if
+// interrupted by a request to stop.
+static int tecm_ladder(tinyecm_t *t, mpz_t k, mp_limb_t *Xp, mp_limb_t *Zp, 
+	mp_limb_t *Xo, mp_limb_t *Zo)
+{
+	int i;
+
+	tecm_copy(t, Xp, RES(T_L0X));
+	if (Zp != NULL)
+		tecm_copy(t, Zp, RES(T_L0Z));
+	else
+		tecm_copy(t, RES(T_ONE), RES(T_L0Z));
+	tecm_dbl(t, RES(T_L0X), RES(T_L0Z), RES(T_L1X), RES(T_L1Z));
+
+	for (i = (int)mpz_sizeinbase(k, 2) - 2; i >= 0; i--)
+	{
+		if (mpz_tstbit(k, i))
+		{
+			tecm_add(t, RES(T_L0X), RES(T_L0Z), RES(T_L1X), RES(T_L1Z),
+				Xp, Zp, RES(T_L0X), RES(T_L0Z));
+			tecm_dbl(t, RES(T_L1X), RES(T_L1Z), RES(T_L1X), RES(T_L1Z));
+		}
+		else
+		{
+			tecm_add(t, RES(T_L0X), RES(T_L0Z), RES(T_L1X), RES(T_L1Z),
+				Xp, Zp, RES(T_L1X), RES(T_L1Z));
+			tecm_dbl(t, RES(T_L0X), RES(T_L0Z), RES(T_L0X), RES(T_L0Z));
+		}
+
+		if (((i & 4095) == 0) && ecm_stop_asap())
+			return 0;
+	}
+
+	tecm_copy(t, RES(T_L0X), Xo);
+	tecm_copy(t, RES(T_L0Z), Zo);
+	return 1;
+}
+
+/********************* per B1/B2 precomputation **********************/
+
+// gmp-ecm's default B2 at some of the usual B1's.  factor()'s curve 
+// counts and t-level credit are based on these.
+static const double tecm_gmpecm_B2[][2] = {
+	{2000., 147396.},
+	{11000., 1873422.},
+	{50000., 12746592.},
+	{250000., 128992510.},
+	{1000000., 1045563762.},
+	{3000000., 5706890290.},
+	{11000000., 35133391030.},
+	{43000000., 240490660426.}
+};
+
+#define TECM_NUM_B2 (sizeof(tecm_gmpecm_B2) / sizeof(tecm_gmpecm_B2[0]))
+
+uint64 tinyecm_B2(fact_obj_t *fobj)
+{
+	// the default is the B2 gmp-ecm would use for this B1, interpolated
+	// linearly in log(B1) vs. log(B2) between the points of the table,
+	// so that a tinyecm curve does (about) the work of a gmp-ecm curve.
+	double lb1, x0, y0, x1, y1, B2;
+	int i;
+
+	if (fobj->ecm_obj.stg2_is_default == 0)
+		return fobj->ecm_obj.B2;
+
+	// the segment that B1 falls in, or the nearest one at either end
+	for (i = 1; i < TECM_NUM_B2 - 1; i++)
+	{
+		if ((double)fobj->ecm_obj.B1 < tecm_gmpecm_B2[i][0])
+			break;
+	}
+
+	lb1 = log((double)fobj->ecm_obj.B1);
+	x0 = log(tecm_gmpecm_B2[i - 1][0]);
+	y0 = log(tecm_gmpecm_B2[i - 1][1]);
+	x1 = log(tecm_gmpecm_B2[i][0]);
+	y1 = log(tecm_gmpecm_B2[i][1]);
+	B2 = exp(y0 + (lb1 - x0) * (y1 - y0) / (x1 - x0));
+
+	if (B2 <= (double)fobj->ecm_obj.B1)
+		return (uint64)fobj->ecm_obj.B1 * 100;
+
+	return (uint64)(B2 + 0.5);
+}
+
+void tinyecm_plan_free(fact_obj_t *fobj)
+{
+	tecm_plan_t *plan = fobj->ecm_obj.tiny_plan;
+
+	if (plan == NULL)
+		return;
+
+	mpz_clear(plan->s);
+	free(plan->jidx);
+	free(plan->pairs);
+	free(plan);
+	fobj->ecm_obj.tiny_plan = NULL;
+	return;
+}
+
+int tinyecm_plan(fact_obj_t *fobj, uint32 B1, uint64 B2)
+{
+	// set up the stage 1 exponent and stage 2 pairing for these bounds
+	// in fobj's ecm_obj, for all threads of the run to share.  returns 0
+	// if they are out of range for tinyecm.
+	tecm_plan_t *plan = fobj->ecm_obj.tiny_plan;
+	uint64 *primes, np, i, p, q, w, lo, hi;
+	mpz_t *chunks;
+	int nchunks, j, d, nbits;
+	uint32 k;
+
+	if ((plan != NULL) && (plan->B1 == B1) && (plan->B2 == B2))
+		return 1;
+
+	if ((B1 < 100) || (B2 <= B1) || (B2 > TINYECM_MAXB2))
+		return 0;
+
+	tinyecm_plan_free(fobj);
+	plan = (tecm_plan_t *)malloc(sizeof(tecm_plan_t));
+
+	// stage 1 exponent: multiply all prime powers <= B1 into word sized
+	// chunks, then combine the chunks pairwise so the big products stay
+	// balanced.
+	primes = get_prime_cache(B1, &np);
+	chunks = (mpz_t *)malloc((np + 1) * sizeof(mpz_t));
+	nchunks = 0;
+	w = 1;
+	for (i = 0; i < np; i++)
+	{
+		p = primes[i];
+		if (p > B1)
+			break;
+
+		for (q = p; q * p <= B1; q *= p) ;
+
+		if (w > (0xffffffffffffffffULL / q))
+		{
+			mpz_init2(chunks[nchunks], 64);
+			uint64_2gmp(w, chunks[nchunks]);
+			nchunks++;
+			w = 1;
+		}
+		w *= q;
+	}
+	mpz_init2(chunks[nchunks], 64);
+	uint64_2gmp(w, chunks[nchunks]);
+	nchunks++;
+
+	while (nchunks > 1)
+	{
+		for (j = 0; j < nchunks / 2; j++)
+		{
+			mpz_mul(chunks[j], chunks[2*j], chunks[2*j+1]);
+		}
+		if (nchunks & 1)
+		{
+			mpz_set(chunks[j], chunks[nchunks - 1]);
+			j++;
+		}
+		for (d = j; d < nchunks; d++)
+			mpz_clear(chunks[d]);
+		nchunks = j;
+	}
+
+	mpz_init(plan->s);
+	mpz_set(plan->s, chunks[0]);
+	mpz_clear(chunks[0]);
+	free(chunks);
+
+	// stage 2: primes p in (B1, B2] are written as p = k*D +/- j with
+	// j < D/2 and gcd(j,D) = 1, so that both primes of a pair cost one
+	// product.
+	plan->D = (B2 < 1000000) ? 210 : 2310;
+	plan->jidx = (int *)malloc(plan->D / 2 * sizeof(int));
+	plan->nbaby = 0;
+	for (j = 0; j < plan->D / 2; j++)
+	{
+		if ((j & 1) && (spGCD(j, plan->D) == 1))
+			plan->jidx[j] = plan->nbaby++;
+		else
+			plan->jidx[j] = -1;
+	}
+
+	plan->kstart = (uint32)((B1 + 1 + plan->D / 2) / plan->D);
+	if (plan->kstart < 1)
+		plan->kstart = 1;
+	plan->kend = (uint32)((B2 + plan->D / 2) / plan->D);
+
+	nbits = (plan->kend - plan->kstart + 1) * plan->nbaby;
+	plan->pairs = (uint32 *)calloc(nbits / 32 + 1, sizeof(uint32));
+
+	// the primes up to B2 are sieved a range at a time rather than taken
+	// from the shared prime cache, which would otherwise be grown to B2
+	// and kept for the life of the process.
+	for (lo = (uint64)B1 + 1; lo <= B2; lo = hi + 1)
+	{
+		hi = MIN(B2, lo + TECM_PAIR_RANGE - 1);
+
+		if (hi > (uint64)spSOEprimes[szSOEp - 1] * (uint64)spSOEprimes[szSOEp - 1])
+			primes = soe_wrapper(spSOEprimes, szSOEp, lo, hi, 0, &np);
+		else
+			primes = GetPRIMESRange(spSOEprimes, szSOEp, NULL, lo, hi, &np);
+
+		for (i = 0; i < np; i++)
+		{
+			p = primes[i];
+			if ((p < lo) || (p > hi))
+				continue;
+
+			k = (uint32)((p + plan->D / 2) / plan->D);
+			if (k < plan->kstart)
+				continue;
+
+			if (p > (uint64)k * plan->D)
+				j = plan->jidx[p - (uint64)k * plan->D];
+			else
+				j = plan->jidx[(uint64)k * plan->D - p];
+
+			if (j < 0)
+				continue;
+
+			d = (k - plan->kstart) * plan->nbaby + j;
+			plan->pairs[d >> 5] |= (1U << (d & 31));
+		}
+		free(primes);
+	}
+
+	plan->B1 = B1;
+	plan->B2 = B2;
+	fobj->ecm_obj.tiny_plan = plan;
+
+	return 1;
+}
+
+/********************* one curve **********************/
+
+int tinyecm_curve(tinyecm_t *t, tecm_plan_t *plan, mpz_t f, mpz_t n, uint32 sigma)
+{
+	// run one curve with the given plan on n.  returns the stage in
+	// which a factor was found (f is set to it), or 0 with f == 1.
+	mpz_t u, v, a, b, tmp;
+	uint32 k, kk;
+	int i, j, bit, stage = 0;
+	int c0, c1, c2, tmp_slot;
+
+	mpz_set_ui(f, 1);
+
+	tecm_setup(t, n);
+
+	mpz_init(u);
+	mpz_init(v);
+	mpz_init(a);
+	mpz_init(b);
+	mpz_init(tmp);
+
+	// Suyama's parameterization: u = sigma^2 - 5, v = 4*sigma,
+	// x0 = u^3/v^3, (A+2)/4 = (v-u)^3(3u+v)/(16u^3v)
+	mpz_set_ui(u, sigma);
+	mpz_mul(u, u, u);
+	mpz_sub_ui(u, u, 5);
+	mpz_mod(u, u, n);
+	mpz_set_ui(v, sigma);
+	mpz_mul_ui(v, v, 4);
+	mpz_mod(v, v, n);
+
+	// b = 16u^3v^4, the common denominator
+	mpz_powm_ui(a, u, 3, n);
+	mpz_powm_ui(b, v, 4, n);
+	mpz_mul(b, b, a);
+	mpz_mul_ui(b, b, 16);
+	mpz_mod(b, b, n);
+	if (!mpz_invert(tmp, b, n))
+	{
+		mpz_gcd(f, b, n);
+		if (mpz_cmp(f, n) == 0)
+			mpz_set_ui(f, 1);
+		else
+			stage = 1;
+		goto done;
+	}
+
+	// x0 = u^3 * 16u^3v / b
+	mpz_mul(b, a, a);
+	mpz_mul(b, b, v);
+	mpz_mul_ui(b, b, 16);
+	mpz_mul(b, b, tmp);
+	mpz_mod(b, b, n);
+	tecm_set(t, RES(T_XP), b, n, u);
+
+	// a24 = (v-u)^3(3u+v) * v^3 / b
+	mpz_set_ui(u, sigma);
+	mpz_mul(u, u, u);
+	mpz_sub_ui(u, u, 5);
+	mpz_mod(u, u, n);
+	mpz_sub(a, v, u);
+	mpz_powm_ui(a, a, 3, n);
+	mpz_mul_ui(b, u, 3);
+	mpz_add(b, b, v);
+	mpz_mul(a, a, b);
+	mpz_powm_ui(b, v, 3, n);
+	mpz_mul(a, a, b);
+	mpz_mul(a, a, tmp);
+	mpz_mod(a, a, n);
+	tecm_set(t, RES(T_A24), a, n, u);
+
+	mpz_set_ui(a, 1);
+	tecm_set(t, RES(T_ONE), a, n, u);
+	tecm_copy(t, RES(T_ONE), RES(T_ACC));
+
+	// stage 1
+	if (!tecm_ladder(t, plan->s, RES(T_XP), NULL, RES(T_XQ), RES(T_ZQ)))
+		goto done;
+
+	tecm_gcd(t, f, RES(T_ZQ), n);
+	if (mpz_cmp_ui(f, 1) > 0)
+	{
+		if (mpz_cmp(f, n) == 0)
+			mpz_set_ui(f, 1);
+		else
+			stage = 1;
+		goto done;
+	}
+
+	// stage 2 baby steps: j*Q for odd j < D/2, keeping those coprime to D
+	tecm_dbl(t, RES(T_XQ), RES(T_ZQ), RES(T_XQ2), RES(T_ZQ2));
+	tecm_copy(t, RES(T_XQ), RES(T_XR0));
+	tecm_copy(t, RES(T_ZQ), RES(T_ZR0));
+	tecm_add(t, RES(T_XQ2), RES(T_ZQ2), RES(T_XQ), RES(T_ZQ),
+		RES(T_XQ), RES(T_ZQ), RES(T_XR1), RES(T_ZR1));
+	c0 = T_XR0;
+	c1 = T_XR1;
+	for (j = 1; j < plan->D / 2; j += 2)
+	{
+		if (j >= 5)
+		{
+			// (j-2)Q + 2Q, difference (j-4)Q, replaces (j-4)Q
+			tecm_add(t, RES(c1), RES(c1 + 1), RES(T_XQ2), RES(T_ZQ2),
+				RES(c0), RES(c0 + 1), RES(c0), RES(c0 + 1));
+			tmp_slot = c0;
+			c0 = c1;
+			c1 = tmp_slot;
+		}
+
+		i = plan->jidx[j];
+		if (i < 0)
+			continue;
+
+		// j == 1 is in c0, later j in c1
+		tmp_slot = (j == 1) ? c0 : c1;
+		tecm_copy(t, RES(tmp_slot), XB(i));
+		tecm_copy(t, RES(tmp_slot + 1), ZB(i));
+		tecm_mulmod(t, XB(i), ZB(i), XZB(i));
+	}
+
+	// giant steps: G = D*Q, and the two starting multiples kstart*D*Q
+	// and (kstart+1)*D*Q, after which each is the sum of the previous
+	// one and G
+	mpz_set_ui(a, plan->D);
+	if (!tecm_ladder(t, a, RES(T_XQ), RES(T_ZQ), RES(T_XG), RES(T_ZG)))
+		goto done;
+	mpz_mul_ui(a, a, plan->kstart);
+	if (!tecm_ladder(t, a, RES(T_XQ), RES(T_ZQ), RES(T_XC), RES(T_ZC)))
+		goto done;
+	mpz_set_ui(a, plan->D);
+	mpz_mul_ui(a, a, plan->kstart + 1);
+	if (!tecm_ladder(t, a, RES(T_XQ), RES(T_ZQ), RES(T_XN), RES(T_ZN)))
+		goto done;
+
+	c0 = T_XC;
+	c1 = T_XN;
+	c2 = T_XW;
+	for (k = plan->kstart, kk = 0; k <= plan->kend; k++, kk++)
+	{
+		tecm_mulmod(t, RES(c0), RES(c0 + 1), RES(T_XZG));
+
+		// (Xg - Xj)(Zg + Zj) - XgZg + XjZj = XgZj - XjZg
+		for (i = 0; i < plan->nbaby; i++)
+		{
+			bit = kk * plan->nbaby + i;
+			if ((plan->pairs[bit >> 5] & (1U << (bit & 31))) == 0)
+				continue;
+
+			tecm_submod(t, RES(c0), XB(i), RES(T_T1));
+			tecm_addmod(t, RES(c0 + 1), ZB(i), RES(T_T2));
+			tecm_mulmod(t, RES(T_T1), RES(T_T2), RES(T_T1));
+			tecm_submod(t, RES(T_T1), RES(T_XZG), RES(T_T1));
+			tecm_addmod(t, RES(T_T1), XZB(i), RES(T_T1));
+			tecm_mulmod(t, RES(T_ACC), RES(T_T1), RES(T_ACC));
+		}
+
+		if (((kk & 1023) == 1023) && ecm_stop_asap())
+			goto done;
+
+		tecm_add(t, RES(c1), RES(c1 + 1), RES(T_XG), RES(T_ZG),
+			RES(c0), RES(c0 + 1), RES(c2), RES(c2 + 1));
+		tmp_slot = c0;
+		c0 = c1;
+		c1 = c2;
+		c2 = tmp_slot;
+	}
+
+	tecm_gcd(t, f, RES(T_ACC), n);
+	if (mpz_cmp_ui(f, 1) > 0)
+	{
+		if (mpz_cmp(f, n) == 0)
+			mpz_set_ui(f, 1);
+		else
+			stage = 2;
+	}
+
+done:
+	mpz_clear(u);
+	mpz_clear(v);
+	mpz_clear(a);
+	mpz_clear(b);
+	mpz_clear(tmp);
+
+	return stage;
+}
@@ -158,6 +158,9 @@ void nfs(fact_obj_t *fobj)
 	TIME_DIFF *	difference;
 	double t_time;
 	uint32 pre_batch_rels = 0;
+	uint32 pre_batch_q, sieved_rels = 0;	// measured yield, for the job cache
+	uint64 sieved_q = 0;
+	mpz_t sieved_n;
 	char tmpstr[GSTR_MAXSIZE];
 	int process_done;
 	enum nfs_state_e nfs_state;
@@ -184,6 +187,7 @@ void nfs(fact_obj_t *fobj)
 
 	//start a counter for the whole job
 	gettimeofday(&start, NULL);
+	mpz_init(sieved_n);
 
 	//nfs state machine:
 	input = (char *)malloc(GSTR_MAXSIZE * sizeof(char));
@@ -200,8 +204,8 @@ void nfs(fact_obj_t *fobj)
 			// create an msieve_obj
 			// this will initialize the savefile to the outputfile name provided
 			obj = msieve_obj_new(input, flags, fobj->nfs_obj.outputfile, fobj->nfs_obj.logfile,
-				fobj->nfs_obj.fbfile, g_rand.low, g_rand.hi, (uint32)0, cpu,
-				(uint32)L1CACHE, (uint32)L2CACHE, (uint32)THREADS, (uint32)0, nfs_args);
+				fobj->nfs_obj.fbfile, fobj->seed1, fobj->seed2, (uint32)0, cpu,
+				(uint32)L1CACHE, (uint32)L2CACHE, (uint32)fobj->num_threads, (uint32)0, nfs_args);
 			fobj->nfs_obj.mobj = obj;
 
 			// initialize these before checking existing files.  If poly
@@ -234,7 +238,7 @@ void nfs(fact_obj_t *fobj)
 			factor_list_init(&factor_list);
 
 			if (fobj->nfs_obj.rangeq > 0)
-				job.qrange = ceil((double)fobj->nfs_obj.rangeq / (double)THREADS);
+				job.qrange = ceil((double)fobj->nfs_obj.rangeq / (double)fobj->num_threads);
 
 			break;
 
@@ -245,6 +249,14 @@ void nfs(fact_obj_t *fobj)
 			{
 				int better_by_gnfs = 0;
 
+				// a cached job for this input, or for a related one that
+				// shares its polynomial, skips poly select and test sieving
+				if (nfs_cache_lookup(fobj, &job))
+				{
+					nfs_state = NFS_STATE_SIEVE;
+					break;
+				}
+
 				// always check snfs forms (it is fast)
 				better_by_gnfs = snfs_choose_poly(fobj, &job);
 
@@ -290,6 +302,9 @@ void nfs(fact_obj_t *fobj)
 					fobj->nfs_obj.snfs = 1;
 					mpz_set(fobj->nfs_obj.gmp_n, job.snfs->n);
 				}
+
+				// remember the polynomial now, in case the job is interrupted
+				nfs_cache_store(fobj, &job, fobj->nfs_obj.gmp_n, 0., 0);
 			}
 
 			nfs_state = NFS_STATE_SIEVE;
@@ -308,7 +323,24 @@ void nfs(fact_obj_t *fobj)
 			if (((fobj->nfs_obj.nfs_phases == NFS_DEFAULT_PHASES) ||
 				(fobj->nfs_obj.nfs_phases & NFS_PHASE_SIEVE)) &&
 				!(fobj->nfs_obj.nfs_phases & NFS_DONE_SIEVING))
+			{
+				// new relations are tallied as they are added to the .dat file
+				if (job.relstats == NULL)
+					job.relstats = nfs_relstats_load(fobj, &job);
+				pre_batch_q = job.startq;
+				mpz_set(sieved_n, fobj->nfs_obj.gmp_n);
 				do_sieving(fobj, &job);
+				sieved_q += job.startq - pre_batch_q;
+				sieved_rels += job.current_rels - pre_batch_rels;
+
+				// size the next batch from this one's yield
+				gettimeofday(&bstop, NULL);
+				difference = my_difftime (&bstart, &bstop);
+				t_time = ((double)difference->secs + (double)difference->usecs / 1000000);
+				free(difference);
+				nfs_adapt_batch(fobj, &job, job.current_rels - pre_batch_rels,
+					job.startq - pre_batch_q, t_time);
+			}
 			else
 				fobj->nfs_obj.nfs_phases |= NFS_DONE_SIEVING;
 
@@ -393,7 +425,7 @@ void nfs(fact_obj_t *fobj)
 				{
 					msieve_obj_free(obj);
 					obj = msieve_obj_new(input, flags, fobj->nfs_obj.outputfile, fobj->nfs_obj.logfile,
-						fobj->nfs_obj.fbfile, g_rand.low, g_rand.hi, (uint32)0, cpu,
+						fobj->nfs_obj.fbfile, fobj->seed1, fobj->seed2, (uint32)0, cpu,
 						(uint32)L1CACHE, (uint32)L2CACHE, (uint32)LATHREADS, (uint32)0, nfs_args);
 				}
 
@@ -451,8 +483,8 @@ void nfs(fact_obj_t *fobj)
 				{
 					msieve_obj_free(obj);
 					obj = msieve_obj_new(input, flags, fobj->nfs_obj.outputfile, fobj->nfs_obj.logfile,
-						fobj->nfs_obj.fbfile, g_rand.low, g_rand.hi, (uint32)0, cpu,
-						(uint32)L1CACHE, (uint32)L2CACHE, (uint32)THREADS, (uint32)0, nfs_args);
+						fobj->nfs_obj.fbfile, fobj->seed1, fobj->seed2, (uint32)0, cpu,
+						(uint32)L1CACHE, (uint32)L2CACHE, (uint32)fobj->num_threads, (uint32)0, nfs_args);
 				}
 
 				obj_ptr = NULL;
@@ -520,6 +552,10 @@ void nfs(fact_obj_t *fobj)
 			break;
 
 		case NFS_STATE_CLEANUP:
+
+			// the job file is still there: record how the job went
+			nfs_cache_store(fobj, &job, sieved_n, 
+				(sieved_q > 0) ? (double)sieved_rels / (double)sieved_q : 0., job.current_rels);
 			
 			remove(fobj->nfs_obj.outputfile);
 			remove(fobj->nfs_obj.fbfile);
@@ -556,6 +592,46 @@ void nfs(fact_obj_t *fobj)
 			break;
 
 		case NFS_STATE_FILTCHECK:
+			if ((job.current_rels >= job.min_rels) &&
+				(job.current_rels < 1.25 * job.min_rels) &&
+				((fobj->nfs_obj.nfs_phases == NFS_DEFAULT_PHASES) ||
+				(fobj->nfs_obj.nfs_phases & NFS_PHASE_SIEVE)) &&
+				!(fobj->nfs_obj.nfs_phases & NFS_DONE_SIEVING))
+			{
+				// min_rels is only a guess.  before paying for a full filtering
+				// pass, check with the running relation counts: if singleton
+				// removal would leave fewer relations than ideals then filtering
+				// will fail, so keep sieving instead.  past 1.25 * min_rels we
+				// filter regardless, in case the estimate is too pessimistic.
+				uint32 rels_left, ideals_left;
+				int64 excess;
+
+				if (job.relstats == NULL)
+					job.relstats = nfs_relstats_load(fobj, &job);
+
+				excess = nfs_relstats_excess(job.relstats, &rels_left, &ideals_left);
+
+				if (VFLAG > 0)
+					printf("nfs: %u unique relations (%u duplicates), %u relations "
+						"and %u large ideals after singleton removal, estimated excess %" PRId64 "\n",
+						job.relstats->num_rels, job.relstats->num_dups, 
+						rels_left, ideals_left, excess);
+
+				logprint_oc(fobj->flogname, "a", "nfs: %u unique relations, "
+					"estimated excess after singleton removal %" PRId64 "\n",
+					job.relstats->num_rels, excess);
+
+				if (excess <= 0)
+				{
+					if (VFLAG > 0)
+						printf("nfs: filtering not expected to succeed yet, "
+							"continuing with sieving ...\n");
+
+					nfs_state = NFS_STATE_SIEVE;
+					break;
+				}
+			}
+
 			if (job.current_rels >= job.min_rels)
 			{
 				if (VFLAG > 0)
@@ -641,8 +717,8 @@ void nfs(fact_obj_t *fobj)
 //
 //			msieve_obj_free(fobj->nfs_obj.mobj);
 //			obj = msieve_obj_new(input, flags, fobj->nfs_obj.outputfile, fobj->nfs_obj.logfile, 
-//				fobj->nfs_obj.fbfile, g_rand.low, g_rand.hi, (uint32)0, nfs_lower, nfs_upper, cpu, 
-//				(uint32)L1CACHE, (uint32)L2CACHE, (uint32)THREADS, (uint32)0, (uint32)0, 0.0);
+//				fobj->nfs_obj.fbfile, fobj->seed1, fobj->seed2, (uint32)0, nfs_lower, nfs_upper, cpu, 
+//				(uint32)L1CACHE, (uint32)L2CACHE, (uint32)fobj->num_threads, (uint32)0, (uint32)0, 0.0);
 //			fobj->nfs_obj.mobj = obj;
 //
 //			printf("output: %s\n", fobj->nfs_obj.mobj->savefile.name);
@@ -841,6 +917,9 @@ void nfs(fact_obj_t *fobj)
 	if (obj != NULL)
 		msieve_obj_free(obj);
 	free(input);
+
+	if (job.relstats != NULL)
+		nfs_relstats_free(job.relstats);
 	
 	if( job.snfs )
 	{
@@ -852,6 +931,7 @@ void nfs(fact_obj_t *fobj)
 		mpz_polys_free(job.poly);
 		free(job.poly);
 	}
+	mpz_clear(sieved_n);
 
 	return;
 }
@@ -864,7 +944,10 @@ int check_for_sievers(fact_obj_t *fobj, int revert_to_siqs)
 	{
 		FILE *test;
 		char name[1024];
-		int found, i;
+		int found = 0, i;
+
+		if (fobj->nfs_obj.siever == NFS_BUILTIN_SIEVER)
+			return 0;
 
 		for (i=11; i<=16; i++)
 		{
@@ -882,7 +965,17 @@ int check_for_sievers(fact_obj_t *fobj, int revert_to_siqs)
 			}
 		}
 
-		if (!found && revert_to_siqs)
+		if (!found && (gmp_base10(fobj->nfs_obj.gmp_n) <= NFS_BUILTIN_MAXDIGITS))
+		{
+			// small enough for the in-process siever
+			printf("WARNING: could not find ggnfs sievers, using the built-in "
+				"lattice siever\n");
+			logprint_oc(fobj->flogname, "a", "WARNING: could not find ggnfs sievers, "
+				"using the built-in lattice siever\n");
+			fobj->nfs_obj.siever = NFS_BUILTIN_SIEVER;
+			return 0;
+		}
+		else if (!found && revert_to_siqs)
 		{
 			printf("WARNING: could not find ggnfs sievers, reverting to siqs!\n");
 			logprint_oc(fobj->flogname, "a", "WARNING: could not find ggnfs sievers, "
@@ -1124,6 +1217,12 @@ void get_ggnfs_params(fact_obj_t *fobj, nfs_job_t *job)
 
 	nfs_set_min_rels(job);
 
+	if (fobj->nfs_obj.siever == NFS_BUILTIN_SIEVER)
+	{
+		strcpy(job->sievername, "builtin");
+		return;
+	}
+
 	sprintf(job->sievername, "%sgnfs-lasieve4I%de", fobj->nfs_obj.ggnfs_dir, fobj->nfs_obj.siever);
 #if defined(WIN32)
 	sprintf(job->sievername, "%s.exe", job->sievername);
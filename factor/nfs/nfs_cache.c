@@ -0,0 +1,477 @@
+/*----------------------------------------------------------------------
+This source distribution is placed in the public domain by its author,
+Ben Buhrow. You may use it for any purpose, free of charge,
+without having to notify anyone. I disclaim any responsibility for any
+errors.
+
+Optionally, please be nice and tell me if you find this source to be
+useful. Again optionally, if you add to the functionality present here
+please consider making those additions public too, so that others may
+benefit from your work.
+
+       				   --bbuhrow@gmail.com 12/6/2012
+----------------------------------------------------------------------*/
+
+#include "nfs.h"
+#include "gmp_xface.h"
+
+#ifdef USE_NFS
+
+// a persistent cache of nfs jobs (-nfscache, default nfs.cache), so that
+// repeated and related inputs can skip poly selection and test sieving.
+// each job is stored as a block:
+//
+//   [job]
+//   key: <n, in hex>
+//   digits: <size of n>
+//   yield: <relations per unit of special-q range, 0 if not measured>
+//   rels: <relations needed to build a matrix, 0 if not known>
+//   <the job file, without its n: line>
+//   [end]
+//
+// a cached job is reused for an exact match of n.  otherwise any cached
+// polynomial pair whose common root m is also a root mod the new input
+// can be reused, which is what happens with different cofactors of the
+// same b^n+-1 and the like.  snfs polynomials don't depend on the size of
+// the cofactor, but a gnfs polynomial is only worth reusing if the input
+// is not much smaller than the number it was selected for.
+
+#define NFS_CACHE_MAX_ENTRIES 200
+#define NFS_CACHE_GNFS_SLACK 5		// digits a gnfs input may have shrunk by
+
+typedef struct
+{
+	mpz_t key;
+	int digits;
+	double yield;
+	uint32 rels;
+	int is_snfs;
+	char *text;		// job file lines
+	int len;
+	int alloc;
+} nfs_cache_entry_t;
+
+static void nfs_cache_append(nfs_cache_entry_t *e, char *line)
+{
+	int n = strlen(line);
+
+	if ((e->len + n + 2) > e->alloc)
+	{
+		e->alloc = 2 * (e->len + n + 2);
+		e->text = (char *)xrealloc(e->text, e->alloc * sizeof(char));
+	}
+	strcpy(e->text + e->len, line);
+	e->len += n;
+	e->text[e->len++] = '\n';
+	e->text[e->len] = '\0';
+
+	return;
+}
+
+static void nfs_cache_free(nfs_cache_entry_t *entries, int num)
+{
+	int i;
+
+	for (i = 0; i < num; i++)
+	{
+		mpz_clear(entries[i].key);
+		free(entries[i].text);
+	}
+	free(entries);
+
+	return;
+}
+
+static nfs_cache_entry_t *nfs_cache_read(char *filename, int *num)
+{
+	// read every complete block of the cache file.  a block cut short
+	// by an interrupted write is ignored.
+	FILE *in;
+	nfs_cache_entry_t *entries = NULL, *e = NULL;
+	char line[GSTR_MAXSIZE];
+	int alloc = 0, i;
+
+	*num = 0;
+	in = fopen(filename, "r");
+	if (in == NULL)
+		return NULL;
+
+	while (fgets(line, GSTR_MAXSIZE, in) != NULL)
+	{
+		i = strlen(line);
+		while ((i > 0) && isspace(line[i - 1]))
+			line[--i] = '\0';
+
+		if (strcmp(line, "[job]") == 0)
+		{
+			if (e != NULL)
+			{
+				// unterminated block
+				mpz_clear(e->key);
+				free(e->text);
+			}
+
+			if (*num == alloc)
+			{
+				alloc = (alloc == 0) ? 16 : 2 * alloc;
+				entries = (nfs_cache_entry_t *)xrealloc(entries,
+					alloc * sizeof(nfs_cache_entry_t));
+			}
+
+			e = &entries[*num];
+			memset(e, 0, sizeof(nfs_cache_entry_t));
+			mpz_init(e->key);
+			e->alloc = 1024;
+			e->text = (char *)xmalloc(e->alloc * sizeof(char));
+			e->text[0] = '\0';
+		}
+		else if (e == NULL)
+			continue;
+		else if (strcmp(line, "[end]") == 0)
+		{
+			if (mpz_sgn(e->key) > 0)
+				(*num)++;
+			else
+			{
+				mpz_clear(e->key);
+				free(e->text);
+			}
+			e = NULL;
+		}
+		else if (strncmp(line, "key:", 4) == 0)
+			mpz_set_str(e->key, line + 4 + strspn(line + 4, " \t"), 16);
+		else if (strncmp(line, "digits:", 7) == 0)
+			e->digits = atoi(line + 7);
+		else if (strncmp(line, "yield:", 6) == 0)
+			e->yield = strtod(line + 6, NULL);
+		else if (strncmp(line, "rels:", 5) == 0)
+			e->rels = strtoul(line + 5, NULL, 10);
+		else
+		{
+			if (strstr(line, "type:") && strstr(line, "snfs"))
+				e->is_snfs = 1;
+			nfs_cache_append(e, line);
+		}
+	}
+	fclose(in);
+
+	if (e != NULL)
+	{
+		mpz_clear(e->key);
+		free(e->text);
+	}
+
+	return entries;
+}
+
+static void nfs_cache_get_poly(nfs_cache_entry_t *e, mpz_polys_t *poly)
+{
+	char line[GSTR_MAXSIZE], *ptr, *next;
+	int n;
+
+	for (n = 0; n <= MAX_POLY_DEGREE; n++)
+		mpz_set_ui(poly->alg.coeff[n], 0);
+	mpz_set_ui(poly->rat.coeff[0], 0);
+	mpz_set_ui(poly->rat.coeff[1], 0);
+	poly->alg.degree = 0;
+
+	for (ptr = e->text; *ptr != '\0'; ptr = next)
+	{
+		next = strchr(ptr, '\n');
+		n = (int)(next - ptr);
+		next++;
+		if (n >= GSTR_MAXSIZE)
+			continue;
+		strncpy(line, ptr, n);
+		line[n] = '\0';
+		parse_poly_line(line, poly);
+	}
+
+	return;
+}
+
+static int nfs_cache_root_ok(mpz_polys_t *poly, mpz_t n)
+{
+	// check that the root -Y0/Y1 of the rational poly is also a root of
+	// the algebraic poly mod n, by evaluating the homogeneous form of
+	// the algebraic poly at (-Y0, Y1).
+	mpz_t r, x, ypow, t;
+	int i, d = poly->alg.degree, ok;
+
+	if ((d < 1) || (mpz_sgn(poly->rat.coeff[1]) == 0))
+		return 0;
+
+	mpz_init(r);
+	mpz_init(x);
+	mpz_init(ypow);
+	mpz_init(t);
+
+	// need Y1 invertible for the root to exist
+	mpz_gcd(t, poly->rat.coeff[1], n);
+	ok = (mpz_cmp_ui(t, 1) == 0);
+
+	mpz_neg(x, poly->rat.coeff[0]);
+	mpz_mod(x, x, n);
+	mpz_mod(ypow, poly->rat.coeff[1], n);
+	mpz_mod(r, poly->alg.coeff[d], n);
+	for (i = d - 1; ok && (i >= 0); i--)
+	{
+		mpz_mul(r, r, x);
+		mpz_mul(t, poly->alg.coeff[i], ypow);
+		mpz_add(r, r, t);
+		mpz_mod(r, r, n);
+		mpz_mul(ypow, ypow, poly->rat.coeff[1]);
+		mpz_mod(ypow, ypow, n);
+	}
+	ok = ok && (mpz_sgn(r) == 0);
+
+	mpz_clear(r);
+	mpz_clear(x);
+	mpz_clear(ypow);
+	mpz_clear(t);
+
+	return ok;
+}
+
+static int nfs_cache_same_poly(mpz_polys_t *a, mpz_polys_t *b)
+{
+	int i;
+
+	if (a->alg.degree != b->alg.degree)
+		return 0;
+	for (i = 0; i <= (int)a->alg.degree; i++)
+		if (mpz_cmp(a->alg.coeff[i], b->alg.coeff[i]) != 0)
+			return 0;
+	for (i = 0; i < 2; i++)
+		if (mpz_cmp(a->rat.coeff[i], b->rat.coeff[i]) != 0)
+			return 0;
+
+	return 1;
+}
+
+int nfs_cache_lookup(fact_obj_t *fobj, nfs_job_t *job)
+{
+	// look for a cached job that can be used for the current input.  on
+	// a hit the job file is written and parsed into job, the .fb file is
+	// made, and 1 is returned.
+	nfs_cache_entry_t *entries, *best = NULL;
+	mpz_polys_t poly;
+	int num, i, digits = gmp_base10(fobj->nfs_obj.gmp_n);
+	FILE *out;
+
+	if (fobj->nfs_obj.cachefile[0] == '\0')
+		return 0;
+
+	entries = nfs_cache_read(fobj->nfs_obj.cachefile, &num);
+	if (num == 0)
+	{
+		free(entries);
+		return 0;
+	}
+
+	mpz_polys_init(&poly);
+	for (i = 0; i < num; i++)
+	{
+		nfs_cache_entry_t *e = &entries[i];
+
+		// respect -snfs and -gnfs
+		if ((e->is_snfs && fobj->nfs_obj.gnfs) || (!e->is_snfs && fobj->nfs_obj.snfs))
+			continue;
+
+		if (mpz_cmp(e->key, fobj->nfs_obj.gmp_n) == 0)
+		{
+			best = e;
+			break;
+		}
+
+		if (!e->is_snfs && (digits + NFS_CACHE_GNFS_SLACK < e->digits))
+			continue;
+
+		nfs_cache_get_poly(e, &poly);
+		if (!nfs_cache_root_ok(&poly, fobj->nfs_obj.gmp_n))
+			continue;
+
+		// of several related jobs, take the best measured yield, or the
+		// most recent one
+		if ((best == NULL) || (e->yield >= best->yield))
+			best = e;
+	}
+	mpz_polys_free(&poly);
+
+	if (best == NULL)
+	{
+		nfs_cache_free(entries, num);
+		return 0;
+	}
+
+	out = fopen(fobj->nfs_obj.job_infile, "w");
+	if (out == NULL)
+	{
+		printf("fopen error: %s\n", strerror(errno));
+		printf("could not open %s for writing\n", fobj->nfs_obj.job_infile);
+		nfs_cache_free(entries, num);
+		return 0;
+	}
+	gmp_fprintf(out, "n: %Zd\n", fobj->nfs_obj.gmp_n);
+	fputs(best->text, out);
+	fclose(out);
+
+	if (VFLAG >= 0)
+		printf("nfs: using cached %s job for %s input (c%d)\n",
+			best->is_snfs ? "snfs" : "gnfs",
+			(mpz_cmp(best->key, fobj->nfs_obj.gmp_n) == 0) ? "this" : "a related",
+			best->digits);
+	if ((VFLAG > 0) && (best->yield > 0))
+		printf("nfs: cached yield %1.3f rels/q, %u relations needed\n",
+			best->yield, best->rels);
+	logprint_oc(fobj->flogname, "a", "nfs: using cached %s job from a c%d\n",
+		best->is_snfs ? "snfs" : "gnfs", best->digits);
+
+	// the job comes back through the usual job file parser
+	parse_job_file(fobj, job);
+	get_ggnfs_params(fobj, job);
+	read_job_poly(fobj->nfs_obj.job_infile, job->poly);
+	if (job->snfs != NULL)
+	{
+		mpz_set(job->snfs->n, fobj->nfs_obj.gmp_n);
+		fobj->nfs_obj.snfs = 1;
+	}
+
+	// the same polynomial and parameters will need about as many
+	// relations as last time, whatever the input
+	if (best->rels > 0)
+		job->min_rels = best->rels;
+
+	job->startq = (job->poly->side == RATIONAL_SPQ) ? job->rlim / 2 : job->alim / 2;
+	ggnfs_to_msieve(fobj, job);
+
+	nfs_cache_free(entries, num);
+	return 1;
+}
+
+void nfs_cache_store(fact_obj_t *fobj, nfs_job_t *job, mpz_t n, double yield, uint32 rels)
+{
+	// add the current job file, for input n, to the cache, replacing any
+	// entry for the same input or the same polynomial.  the new cache is written to a
+	// temporary file and renamed over the old one.
+	nfs_cache_entry_t *entries, e;
+	mpz_polys_t poly, cpoly;
+	char line[GSTR_MAXSIZE], tmpname[GSTR_MAXSIZE + 16];
+	FILE *in, *out;
+	int num, i, first;
+
+	if ((fobj->nfs_obj.cachefile[0] == '\0') || (mpz_cmp_ui(n, 1) <= 0))
+		return;
+
+	in = fopen(fobj->nfs_obj.job_infile, "r");
+	if (in == NULL)
+		return;
+
+	memset(&e, 0, sizeof(nfs_cache_entry_t));
+	mpz_init(e.key);
+	mpz_set(e.key, n);
+	e.digits = gmp_base10(n);
+	e.yield = yield;
+	e.rels = rels;
+	e.alloc = 1024;
+	e.text = (char *)xmalloc(e.alloc * sizeof(char));
+	e.text[0] = '\0';
+	while (fgets(line, GSTR_MAXSIZE, in) != NULL)
+	{
+		i = strlen(line);
+		while ((i > 0) && isspace(line[i - 1]))
+			line[--i] = '\0';
+		// a side switch made while sieving (nfs_adapt_batch) is not part 
+		// of the job's starting point
+		if ((i == 0) || (strncmp(line, "n:", 2) == 0) || 
+			(strncmp(line, "# sieving ", 10) == 0))
+			continue;
+		nfs_cache_append(&e, line);
+	}
+	fclose(in);
+
+	mpz_polys_init(&poly);
+	mpz_polys_init(&cpoly);
+	nfs_cache_get_poly(&e, &poly);
+	if (NFS_ABORT || !nfs_cache_root_ok(&poly, n))
+	{
+		// an interrupted poly select can leave an old job file behind
+		mpz_polys_free(&poly);
+		mpz_polys_free(&cpoly);
+		mpz_clear(e.key);
+		free(e.text);
+		return;
+	}
+
+	entries = nfs_cache_read(fobj->nfs_obj.cachefile, &num);
+
+	// concurrent -batchjobs lines each get their own temporary file
+	sprintf(tmpname, "%s.%08x.tmp", fobj->nfs_obj.cachefile,
+		(uint32)(mpz_get_ui(n) & 0xffffffff));
+	out = fopen(tmpname, "w");
+	if (out == NULL)
+	{
+		printf("fopen error: %s\n", strerror(errno));
+		printf("could not open %s for writing\n", tmpname);
+		nfs_cache_free(entries, num);
+		mpz_polys_free(&poly);
+		mpz_polys_free(&cpoly);
+		mpz_clear(e.key);
+		free(e.text);
+		return;
+	}
+
+	// oldest entries are first, and are the ones to go when it's full
+	first = MAX(0, num - (NFS_CACHE_MAX_ENTRIES - 1));
+	for (i = first; i < num; i++)
+	{
+		if (mpz_cmp(entries[i].key, e.key) == 0)
+			continue;
+
+		nfs_cache_get_poly(&entries[i], &cpoly);
+		if (nfs_cache_same_poly(&poly, &cpoly))
+		{
+			// keep an earlier measurement if this run didn't make one
+			if (e.yield == 0)
+			{
+				e.yield = entries[i].yield;
+				e.rels = entries[i].rels;
+			}
+			continue;
+		}
+
+		gmp_fprintf(out, "[job]\nkey: %Zx\ndigits: %d\nyield: %1.4f\nrels: %u\n%s[end]\n",
+			entries[i].key, entries[i].digits, entries[i].yield, entries[i].rels,
+			entries[i].text);
+	}
+
+	gmp_fprintf(out, "[job]\nkey: %Zx\ndigits: %d\nyield: %1.4f\nrels: %u\n%s[end]\n",
+		e.key, e.digits, e.yield, e.rels, e.text);
+
+	if (fclose(out) != 0)
+	{
+		printf(" ***Error: problem closing file %s\n", tmpname);
+		remove(tmpname);
+	}
+	else
+	{
+#if defined(WIN32) || defined(_WIN64)
+		// rename won't replace an existing file on windows
+		remove(fobj->nfs_obj.cachefile);
+#endif
+		rename(tmpname, fobj->nfs_obj.cachefile);
+	}
+
+	if (VFLAG > 0)
+		printf("nfs: saved job to %s\n", fobj->nfs_obj.cachefile);
+
+	nfs_cache_free(entries, num);
+	mpz_polys_free(&poly);
+	mpz_polys_free(&cpoly);
+	mpz_clear(e.key);
+	free(e.text);
+
+	return;
+}
+
+#endif
@@ -17,8 +17,10 @@ benefit from your work.
 
 #ifdef USE_NFS
 
-void savefile_concat(char *filein, char *fileout, msieve_obj *mobj)
+void savefile_concat(char *filein, char *fileout, msieve_obj *mobj, nfs_relstats_t *stats)
 {
+	// append filein to the msieve savefile, and if stats are
+	// provided, tally each relation as it goes by
 	FILE *in;
 
 	in = fopen(filein,"r");
@@ -37,8 +39,10 @@ void savefile_concat(char *filein, char *fileout, msieve_obj *mobj)
 		tmpptr = fgets(tmpline, GSTR_MAXSIZE, in);
 		if (tmpptr == NULL)
 			break;
-		else
-			savefile_write_line(&mobj->savefile, tmpline);
+
+		savefile_write_line(&mobj->savefile, tmpline);
+		if (stats != NULL)
+			nfs_relstats_add(stats, tmpline);
 	}
 	fclose(in);
 
@@ -1073,6 +1077,15 @@ uint32 parse_job_file(fact_obj_t *fobj, nfs_job_t *job)
 			continue;
 		}
 		
+		// written by update_job_side: the job has already changed sides
+		// once, and must not do so again after a restart
+		if (strncmp(line, "# sieving ", 10) == 0)
+		{
+			job->side_switched = 1;
+			if (VFLAG > 0)
+				printf("nfs: found special-q side switch\n");
+		}
+
 		substr = strstr(line, "algebraic");
 		if (substr != NULL)
 		{
@@ -1251,6 +1264,93 @@ void fill_job_file(fact_obj_t *fobj, nfs_job_t *job, uint32 missing_params)
 	}
 }
 
+int parse_poly_line(char *line, mpz_polys_t *poly)
+{
+	// read one polynomial line of a ggnfs job file (skew, cN or YN, with the
+	// line ending stripped) into poly.  returns 1 if the line was one of those.
+	int i;
+
+	if (strncmp(line, "skew:", 5) == 0)
+	{
+		poly->skew = strtod(line + 5, NULL);
+		return 1;
+	}
+
+	if ((line[0] == 'c') && isdigit(line[1]) && (line[2] == ':'))
+	{
+		i = line[1] - '0';
+		if (i > MAX_POLY_DEGREE)
+			return 0;
+		mpz_set_str(poly->alg.coeff[i], line + 3 + strspn(line + 3, " \t"), 10);
+		if ((mpz_sgn(poly->alg.coeff[i]) != 0) && (i > (int)poly->alg.degree))
+			poly->alg.degree = i;
+		return 1;
+	}
+
+	if ((line[0] == 'Y') && ((line[1] == '0') || (line[1] == '1')) && (line[2] == ':'))
+	{
+		i = line[1] - '0';
+		mpz_set_str(poly->rat.coeff[i], line + 3 + strspn(line + 3, " \t"), 10);
+		poly->rat.degree = 1;
+		return 1;
+	}
+
+	return 0;
+}
+
+int read_job_poly(char *filename, mpz_polys_t *poly)
+{
+	// fill in poly from the polynomial in a ggnfs job file.  returns 1 if 
+	// an algebraic polynomial was found.
+	FILE *in;
+	char line[GSTR_MAXSIZE], *ptr;
+	int i;
+
+	in = fopen(filename, "r");
+	if (in == NULL)
+	{
+		printf("fopen error: %s\n", strerror(errno));
+		printf("could not open %s for reading!\n", filename);
+		return 0;
+	}
+
+	for (i = 0; i <= MAX_POLY_DEGREE; i++)
+		mpz_set_ui(poly->alg.coeff[i], 0);
+	mpz_set_ui(poly->rat.coeff[0], 0);
+	mpz_set_ui(poly->rat.coeff[1], 0);
+	poly->alg.degree = 0;
+
+	while ((ptr = fgets(line, GSTR_MAXSIZE, in)) != NULL)
+	{
+		// strip trailing whitespace, so mpz_set_str sees only digits
+		i = strlen(line);
+		while ((i > 0) && isspace(line[i - 1]))
+			line[--i] = '\0';
+		parse_poly_line(line, poly);
+	}
+	fclose(in);
+
+	return (poly->alg.degree > 0);
+}
+
+void update_job_side(fact_obj_t *fobj, nfs_job_t *job)
+{
+	// record a change of special-q side in the job file.  ggnfs ignores
+	// comments, and parse_job_file takes the last side it finds.
+	FILE *out = fopen(fobj->nfs_obj.job_infile, "a");
+	if (out == NULL)
+	{
+		printf("nfs: couldn't update job file with new special-q side\n");
+		return;
+	}
+
+	fprintf(out, "# sieving %s side\n", 
+		(job->poly->side == RATIONAL_SPQ) ? "rational" : "algebraic");
+	fclose(out);
+
+	return;
+}
+
 void print_poly(mpz_polys_t* poly, FILE *out)
 {
 	// print the poly to stdout
@@ -0,0 +1,985 @@
+/*----------------------------------------------------------------------
+This source distribution is placed in the public domain by its author,
+Ben Buhrow. You may use it for any purpose, free of charge,
+without having to notify anyone. I disclaim any responsibility for any
+errors.
+
+Optionally, please be nice and tell me if you find this source to be
+useful. Again optionally, if you add to the functionality present here
+please consider making those additions public too, so that others may
+benefit from your work.
+
+       				   --bbuhrow@gmail.com 12/6/2012
+----------------------------------------------------------------------*/
+
+#include "nfs.h"
+#include "gmp_xface.h"
+#include "soe.h"
+
+#ifdef USE_NFS
+
+// a small in-process special-q lattice siever, used with -siever 1 or
+// when the ggnfs binaries can't be found.  it is meant for jobs up to
+// about C120 and is a good deal slower than ggnfs.
+//
+// for each special-q the reduced q-lattice is sieved over a fixed I x J
+// region of (i,j) space on both sides.  factor base primes below I are
+// line sieved, one row at a time; larger primes hit each row at most
+// once, and their hits are enumerated directly with the franke-kleinjung
+// reduced basis of the p-lattice.  cells that look smooth on both sides
+// are resieved to collect their factor base primes, the leftover
+// cofactors are split with squfof, and relations are written in the
+// ggnfs format (a,b:rat primes:alg primes, in hex).
+
+#define LASIEVE_LOGI 12
+#define LASIEVE_I (1 << LASIEVE_LOGI)
+#define LASIEVE_J (1 << (LASIEVE_LOGI - 2))
+#define LASIEVE_BLOCK 128		// cells per norm estimate along a row
+#define LASIEVE_FUDGE 3			// bits for unsieved prime powers and ideals
+#define LASIEVE_TD_BOUND 256	// survivors are trial divided by primes below this
+#define LASIEVE_BRUTE_ROOTS 64	// find roots mod p by exhaustive search below this
+#define LASIEVE_MAX_FACTORS 64
+
+// one side of the factor base: each entry is a prime p and a root r with
+// a = r*b mod p for the (a,b) on the ideal.  projective roots are left
+// out, and caught during cofactorization instead.
+typedef struct
+{
+	uint32 *p;
+	uint32 *r;
+	uint8 *logp;
+	uint32 num;
+	uint32 alloc;
+
+	uint32 lim;
+	uint32 lpb;
+	uint32 mfb;
+	double lambda;
+
+	mpz_poly_t *poly;
+	int degree;
+	double coeff[MAX_POLY_DEGREE + 1];
+} lasieve_fb_t;
+
+// a resieved factor base prime at a surviving sieve location
+typedef struct
+{
+	uint32 pos;
+	uint32 p;
+} lasieve_hit_t;
+
+typedef struct
+{
+	lasieve_hit_t *hits;
+	uint32 num;
+	uint32 alloc;
+} lasieve_hits_t;
+
+// the current special-q and its reduced lattice:
+// (a,b) = i*(a0,b0) + j*(a1,b1)
+typedef struct
+{
+	uint32 q;
+	int side;			// 0 = rational, 1 = algebraic
+	int64 a0, b0, a1, b1;
+} lasieve_spq_t;
+
+/*============================================================================*/
+// polynomial arithmetic mod p, for factor base roots.  polys are arrays of
+// coefficients, lowest degree first, along with their degree (-1 for zero)
+
+static uint32 lpoly_addmod(uint32 a, uint32 b, uint32 p)
+{
+	uint64 t = (uint64)a + (uint64)b;
+	return (uint32)(t >= p ? t - p : t);
+}
+
+static uint32 lpoly_mulmod(uint32 a, uint32 b, uint32 p)
+{
+	return (uint32)(((uint64)a * (uint64)b) % (uint64)p);
+}
+
+static int lpoly_degree(uint32 *a, int d)
+{
+	while ((d >= 0) && (a[d] == 0))
+		d--;
+	return d;
+}
+
+static int lpoly_monic(uint32 *a, int d, uint32 p)
+{
+	uint32 inv;
+	int i;
+
+	d = lpoly_degree(a, d);
+	if ((d < 0) || (a[d] == 1))
+		return d;
+
+	inv = modinv_1(a[d], p);
+	for (i = 0; i <= d; i++)
+		a[i] = lpoly_mulmod(a[i], inv, p);
+
+	return d;
+}
+
+static int lpoly_divrem(uint32 *quot, uint32 *a, int da, uint32 *m, int dm, uint32 p)
+{
+	// a = a mod m for monic m, and the quotient in quot if it's not NULL.
+	// returns the degree of the remainder.
+	int i, j;
+
+	for (i = da; i >= dm; i--)
+	{
+		uint32 c = a[i];
+
+		if (quot != NULL)
+			quot[i - dm] = c;
+
+		if (c == 0)
+			continue;
+
+		for (j = 0; j <= dm; j++)
+			a[i - dm + j] = lpoly_addmod(a[i - dm + j],
+				p - lpoly_mulmod(c, m[j], p), p);
+	}
+
+	return lpoly_degree(a, MIN(da, dm - 1));
+}
+
+static int lpoly_mul(uint32 *r, uint32 *a, int da, uint32 *b, int db,
+	uint32 *m, int dm, uint32 p)
+{
+	// r = a * b mod m.  r may be a or b.
+	uint32 t[2 * MAX_POLY_DEGREE + 1];
+	int i, j, dt;
+
+	if ((da < 0) || (db < 0))
+		return -1;
+
+	dt = da + db;
+	for (i = 0; i <= dt; i++)
+		t[i] = 0;
+
+	for (i = 0; i <= da; i++)
+		for (j = 0; j <= db; j++)
+			t[i + j] = lpoly_addmod(t[i + j], lpoly_mulmod(a[i], b[j], p), p);
+
+	dt = lpoly_divrem(NULL, t, dt, m, dm, p);
+	for (i = 0; i <= dt; i++)
+		r[i] = t[i];
+
+	return dt;
+}
+
+static int lpoly_powmod(uint32 *r, uint32 c, uint64 e, uint32 *m, int dm, uint32 p)
+{
+	// r = (x + c)^e mod m
+	uint32 b[MAX_POLY_DEGREE + 1];
+	int db, dr;
+
+	b[0] = c % p;
+	b[1] = 1;
+	db = lpoly_divrem(NULL, b, 1, m, dm, p);
+
+	r[0] = 1;
+	dr = 0;
+	while (e > 0)
+	{
+		if (e & 1)
+			dr = lpoly_mul(r, r, dr, b, db, m, dm, p);
+		e >>= 1;
+		if (e > 0)
+			db = lpoly_mul(b, b, db, b, db, m, dm, p);
+	}
+
+	return dr;
+}
+
+static int lpoly_gcd(uint32 *g, uint32 *a, int da, uint32 *b, int db, uint32 p)
+{
+	// g = monic gcd(a, b).  a and b are overwritten.
+	uint32 *x = a, *y = b, *t;
+	int dx = da, dy = db, dt, i;
+
+	while (dy >= 0)
+	{
+		dy = lpoly_monic(y, dy, p);
+		dx = lpoly_divrem(NULL, x, dx, y, dy, p);
+		t = x; x = y; y = t;
+		dt = dx; dx = dy; dy = dt;
+	}
+
+	dx = lpoly_monic(x, dx, p);
+	for (i = 0; i <= dx; i++)
+		g[i] = x[i];
+
+	return dx;
+}
+
+static void lpoly_split(uint32 *g, int dg, uint32 p, uint32 *roots, int *nroots,
+	uint32 *seed)
+{
+	// g is monic, squarefree and a product of linear factors.  split it
+	// with gcd(g, (x + c)^((p-1)/2) - 1) for random c.
+	uint32 h[MAX_POLY_DEGREE + 1], t[MAX_POLY_DEGREE + 1];
+	uint32 k[MAX_POLY_DEGREE + 1], quot[MAX_POLY_DEGREE + 1];
+	int dh, dt, dk, i;
+
+	if (dg <= 0)
+		return;
+
+	if (dg == 1)
+	{
+		roots[(*nroots)++] = (p - g[0]) % p;
+		return;
+	}
+
+	while (1)
+	{
+		*seed = *seed * 1103515245 + 12345;
+
+		dh = lpoly_powmod(h, (*seed >> 8) % p, (p - 1) / 2, g, dg, p);
+		if (dh < 0)
+			continue;
+		h[0] = lpoly_addmod(h[0], p - 1, p);
+		dh = lpoly_degree(h, dh);
+
+		for (i = 0; i <= dg; i++)
+			t[i] = g[i];
+		dt = dg;
+
+		dk = lpoly_gcd(k, t, dt, h, dh, p);
+		if ((dk > 0) && (dk < dg))
+			break;
+	}
+
+	for (i = 0; i <= dg; i++)
+		t[i] = g[i];
+	lpoly_divrem(quot, t, dg, k, dk, p);
+
+	lpoly_split(k, dk, p, roots, nroots, seed);
+	lpoly_split(quot, dg - dk, p, roots, nroots, seed);
+	return;
+}
+
+static int lasieve_roots(mpz_poly_t *poly, uint32 p, uint32 *roots)
+{
+	// the distinct affine roots of poly mod p
+	uint32 f[MAX_POLY_DEGREE + 1], g[MAX_POLY_DEGREE + 1], h[MAX_POLY_DEGREE + 1];
+	uint32 seed = p;
+	int i, d, dg, dh, nroots = 0;
+
+	for (i = 0; i <= (int)poly->degree; i++)
+		f[i] = (uint32)mpz_fdiv_ui(poly->coeff[i], p);
+	d = lpoly_degree(f, poly->degree);
+
+	if (d <= 0)
+		return 0;
+
+	if (p < LASIEVE_BRUTE_ROOTS)
+	{
+		uint32 r;
+
+		for (r = 0; r < p; r++)
+		{
+			uint32 v = f[d];
+
+			for (i = d - 1; i >= 0; i--)
+				v = lpoly_addmod(lpoly_mulmod(v, r, p), f[i], p);
+
+			if (v == 0)
+				roots[nroots++] = r;
+		}
+
+		return nroots;
+	}
+
+	// the linear factors of f are gcd(f, x^p - x)
+	d = lpoly_monic(f, d, p);
+	for (i = 0; i <= d; i++)
+		g[i] = f[i];
+
+	dh = lpoly_powmod(h, 0, p, f, d, p);
+	for (i = dh + 1; i <= 1; i++)
+		h[i] = 0;
+	dh = MAX(dh, 1);
+	h[1] = lpoly_addmod(h[1], p - 1, p);
+	dh = lpoly_degree(h, dh);
+
+	if (dh < 0)
+	{
+		// f divides x^p - x: it splits completely already
+		dg = d;
+	}
+	else
+	{
+		dg = lpoly_gcd(g, g, d, h, dh, p);
+	}
+
+	lpoly_split(g, dg, p, roots, &nroots, &seed);
+	return nroots;
+}
+
+/*============================================================================*/
+
+static void lasieve_fb_init(lasieve_fb_t *fb, mpz_poly_t *poly, uint32 lim,
+	uint32 lpb, uint32 mfb, double lambda, uint64 *primes, uint64 num_p)
+{
+	uint32 roots[MAX_POLY_DEGREE];
+	uint64 k;
+	int i, n;
+
+	fb->poly = poly;
+	fb->degree = poly->degree;
+	for (i = 0; i <= fb->degree; i++)
+		fb->coeff[i] = mpz_get_d(poly->coeff[i]);
+
+	fb->lim = lim;
+	fb->lpb = MIN(lpb, 32);
+	fb->mfb = mfb;
+	fb->lambda = lambda;
+
+	fb->alloc = 1024;
+	fb->num = 0;
+	fb->p = (uint32 *)xmalloc(fb->alloc * sizeof(uint32));
+	fb->r = (uint32 *)xmalloc(fb->alloc * sizeof(uint32));
+	fb->logp = (uint8 *)xmalloc(fb->alloc * sizeof(uint8));
+
+	for (k = 0; (k < num_p) && (primes[k] <= lim); k++)
+	{
+		uint32 p = (uint32)primes[k];
+
+		n = lasieve_roots(poly, p, roots);
+		for (i = 0; i < n; i++)
+		{
+			if (fb->num == fb->alloc)
+			{
+				fb->alloc *= 2;
+				fb->p = (uint32 *)xrealloc(fb->p, fb->alloc * sizeof(uint32));
+				fb->r = (uint32 *)xrealloc(fb->r, fb->alloc * sizeof(uint32));
+				fb->logp = (uint8 *)xrealloc(fb->logp, fb->alloc * sizeof(uint8));
+			}
+
+			fb->p[fb->num] = p;
+			fb->r[fb->num] = roots[i];
+			fb->logp[fb->num] = (uint8)(log((double)p) / log(2.0) + 0.5);
+			fb->num++;
+		}
+	}
+
+	return;
+}
+
+static void lasieve_fb_free(lasieve_fb_t *fb)
+{
+	free(fb->p);
+	free(fb->r);
+	free(fb->logp);
+	return;
+}
+
+static void lasieve_reduce(lasieve_spq_t *spq, uint32 r, double skew)
+{
+	// gauss reduce the basis (q,0), (r,1) of {(a,b) : a = r*b mod q} with
+	// the norm a^2 + (skew*b)^2, so the sieve region is roughly square in
+	// the skewed (a,b) plane
+	int64 x0 = spq->q, y0 = 0, x1 = r, y1 = 1, t;
+	double s2 = skew * skew;
+
+	while (1)
+	{
+		double n0 = (double)x0 * (double)x0 + s2 * (double)y0 * (double)y0;
+		double n1 = (double)x1 * (double)x1 + s2 * (double)y1 * (double)y1;
+		double dot;
+		int64 mu;
+
+		if (n1 < n0)
+		{
+			t = x0; x0 = x1; x1 = t;
+			t = y0; y0 = y1; y1 = t;
+			dot = n0; n0 = n1; n1 = dot;
+		}
+
+		dot = (double)x0 * (double)x1 + s2 * (double)y0 * (double)y1;
+		mu = (int64)floor(dot / n0 + 0.5);
+		if (mu == 0)
+			break;
+
+		x1 -= mu * x0;
+		y1 -= mu * y0;
+	}
+
+	spq->a0 = x0;
+	spq->b0 = y0;
+	spq->a1 = x1;
+	spq->b1 = y1;
+	return;
+}
+
+static uint64 lasieve_gcd(uint64 x, uint64 y)
+{
+	while (y != 0)
+	{
+		uint64 t = x % y;
+		x = y;
+		y = t;
+	}
+	return x;
+}
+
+static uint32 lasieve_mod(int64 x, uint32 p)
+{
+	int64 m = x % (int64)p;
+	return (uint32)(m < 0 ? m + p : m);
+}
+
+static void lasieve_record(lasieve_hits_t *h, uint32 pos, uint32 p)
+{
+	if (h->num == h->alloc)
+	{
+		h->alloc *= 2;
+		h->hits = (lasieve_hit_t *)xrealloc(h->hits, h->alloc * sizeof(lasieve_hit_t));
+	}
+	h->hits[h->num].pos = pos;
+	h->hits[h->num].p = p;
+	h->num++;
+	return;
+}
+
+static void lasieve_side(lasieve_fb_t *fb, lasieve_spq_t *spq, int side,
+	uint8 *sieve, lasieve_hits_t *hits)
+{
+	// with hits == NULL, add log p at every location of the region on
+	// each factor base ideal.  otherwise visit the same locations, and
+	// record the prime wherever sieve is nonzero.
+	uint32 k;
+
+	for (k = 0; k < fb->num; k++)
+	{
+		uint32 p = fb->p[k];
+		uint32 R = fb->r[k];
+		uint8 logp = fb->logp[k];
+		uint32 u, w, rho;
+
+		if ((side == spq->side) && (p == spq->q))
+			continue;
+
+		// i*(a0 - R*b0) + j*(a1 - R*b1) = 0 mod p
+		u = lasieve_mod(spq->a0, p);
+		u = lpoly_addmod(u, p - lpoly_mulmod(R, lasieve_mod(spq->b0, p), p), p);
+		w = lasieve_mod(spq->a1, p);
+		w = lpoly_addmod(w, p - lpoly_mulmod(R, lasieve_mod(spq->b1, p), p), p);
+
+		// the ideal contains the whole row j = 0 mod p (or the whole
+		// region) - rare, and left to cofactorization
+		if (u == 0)
+			continue;
+
+		// hits are at i = rho*j mod p
+		rho = lpoly_mulmod((p - w) % p, modinv_1(u, p), p);
+
+		if (p < LASIEVE_I)
+		{
+			uint32 x0 = (LASIEVE_I / 2) % p;
+			uint32 j, x;
+
+			for (j = 1; j < LASIEVE_J; j++)
+			{
+				uint8 *row = sieve + j * LASIEVE_I;
+
+				x0 += rho;
+				if (x0 >= p)
+					x0 -= p;
+
+				if (hits == NULL)
+				{
+					for (x = x0; x < LASIEVE_I; x += p)
+						row[x] += logp;
+				}
+				else
+				{
+					for (x = x0; x < LASIEVE_I; x += p)
+						if (row[x])
+							lasieve_record(hits, j * LASIEVE_I + x, p);
+				}
+			}
+		}
+		else if (rho == 0)
+		{
+			// only i = 0
+			uint32 j, pos;
+
+			for (j = 1; j < LASIEVE_J; j++)
+			{
+				pos = j * LASIEVE_I + LASIEVE_I / 2;
+				if (hits == NULL)
+					sieve[pos] += logp;
+				else if (sieve[pos])
+					lasieve_record(hits, pos, p);
+			}
+		}
+		else
+		{
+			// franke-kleinjung: reduce the basis (-p,0), (rho,1) to
+			// (alpha,beta), (gamma,delta) with -I < alpha <= 0 <= gamma < I
+			// and gamma - alpha >= I.  then the next lattice point in the
+			// strip 0 <= x < I after (x,j) is always one of +v, +w or +v+w.
+			int64 alpha = -(int64)p, beta = 0, gamma = rho, delta = 1, c;
+			int64 x;
+			uint32 j;
+
+			while (1)
+			{
+				if (gamma < LASIEVE_I)
+				{
+					c = (-alpha - LASIEVE_I) / gamma + 1;
+					alpha += c * gamma;
+					beta += c * delta;
+					break;
+				}
+
+				c = -alpha / gamma;
+				alpha += c * gamma;
+				beta += c * delta;
+
+				if (-alpha < LASIEVE_I)
+				{
+					c = (gamma - LASIEVE_I) / (-alpha) + 1;
+					gamma += c * alpha;
+					delta += c * beta;
+					break;
+				}
+
+				c = gamma / (-alpha);
+				gamma += c * alpha;
+				delta += c * beta;
+			}
+
+			x = LASIEVE_I / 2;
+			j = 0;
+			while (1)
+			{
+				uint32 pos;
+
+				if (x >= -alpha)
+				{
+					x += alpha;
+					j += (uint32)beta;
+				}
+				else if (x < LASIEVE_I - gamma)
+				{
+					x += gamma;
+					j += (uint32)delta;
+				}
+				else
+				{
+					x += alpha + gamma;
+					j += (uint32)(beta + delta);
+				}
+
+				if (j >= LASIEVE_J)
+					break;
+
+				pos = j * LASIEVE_I + (uint32)x;
+				if (hits == NULL)
+					sieve[pos] += logp;
+				else if (sieve[pos])
+					lasieve_record(hits, pos, p);
+			}
+		}
+	}
+
+	return;
+}
+
+static void lasieve_thresholds(lasieve_fb_t *fb, lasieve_spq_t *spq, int side,
+	uint8 *thresh)
+{
+	// per block of each row: the sieve value above which the cofactor left
+	// after the factor base primes is small enough to be worth a look
+	double logq = (side == spq->side) ? log((double)spq->q) / log(2.0) : 0.;
+	double slack = (fb->lambda > 0.) ? 
+		MIN((double)fb->mfb, fb->lambda * (double)fb->lpb) : (double)fb->mfb;
+	uint32 j, blk;
+	int k;
+
+	for (j = 1; j < LASIEVE_J; j++)
+	{
+		for (blk = 0; blk < LASIEVE_I / LASIEVE_BLOCK; blk++)
+		{
+			double i = (double)(blk * LASIEVE_BLOCK + LASIEVE_BLOCK / 2) - LASIEVE_I / 2;
+			double a = i * (double)spq->a0 + (double)j * (double)spq->a1;
+			double b = i * (double)spq->b0 + (double)j * (double)spq->b1;
+			double v = fb->coeff[fb->degree], bp = 1., t;
+
+			// homogeneous evaluation: sum c_k a^k b^(d-k)
+			for (k = fb->degree - 1; k >= 0; k--)
+			{
+				bp *= b;
+				v = v * a + fb->coeff[k] * bp;
+			}
+
+			t = (fabs(v) < 1.) ? 0. : log(fabs(v)) / log(2.0);
+			t -= logq + slack + LASIEVE_FUDGE;
+			if (t < 0.)
+				t = 0.;
+			if (t > 255.)
+				t = 255.;
+			thresh[j * (LASIEVE_I / LASIEVE_BLOCK) + blk] = (uint8)t;
+		}
+	}
+
+	return;
+}
+
+static int lasieve_hit_cmp(const void *x, const void *y)
+{
+	const lasieve_hit_t *a = (const lasieve_hit_t *)x;
+	const lasieve_hit_t *b = (const lasieve_hit_t *)y;
+
+	if (a->pos < b->pos)
+		return -1;
+	else if (a->pos > b->pos)
+		return 1;
+	return 0;
+}
+
+static int lasieve_divide_out(mpz_t n, uint32 p, uint32 *f, int *nf)
+{
+	while (mpz_divisible_ui_p(n, p))
+	{
+		if (*nf == LASIEVE_MAX_FACTORS)
+			return 0;
+		mpz_divexact_ui(n, n, p);
+		f[(*nf)++] = p;
+	}
+	return 1;
+}
+
+static int lasieve_cofactor(mpz_t n, lasieve_fb_t *fb, uint32 *f, int *nf)
+{
+	// what's left of a norm after the factor base primes must be 1, a
+	// prime below 2^lpb, or a product of two of them below 2^mfb
+	uint64 f1, f2;
+	uint32 bits;
+
+	if (mpz_cmp_ui(n, 1) == 0)
+		return 1;
+
+	bits = mpz_sizeinbase(n, 2);
+	if ((bits > fb->mfb) || (*nf > LASIEVE_MAX_FACTORS - 2))
+		return 0;
+
+	if (mpz_probab_prime_p(n, 1))
+	{
+		if (bits > fb->lpb)
+			return 0;
+		f[(*nf)++] = (uint32)mpz_get_ui(n);
+		return 1;
+	}
+
+	if (bits > 62)
+		return 0;
+
+	f1 = sp_shanks_loop(n, NULL);
+	f2 = mpz_get_64(n);
+	if ((f1 <= 1) || (f1 >= f2) || (f2 % f1 != 0))
+		return 0;
+	f2 /= f1;
+
+	if ((f1 >> fb->lpb) || (f2 >> fb->lpb))
+		return 0;
+
+	// three large primes aren't allowed
+	mpz_set_64(n, f1);
+	if (!mpz_probab_prime_p(n, 1))
+		return 0;
+	mpz_set_64(n, f2);
+	if (!mpz_probab_prime_p(n, 1))
+		return 0;
+
+	f[(*nf)++] = (uint32)f1;
+	f[(*nf)++] = (uint32)f2;
+	return 1;
+}
+
+static void lasieve_norm(mpz_t norm, mpz_poly_t *poly, int64 a, uint64 b, mpz_t t)
+{
+	// |sum c_k a^k b^(d-k)|
+	mpz_t bp;
+	int k;
+
+	mpz_init_set_ui(bp, 1);
+	mpz_set(norm, poly->coeff[poly->degree]);
+	for (k = poly->degree - 1; k >= 0; k--)
+	{
+		mpz_set_64(t, (uint64)(a < 0 ? -a : a));
+		if (a < 0)
+			mpz_neg(t, t);
+		mpz_mul(norm, norm, t);
+
+		mpz_set_64(t, b);
+		mpz_mul(bp, bp, t);
+		mpz_mul(t, bp, poly->coeff[k]);
+		mpz_add(norm, norm, t);
+	}
+	mpz_abs(norm, norm);
+	mpz_clear(bp);
+	return;
+}
+
+uint32 nfs_lasieve(fact_obj_t *fobj, nfs_job_t *job, uint32 startq, uint32 qrange,
+	char *outfile)
+{
+	// sieve special-q in [startq, startq + qrange) and append the relations
+	// found to outfile.  returns the number of relations.
+	lasieve_fb_t fb[2];
+	lasieve_spq_t spq;
+	lasieve_hits_t hits[2];
+	uint8 *sieve[2], *thresh[2];
+	uint32 *cand, num_cand, alloc_cand;
+	uint64 *primes, num_p, k;
+	uint32 lim, count = 0, num_spq = 0;
+	uint32 roots[MAX_POLY_DEGREE];
+	uint32 f[2][LASIEVE_MAX_FACTORS];
+	int nf[2];
+	mpz_t norm, t;
+	double skew;
+	struct timeval start, stop;
+	TIME_DIFF *	difference;
+	double t_time;
+	FILE *out;
+	int side, i;
+
+	if ((job->poly == NULL) || (job->poly->alg.degree < 1))
+	{
+		printf("nfs: built-in siever has no polynomial to sieve\n");
+		return 0;
+	}
+
+	skew = (job->poly->skew > 0.) ? job->poly->skew : 1.;
+
+	gettimeofday(&start, NULL);
+
+	out = fopen(outfile, "a");
+	if (out == NULL)
+	{
+		printf("fopen error: %s\n", strerror(errno));
+		printf("could not open %s for appending\n", outfile);
+		return 0;
+	}
+
+	spq.side = (job->poly->side == RATIONAL_SPQ) ? 0 : 1;
+
+	// factor bases, and the special-q.  the shared prime cache is safe to
+	// use from several sieving threads at once.
+	lim = MAX(job->rlim, job->alim);
+	primes = get_prime_cache(MAX(lim, (uint64)startq + qrange), &num_p);
+	lasieve_fb_init(&fb[0], &job->poly->rat, job->rlim, job->lpbr,
+		MIN(job->mfbr, 62), job->rlambda, primes, num_p);
+	lasieve_fb_init(&fb[1], &job->poly->alg, job->alim, job->lpba,
+		MIN(job->mfba, 62), job->alambda, primes, num_p);
+
+	if (VFLAG > 1)
+		printf("nfs: built-in siever: %u rational and %u algebraic factor base ideals\n",
+			fb[0].num, fb[1].num);
+
+	for (side = 0; side < 2; side++)
+	{
+		sieve[side] = (uint8 *)xmalloc(LASIEVE_I * LASIEVE_J * sizeof(uint8));
+		thresh[side] = (uint8 *)xmalloc(LASIEVE_J * (LASIEVE_I / LASIEVE_BLOCK) * sizeof(uint8));
+		hits[side].alloc = 4096;
+		hits[side].num = 0;
+		hits[side].hits = (lasieve_hit_t *)xmalloc(hits[side].alloc * sizeof(lasieve_hit_t));
+	}
+	alloc_cand = 1024;
+	cand = (uint32 *)xmalloc(alloc_cand * sizeof(uint32));
+	mpz_init(norm);
+	mpz_init(t);
+
+	for (k = 0; (k < num_p) && (primes[k] < startq); k++);
+
+	for (; (k < num_p) && (NFS_ABORT == 0); k++)
+	{
+		uint32 nroots, r;
+
+		if (primes[k] >= (uint64)startq + qrange)
+			break;
+		spq.q = (uint32)primes[k];
+
+		nroots = lasieve_roots(spq.side ? &job->poly->alg : &job->poly->rat,
+			spq.q, roots);
+
+		for (r = 0; r < nroots; r++)
+		{
+			uint32 j, x, c;
+
+			lasieve_reduce(&spq, roots[r], skew);
+			num_spq++;
+
+			// sieve both sides
+			for (side = 0; side < 2; side++)
+			{
+				memset(sieve[side], 0, LASIEVE_I * LASIEVE_J);
+				lasieve_side(&fb[side], &spq, side, sieve[side], NULL);
+				lasieve_thresholds(&fb[side], &spq, side, thresh[side]);
+			}
+
+			// survivors on both sides, skipping (i,j) both even
+			num_cand = 0;
+			for (j = 1; j < LASIEVE_J; j++)
+			{
+				uint8 *s0 = sieve[0] + j * LASIEVE_I;
+				uint8 *s1 = sieve[1] + j * LASIEVE_I;
+				uint8 *t0 = thresh[0] + j * (LASIEVE_I / LASIEVE_BLOCK);
+				uint8 *t1 = thresh[1] + j * (LASIEVE_I / LASIEVE_BLOCK);
+
+				for (x = 0; x < LASIEVE_I; x++)
+				{
+					if ((s0[x] < t0[x / LASIEVE_BLOCK]) ||
+						(s1[x] < t1[x / LASIEVE_BLOCK]))
+						continue;
+
+					if (((j & 1) == 0) && ((x & 1) == 0))
+						continue;
+
+					if (num_cand == alloc_cand)
+					{
+						alloc_cand *= 2;
+						cand = (uint32 *)xrealloc(cand, alloc_cand * sizeof(uint32));
+					}
+					cand[num_cand++] = j * LASIEVE_I + x;
+				}
+			}
+
+			if (num_cand == 0)
+				continue;
+
+			// resieve to find the factor base primes of the survivors
+			memset(sieve[0], 0, LASIEVE_I * LASIEVE_J);
+			for (c = 0; c < num_cand; c++)
+				sieve[0][cand[c]] = 1;
+
+			for (side = 0; side < 2; side++)
+			{
+				hits[side].num = 0;
+				lasieve_side(&fb[side], &spq, side, sieve[0], &hits[side]);
+				qsort(hits[side].hits, hits[side].num, sizeof(lasieve_hit_t),
+					&lasieve_hit_cmp);
+			}
+
+			// check each survivor for real
+			{
+				uint32 h[2] = {0, 0};
+
+				for (c = 0; c < num_cand; c++)
+				{
+					uint32 pos = cand[c];
+					int64 ii = (int64)(pos % LASIEVE_I) - LASIEVE_I / 2;
+					int64 jj = pos / LASIEVE_I;
+					int64 a = ii * spq.a0 + jj * spq.a1;
+					int64 b = ii * spq.b0 + jj * spq.b1;
+					int ok = 1;
+
+					if (b < 0)
+					{
+						a = -a;
+						b = -b;
+					}
+
+					// skip over this location's hits whatever happens
+					for (side = 0; side < 2; side++)
+					{
+						uint32 first = h[side];
+
+						while ((h[side] < hits[side].num) && (hits[side].hits[h[side]].pos == pos))
+							h[side]++;
+
+						if (!ok)
+							continue;
+
+						if ((b == 0) || (b >> 32) ||
+							(lasieve_gcd((uint64)(a < 0 ? -a : a), (uint64)b) != 1))
+						{
+							ok = 0;
+							continue;
+						}
+
+						lasieve_norm(norm, side ? &job->poly->alg : &job->poly->rat, a, b, t);
+						if (mpz_sgn(norm) == 0)
+						{
+							ok = 0;
+							continue;
+						}
+
+						nf[side] = 0;
+						if (side == spq.side)
+							ok = lasieve_divide_out(norm, spq.q, f[side], &nf[side]);
+
+						for (i = first; ok && (i < (int)h[side]); i++)
+							ok = lasieve_divide_out(norm, hits[side].hits[i].p, f[side], &nf[side]);
+
+						for (i = 0; ok && (i < (int)szSOEp) && (spSOEprimes[i] < LASIEVE_TD_BOUND); i++)
+							ok = lasieve_divide_out(norm, spSOEprimes[i], f[side], &nf[side]);
+
+						if (ok)
+							ok = lasieve_cofactor(norm, &fb[side], f[side], &nf[side]);
+					}
+
+					if (!ok)
+						continue;
+
+					// ggnfs lists the special-q last on its side, which is
+					// where get_spq looks for it when a job is resumed
+					for (i = 0, j = 0; i < nf[spq.side]; i++)
+					{
+						if (f[spq.side][i] != spq.q)
+							f[spq.side][j++] = f[spq.side][i];
+					}
+					for (; j < (uint32)nf[spq.side]; j++)
+						f[spq.side][j] = spq.q;
+
+					if (a < 0)
+						fprintf(out, "-%" PRIu64 ",%" PRIu64 ":", (uint64)(-a), (uint64)b);
+					else
+						fprintf(out, "%" PRIu64 ",%" PRIu64 ":", (uint64)a, (uint64)b);
+
+					for (side = 0; side < 2; side++)
+					{
+						for (i = 0; i < nf[side]; i++)
+							fprintf(out, "%x%s", f[side][i], (i < nf[side] - 1) ? "," : "");
+						fprintf(out, "%s", side ? "\n" : ":");
+					}
+					count++;
+				}
+			}
+		}
+	}
+
+	fclose(out);
+
+	gettimeofday(&stop, NULL);
+	difference = my_difftime(&start, &stop);
+	t_time = ((double)difference->secs + (double)difference->usecs / 1000000);
+	free(difference);
+
+	if (VFLAG > 0)
+		printf("nfs: built-in siever found %u relations from %u special-q "
+			"in %1.2f sec (%1.4f sec/rel)\n", count, num_spq, t_time,
+			count > 0 ? t_time / count : 0.);
+
+	mpz_clear(norm);
+	mpz_clear(t);
+	free(cand);
+	for (side = 0; side < 2; side++)
+	{
+		free(sieve[side]);
+		free(thresh[side]);
+		free(hits[side].hits);
+		lasieve_fb_free(&fb[side]);
+	}
+
+	return count;
+}
+
+#endif
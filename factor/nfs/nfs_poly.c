@@ -218,6 +218,65 @@ cleanup:
 	return retcode;
 }
 
+static double polysearch_best_e(char *filename)
+{
+	// best murphy e score among the polys in a msieve .p file
+	FILE *in;
+	char line[GSTR_MAXSIZE], *ptr;
+	double score, best = 0.;
+
+	in = fopen(filename, "r");
+	if (in == NULL)
+		return 0.;
+
+	while (fgets(line, GSTR_MAXSIZE, in) != NULL)
+	{
+		if (line[0] != '#')
+			continue;
+
+		// comment lines look like "# norm x alpha y e z rroots w"
+		ptr = strstr(line, " e ");
+		if (ptr == NULL)
+			ptr = strstr(line, " e\t");
+		if (ptr == NULL)
+			continue;
+
+		score = strtod(ptr + 3, NULL);
+		if (score > best)
+			best = score;
+	}
+	fclose(in);
+
+	return best;
+}
+
+static double polysearch_savings_rate(double t_elapsed, double best_e, 
+	double *rec_time, double *rec_e, int num_rec, double sieve_est)
+{
+	// estimate how many seconds of sieving another second of poly search
+	// saves.  sieving time goes roughly as 1/E, so a relative gain in the
+	// best E is the same relative saving in sieving time.  the rate of 
+	// gain is taken from the second half of the search so far, which
+	// naturally slows down as new records get harder to find.
+	double e_half = 0.;
+	int i;
+
+	if ((num_rec == 0) || (t_elapsed <= 0.))
+		return 1e99;
+
+	for (i = 0; i < num_rec; i++)
+	{
+		if (rec_time[i] <= t_elapsed / 2.)
+			e_half = rec_e[i];
+	}
+
+	// nothing yet in the first half: too early to tell
+	if (e_half == 0.)
+		return 1e99;
+
+	return sieve_est * (best_e / e_half - 1.) / (t_elapsed / 2.);
+}
+
 void do_msieve_polyselect(fact_obj_t *fobj, msieve_obj *obj, nfs_job_t *job, 
 	mp_t *mpN, factor_list_t *factor_list)
 {
@@ -248,6 +307,13 @@ void do_msieve_polyselect(fact_obj_t *fobj, msieve_obj *obj, nfs_job_t *job,
 	TIME_DIFF *	difference;
 	double t_time;
 
+	// adaptive stopping: the best e score found so far, and when each
+	// new best was found
+	uint32 min_deadline, max_deadline;
+	double best_e = 0., range_e, sieve_est, savings = 0.;
+	double *rec_time, *rec_e;
+	int num_rec = 0, search_done = 0;
+
 	//file into which we will combine all of the thread results
 	sprintf(master_polyfile,"%s.p",fobj->nfs_obj.outputfile);
 
@@ -325,30 +391,49 @@ void do_msieve_polyselect(fact_obj_t *fobj, msieve_obj *obj, nfs_job_t *job,
 	if (fobj->nfs_obj.poly_option == 0)
 	{
 		// 'fast' search.  scale by number of threads
-		deadline /= THREADS;
+		deadline /= fobj->num_threads;
 	}
 
+	// the deadline is a nominal budget: stop as early as a quarter of it 
+	// if the search has stopped paying for itself, or run up to twice it
+	// if it still does.  it pays for itself while a second of search is 
+	// expected to save at least a second of sieving.
+	min_deadline = deadline / 4;
+	max_deadline = 2 * deadline;
+	sieve_est = get_gnfs_time_estimate(fobj, fobj->nfs_obj.gmp_n);
+	if (sieve_est <= 0.)
+	{
+		// no tune info to estimate sieving time with: fixed deadline
+		min_deadline = deadline;
+		max_deadline = deadline;
+	}
+	rec_time = (double *)malloc(1024 * sizeof(double));
+	rec_e = (double *)malloc(1024 * sizeof(double));
+
 	if (VFLAG > 0)
 		printf("nfs: setting deadline of %u seconds\n",deadline);
+	if (VFLAG > 0)
+		printf("nfs: search may stop after %u or extend to %u seconds, estimated sieving time is %1.0f seconds\n",
+			min_deadline, max_deadline, sieve_est);
 
 	//start a counter for the poly selection
 	gettimeofday(&startt, NULL);
 
 	//init each thread data structure with info needed to do poly search on a range
-	thread_data = (nfs_threaddata_t *)malloc(THREADS * sizeof(nfs_threaddata_t));
+	thread_data = (nfs_threaddata_t *)malloc(fobj->num_threads * sizeof(nfs_threaddata_t));
 
 	// allocate the queue of threads waiting for work
-	thread_queue = (int *)malloc(THREADS * sizeof(int));
+	thread_queue = (int *)malloc(fobj->num_threads * sizeof(int));
 	threads_waiting = (int *)malloc(sizeof(int));
 
-	if (THREADS > 1)
+	if (fobj->num_threads > 1)
 	{
 #if defined(WIN32) || defined(_WIN64)
 		queue_lock = CreateMutex( 
 			NULL,              // default security attributes
 			FALSE,             // initially not owned
 			NULL);             // unnamed mutex
-		queue_events = (HANDLE *)malloc(THREADS * sizeof(HANDLE));
+		queue_events = (HANDLE *)malloc(fobj->num_threads * sizeof(HANDLE));
 #else
 		pthread_mutex_init(&queue_lock, NULL);
 		pthread_cond_init(&queue_cond, NULL);
@@ -363,7 +448,7 @@ void do_msieve_polyselect(fact_obj_t *fobj, msieve_obj *obj, nfs_job_t *job,
 	flags = flags | MSIEVE_FLAG_NFS_POLYSIZE;
 	flags = flags | MSIEVE_FLAG_NFS_POLYROOT;
 	
-	for (i=0; i<THREADS; i++)
+	for (i=0; i<fobj->num_threads; i++)
 	{
 		nfs_threaddata_t *t = thread_data + i;		
 		t->fobj = fobj;
@@ -379,7 +464,7 @@ void do_msieve_polyselect(fact_obj_t *fobj, msieve_obj *obj, nfs_job_t *job,
 		t->thread_queue = thread_queue;
         t->threads_waiting = threads_waiting;
 
-		if (THREADS > 1)
+		if (fobj->num_threads > 1)
 		{
 #if defined(WIN32) || defined(_WIN64)
 			// assign a pointer to the mutex
@@ -402,7 +487,7 @@ void do_msieve_polyselect(fact_obj_t *fobj, msieve_obj *obj, nfs_job_t *job,
 	}
 	else
 	{
-		logprint(logfile, "nfs: commencing poly selection with %d threads\n",THREADS);
+		logprint(logfile, "nfs: commencing poly selection with %d threads\n",fobj->num_threads);
 		logprint(logfile, "nfs: setting deadline of %u seconds\n",deadline);
 		fclose(logfile);
 	}
@@ -410,19 +495,19 @@ void do_msieve_polyselect(fact_obj_t *fobj, msieve_obj *obj, nfs_job_t *job,
 	// determine the start and range values
 	get_polysearch_params(fobj, &start, &range);	
 
-	if (THREADS > 1)
+	if (fobj->num_threads > 1)
 	{
 		// Activate the worker threads one at a time. 
 		// Initialize the work queue to say all threads are waiting for work
-		for (i = 0; i < THREADS; i++) 
+		for (i = 0; i < fobj->num_threads; i++) 
 		{
 			nfs_start_worker_thread(thread_data + i, 2);
 			thread_queue[i] = i;
 		}
 	}
-	*threads_waiting = THREADS;
+	*threads_waiting = fobj->num_threads;
 
-	if (THREADS > 1)
+	if (fobj->num_threads > 1)
 	{
 #if defined(WIN32) || defined(_WIN64)
 		// nothing
@@ -449,7 +534,7 @@ void do_msieve_polyselect(fact_obj_t *fobj, msieve_obj *obj, nfs_job_t *job,
 			if (!is_startup)
 				threads_working--;
 
-			if (THREADS > 1)
+			if (fobj->num_threads > 1)
 			{
 				// Pop a waiting thread off the queue (OK, it's stack not a queue)
 #if defined(WIN32) || defined(_WIN64)
@@ -535,6 +620,27 @@ void do_msieve_polyselect(fact_obj_t *fobj, msieve_obj *obj, nfs_job_t *job,
 				fprintf(fid, "time: %u\n", total_time);
 				fclose(fid);
 
+				// track the best score so far
+				sprintf(syscmd, "%s.p",t->polyfilename); 
+				range_e = polysearch_best_e(syscmd);
+				if (range_e > best_e)
+				{
+					best_e = range_e;
+					if (num_rec < 1024)
+					{
+						rec_time[num_rec] = t_time;
+						rec_e[num_rec] = best_e;
+						num_rec++;
+					}
+					else
+					{
+						rec_time[num_rec - 1] = t_time;
+						rec_e[num_rec - 1] = best_e;
+					}
+
+					if (VFLAG > 0)
+						printf("nfs: new best e score %1.3e after %1.0f seconds\n", best_e, t_time);
+				}
 			}
 
 			// remove each thread's .p file after it's copied
@@ -558,9 +664,34 @@ void do_msieve_polyselect(fact_obj_t *fobj, msieve_obj *obj, nfs_job_t *job,
 			if (NFS_ABORT)
 				break;
 
+			// decide whether the search goes on.  past the minimum, it stops once
+			// the expected savings in sieving time no longer cover the search 
+			// time.  past the nominal deadline it continues only while they 
+			// clearly do, and never past the maximum.
+			if (!search_done && !is_startup && (fobj->nfs_obj.polyrange == 0))
+			{
+				uint32 t_next = (uint32)t_time + estimated_range_time;
+
+				savings = polysearch_savings_rate(t_time, best_e, rec_time, rec_e, 
+					num_rec, sieve_est);
+
+				if (t_next > max_deadline)
+					search_done = 1;
+				else if ((t_next > deadline) && (savings < 2.0))
+					search_done = 1;
+				else if (((uint32)t_time >= min_deadline) && (savings < 1.0))
+					search_done = 1;
+
+				if (search_done && (VFLAG > 0))
+					printf("nfs: stopping poly search after %1.0f seconds, "
+						"expected sieving savings %1.2f sec per sec of search\n",
+						t_time, savings);
+			}
+
 			// if we can re-start the thread such that it is likely to finish before the
 			// deadline, go ahead and do so.
-			if ((uint32)t_time + estimated_range_time <= deadline)
+			if (!search_done && ((fobj->nfs_obj.polyrange == 0) || 
+				((uint32)t_time + estimated_range_time <= deadline)))
 			{
 
 				// unless the user has specified a custom range search, in which case
@@ -587,7 +718,7 @@ void do_msieve_polyselect(fact_obj_t *fobj, msieve_obj *obj, nfs_job_t *job,
 					}
 
 					// signal the job to start
-					if (THREADS > 1)
+					if (fobj->num_threads > 1)
 					{
 						// send the thread a signal to start processing the poly we just generated for it
 #if defined(WIN32) || defined(_WIN64)
@@ -606,7 +737,7 @@ void do_msieve_polyselect(fact_obj_t *fobj, msieve_obj *obj, nfs_job_t *job,
 				}
 			}
 
-			if (THREADS == 1)
+			if (fobj->num_threads == 1)
 				*threads_waiting = 0;
 
 		}
@@ -619,12 +750,12 @@ void do_msieve_polyselect(fact_obj_t *fobj, msieve_obj *obj, nfs_job_t *job,
 		if (threads_working == 0)
 			break;
 
-		if (THREADS > 1)
+		if (fobj->num_threads > 1)
 		{
 			// wait for a thread to finish and put itself in the waiting queue
 #if defined(WIN32) || defined(_WIN64)
 			j = WaitForMultipleObjects(
-				THREADS,
+				fobj->num_threads,
 				queue_events,
 				FALSE,
 				INFINITE);
@@ -654,8 +785,8 @@ void do_msieve_polyselect(fact_obj_t *fobj, msieve_obj *obj, nfs_job_t *job,
 		printf("custom range search complete in %6.4f seconds\n",t_time);
 	}
 	else if (VFLAG >= 0)
-		printf("elapsed time of %6.4f seconds exceeds %u second deadline; poly select done\n",
-			t_time,deadline);
+		printf("poly select done after %6.4f seconds (nominal deadline %u seconds), best e = %1.3e\n",
+			t_time, deadline, best_e);
 	
 	logfile = fopen(fobj->flogname, "a");
 	if (logfile == NULL)
@@ -667,14 +798,19 @@ void do_msieve_polyselect(fact_obj_t *fobj, msieve_obj *obj, nfs_job_t *job,
 	{
 		logprint(logfile, "nfs: completed %u ranges of size %" PRIu64 " in %6.4f seconds\n",
 			num_ranges, range, t_time);
+		logprint(logfile, "nfs: best e score %1.3e, expected sieving savings at stop %1.2f sec/sec\n",
+			best_e, savings);
 		fclose(logfile);
 	}
 
+	free(rec_time);
+	free(rec_e);
+
 	//stop worker threads
-	for (i=0; i<THREADS; i++)
+	for (i=0; i<fobj->num_threads; i++)
 	{
 		//static_conf->tot_poly += thread_data[i].dconf->tot_poly;
-		if (THREADS > 1)
+		if (fobj->num_threads > 1)
 			nfs_stop_worker_thread(thread_data + i, 2);
 	}
 
@@ -684,7 +820,7 @@ void do_msieve_polyselect(fact_obj_t *fobj, msieve_obj *obj, nfs_job_t *job,
 	free(threads_waiting);
 
 #if defined(WIN32) || defined(_WIN64)
-	if (THREADS > 1)
+	if (fobj->num_threads > 1)
 		free(queue_events);
 #endif
 
@@ -719,8 +855,8 @@ void init_poly_threaddata(nfs_threaddata_t *t, msieve_obj *obj,
 	//create an msieve_obj.  for poly select, the intermediate output file should be specified in
 	//the savefile field
 	t->obj = msieve_obj_new(obj->input, flags, t->polyfilename, t->logfilename, t->fbfilename, 
-		g_rand.low, g_rand.hi, (uint32)0,
-		obj->cpu, (uint32)L1CACHE, (uint32)L2CACHE, (uint32)THREADS, (uint32)0, nfs_args);
+		fobj->seed1, fobj->seed2, (uint32)0,
+		obj->cpu, (uint32)L1CACHE, (uint32)L2CACHE, (uint32)fobj->num_threads, (uint32)0, nfs_args);
 
 	//pointers to things that are static during poly select
 	t->mpN = mpN;
@@ -744,7 +880,7 @@ void get_polysearch_params(fact_obj_t *fobj, uint64 *start, uint64 *range)
 		// search custom range of leading coefficient.  This effectively ignores the deadline
 		// because the deadline is only checked after each range is done.  if we assign the
 		// entire range up front, the deadline is never checked before polysearch finishes.
-		*range = fobj->nfs_obj.polyrange / THREADS;
+		*range = fobj->nfs_obj.polyrange / fobj->num_threads;
 
 		// sanity check
 		if (*range == 0) *range = 1;
@@ -0,0 +1,395 @@
+/*----------------------------------------------------------------------
+This source distribution is placed in the public domain by its author,
+Ben Buhrow. You may use it for any purpose, free of charge,
+without having to notify anyone. I disclaim any responsibility for any
+errors.
+
+Optionally, please be nice and tell me if you find this source to be
+useful. Again optionally, if you add to the functionality present here
+please consider making those additions public too, so that others may
+benefit from your work.
+
+       				   --bbuhrow@gmail.com 12/6/2012
+----------------------------------------------------------------------*/
+
+#include "nfs.h"
+#include "gmp_xface.h"
+
+#ifdef USE_NFS
+
+// in-memory scoring of a polynomial pair.  this produces the same kind of
+// numbers msieve reports (size, alpha, murphy E, real roots) but without
+// building a msieve_obj and parsing its logfile, so that lots of candidate
+// polys can be scored cheaply and from several threads at once.  the
+// sieve region and factor base bounds below are fixed, so scores are
+// meant to rank polys against each other, not to predict a yield.
+
+#define POLYSCORE_PRIME_BOUND 2000		// primes used in the root property
+#define POLYSCORE_MAX_DEPTH 8			// p-adic lifting depth for repeated roots
+#define POLYSCORE_NUM_POINTS 1000		// samples along the sieve region boundary
+#define POLYSCORE_SIEVE_AREA 1e16
+#define POLYSCORE_RFB_LIMIT 5000000.
+#define POLYSCORE_AFB_LIMIT 10000000.
+
+#define DICKMAN_STEPS 256				// table entries per unit of u
+#define DICKMAN_UMAX 40
+
+static double dickman_log_rho[DICKMAN_STEPS * DICKMAN_UMAX + 1];
+static int dickman_ready = 0;
+
+void nfs_polyscore_init(void)
+{
+	// tabulate log(rho(u)) from u*rho(u) = integral of rho over [u-1,u],
+	// using the trapezoid rule.  the rho(u) term of the sum is moved to 
+	// the left side, so every entry comes out positive.  on [0,2] rho is
+	// known in closed form.
+	double *rho;
+	double h = 1.0 / DICKMAN_STEPS;
+	double sum = 0.0;
+	int i, n = DICKMAN_STEPS * DICKMAN_UMAX + 1;
+
+	if (dickman_ready)
+		return;
+
+	rho = (double *)xmalloc(n * sizeof(double));
+
+	for (i = 0; i < n; i++)
+	{
+		double u = i * h;
+
+		if (i <= DICKMAN_STEPS)
+			rho[i] = 1.0;
+		else if (i <= 2 * DICKMAN_STEPS)
+			rho[i] = 1.0 - log(u);
+		else
+		{
+			// sum holds rho[i-N+1] + ... + rho[i-1]
+			rho[i] = h * (sum + rho[i - DICKMAN_STEPS] / 2.0) / (u - h / 2.0);
+		}
+
+		if (i >= 2 * DICKMAN_STEPS)
+		{
+			sum += rho[i];
+			sum -= rho[i + 1 - DICKMAN_STEPS];
+		}
+		else if (i >= DICKMAN_STEPS + 1)
+			sum += rho[i];
+
+		dickman_log_rho[i] = log(rho[i]);
+	}
+
+	free(rho);
+	dickman_ready = 1;
+	return;
+}
+
+static double polyscore_log_rho(double u)
+{
+	double x;
+	int i;
+
+	if (u <= 1.0)
+		return 0.0;
+
+	x = u * DICKMAN_STEPS;
+	i = (int)x;
+	if (i >= DICKMAN_STEPS * DICKMAN_UMAX)
+	{
+		// extend linearly past the end of the table
+		i = DICKMAN_STEPS * DICKMAN_UMAX;
+		return dickman_log_rho[i] + (x - i) *
+			(dickman_log_rho[i] - dickman_log_rho[i - 1]);
+	}
+
+	return dickman_log_rho[i] + (x - i) *
+		(dickman_log_rho[i + 1] - dickman_log_rho[i]);
+}
+
+static double polyscore_affine_val(mpz_t *c, int deg, uint32 p, int depth)
+{
+	// expected p-adic valuation of c(x) for x uniform in Z_p.  the
+	// content is divided out, then each root r mod p contributes
+	// 1/(p-1) if it is simple, or 1/p times the valuation of c(r + p*x)
+	// if it is not.
+	mpz_t g[MAX_POLY_DEGREE + 1], h[MAX_POLY_DEGREE + 1];
+	uint32 cp[MAX_POLY_DEGREE + 1], dp[MAX_POLY_DEGREE + 1];
+	uint64 f, fd;
+	uint32 r;
+	int i, j, v = 0, all_zero = 1;
+	double sum = 0.0;
+
+	for (i = 0; i <= deg; i++)
+	{
+		mpz_init_set(g[i], c[i]);
+		mpz_init(h[i]);
+		if (mpz_sgn(c[i]) != 0)
+			all_zero = 0;
+	}
+
+	if (all_zero)
+	{
+		sum = POLYSCORE_MAX_DEPTH;
+		goto done;
+	}
+
+	while (1)
+	{
+		for (i = 0; i <= deg; i++)
+			if (!mpz_divisible_ui_p(g[i], p))
+				break;
+
+		if (i <= deg)
+			break;
+
+		for (i = 0; i <= deg; i++)
+			mpz_divexact_ui(g[i], g[i], p);
+		v++;
+	}
+
+	if (depth >= POLYSCORE_MAX_DEPTH)
+		goto done;
+
+	for (i = 0; i <= deg; i++)
+		cp[i] = mpz_fdiv_ui(g[i], p);
+	for (i = 0; i < deg; i++)
+		dp[i] = (uint32)(((uint64)(i + 1) * cp[i + 1]) % p);
+
+	for (r = 0; r < p; r++)
+	{
+		f = cp[deg];
+		for (i = deg - 1; i >= 0; i--)
+			f = (f * r + cp[i]) % p;
+
+		if (f != 0)
+			continue;
+
+		fd = 0;
+		for (i = deg - 1; i >= 0; i--)
+			fd = (fd * r + dp[i]) % p;
+
+		if (fd != 0)
+		{
+			sum += 1.0 / (double)(p - 1);
+			continue;
+		}
+
+		// repeated root: h(x) = g(r + p*x).  shift by r with
+		// synthetic division, then scale coefficient i by p^i.
+		for (i = 0; i <= deg; i++)
+			mpz_set(h[i], g[i]);
+
+		for (i = 0; i < deg; i++)
+			for (j = deg - 1; j >= i; j--)
+				mpz_addmul_ui(h[j], h[j + 1], r);
+
+		for (i = 1; i <= deg; i++)
+			for (j = i; j <= deg; j++)
+				mpz_mul_ui(h[j], h[j], p);
+
+		sum += polyscore_affine_val(h, deg, p, depth + 1) / (double)p;
+	}
+
+done:
+	for (i = 0; i <= deg; i++)
+	{
+		mpz_clear(g[i]);
+		mpz_clear(h[i]);
+	}
+
+	return (double)v + sum;
+}
+
+static double polyscore_root_score(mpz_poly_t *poly)
+{
+	// murphy's alpha: the sum over small p of the difference between
+	// the expected valuation of a random integer and that of a
+	// homogeneous value F(a,b) with a,b coprime.  coprime pairs are the
+	// points of the projective line mod p: (x:1) with weight p/(p+1) and
+	// (1:p*y) with weight 1/(p+1).
+	mpz_t rev[MAX_POLY_DEGREE + 1], pk;
+	int i, d = poly->degree;
+	uint32 k;
+	double alpha = 0.0;
+
+	mpz_init(pk);
+	for (i = 0; i <= d; i++)
+		mpz_init(rev[i]);
+
+	for (k = 0; (k < szSOEp) && (spSOEprimes[k] < POLYSCORE_PRIME_BOUND); k++)
+	{
+		uint32 p = spSOEprimes[k];
+		double aff, proj, cont;
+
+		aff = polyscore_affine_val(poly->coeff, d, p, 0);
+
+		// F(1, p*y) as a polynomial in y
+		mpz_set_ui(pk, 1);
+		for (i = 0; i <= d; i++)
+		{
+			mpz_mul(rev[i], poly->coeff[d - i], pk);
+			mpz_mul_ui(pk, pk, p);
+		}
+		proj = polyscore_affine_val(rev, d, p, 0);
+
+		cont = ((double)p * aff + proj) / (double)(p + 1);
+		alpha += (1.0 / (double)(p - 1) - cont) * log((double)p);
+	}
+
+	mpz_clear(pk);
+	for (i = 0; i <= d; i++)
+		mpz_clear(rev[i]);
+
+	return alpha;
+}
+
+static double polyscore_eval(double *c, int deg, double x)
+{
+	double f = c[deg];
+	int i;
+
+	for (i = deg - 1; i >= 0; i--)
+		f = f * x + c[i];
+
+	return f;
+}
+
+static int polyscore_real_roots(double *c, int deg, double *roots)
+{
+	// isolate the real roots of c by bisection between the real roots
+	// of its derivative, which are found the same way.  returns the
+	// number of roots found; roots are written in ascending order.
+	double dc[MAX_POLY_DEGREE + 1], crit[MAX_POLY_DEGREE + 2];
+	double bound = 0.0, flo, fhi;
+	int i, j, ncrit, n = 0;
+
+	while ((deg > 0) && (c[deg] == 0.0))
+		deg--;
+
+	if (deg == 0)
+		return 0;
+
+	if (deg == 1)
+	{
+		roots[0] = -c[0] / c[1];
+		return 1;
+	}
+
+	for (i = 0; i < deg; i++)
+	{
+		dc[i] = (double)(i + 1) * c[i + 1];
+		bound = MAX(bound, fabs(c[i] / c[deg]));
+	}
+	bound += 1.0;
+
+	crit[0] = -bound;
+	ncrit = 1 + polyscore_real_roots(dc, deg - 1, crit + 1);
+	crit[ncrit++] = bound;
+
+	for (i = 0; i < ncrit - 1; i++)
+	{
+		double lo = MAX(crit[i], -bound);
+		double hi = MIN(crit[i + 1], bound);
+
+		flo = polyscore_eval(c, deg, lo);
+		fhi = polyscore_eval(c, deg, hi);
+
+		if (flo == 0.0)
+		{
+			if ((n == 0) || (roots[n - 1] != lo))
+				roots[n++] = lo;
+			continue;
+		}
+
+		if (fhi == 0.0)
+		{
+			roots[n++] = hi;
+			continue;
+		}
+
+		if ((flo < 0.0) == (fhi < 0.0))
+			continue;
+
+		for (j = 0; j < 200; j++)
+		{
+			double mid = (lo + hi) / 2.0;
+			double fmid = polyscore_eval(c, deg, mid);
+
+			if ((mid == lo) || (mid == hi))
+				break;
+
+			if ((fmid < 0.0) == (flo < 0.0))
+				lo = mid;
+			else
+				hi = mid;
+		}
+		roots[n++] = (lo + hi) / 2.0;
+	}
+
+	return n;
+}
+
+static double polyscore_log_norm(double *c, int deg, double x, double y)
+{
+	// log |F(x,y)| for the homogenized polynomial, floored at zero
+	double f = fabs(polyscore_eval(c, deg, x / y));
+
+	if (f == 0.0)
+		return 0.0;
+
+	f = log(f) + (double)deg * log(fabs(y));
+	return (f < 0.0) ? 0.0 : f;
+}
+
+void nfs_score_poly(mpz_polys_t *poly, nfs_polyscore_t *score)
+{
+	// murphy E is the average over the boundary of the (skewed) sieve
+	// region of rho(u_r) * rho(u_a), where u = (log|F(x,y)| + alpha) /
+	// log(fb limit) on each side.  size is the same average with both
+	// alphas taken as zero, i.e. the contribution of the norms alone.
+	double rc[MAX_POLY_DEGREE + 1], ac[MAX_POLY_DEGREE + 1];
+	double roots[MAX_POLY_DEGREE];
+	double ralpha, aalpha, skew, sx, sy;
+	double lr, la, lrfb, lafb;
+	double e = 0.0, s = 0.0;
+	int i, rdeg = poly->rat.degree, adeg = poly->alg.degree;
+
+	nfs_polyscore_init();
+
+	for (i = 0; i <= rdeg; i++)
+		rc[i] = mpz_get_d(poly->rat.coeff[i]);
+	for (i = 0; i <= adeg; i++)
+		ac[i] = mpz_get_d(poly->alg.coeff[i]);
+
+	ralpha = polyscore_root_score(&poly->rat);
+	aalpha = polyscore_root_score(&poly->alg);
+
+	skew = (poly->skew > 0.) ? poly->skew : 1.0;
+	sx = sqrt(POLYSCORE_SIEVE_AREA * skew);
+	sy = sqrt(POLYSCORE_SIEVE_AREA / skew);
+	lrfb = log(POLYSCORE_RFB_LIMIT);
+	lafb = log(POLYSCORE_AFB_LIMIT);
+
+	for (i = 0; i < POLYSCORE_NUM_POINTS; i++)
+	{
+		double theta = M_PI * ((double)i + 0.5) / (double)POLYSCORE_NUM_POINTS;
+		double x = sx * cos(theta);
+		double y = sy * sin(theta);
+
+		lr = polyscore_log_norm(rc, rdeg, x, y);
+		la = polyscore_log_norm(ac, adeg, x, y);
+
+		e += exp(polyscore_log_rho((lr + ralpha) / lrfb) +
+			polyscore_log_rho((la + aalpha) / lafb));
+		s += exp(polyscore_log_rho(lr / lrfb) +
+			polyscore_log_rho(la / lafb));
+	}
+
+	score->murphy = e / (double)POLYSCORE_NUM_POINTS;
+	score->size = s / (double)POLYSCORE_NUM_POINTS;
+	score->alpha = aalpha;
+	score->rroots = polyscore_real_roots(ac, adeg, roots);
+
+	return;
+}
+
+#endif
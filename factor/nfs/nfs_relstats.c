@@ -0,0 +1,376 @@
+/*----------------------------------------------------------------------
+This source distribution is placed in the public domain by its author,
+Ben Buhrow. You may use it for any purpose, free of charge,
+without having to notify anyone. I disclaim any responsibility for any
+errors.
+
+Optionally, please be nice and tell me if you find this source to be
+useful. Again optionally, if you add to the functionality present here
+please consider making those additions public too, so that others may
+benefit from your work.
+
+       				   --bbuhrow@gmail.com 12/6/2012
+----------------------------------------------------------------------*/
+
+#include "nfs.h"
+#include "gmp_xface.h"
+
+#ifdef USE_NFS
+
+// running relation statistics for nfs.  every relation appended to the
+// .dat file is also fed through here: duplicates are recognized by their
+// (a,b) pair and the large ideals of each unique relation are recorded.
+// from that we can run singleton removal in memory and estimate the
+// excess that msieve's filtering will see, without reading the .dat file.
+
+#define RELSTATS_RAT_ROOT 0xffffffff	// root value marking a rational ideal
+
+static uint64 relstats_hash64(uint64 x)
+{
+	// 64-bit finalizer from murmurhash3
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+static void relstats_grow_rel_hash(nfs_relstats_t *s)
+{
+	uint64 *old = s->rel_hash;
+	uint32 old_size = s->rel_hash_size;
+	uint32 i, j;
+
+	s->rel_hash_size *= 2;
+	s->rel_hash = (uint64 *)xcalloc(s->rel_hash_size, sizeof(uint64));
+
+	for (i = 0; i < old_size; i++)
+	{
+		if (old[i] == 0)
+			continue;
+
+		j = (uint32)old[i] & (s->rel_hash_size - 1);
+		while (s->rel_hash[j] != 0)
+			j = (j + 1) & (s->rel_hash_size - 1);
+		s->rel_hash[j] = old[i];
+	}
+
+	free(old);
+	return;
+}
+
+static void relstats_grow_ideal_hash(nfs_relstats_t *s)
+{
+	uint32 i, j;
+
+	free(s->ideal_hash);
+	s->ideal_hash_size *= 2;
+	s->ideal_hash = (uint32 *)xcalloc(s->ideal_hash_size, sizeof(uint32));
+
+	for (i = 0; i < s->num_ideals; i++)
+	{
+		j = (uint32)relstats_hash64(s->ideal_keys[i]) & (s->ideal_hash_size - 1);
+		while (s->ideal_hash[j] != 0)
+			j = (j + 1) & (s->ideal_hash_size - 1);
+		s->ideal_hash[j] = i + 1;
+	}
+
+	return;
+}
+
+static uint32 relstats_find_ideal(nfs_relstats_t *s, uint64 key)
+{
+	// return the index of this ideal, adding it if it is new
+	uint32 j, idx;
+
+	j = (uint32)relstats_hash64(key) & (s->ideal_hash_size - 1);
+	while ((idx = s->ideal_hash[j]) != 0)
+	{
+		if (s->ideal_keys[idx - 1] == key)
+			return idx - 1;
+		j = (j + 1) & (s->ideal_hash_size - 1);
+	}
+
+	if (s->num_ideals == s->alloc_ideals)
+	{
+		s->alloc_ideals *= 2;
+		s->ideal_keys = (uint64 *)xrealloc(s->ideal_keys,
+			s->alloc_ideals * sizeof(uint64));
+		s->ideal_counts = (uint32 *)xrealloc(s->ideal_counts,
+			s->alloc_ideals * sizeof(uint32));
+	}
+
+	idx = s->num_ideals++;
+	s->ideal_keys[idx] = key;
+	s->ideal_counts[idx] = 0;
+	s->ideal_hash[j] = idx + 1;
+
+	if (s->num_ideals > s->ideal_hash_size / 2)
+		relstats_grow_ideal_hash(s);
+
+	return idx;
+}
+
+static uint64 relstats_ideal_key(uint64 p, int64 a, uint32 b, int alg)
+{
+	// rational ideals are identified by p alone, algebraic ideals by
+	// (p, a/b mod p), with p standing in for the root when p | b.
+	uint64 r;
+
+	if (!alg)
+		r = RELSTATS_RAT_ROOT;
+	else if (p > 0xffffffff)
+	{
+		// lpb > 32 is rare; fold the root into the key modulo a 32-bit
+		// hash of a/b.  a collision only merges two ideals in the estimate.
+		return relstats_hash64(p) ^ ((uint64)(b % 0xfffffffb) << 32) ^
+			(uint64)((a < 0 ? -a : a) % 0xfffffffb);
+	}
+	else
+	{
+		uint32 bm = (uint32)(b % p);
+		int64 am = a % (int64)p;
+
+		if (am < 0)
+			am += p;
+
+		if (bm == 0)
+			r = p;
+		else
+			r = ((uint64)am * (uint64)modinv_1(bm, (uint32)p)) % p;
+	}
+
+	return (p << 32) | r;
+}
+
+nfs_relstats_t *nfs_relstats_load(fact_obj_t *fobj, nfs_job_t *job)
+{
+	// start the relation statistics for this job, reading in
+	// whatever is already in the .dat file
+	msieve_obj *mobj = fobj->nfs_obj.mobj;
+	nfs_relstats_t *s;
+	char line[GSTR_MAXSIZE];
+
+	s = (nfs_relstats_t *)xmalloc(sizeof(nfs_relstats_t));
+
+	s->rel_hash_size = 1 << 16;
+	s->rel_hash = (uint64 *)xcalloc(s->rel_hash_size, sizeof(uint64));
+	s->num_rels = 0;
+	s->num_dups = 0;
+	s->num_bad = 0;
+
+	s->ideal_hash_size = 1 << 16;
+	s->ideal_hash = (uint32 *)xcalloc(s->ideal_hash_size, sizeof(uint32));
+	s->alloc_ideals = 1 << 15;
+	s->ideal_keys = (uint64 *)xmalloc(s->alloc_ideals * sizeof(uint64));
+	s->ideal_counts = (uint32 *)xmalloc(s->alloc_ideals * sizeof(uint32));
+	s->num_ideals = 0;
+
+	s->alloc_rels = 1 << 15;
+	s->rel_num_ideals = (uint8 *)xmalloc(s->alloc_rels * sizeof(uint8));
+	s->alloc_rel_ideals = 4 * s->alloc_rels;
+	s->rel_ideals = (uint32 *)xmalloc(s->alloc_rel_ideals * sizeof(uint32));
+	s->num_rel_ideals = 0;
+
+	// ideals below the factor base bounds are too common to ever be
+	// singletons; just count them, li(x) ~ x / (log(x) - 1)
+	s->filtmin_r = job->rlim;
+	s->filtmin_a = job->alim;
+	s->small_ideals = 0;
+	if (job->rlim > 2)
+		s->small_ideals += (uint32)(job->rlim / (log(job->rlim) - 1));
+	if (job->alim > 2)
+		s->small_ideals += (uint32)(job->alim / (log(job->alim) - 1));
+
+	if (savefile_exists(&mobj->savefile))
+	{
+		savefile_open(&mobj->savefile, SAVEFILE_READ);
+		while (1)
+		{
+			savefile_read_line(line, GSTR_MAXSIZE, &mobj->savefile);
+			if (savefile_eof(&mobj->savefile))
+				break;
+			nfs_relstats_add(s, line);
+		}
+		savefile_close(&mobj->savefile);
+
+		if (VFLAG > 0)
+			printf("nfs: read %u unique relations (%u duplicates, %u unparsed) "
+				"from existing data file\n", s->num_rels, s->num_dups, s->num_bad);
+	}
+
+	return s;
+}
+
+void nfs_relstats_free(nfs_relstats_t *s)
+{
+	free(s->rel_hash);
+	free(s->ideal_hash);
+	free(s->ideal_keys);
+	free(s->ideal_counts);
+	free(s->rel_num_ideals);
+	free(s->rel_ideals);
+	free(s);
+	return;
+}
+
+int nfs_relstats_add(nfs_relstats_t *s, char *line)
+{
+	// add one line of lattice siever output: a,b:rat primes:alg primes
+	// with the primes in hex.  returns 1 for a new relation, 0 for a
+	// duplicate, and -1 for anything that doesn't parse (comments,
+	// the N line, a partial last line, ...)
+	int64 a;
+	uint32 b;
+	uint64 h, p;
+	uint32 j, i, n, idx, first;
+	char *ptr, *next;
+	int side;
+
+	if ((line[0] == '#') || (line[0] == 'N'))
+		return -1;
+
+	if (line[0] == '-')
+		a = -(int64)strto_uint64(line + 1, &ptr, 10);
+	else
+		a = (int64)strto_uint64(line, &ptr, 10);
+	if ((ptr == line) || (*ptr != ','))
+	{
+		s->num_bad++;
+		return -1;
+	}
+	b = strtoul(ptr + 1, &ptr, 10);
+	if ((*ptr != ':') || (strchr(ptr + 1, ':') == NULL))
+	{
+		s->num_bad++;
+		return -1;
+	}
+
+	// duplicate check on a hash of (a,b).  0 marks an empty slot.
+	h = relstats_hash64((uint64)a ^ relstats_hash64(b));
+	if (h == 0)
+		h = 1;
+
+	j = (uint32)h & (s->rel_hash_size - 1);
+	while (s->rel_hash[j] != 0)
+	{
+		if (s->rel_hash[j] == h)
+		{
+			s->num_dups++;
+			return 0;
+		}
+		j = (j + 1) & (s->rel_hash_size - 1);
+	}
+	s->rel_hash[j] = h;
+
+	if (s->num_rels == s->alloc_rels)
+	{
+		s->alloc_rels *= 2;
+		s->rel_num_ideals = (uint8 *)xrealloc(s->rel_num_ideals,
+			s->alloc_rels * sizeof(uint8));
+	}
+
+	// record each distinct large ideal once per relation
+	first = s->num_rel_ideals;
+	n = 0;
+	ptr++;
+	for (side = 0; side < 2; side++)
+	{
+		uint32 filtmin = (side ? s->filtmin_a : s->filtmin_r);
+
+		while ((*ptr != ':') && (*ptr != '\0') && (*ptr != '\n') && (*ptr != '\r'))
+		{
+			p = strto_uint64(ptr, &next, 16);
+			if (next == ptr)
+				break;
+			ptr = (*next == ',' ? next + 1 : next);
+
+			if ((p <= filtmin) || (n == 255))
+				continue;
+
+			idx = relstats_find_ideal(s, relstats_ideal_key(p, a, b, side));
+			for (i = first; i < s->num_rel_ideals; i++)
+				if (s->rel_ideals[i] == idx)
+					break;
+
+			if (i < s->num_rel_ideals)
+				continue;
+
+			if (s->num_rel_ideals == s->alloc_rel_ideals)
+			{
+				s->alloc_rel_ideals *= 2;
+				s->rel_ideals = (uint32 *)xrealloc(s->rel_ideals,
+					s->alloc_rel_ideals * sizeof(uint32));
+			}
+			s->rel_ideals[s->num_rel_ideals++] = idx;
+			s->ideal_counts[idx]++;
+			n++;
+		}
+
+		if (*ptr == ':')
+			ptr++;
+	}
+
+	s->rel_num_ideals[s->num_rels++] = (uint8)n;
+
+	if (s->num_rels > s->rel_hash_size / 2)
+		relstats_grow_rel_hash(s);
+
+	return 1;
+}
+
+int64 nfs_relstats_excess(nfs_relstats_t *s, uint32 *rels_left, uint32 *ideals_left)
+{
+	// remove singletons in memory until none remain, and return the
+	// number of relations left over the number of ideals left, small
+	// ideals included.  filtering can succeed once this is positive.
+	uint32 *counts;
+	uint8 *alive;
+	uint32 i, j, pos, removed, nrels, nideals;
+
+	counts = (uint32 *)xmalloc(s->num_ideals * sizeof(uint32) + 1);
+	memcpy(counts, s->ideal_counts, s->num_ideals * sizeof(uint32));
+	alive = (uint8 *)xmalloc(s->num_rels * sizeof(uint8) + 1);
+	memset(alive, 1, s->num_rels);
+
+	nrels = s->num_rels;
+	do
+	{
+		removed = 0;
+		for (i = 0, pos = 0; i < s->num_rels; pos += s->rel_num_ideals[i++])
+		{
+			uint32 *ideals = s->rel_ideals + pos;
+
+			if (!alive[i])
+				continue;
+
+			for (j = 0; j < s->rel_num_ideals[i]; j++)
+				if (counts[ideals[j]] == 1)
+					break;
+
+			if (j == s->rel_num_ideals[i])
+				continue;
+
+			for (j = 0; j < s->rel_num_ideals[i]; j++)
+				counts[ideals[j]]--;
+			alive[i] = 0;
+			removed++;
+		}
+		nrels -= removed;
+
+	} while (removed > 0);
+
+	for (i = 0, nideals = 0; i < s->num_ideals; i++)
+		if (counts[i] > 0)
+			nideals++;
+
+	free(counts);
+	free(alive);
+
+	*rels_left = nrels;
+	*ideals_left = nideals;
+	return (int64)nrels - (int64)nideals - (int64)s->small_ideals;
+}
+
+#endif
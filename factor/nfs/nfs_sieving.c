@@ -18,19 +18,313 @@ benefit from your work.
 
 // potential enhancements:
 
-// 2)
-// run a series of test "refinements" based on difficulty.  The idea
-// being twofold: a) for lower difficulty even a 2k range of spq might
-// be overkill and b) for some polys the differences in sieve speed
-// is obvious after only a few hundred spq.  So run a very small range
-// first, and if we have a clear winner go with it.  if not, run more
-// tests depending on both the "closeness" of the testing and the
-// difficulty.
 // 3)
 // in windows, we count the number of ctrl-c's and force quit after 2.
 // this defeats ctrl-c'ing out of more than one test sieve.  while test
 // sieving, on windows, we need to allow more than two ctrl-c's
 
+// test sieving runs all candidates at once, one siever per thread.  each
+// candidate is sieved over TSIEVE_SAMPLES short special-q ranges spread 
+// above its factor base bound, and after every finished sample a candidate
+// is dropped if its estimated sieving time is clearly worse than the 
+// leader's (non-overlapping 95% confidence intervals).
+#define TSIEVE_SAMPLES 4
+
+// one siever run: either factor base generation (sample < 0) or one
+// special-q sample of one candidate
+typedef struct
+{
+	int job;
+	int sample;
+	uint32 startq;
+	uint32 range;
+} tsieve_task_t;
+
+// running results for one candidate
+typedef struct
+{
+	double sum;			// per-sample estimates of total sieving time
+	double sumsq;
+	double t_time;		// total siever time
+	uint32 count;		// total relations
+	uint32 range;		// total special-q sieved
+	int samples;
+	int dropped;
+} tsieve_stats_t;
+
+typedef struct
+{
+	fact_obj_t *fobj;
+	nfs_job_t *jobs;
+	char **filenames;
+	int njobs;
+	int verbose_siever;
+
+	tsieve_task_t *tasks;
+	int num_tasks;
+	int next_task;
+	tsieve_stats_t *stats;
+
+#if defined(WIN32) || defined(_WIN64)
+	HANDLE lock;
+#else
+	pthread_mutex_t lock;
+#endif
+
+} tsieve_queue_t;
+
+typedef struct
+{
+	tsieve_queue_t *q;
+
+#if defined(WIN32) || defined(_WIN64)
+	HANDLE thread_id;
+#else
+	pthread_t thread_id;
+#endif
+
+} tsieve_thread_t;
+
+static void tsieve_lock(tsieve_queue_t *q)
+{
+#if defined(WIN32) || defined(_WIN64)
+	WaitForSingleObject(q->lock, INFINITE);
+#else
+	pthread_mutex_lock(&q->lock);
+#endif
+}
+
+static void tsieve_unlock(tsieve_queue_t *q)
+{
+#if defined(WIN32) || defined(_WIN64)
+	ReleaseMutex(q->lock);
+#else
+	pthread_mutex_unlock(&q->lock);
+#endif
+}
+
+static void tsieve_interval(tsieve_stats_t *s, double *mean, double *hw)
+{
+	// mean and 95% confidence half-width of the per-sample estimates
+	static const double student_t[] = {12.71, 4.30, 3.18, 2.78, 2.57, 2.45, 2.36, 2.31};
+	double var;
+	int df = s->samples - 1;
+
+	*mean = s->sum / s->samples;
+	var = (s->sumsq - s->samples * *mean * *mean) / df;
+	if (var < 0.)
+		var = 0.;
+
+	*hw = (df <= 8 ? student_t[df - 1] : 2.0) * sqrt(var / s->samples);
+	return;
+}
+
+static void tsieve_check_drop(tsieve_queue_t *q)
+{
+	// called with the lock held after a sample completes
+	double mean, hw, lead_mean = 0., lead_hi = 0.;
+	int i, leader = -1;
+
+	for (i = 0; i < q->njobs; i++)
+	{
+		if (q->stats[i].dropped || (q->stats[i].samples < 2))
+			continue;
+
+		tsieve_interval(&q->stats[i], &mean, &hw);
+		if ((leader < 0) || (mean < lead_mean))
+		{
+			leader = i;
+			lead_mean = mean;
+			lead_hi = mean + hw;
+		}
+	}
+
+	if (leader < 0)
+		return;
+
+	for (i = 0; i < q->njobs; i++)
+	{
+		if ((i == leader) || q->stats[i].dropped || (q->stats[i].samples < 2))
+			continue;
+
+		tsieve_interval(&q->stats[i], &mean, &hw);
+		if ((mean - hw) > lead_hi)
+		{
+			q->stats[i].dropped = 1;
+			if (VFLAG > 0)
+				printf("test: dropping polynomial %d after %d samples, clearly slower "
+					"than polynomial %d\n", i, q->stats[i].samples, leader);
+		}
+	}
+
+	return;
+}
+
+static void tsieve_run_task(tsieve_queue_t *q, tsieve_task_t *task)
+{
+	nfs_job_t *job = &q->jobs[task->job];
+	char *fname = q->filenames[task->job];
+	char syscmd[GSTR_MAXSIZE], outfile[GSTR_MAXSIZE], tmpstr[GSTR_MAXSIZE];
+	struct timeval start, stop;
+	TIME_DIFF *	difference;
+	tsieve_stats_t *s;
+	double t_time, est;
+	uint32 count = 0;
+	int cmd_ok;
+	FILE *in;
+
+	if ((task->sample < 0) && (q->fobj->nfs_obj.siever == NFS_BUILTIN_SIEVER))
+	{
+		// the built-in siever makes its factor base on every call
+		return;
+	}
+	else if (task->sample < 0)
+	{
+		//create the afb/rfb - we don't want the time it takes to do this to
+		//pollute the sieve timings
+		if (snprintf(syscmd, GSTR_MAXSIZE, "%s -b %s -k -c 0 -F", 
+			job->sievername, fname) < GSTR_MAXSIZE)
+			system(syscmd);
+		return;
+	}
+
+	snprintf(outfile, GSTR_MAXSIZE, "%s.%d.out", fname, task->sample);
+	cmd_ok = (snprintf(syscmd, GSTR_MAXSIZE, "%s%s -%c %s -f %u -c %u -o %s",
+		job->sievername, q->verbose_siever ? " -v" : "", 
+		(job->poly->side == RATIONAL_SPQ) ? 'r' : 'a', 
+		fname, task->startq, task->range, outfile) < GSTR_MAXSIZE);
+
+	gettimeofday(&start, NULL);
+	if (q->fobj->nfs_obj.siever == NFS_BUILTIN_SIEVER)
+	{
+		remove(outfile);
+		nfs_lasieve(q->fobj, job, task->startq, task->range, outfile);
+	}
+	else if (cmd_ok)
+		system(syscmd);
+	else
+		printf("test: siever path too long, not sampling polynomial %d\n", task->job);
+	gettimeofday(&stop, NULL);
+	difference = my_difftime (&start, &stop);
+	t_time = ((double)difference->secs + (double)difference->usecs / 1000000);
+	free(difference);
+
+	//count relations
+	in = fopen(outfile, "r");
+	if (in != NULL)
+	{
+		while (fgets(tmpstr, GSTR_MAXSIZE, in) != NULL)
+			count++;
+		fclose(in);
+	}
+	remove(outfile);
+
+	// use estimated sieving time to rank, not sec/rel, since the latter
+	// is a function of parameterization and therefore not directly comparable
+	// to each other.  be conservative about estimates.
+	if (count > 0)
+		est = (t_time / count) * job->min_rels * 1.25 / q->fobj->num_threads;
+	else
+		est = 999999999.;
+
+	tsieve_lock(q);
+	s = &q->stats[task->job];
+	s->sum += est;
+	s->sumsq += est * est;
+	s->t_time += t_time;
+	s->count += count;
+	s->range += task->range;
+	s->samples++;
+
+	if (VFLAG > 0)
+		printf("test: polynomial %d sample %d: %u relations from special-q %u-%u in %1.2f sec\n",
+			task->job, task->sample, count, task->startq, task->startq + task->range, t_time);
+
+	// a candidate that finds nothing is out
+	if (count == 0)
+		s->dropped = 1;
+	else
+		tsieve_check_drop(q);
+	tsieve_unlock(q);
+
+	return;
+}
+
+#if defined(WIN32) || defined(_WIN64)
+DWORD WINAPI tsieve_worker(LPVOID thread_data) {
+#else
+void *tsieve_worker(void *thread_data) {
+#endif
+	tsieve_queue_t *q = ((tsieve_thread_t *)thread_data)->q;
+	tsieve_task_t *task;
+
+	while (1)
+	{
+		// take the next task whose candidate is still in the running
+		tsieve_lock(q);
+		task = NULL;
+		while ((q->next_task < q->num_tasks) && (NFS_ABORT == 0))
+		{
+			task = &q->tasks[q->next_task++];
+			if (!q->stats[task->job].dropped)
+				break;
+			task = NULL;
+		}
+		tsieve_unlock(q);
+
+		if (task == NULL)
+			break;
+
+		tsieve_run_task(q, task);
+	}
+
+#if defined(WIN32) || defined(_WIN64)
+	return 0;
+#else
+	return NULL;
+#endif
+}
+
+static void tsieve_run_queue(tsieve_queue_t *q, int num_threads)
+{
+	// run all queued tasks on up to num_threads concurrent sievers.
+	// the calling thread is one of them.
+	tsieve_thread_t *threads;
+	int i;
+
+	num_threads = MIN(num_threads, q->num_tasks);
+	if (num_threads < 1)
+		num_threads = 1;
+
+	threads = (tsieve_thread_t *)malloc(num_threads * sizeof(tsieve_thread_t));
+	for (i = 0; i < num_threads; i++)
+		threads[i].q = q;
+
+	for (i = 1; i < num_threads; i++)
+	{
+#if defined(WIN32) || defined(_WIN64)
+		threads[i].thread_id = CreateThread(NULL, 0, tsieve_worker, &threads[i], 0, NULL);
+#else
+		pthread_create(&threads[i].thread_id, NULL, tsieve_worker, &threads[i]);
+#endif
+	}
+
+	tsieve_worker(&threads[0]);
+
+	for (i = 1; i < num_threads; i++)
+	{
+#if defined(WIN32) || defined(_WIN64)
+		WaitForSingleObject(threads[i].thread_id, INFINITE);
+		CloseHandle(threads[i].thread_id);
+#else
+		pthread_join(threads[i].thread_id, NULL);
+#endif
+	}
+
+	free(threads);
+	return;
+}
+
 int test_sieve(fact_obj_t* fobj, void* args, int njobs, int are_files)
 /* if(are_files), then treat args as a char** list of (external) polys
  * else args is a nfs_job_t* array of job structs
@@ -39,7 +333,7 @@ int test_sieve(fact_obj_t* fobj, void* args, int njobs, int are_files)
 // an arbitrary list of files of external polys
 {
 	uint32 count;
-	int i, minscore_id = 0;
+	int i, j, minscore_id = 0;
 	double* score = (double*)malloc(njobs * sizeof(double));
 	double t_time, min_score = 999999999.;
 	char orig_name[GSTR_MAXSIZE]; // don't clobber fobj->nfs_obj.job_infile
@@ -49,6 +343,7 @@ int test_sieve(fact_obj_t* fobj, void* args, int njobs, int are_files)
 	
 	char** filenames; // args
 	nfs_job_t* jobs; // args
+	tsieve_queue_t q;
 	
 	struct timeval stop, stop2;	// stop time of this job
 	struct timeval start, start2;	// start time of this job
@@ -97,6 +392,21 @@ int test_sieve(fact_obj_t* fobj, void* args, int njobs, int are_files)
 						filenames[i], missing_params);
 				fill_job_file(fobj, jobs+i, missing_params);
 			}
+			// the built-in siever works from job->poly, not the file
+			if (fobj->nfs_obj.siever == NFS_BUILTIN_SIEVER)
+			{
+				if (jobs[i].poly == NULL)
+				{
+					jobs[i].poly = (mpz_polys_t*)malloc(sizeof(mpz_polys_t));
+					if (jobs[i].poly == NULL)
+					{
+						printf("nfs: couldn't allocate memory!\n");
+						exit(-1);
+					}
+					mpz_polys_init(jobs[i].poly);
+				}
+				read_job_poly(filenames[i], jobs[i].poly);
+			}
 			// adjust a/rlim, lpbr/a, and mfbr/a if advantageous
 			skew_snfs_params(fobj, jobs+i);
 		}
@@ -142,10 +452,30 @@ int test_sieve(fact_obj_t* fobj, void* args, int njobs, int are_files)
 	strcpy(fobj->nfs_obj.job_infile, orig_name);
 
 	// now we can get to the actual testing
+	q.fobj = fobj;
+	q.jobs = jobs;
+	q.filenames = filenames;
+	q.njobs = njobs;
+	q.verbose_siever = (VFLAG > 0) && (fobj->num_threads == 1);
+	q.stats = (tsieve_stats_t *)calloc(njobs, sizeof(tsieve_stats_t));
+	q.tasks = (tsieve_task_t *)malloc(njobs * (TSIEVE_SAMPLES + 1) * sizeof(tsieve_task_t));
+	q.num_tasks = 0;
+	q.next_task = 0;
+	if ((q.stats == NULL) || (q.tasks == NULL))
+	{
+		printf("Couldn't alloc memory!\n");
+		exit(-1);
+	}
+#if defined(WIN32) || defined(_WIN64)
+	q.lock = CreateMutex(NULL, FALSE, NULL);
+#else
+	pthread_mutex_init(&q.lock, NULL);
+#endif
+
+	flog = fopen(fobj->flogname, "a");
 	for(i = 0; i < njobs; i++)
 	{
-		char syscmd[GSTR_MAXSIZE], tmpbuf[GSTR_MAXSIZE], side[32];
-		FILE* in;
+		char side[32];
 
 		// should probably scale the range of special-q to test based
 		// on input difficulty, but not sure how to do that easily...
@@ -161,121 +491,91 @@ int test_sieve(fact_obj_t* fobj, void* args, int njobs, int are_files)
 			jobs[i].startq = jobs[i].alim; // ditto
 		}
 
-		flog = fopen(fobj->flogname, "a");
-
-		//create the afb/rfb - we don't want the time it takes to do this to
-		//pollute the sieve timings		
-		sprintf(syscmd, "%s -b %s -k -c 0 -F", jobs[i].sievername, filenames[i]);
-		if (VFLAG > 0) printf("\ntest: generating factor bases\n");
-		gettimeofday(&start, NULL);
-		system(syscmd);
-		gettimeofday(&stop, NULL);
-		difference = my_difftime (&start, &stop);
-		t_time = ((double)difference->secs + (double)difference->usecs / 1000000);
-		free(difference);
-		if (VFLAG > 0) printf("test: fb generation took %6.4f seconds\n", t_time);
-		logprint(flog, "test: fb generation took %6.4f seconds\n", t_time);
-		MySleep(.1);
-
-		//start the test
-		sprintf(syscmd,"%s%s -%c %s -f %u -c %u -o %s.out",
-			jobs[i].sievername, VFLAG>0?" -v":"", side[0], filenames[i], jobs[i].startq, spq_range, filenames[i]);
-
-		if (VFLAG > 0) printf("test: commencing test sieving of polynomial %d on the %s side over range %u-%u\n", i, 
-			side, jobs[i].startq, jobs[i].startq + spq_range);
-		logprint(flog, "test: commencing test sieving of polynomial %d on the %s side over range %u-%u\n", i, 
-			side, jobs[i].startq, jobs[i].startq + spq_range);
+		if (VFLAG > 0) printf("test: polynomial %d will be test sieved on the %s side, "
+			"%d samples of %u special-q from %u\n", i, side, TSIEVE_SAMPLES, 
+			spq_range / TSIEVE_SAMPLES, jobs[i].startq);
+		logprint(flog, "test: polynomial %d will be test sieved on the %s side, "
+			"%d samples of %u special-q from %u\n", i, side, TSIEVE_SAMPLES, 
+			spq_range / TSIEVE_SAMPLES, jobs[i].startq);
 		print_job(&jobs[i], flog);
-		fclose(flog);
 
-		gettimeofday(&start, NULL);
-		system(syscmd);
-		gettimeofday(&stop, NULL);
-		difference = my_difftime (&start, &stop);
-		t_time = ((double)difference->secs + (double)difference->usecs / 1000000);
-		free(difference);		
-		
-		//count relations
-		sprintf(tmpbuf, "%s.out", filenames[i]);
-		in = fopen(tmpbuf, "r");
-		actual_range = 0;
-		count = 0;
-		if( !in )
-		{
-			score[i] = 999999999.;
-			
-			//est = 7*365*24*3600; // 7 years seems like a nice round number
-		}
-		else
+		q.tasks[q.num_tasks].job = i;
+		q.tasks[q.num_tasks].sample = -1;
+		q.num_tasks++;
+	}
+
+	//create the afbs/rfbs first, all at once
+	if (VFLAG > 0) printf("\ntest: generating factor bases\n");
+	gettimeofday(&start, NULL);
+	tsieve_run_queue(&q, fobj->num_threads);
+	gettimeofday(&stop, NULL);
+	difference = my_difftime (&start, &stop);
+	t_time = ((double)difference->secs + (double)difference->usecs / 1000000);
+	free(difference);
+	if (VFLAG > 0) printf("test: fb generation took %6.4f seconds\n", t_time);
+	logprint(flog, "test: fb generation took %6.4f seconds\n", t_time);
+	fclose(flog);
+	MySleep(.1);
+
+	// then the samples.  they are queued sample-major so every candidate
+	// gets measured early, and the ones that fall clearly behind are 
+	// skipped from then on.
+	q.num_tasks = 0;
+	q.next_task = 0;
+	for (j = 0; j < TSIEVE_SAMPLES; j++)
+	{
+		for (i = 0; i < njobs; i++)
 		{
-			// scan the data file and
-			// 1) count the relations
-			// 2) save the last four relations to a buffer in order to extract the last processed
-			//		special-q.
-			// we need both 1) and 2) to compute yield correctly.
-
-			char **lines, *ptr, tmp[GSTR_MAXSIZE];
-			int line;
-			int j;
-
-			lines = (char **)malloc(4 * sizeof(char *));
-			for (j=0; j < 4; j++)
-				lines[j] = (char *)malloc(GSTR_MAXSIZE * sizeof(char));
-
-			line = 0;
-			count = 0;
-			while (1)
-			{
-				// read a line into the next position of the circular buffer
-				ptr = fgets(tmp, GSTR_MAXSIZE, in);
-				if (ptr == NULL) 
-					break;
+			tsieve_task_t *t = &q.tasks[q.num_tasks++];
 
-				// quick check that it might be a valid line
-				if (strlen(tmp) > 30)
-				{
-					// wrap
-					if (++line > 3) line = 0;
-					// then copy
-					strcpy(lines[line], tmp);
-				}
+			t->job = i;
+			t->sample = j;
+			t->range = spq_range / TSIEVE_SAMPLES;
+			t->startq = jobs[i].startq + j * (jobs[i].startq / (2 * TSIEVE_SAMPLES));
+		}
+	}
 
-				count++;
-			}
-			fclose(in);
+	if (VFLAG > 0) printf("test: commencing test sieving of %d polynomials with %d threads\n",
+		njobs, MIN(fobj->num_threads, q.num_tasks));
+	tsieve_run_queue(&q, fobj->num_threads);
 
-			line = get_spq(lines, line, fobj);
-			actual_range = line - jobs[i].startq;
-			if (VFLAG > 0)
-				printf("test: found %u relations in a range of %u special-q\n", 
-				count, actual_range);
+#if defined(WIN32) || defined(_WIN64)
+	CloseHandle(q.lock);
+#else
+	pthread_mutex_destroy(&q.lock);
+#endif
 
-			if (actual_range > spq_range) 
-				actual_range = spq_range;
+	// rank the results and tune the parameters of the winners
+	for(i = 0; i < njobs; i++)
+	{
+		tsieve_stats_t *s = &q.stats[i];
+		char tmpbuf[GSTR_MAXSIZE];
 
-			for (j=0; j < 4; j++)
-				free(lines[j]);
-			free(lines);
+		count = s->count;
+		actual_range = s->range;
 
-			score[i] = t_time / count;
+		if ((s->samples == 0) || (count == 0))
+			score[i] = 999999999.;
+		else
+			score[i] = s->sum / s->samples;
 
-			// use estimated sieving time to rank, not sec/rel, since the latter
-			// is a function of parameterization and therefore not directly comparable
-			// to each other.
-			score[i] = (score[i] * jobs[i].min_rels * 1.25) / THREADS; 
-			// be conservative about estimates
-		}
+		if (VFLAG > 0)
+			printf("test: polynomial %d: found %u relations in a range of %u special-q\n", 
+			i, count, actual_range);
 
 		flog = fopen(fobj->flogname, "a");
 
+		if (s->dropped && (count > 0))
+			logprint(flog, "test: polynomial %d dropped after %d samples\n", i, s->samples);
+
 		if( score[i] < min_score )
 		{
 			minscore_id = i;
 			min_score = score[i];
 			if (VFLAG > 0) printf("test: new best estimated total sieving time = %s (with %d threads)\n", 
-				time_from_secs(time, (unsigned long)score[i]), THREADS); 
+				time_from_secs(time, (unsigned long)score[i]), fobj->num_threads); 
 			logprint(flog, "test: new best estimated total sieving time = %s (with %d threads)\n", 
-				time_from_secs(time, (unsigned long)score[i]), THREADS); 
+				time_from_secs(time, (unsigned long)score[i]), fobj->num_threads); 
 
 			// edit lbpr/a depending on test results.  we target something around 2 rels/Q.
 			// could also change siever version in more extreme cases.
@@ -289,7 +589,8 @@ int test_sieve(fact_obj_t* fobj, void* args, int njobs, int are_files)
 				jobs[i].mfbr -= 2;
 			}
 
-			if (count > 8*actual_range)
+			if ((count > 8*actual_range) &&
+				(strstr(jobs[i].sievername, "gnfs-lasieve4I") != NULL))
 			{
 				char *pos;
 				int siever;
@@ -345,7 +646,8 @@ int test_sieve(fact_obj_t* fobj, void* args, int njobs, int are_files)
 				jobs[i].mfbr += 2;
 			}
 
-			if (count < (actual_range/2))
+			if ((count < (actual_range/2)) &&
+				(strstr(jobs[i].sievername, "gnfs-lasieve4I") != NULL))
 			{
 				char *pos;
 				int siever;
@@ -393,20 +695,21 @@ int test_sieve(fact_obj_t* fobj, void* args, int njobs, int are_files)
 		else
 		{
 			if (VFLAG > 0) printf("test: estimated total sieving time = %s (with %d threads)\n", 
-				time_from_secs(time, (unsigned long)score[i]), THREADS);
+				time_from_secs(time, (unsigned long)score[i]), fobj->num_threads);
 			logprint(flog, "test: estimated total sieving time = %s (with %d threads)\n", 
-				time_from_secs(time, (unsigned long)score[i]), THREADS);
+				time_from_secs(time, (unsigned long)score[i]), fobj->num_threads);
 		}
 
 		fclose(flog);
-		remove(tmpbuf); // clean up after ourselves
-		sprintf(tmpbuf, "%s", filenames[i]);
+		sprintf(tmpbuf, "%s", filenames[i]); // clean up after ourselves
 		remove(tmpbuf);
 		sprintf(tmpbuf, "%s.afb.0", filenames[i]);
 		remove(tmpbuf);
 	}
 
 	// clean up memory allocated
+	free(q.tasks);
+	free(q.stats);
 	if( are_files )
 	{
 		for(i = 0; i < njobs; i++)
@@ -434,6 +737,84 @@ int test_sieve(fact_obj_t* fobj, void* args, int njobs, int are_files)
 	return minscore_id;
 }
 
+// sieving feedback: after each batch the special-q range of the next one
+// is sized from the measured yield so that, at the current rate, it ends
+// about where min_rels is reached.  the range is split evenly over the 
+// threads, so they all reach the target together.  batches stay within 
+// these multiples of the table q-range, so that progress is still saved
+// and checked regularly.
+#define NFS_BATCH_MIN 0.25
+#define NFS_BATCH_MAX 4.0
+// if the yield per special-q falls below this fraction of the first 
+// batch's with most of the relations still to find, switch sides and 
+// start over with small special-q on the other one
+#define NFS_YIELD_COLLAPSE 0.4
+
+void nfs_adapt_batch(fact_obj_t *fobj, nfs_job_t *job, uint32 batch_rels,
+	uint32 batch_q, double batch_time)
+{
+	double yield, need_q;
+	uint32 need_rels, qrange;
+	int threads = fobj->num_threads;
+
+	// nothing to go on, or the user fixed the range
+	if ((batch_q == 0) || (batch_rels == 0) || (fobj->nfs_obj.rangeq > 0))
+		return;
+
+	if (job->base_qrange == 0)
+		job->base_qrange = job->qrange;
+
+	yield = (double)batch_rels / (double)batch_q;
+	if (job->first_yield == 0)
+		job->first_yield = yield;
+
+	if ((yield < NFS_YIELD_COLLAPSE * job->first_yield) &&
+		(job->current_rels < 0.75 * job->min_rels) &&
+		!job->side_switched && (fobj->nfs_obj.sq_side == 0))
+	{
+		job->poly->side = (job->poly->side == RATIONAL_SPQ) ? ALGEBRAIC_SPQ : RATIONAL_SPQ;
+		job->startq = ((job->poly->side == RATIONAL_SPQ) ? job->rlim : job->alim) / 2;
+		job->side_switched = 1;
+		job->first_yield = 0;
+		update_job_side(fobj, job);
+
+		if (VFLAG >= 0)
+			printf("nfs: yield fell to %1.3f rels/q, switching to %s side special-q "
+				"from %u\n", yield, (job->poly->side == RATIONAL_SPQ) ? 
+				"rational" : "algebraic", job->startq);
+		logprint_oc(fobj->flogname, "a", "nfs: yield fell to %1.3f rels/q, "
+			"switching to %s side special-q from %u\n", yield,
+			(job->poly->side == RATIONAL_SPQ) ? "rational" : "algebraic", job->startq);
+	}
+
+	if (job->current_rels < job->min_rels)
+	{
+		// a little extra for the yield falling off as q grows
+		need_rels = job->min_rels - job->current_rels;
+		need_q = 1.02 * (double)need_rels / yield;
+		need_q = MAX(need_q, NFS_BATCH_MIN * job->base_qrange);
+		need_q = MIN(need_q, NFS_BATCH_MAX * job->base_qrange);
+		qrange = (uint32)ceil(need_q / threads) * threads;
+	}
+	else
+	{
+		// past min_rels, so filtering decided more are needed.  it will
+		// raise min_rels if it fails, so go back to the table range.
+		need_rels = 0;
+		need_q = 0;
+		qrange = job->base_qrange;
+	}
+
+	if (VFLAG > 0)
+		printf("nfs: batch yield %1.3f rels/q, %1.1f rels/sec; need %u more relations, "
+			"next q-range %u\n", yield, (batch_time > 0) ? batch_rels / batch_time : 0.,
+			need_rels, qrange);
+
+	job->qrange = qrange;
+
+	return;
+}
+
 void do_sieving(fact_obj_t *fobj, nfs_job_t *job)
 {
 	nfs_threaddata_t *thread_data;		//an array of thread data objects
@@ -441,8 +822,13 @@ void do_sieving(fact_obj_t *fobj, nfs_job_t *job)
 	FILE *fid;
 	FILE *logfile;
 
-	thread_data = (nfs_threaddata_t *)malloc(THREADS * sizeof(nfs_threaddata_t));
-	for (i=0; i<THREADS; i++)
+	// ggnfs reads the polynomial from the job file, but the built-in siever
+	// needs it in job->poly, which gnfs poly selection doesn't fill in
+	if ((fobj->nfs_obj.siever == NFS_BUILTIN_SIEVER) && (job->poly->alg.degree == 0))
+		read_job_poly(fobj->nfs_obj.job_infile, job->poly);
+
+	thread_data = (nfs_threaddata_t *)malloc(fobj->num_threads * sizeof(nfs_threaddata_t));
+	for (i=0; i<fobj->num_threads; i++)
 	{
 		sprintf(thread_data[i].outfilename, "rels%d.dat", i);
 		thread_data[i].job.poly = job->poly; // no sense copying the whole struct
@@ -455,9 +841,9 @@ void do_sieving(fact_obj_t *fobj, nfs_job_t *job)
 		thread_data[i].job.mfbr = job->mfbr;
 		thread_data[i].job.mfba = job->mfba;
 		if (fobj->nfs_obj.rangeq > 0)
-			thread_data[i].job.qrange = ceil((double)fobj->nfs_obj.rangeq / (double)THREADS);
+			thread_data[i].job.qrange = ceil((double)fobj->nfs_obj.rangeq / (double)fobj->num_threads);
 		else
-			thread_data[i].job.qrange = ceil((double)job->qrange / (double)THREADS);
+			thread_data[i].job.qrange = ceil((double)job->qrange / (double)fobj->num_threads);
 		thread_data[i].job.min_rels = job->min_rels;
 		thread_data[i].job.current_rels = job->current_rels;
 		thread_data[i].siever = fobj->nfs_obj.siever;
@@ -471,13 +857,13 @@ void do_sieving(fact_obj_t *fobj, nfs_job_t *job)
 
 	/* activate the threads one at a time. The last is the
 			master thread (i.e. not a thread at all). */		
-	for (i = 0; i < THREADS - 1; i++)
+	for (i = 0; i < fobj->num_threads - 1; i++)
 		nfs_start_worker_thread(thread_data + i, 0);
 
 	nfs_start_worker_thread(thread_data + i, 1);			
 
 	// load threads with work
-	for (i = 0; i < THREADS; i++) 
+	for (i = 0; i < fobj->num_threads; i++) 
 	{
 		nfs_threaddata_t *t = thread_data + i;
 		t->job.startq = job->startq;
@@ -492,16 +878,16 @@ void do_sieving(fact_obj_t *fobj, nfs_job_t *job)
 	}
 	else
 	{
-		logprint(logfile, "nfs: commencing lattice sieving with %d threads\n",THREADS);
+		logprint(logfile, "nfs: commencing lattice sieving with %d threads\n",fobj->num_threads);
 		fclose(logfile);
 	}
 
 	// create a new lasieve process in each thread and watch it
-	for (i = 0; i < THREADS; i++) 
+	for (i = 0; i < fobj->num_threads; i++) 
 	{
 		nfs_threaddata_t *t = thread_data + i;
 
-		if (i == THREADS - 1) {				
+		if (i == fobj->num_threads - 1) {				
 			lasieve_launcher(t);
 		}
 		else {
@@ -517,10 +903,10 @@ void do_sieving(fact_obj_t *fobj, nfs_job_t *job)
 
 	/* wait for each thread to finish */
 
-	for (i = 0; i < THREADS; i++) {
+	for (i = 0; i < fobj->num_threads; i++) {
 		nfs_threaddata_t *t = thread_data + i;
 
-		if (i < THREADS - 1) {
+		if (i < fobj->num_threads - 1) {
 #if defined(WIN32) || defined(_WIN64)
 			WaitForSingleObject(t->finish_event, INFINITE);
 #else
@@ -532,10 +918,11 @@ void do_sieving(fact_obj_t *fobj, nfs_job_t *job)
 	}
 		
 	//combine output
-	for (i = 0; i < THREADS; i++) 
+	for (i = 0; i < fobj->num_threads; i++) 
 	{
 		nfs_threaddata_t *t = thread_data + i;
-		savefile_concat(t->outfilename,fobj->nfs_obj.outputfile,fobj->nfs_obj.mobj);
+		savefile_concat(t->outfilename,fobj->nfs_obj.outputfile,fobj->nfs_obj.mobj,
+			job->relstats);
 
 		// accumulate relation counts
 		job->current_rels += thread_data[i].job.current_rels;
@@ -566,12 +953,13 @@ void do_sieving(fact_obj_t *fobj, nfs_job_t *job)
 			fclose(logfile);
 		}
 
-		savefile_concat("rels.add",fobj->nfs_obj.outputfile,fobj->nfs_obj.mobj);
+		savefile_concat("rels.add",fobj->nfs_obj.outputfile,fobj->nfs_obj.mobj,
+			job->relstats);
 		remove("rels.add");
 	}
 
 	//stop worker threads
-	for (i=0; i<THREADS - 1; i++)
+	for (i=0; i<fobj->num_threads - 1; i++)
 	{
 		nfs_stop_worker_thread(thread_data + i, 0);
 	}
@@ -601,20 +989,20 @@ void do_sieving_pool(fact_obj_t *fobj, nfs_job_t *job)
     pthread_cond_t queue_cond;
 #endif
 
-	thread_data = (nfs_threaddata_t *)malloc(THREADS * sizeof(nfs_threaddata_t));
+	thread_data = (nfs_threaddata_t *)malloc(fobj->num_threads * sizeof(nfs_threaddata_t));
 
 	// allocate the queue of threads waiting for work
-    thread_queue = (int *)malloc(THREADS * sizeof(int));
+    thread_queue = (int *)malloc(fobj->num_threads * sizeof(int));
     threads_waiting = (int *)malloc(sizeof(int));
 
-	if (THREADS > 1)
+	if (fobj->num_threads > 1)
 	{
 #if defined(WIN32) || defined(_WIN64)
 		queue_lock = CreateMutex( 
 			NULL,              // default security attributes
 			FALSE,             // initially not owned
 			NULL);             // unnamed mutex
-		queue_events = (HANDLE *)malloc(THREADS * sizeof(HANDLE));
+		queue_events = (HANDLE *)malloc(fobj->num_threads * sizeof(HANDLE));
 #else
 		pthread_mutex_init(&queue_lock, NULL);
 		pthread_cond_init(&queue_cond, NULL);
@@ -629,12 +1017,12 @@ void do_sieving_pool(fact_obj_t *fobj, nfs_job_t *job)
 	}
 	else
 	{
-		logprint(logfile, "nfs: commencing lattice sieving with %d threads\n",THREADS);
+		logprint(logfile, "nfs: commencing lattice sieving with %d threads\n",fobj->num_threads);
 		fclose(logfile);
 	}
 
-	thread_data = (nfs_threaddata_t *)malloc(THREADS * sizeof(nfs_threaddata_t));
-	for (i=0; i<THREADS; i++)
+	thread_data = (nfs_threaddata_t *)malloc(fobj->num_threads * sizeof(nfs_threaddata_t));
+	for (i=0; i<fobj->num_threads; i++)
 	{
 		thread_data[i].fobj = fobj;
 		sprintf(thread_data[i].outfilename, "rels%d.dat", i);
@@ -660,16 +1048,16 @@ void do_sieving_pool(fact_obj_t *fobj, nfs_job_t *job)
 		// threads from idleing less at the end of a range.  will need
 		// to compute and store the afb first
 		if (fobj->nfs_obj.rangeq > 0)
-			thread_data[i].job.qrange = ceil((double)fobj->nfs_obj.rangeq / (double)THREADS);
+			thread_data[i].job.qrange = ceil((double)fobj->nfs_obj.rangeq / (double)fobj->num_threads);
 		else
-			thread_data[i].job.qrange = ceil((double)job->qrange / (double)THREADS);
+			thread_data[i].job.qrange = ceil((double)job->qrange / (double)fobj->num_threads);
 
 		// assign all thread's a pointer to the waiting queue.  access to 
 		// the array will be controlled by a mutex
         thread_data[i].thread_queue = thread_queue;
         thread_data[i].threads_waiting = threads_waiting;
 
-		if (THREADS > 1)
+		if (fobj->num_threads > 1)
 		{
 #if defined(WIN32) || defined(_WIN64)
 			// assign a pointer to the mutex
@@ -683,7 +1071,7 @@ void do_sieving_pool(fact_obj_t *fobj, nfs_job_t *job)
 	}
 
 
-	if (THREADS > 1)
+	if (fobj->num_threads > 1)
 	{
 #if defined(WIN32) || defined(_WIN64)
 		// nothing
@@ -700,7 +1088,7 @@ void do_sieving_pool(fact_obj_t *fobj, nfs_job_t *job)
 		{
 			int tid;
 			
-			if (THREADS > 1)
+			if (fobj->num_threads > 1)
 			{
 				// Pop a waiting thread off the queue (OK, it's stack not a queue)
 #if defined(WIN32) || defined(_WIN64)
@@ -742,7 +1130,7 @@ void do_sieving_pool(fact_obj_t *fobj, nfs_job_t *job)
 				static_conf->total_poly_a++;
 				new_poly_a(static_conf,thread_data[tid].dconf);
 
-				if (THREADS > 1)
+				if (fobj->num_threads > 1)
 				{
 					// send the thread a signal to start processing the poly we just generated for it
 #if defined(WIN32) || defined(_WIN64)
@@ -760,7 +1148,7 @@ void do_sieving_pool(fact_obj_t *fobj, nfs_job_t *job)
 				threads_working++;
 			}
 
-			if (THREADS == 1)
+			if (fobj->num_threads == 1)
 				*threads_waiting = 0;
 	
 		} // while (*threads_waiting > 0)
@@ -769,12 +1157,12 @@ void do_sieving_pool(fact_obj_t *fobj, nfs_job_t *job)
 		if (threads_working == 0)
 			break;
 
-		if (THREADS > 1)
+		if (fobj->num_threads > 1)
 		{
 			// wait for a thread to finish and put itself in the waiting queue
 #if defined(WIN32) || defined(_WIN64)
 			j = WaitForMultipleObjects(
-				THREADS,
+				fobj->num_threads,
 				queue_events,
 				FALSE,
 				INFINITE);
@@ -793,9 +1181,9 @@ void do_sieving_pool(fact_obj_t *fobj, nfs_job_t *job)
 	}
 
 	//stop worker threads
-	for (i=0; i<THREADS; i++)
+	for (i=0; i<fobj->num_threads; i++)
 	{
-		if (THREADS > 1)
+		if (fobj->num_threads > 1)
 			nfs_stop_worker_thread(thread_data + i);
 	}
 
@@ -837,9 +1225,20 @@ void *lasieve_launcher(void *ptr)
 		printf("nfs: commencing %s side lattice sieving over range: %u - %u\n",
 			side, thread_data->job.startq, thread_data->job.startq + thread_data->job.qrange);
 	}
-	if (VFLAG > 1) printf("syscmd: %s\n", syscmd);
-	if (VFLAG > 1) fflush(stdout);
-	cmdret = system(syscmd);
+	if (thread_data->siever == NFS_BUILTIN_SIEVER)
+	{
+		// in-process siever: relations are appended to the same output
+		// file, and a ctrl-c shows up in NFS_ABORT directly
+		nfs_lasieve(fobj, &thread_data->job, thread_data->job.startq,
+			thread_data->job.qrange, thread_data->outfilename);
+		cmdret = 0;
+	}
+	else
+	{
+		if (VFLAG > 1) printf("syscmd: %s\n", syscmd);
+		if (VFLAG > 1) fflush(stdout);
+		cmdret = system(syscmd);
+	}
 
 	// a ctrl-c abort signal is caught by the system command, and nfsexit never gets called.
 	// so check for abnormal exit from the system command.
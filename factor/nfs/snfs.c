@@ -251,10 +251,11 @@ void approx_norms(snfs_t *poly)
 	eval_poly(res, (int64)a, (int64)b, &poly->poly->rat);
 	poly->rnorm = mpz_get_d(res);
 
-	// extract from msieve (in a convoluted way) the Murphy score of the polynomial
-	// along with several other values.  This will be used to rank the polynomials generated.
-	analyze_one_poly_xface(poly);
+	// the Murphy score and friends are computed later, for all candidates 
+	// at once, in snfs_rank_polys.
 
+	mpz_clear(tmp);
+	mpz_clear(res);
 	return;
 }
 
@@ -2454,56 +2455,102 @@ void snfs_scale_difficulty(snfs_t *polys, int npoly)
 
 void analyze_one_poly_xface(snfs_t *poly)
 {
-	char line[1024], *ptr;
-	FILE *in;
-	msieve_obj *obj;
-	char outfile[80];
+	// score the polynomial in memory and record the results with it.
+	// the murphy default matches what snfs_rank_polys uses for rejects.
+	nfs_polyscore_t score;
 
-	sprintf(outfile, "YAFU_get_poly_score.out");
+	poly->poly->murphy = 1e-99;
+	nfs_score_poly(poly->poly, &score);
 
-	obj = msieve_obj_new("", MSIEVE_FLAG_USE_LOGFILE, NULL, outfile,
-		NULL, 0, 0, (uint32)0, (enum cpu_type)0, 0, 0, 0, (uint32)0, "");
+	poly->poly->size = score.size;
+	poly->poly->alpha = score.alpha;
+	poly->poly->murphy = score.murphy;
+	poly->poly->rroots = score.rroots;
 
-	remove(outfile);
-	poly->poly->murphy = 1e-99;
-	analyze_one_poly(obj, &poly->poly->rat, &poly->poly->alg, poly->poly->skew);
-	in = fopen(outfile, "r");
-	if (in != NULL)
+	return;
+}
+
+// candidate scoring is spread over threads by snfs_rank_polys
+typedef struct
+{
+	snfs_t *polys;
+	int npoly;
+	int tid;
+	int nthreads;
+
+#if defined(WIN32) || defined(_WIN64)
+	HANDLE thread_id;
+#else
+	pthread_t thread_id;
+#endif
+
+} snfs_score_thread_t;
+
+#if defined(WIN32) || defined(_WIN64)
+DWORD WINAPI snfs_score_worker(LPVOID thread_data) {
+#else
+void *snfs_score_worker(void *thread_data) {
+#endif
+	snfs_score_thread_t *t = (snfs_score_thread_t *)thread_data;
+	int i;
+
+	// polys are dealt round-robin; they are all about the same cost
+	for (i = t->tid; i < t->npoly; i += t->nthreads)
 	{
-		while (!feof(in))
-		{
-			ptr = fgets(line, 1024, in);
-			if (ptr == NULL)
-				break;
+		if (t->polys[i].valid)
+			analyze_one_poly_xface(&t->polys[i]);
+	}
 
-			ptr = strstr(line, "size");
-			if (ptr == NULL)
-				continue;
+#if defined(WIN32) || defined(_WIN64)
+	return 0;
+#else
+	return NULL;
+#endif
+}
 
-			poly->poly->size = strtod(ptr + 5, NULL);
+void snfs_score_polys(fact_obj_t *fobj, snfs_t *polys, int npoly)
+{
+	snfs_score_thread_t *threads;
+	int i, nthreads = MIN(fobj->num_threads, npoly);
 
-			ptr = strstr(ptr, "alpha");
-			if (ptr == NULL)
-				continue;
+	if (nthreads < 1)
+		nthreads = 1;
 
-			poly->poly->alpha = strtod(ptr + 6, NULL);
+	// the rho table is shared, build it before anyone reads it
+	nfs_polyscore_init();
 
-			ptr = strstr(ptr, "combined");
-			if (ptr == NULL)
-				continue;
+	threads = (snfs_score_thread_t *)malloc(nthreads * sizeof(snfs_score_thread_t));
+	for (i = 0; i < nthreads; i++)
+	{
+		threads[i].polys = polys;
+		threads[i].npoly = npoly;
+		threads[i].tid = i;
+		threads[i].nthreads = nthreads;
+	}
 
-			poly->poly->murphy = strtod(ptr + 11, NULL);
+	// the main thread takes the first share itself
+	for (i = 1; i < nthreads; i++)
+	{
+#if defined(WIN32) || defined(_WIN64)
+		threads[i].thread_id = CreateThread(NULL, 0, snfs_score_worker, &threads[i], 0, NULL);
+#else
+		pthread_create(&threads[i].thread_id, NULL, snfs_score_worker, &threads[i]);
+#endif
+	}
 
-			ptr = strstr(ptr, "rroots");
-			if (ptr == NULL)
-				continue;
+	snfs_score_worker(&threads[0]);
 
-			sscanf(ptr + 8, "%d", &poly->poly->rroots);
-		}
-		fclose(in);			
+	for (i = 1; i < nthreads; i++)
+	{
+#if defined(WIN32) || defined(_WIN64)
+		WaitForSingleObject(threads[i].thread_id, INFINITE);
+		CloseHandle(threads[i].thread_id);
+#else
+		pthread_join(threads[i].thread_id, NULL);
+#endif
 	}
-	msieve_obj_free(obj);
 
+	free(threads);
 	return;
 }
 
@@ -2547,7 +2594,10 @@ int snfs_rank_polys(fact_obj_t *fobj, snfs_t *polys, int npoly)
 	int pref_count = 0;
 	int alt_count = 0;
 
-	// first eliminate duplicate 
+	// score all of the candidates, in parallel
+	snfs_score_polys(fobj, polys, npoly);
+
+	// then eliminate duplicate 
 	for (i=0, k=0; i<npoly; i++)
 	{
 		for (j=i+1; j<npoly; j++)
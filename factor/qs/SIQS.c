@@ -91,6 +91,12 @@ void SIQS(fact_obj_t *fobj)
 	// checking savefile
 	FILE *data;
 	char tmpstr[GSTR_MAXSIZE];
+	uint32 saved_mult = 0;
+	int resuming = 0;
+
+	// memory accounting
+	int num_threads = fobj->num_threads;
+	size_t thread_bytes, shared_bytes;
 
 	//logfile for this factorization
 	//must ensure it is only written to by main thread
@@ -141,6 +147,12 @@ void SIQS(fact_obj_t *fobj)
 				add_to_factor_list(fobj, g);
 			mpz_tdiv_q(fobj->qs_obj.gmp_n, fobj->qs_obj.gmp_n, g);
 			mpz_set(fobj->N, fobj->qs_obj.gmp_n);
+			resuming = 1;
+
+			// relations in the file only make sense with the multiplier
+			// they were found with, so reuse it if it was recorded
+			if ((fgets(tmpstr, GSTR_MAXSIZE, data) != NULL) && (tmpstr[0] == 'M'))
+				saved_mult = strtoul(tmpstr + 2, NULL, 10);
 		}
 		mpz_clear(tmpz);
 		mpz_clear(g);
@@ -174,25 +186,25 @@ void SIQS(fact_obj_t *fobj)
 	static_conf->obj = fobj;
 
     // allocate the queue of threads waiting for work
-    thread_queue = (int *)malloc(THREADS * sizeof(int));
+    thread_queue = (int *)malloc(fobj->num_threads * sizeof(int));
     threads_waiting = (int *)malloc(sizeof(int));
 
-	if (THREADS > 1)
+	if (fobj->num_threads > 1)
 	{
 #if defined(WIN32) || defined(_WIN64)
 		queue_lock = CreateMutex( 
 			NULL,              // default security attributes
 			FALSE,             // initially not owned
 			NULL);             // unnamed mutex
-		queue_events = (HANDLE *)malloc(THREADS * sizeof(HANDLE));
+		queue_events = (HANDLE *)malloc(fobj->num_threads * sizeof(HANDLE));
 #else
 		pthread_mutex_init(&queue_lock, NULL);
 		pthread_cond_init(&queue_cond, NULL);
 #endif
 	}
 
-	thread_data = (thread_sievedata_t *)malloc(THREADS * sizeof(thread_sievedata_t));
-	for (i=0; i<THREADS; i++)
+	thread_data = (thread_sievedata_t *)malloc(fobj->num_threads * sizeof(thread_sievedata_t));
+	for (i=0; i<fobj->num_threads; i++)
 	{
 		thread_data[i].dconf = (dynamic_conf_t *)malloc(sizeof(dynamic_conf_t));
 		thread_data[i].sconf = static_conf;
@@ -202,7 +214,7 @@ void SIQS(fact_obj_t *fobj)
         thread_data[i].thread_queue = thread_queue;
         thread_data[i].threads_waiting = threads_waiting;
 
-		if (THREADS > 1)
+		if (fobj->num_threads > 1)
 		{
 #if defined(WIN32) || defined(_WIN64)
 			// assign a pointer to the mutex
@@ -217,14 +229,11 @@ void SIQS(fact_obj_t *fobj)
 
 	//initialize the flag to watch for interrupts, and set the
 	//pointer to the function to call if we see a user interrupt
-	SIQS_ABORT = 0;
+	fobj_watch_sigint(fobj);
 	signal(SIGINT,siqsexit);
-
-	//initialize offset for savefile buffer
-	savefile_buf_off = 0;	
 	
 	//function pointer to the sieve array scanner
-	scan_ptr = NULL;
+	static_conf->scan_ptr = NULL;
 
 	//start a counter for the whole job
 	gettimeofday(&static_conf->totaltime_start, NULL);
@@ -237,7 +246,7 @@ void SIQS(fact_obj_t *fobj)
 	{
 		logprint(sieve_log,"starting SIQS on c%d: %s\n",fobj->digits,
 			mpz_conv2str(&gstr1.s, 10, fobj->qs_obj.gmp_n));
-		logprint(sieve_log,"random seeds: %u, %u\n",g_rand.hi, g_rand.low);
+		logprint(sieve_log,"random seeds: %u, %u\n",fobj->seed2, fobj->seed1);
 		fflush(sieve_log);
 	}
 
@@ -249,6 +258,19 @@ void SIQS(fact_obj_t *fobj)
 	} 
 #endif
 
+	//optionally pick the multiplier by test sieving the best candidates.
+	//don't bother for small jobs, where the tests would cost more than
+	//a better multiplier could save.  a savefile written before the
+	//multiplier was recorded holds relations of the default choice,
+	//so resuming one keeps the default.
+	static_conf->forced_multiplier = saved_mult;
+	if ((resuming == 0) && (fobj->qs_obj.mult_test > 1) && 
+		(fobj->digits >= QS_MULT_TEST_MIN_DIGITS))
+	{
+		static_conf->forced_multiplier = 
+			siqs_test_multipliers(fobj, fobj->qs_obj.mult_test);
+	}
+
 	//get best parameters, multiplier, and factor base for the job
 	//initialize and fill out the static part of the job data structure
 	siqs_static_init(static_conf, 0);
@@ -264,8 +286,40 @@ void SIQS(fact_obj_t *fobj)
 	else
 		static_conf->in_mem = 0;
 
-	//allocate structures for use in sieving with threads
-	for (i=0; i<THREADS; i++)
+	//allocate structures for use in sieving with threads.  the first
+	//one tells us what a thread costs: if that many threads won't fit
+	//in the memory budget, run fewer.
+	siqs_dynamic_init(thread_data[0].dconf, static_conf);
+	thread_bytes = siqs_memory_report(static_conf, thread_data[0].dconf,
+		fobj->num_threads, &shared_bytes, 
+		(VFLAG > 1) || ((VFLAG > 0) && (fobj->qs_obj.mem_budget > 0)));
+
+	if (fobj->qs_obj.mem_budget > 0)
+	{
+		size_t budget = (size_t)fobj->qs_obj.mem_budget << 20;
+		int fit = 1;
+
+		if (budget > shared_bytes)
+			fit = (int)((budget - shared_bytes) / thread_bytes);
+
+		if (fit < 1)
+			fit = 1;
+
+		if (fit < fobj->num_threads)
+		{
+			printf("memory budget of %u MB allows %d of %d threads\n",
+				fobj->qs_obj.mem_budget, fit, fobj->num_threads);
+			if (sieve_log != NULL)
+				logprint(sieve_log,"memory budget of %u MB allows %d of %d threads\n",
+					fobj->qs_obj.mem_budget, fit, fobj->num_threads);
+
+			for (i=fit; i<fobj->num_threads; i++)
+				free(thread_data[i].dconf);
+			fobj->num_threads = fit;
+		}
+	}
+
+	for (i=1; i<fobj->num_threads; i++)
 		siqs_dynamic_init(thread_data[i].dconf, static_conf);
 
 	//check if a savefile exists for this number, and if so load the data
@@ -276,7 +330,9 @@ void SIQS(fact_obj_t *fobj)
 	//start the process
 	num_needed = static_conf->factor_base->B + static_conf->num_extra_relations;
 	num_found = static_conf->num_r;
-	static_conf->total_poly_a = -1;
+	// keep any A values recovered from the savefile in the list
+	// so that they are not used again
+	static_conf->total_poly_a = static_conf->total_poly_a - 1;
 
 #ifdef OPT_DEBUG
 	optfile = fopen("optfile.csv","a");
@@ -292,17 +348,17 @@ void SIQS(fact_obj_t *fobj)
 	num_meas = 0;
 	orig_value = static_conf->tf_small_cutoff;
 
-	if (THREADS > 1)
+	if (fobj->num_threads > 1)
 	{
 		// Activate the worker threads one at a time. 
 		// Initialize the work queue to say all threads are waiting for work
-		for (i = 0; i < THREADS; i++) 
+		for (i = 0; i < fobj->num_threads; i++) 
 		{
 			start_worker_thread(thread_data + i);
 			thread_queue[i] = i;
 		}
 	}
-    *threads_waiting = THREADS;
+    *threads_waiting = fobj->num_threads;
 
           /*
             MASTER THREAD:
@@ -340,7 +396,7 @@ void SIQS(fact_obj_t *fobj)
             }
 
 
-            WORKER THREADS:
+            WORKER fobj->num_threads:
 
             while (1) {
               wait for COMMAND_RUN (same as current code)
@@ -356,7 +412,7 @@ void SIQS(fact_obj_t *fobj)
 
         // Master thread begins with the workqueue locked
 
-	if (THREADS > 1)
+	if (fobj->num_threads > 1)
 	{
 #if defined(WIN32) || defined(_WIN64)
 		// nothing
@@ -373,7 +429,7 @@ void SIQS(fact_obj_t *fobj)
 		{
 			int tid;
 			
-			if (THREADS > 1)
+			if (fobj->num_threads > 1)
 			{
 				// Pop a waiting thread off the queue (OK, it's stack not a queue)
 #if defined(WIN32) || defined(_WIN64)
@@ -507,7 +563,7 @@ void SIQS(fact_obj_t *fobj)
 				free(qs_timing_diff);
 #endif
 
-				if (THREADS > 1)
+				if (fobj->num_threads > 1)
 				{
 					// send the thread a signal to start processing the poly we just generated for it
 #if defined(WIN32) || defined(_WIN64)
@@ -525,7 +581,7 @@ void SIQS(fact_obj_t *fobj)
 				threads_working++;
 			}
 
-			if (THREADS == 1)
+			if (fobj->num_threads == 1)
 				*threads_waiting = 0;
 	
 		} // while (*threads_waiting > 0)
@@ -534,12 +590,12 @@ void SIQS(fact_obj_t *fobj)
 		if (threads_working == 0)
 			break;
 
-		if (THREADS > 1)
+		if (fobj->num_threads > 1)
 		{
 			// wait for a thread to finish and put itself in the waiting queue
 #if defined(WIN32) || defined(_WIN64)
 			j = WaitForMultipleObjects(
-				THREADS,
+				fobj->num_threads,
 				queue_events,
 				FALSE,
 				INFINITE);
@@ -562,11 +618,25 @@ void SIQS(fact_obj_t *fobj)
 	fclose(optfile);
 #endif		
 
+	//report what the buffers that grow with use ended up needing
+	if (VFLAG > 1)
+	{
+		for (i=1, j=0; i<fobj->num_threads; i++)
+		{
+			if (siqs_memory_report(static_conf, thread_data[i].dconf, 0, NULL, 0) >
+				siqs_memory_report(static_conf, thread_data[j].dconf, 0, NULL, 0))
+				j = i;
+		}
+		printf("\nat the end of sieving, ");
+		siqs_memory_report(static_conf, thread_data[j].dconf, 
+			fobj->num_threads, NULL, 1);
+	}
+
 	//stop worker threads
-	for (i=0; i<THREADS; i++)
+	for (i=0; i<fobj->num_threads; i++)
 	{
 		//static_conf->tot_poly += thread_data[i].dconf->tot_poly;
-		if (THREADS > 1)
+		if (fobj->num_threads > 1)
 			stop_worker_thread(thread_data + i);
 		free_sieve(thread_data[i].dconf);
 		free(thread_data[i].dconf->relation_buf);
@@ -580,8 +650,12 @@ void SIQS(fact_obj_t *fobj)
 	cuCtxDetach(static_conf->cuContext);
 #endif
 	
+	//anything still waiting on a batch test goes in now
+	batch_test(static_conf);
+
 	//finialize savefile
 	qs_savefile_flush(&static_conf->obj->qs_obj.savefile);
+	siqs_write_checkpoint(static_conf);
 	qs_savefile_close(&static_conf->obj->qs_obj.savefile);		
 	
 	update_final(static_conf);
@@ -607,6 +681,9 @@ void SIQS(fact_obj_t *fobj)
 	if (VFLAG > 0)
 	{
 		printf("QS elapsed time = %6.4f seconds.\n",t_time);
+		if (static_conf->num_a_rejected > 0)
+			printf("%u poly_a candidates rejected for sharing all but one "
+				"factor with a previous poly_a\n", static_conf->num_a_rejected);
 		//printf("Predicted MAX_DIFF = %u, Actual MAX_DIFF = %u\n",MAX_DIFF,MAX_DIFF2);
 		printf("\n==== post processing stage (msieve-1.38) ====\n");
 	}
@@ -699,17 +776,18 @@ done:
 	if (sieve_log != NULL)
 		fclose(sieve_log);
 
-	for (i=0; i<THREADS; i++)
+	for (i=0; i<fobj->num_threads; i++)
 	{
 		free(thread_data[i].dconf);
 	}
+	fobj->num_threads = num_threads;
 	free(static_conf);
 	free(thread_data);
     free(thread_queue);
     free(threads_waiting);
 
 #if defined(WIN32) || defined(_WIN64)
-	if (THREADS > 1)
+	if (fobj->num_threads > 1)
 		free(queue_events);
 #endif
 
@@ -893,7 +971,11 @@ void *process_poly(void *ptr)
 	dconf->numB = 1;
 	computeBl(sconf,dconf);
 
-	firstRoots_ptr(sconf,dconf);
+	//make sure there is room for this A's root updates
+	if ((uint32)dconf->curr_poly->s > dconf->rootupdate_rows)
+		siqs_alloc_rootupdates(sconf, dconf, dconf->curr_poly->s);
+
+	sconf->firstRoots_ptr(sconf,dconf);
 
 #ifdef QS_TIMING
 	gettimeofday (&qs_timing_stop, NULL);
@@ -911,39 +993,38 @@ void *process_poly(void *ptr)
 		//a faster sieve routine.
 		uint32 invalid_root_marker = 0xFFFFFFFF; //(BLOCKSIZEm1 << 16) | BLOCKSIZEm1;
 
+		//lay out the small prime patterns for this poly's roots
+		if (sconf->num_stripes > 0)
+			stripe_build_patterns(sconf, dconf);
+
 		for (i=0; i < num_blocks; i++)
 		{
 			//set the roots for the factors of a such that
 			//they will not be sieved.  we haven't found roots for them
-			printf("setting prime roots\n"); fflush(stdout);
 			set_aprime_roots(sconf, invalid_root_marker, poly->qlisort, poly->s, fb_sieve_p, 1);
-			printf("medsieve p\n"); fflush(stdout);
-			med_sieve_ptr(sieve, fb_sieve_p, fb, start_prime, blockinit);
-			printf("lpsieve p\n"); fflush(stdout);
+			sconf->med_sieve_ptr(sieve, fb_sieve_p, fb, start_prime, blockinit);
+			if (sconf->num_stripes > 0)
+				stripe_sieveblock(sieve, dconf->stripe_patterns, sconf, i);
 			lp_sieveblock(sieve, i, num_blocks, buckets, 0);
 
 			//set the roots for the factors of a to force the following routine
 			//to explicitly trial divide since we haven't found roots for them
-			printf("setting prime roots\n"); fflush(stdout);
 			set_aprime_roots(sconf, invalid_root_marker, poly->qlisort, poly->s, fb_sieve_p, 0);
-			printf("scan p\n"); fflush(stdout);
-			scan_ptr(i,0,sconf,dconf);
+			sconf->scan_ptr(i,0,sconf,dconf);
 
 			//set the roots for the factors of a such that
 			//they will not be sieved.  we haven't found roots for them
-			printf("setting prime roots\n"); fflush(stdout);
 			set_aprime_roots(sconf, invalid_root_marker, poly->qlisort, poly->s, fb_sieve_n, 1);
-			printf("medsieve n\n"); fflush(stdout);
-			med_sieve_ptr(sieve, fb_sieve_n, fb, start_prime, blockinit);
-			printf("lpsieve n\n"); fflush(stdout);
+			sconf->med_sieve_ptr(sieve, fb_sieve_n, fb, start_prime, blockinit);
+			if (sconf->num_stripes > 0)
+				stripe_sieveblock(sieve, dconf->stripe_patterns + 
+					sconf->stripe_alloc, sconf, i);
 			lp_sieveblock(sieve, i, num_blocks, buckets, 1);
 
 			//set the roots for the factors of a to force the following routine
 			//to explicitly trial divide since we haven't found roots for them
-			printf("setting prime roots\n"); fflush(stdout);
 			set_aprime_roots(sconf, invalid_root_marker, poly->qlisort, poly->s, fb_sieve_n, 0);
-			printf("scan p\n"); fflush(stdout);
-			scan_ptr(i,1,sconf,dconf);			
+			sconf->scan_ptr(i,1,sconf,dconf);			
 
 		}
 
@@ -976,11 +1057,9 @@ void *process_poly(void *ptr)
 
 		//next polynomial
 		//use the stored Bl's and the gray code to find the next b
-		printf("next B\n"); fflush(stdout);
 		nextB(dconf,sconf);
 		//and update the roots
-		printf("next roots\n"); fflush(stdout);
-		nextRoots_ptr(sconf, dconf);
+		sconf->nextRoots_ptr(sconf, dconf);
 
 	}
 
@@ -1117,13 +1196,15 @@ uint32 siqs_merge_data(dynamic_conf_t *dconf, static_conf_t *sconf)
 
 #endif
 
+	//relations whose residues wait on a batch test are set aside
+	batch_add(sconf, dconf);
+
 	//save the data and merge into master cycle structure
 	for (i=0; i<dconf->buffered_rels; i++)
 	{
-#ifdef HAVE_CUDA
 		if (dconf->relation_buf[i].num_factors == 0)
 			continue;
-#endif
+
 		rel = dconf->relation_buf + i;
 		//if ((rel->large_prime[0]) > 1 && (rel->large_prime[1] > 1))
 		//	ndp++;
@@ -1148,6 +1229,12 @@ uint32 siqs_merge_data(dynamic_conf_t *dconf, static_conf_t *sconf)
 		sconf->num_cycles +
 		sconf->components - sconf->vertices;
 
+	//test the waiting residues once there are enough of them, or once
+	//it looks like we're done without them
+	if ((sconf->num_batch > 0) && ((sconf->num_batch >= sconf->batch_size) ||
+		(sconf->num_r >= sconf->factor_base->B + sconf->num_extra_relations)))
+		batch_test(sconf);
+
 	return sconf->num_r;
 }
 
@@ -1189,8 +1276,12 @@ int siqs_check_restart(dynamic_conf_t *dconf, static_conf_t *sconf)
 		qs_savefile_open(&obj->qs_obj.savefile,SAVEFILE_WRITE);
 		gmp_sprintf(buf,"N 0x%Zx\n", sconf->obj->qs_obj.gmp_n);
 		qs_savefile_write_line(&obj->qs_obj.savefile,buf);
+		sprintf(buf,"M %u\n", sconf->multiplier);
+		qs_savefile_write_line(&obj->qs_obj.savefile,buf);
 		qs_savefile_flush(&obj->qs_obj.savefile);
 		qs_savefile_close(&obj->qs_obj.savefile);
+		//any checkpoint left over belongs to the old savefile
+		siqs_remove_checkpoint(sconf);
 		//and get ready for collecting relations
 		qs_savefile_open(&obj->qs_obj.savefile,SAVEFILE_APPEND);
 	}
@@ -1239,6 +1330,9 @@ void print_siqs_splash(dynamic_conf_t *dconf, static_conf_t *sconf)
 		printf("using multiplier of %u\n",sconf->multiplier);
 		printf("using SPV correction of %d bits, starting at offset %d\n",
 			sconf->tf_small_cutoff,sconf->sieve_small_fb_start);
+		if (sconf->num_stripes > 0)
+			printf("pattern sieving %d small primes in %d stripes\n",
+				sconf->stripe_fb_end - 2, sconf->num_stripes);
 
 #if defined(HAS_SSE2)
 		printf("using SSE2 for x%d sieve scanning\n",
@@ -1328,7 +1422,7 @@ void print_siqs_splash(dynamic_conf_t *dconf, static_conf_t *sconf)
 
 	if (VFLAG >= 0)
 	{
-		if (THREADS == 1)
+		if (sconf->obj->num_threads == 1)
 		{
 			printf("\n==== sieving in progress (1 thread): %7u relations needed ====\n",
 				sconf->factor_base->B + sconf->num_extra_relations);
@@ -1337,7 +1431,7 @@ void print_siqs_splash(dynamic_conf_t *dconf, static_conf_t *sconf)
 		else
 		{
 			printf("\n==== sieving in progress (%2d threads): %7u relations needed ====\n",
-				THREADS,sconf->factor_base->B + sconf->num_extra_relations);
+				sconf->obj->num_threads,sconf->factor_base->B + sconf->num_extra_relations);
 			printf(  "====            Press ctrl-c to abort and save state            ====\n");
 		}
 	}
@@ -1375,6 +1469,9 @@ void print_siqs_splash(dynamic_conf_t *dconf, static_conf_t *sconf)
 		logprint(sconf->obj->logfile,"using multiplier of %u\n",sconf->multiplier);
 		logprint(sconf->obj->logfile,"using SPV correction of %d bits, starting at offset %d\n",
 			sconf->tf_small_cutoff,sconf->sieve_small_fb_start);
+		if (sconf->num_stripes > 0)
+			logprint(sconf->obj->logfile,"pattern sieving %d small primes in %d stripes\n",
+				sconf->stripe_fb_end - 2, sconf->num_stripes);
 
 
 #if defined(HAS_SSE2)
@@ -1423,10 +1520,10 @@ void print_siqs_splash(dynamic_conf_t *dconf, static_conf_t *sconf)
 #endif
 		logprint(sconf->obj->logfile,"trial factoring cutoff at %d bits\n",
 			sconf->tf_closnuf);
-		if (THREADS == 1)
+		if (sconf->obj->num_threads == 1)
 			logprint(sconf->obj->logfile,"==== sieving started (1 thread) ====\n");
 		else
-			logprint(sconf->obj->logfile,"==== sieving started (%2d threads) ====\n",THREADS);
+			logprint(sconf->obj->logfile,"==== sieving started (%2d threads) ====\n",sconf->obj->num_threads);
 	}
 
 	return;
@@ -1435,13 +1532,9 @@ void print_siqs_splash(dynamic_conf_t *dconf, static_conf_t *sconf)
 int siqs_dynamic_init(dynamic_conf_t *dconf, static_conf_t *sconf)
 {
 	//allocate the dynamic structure which hold scratch space for 
-	//various things used during sieving.
-	uint32 i, memsize;
-
-	if (VFLAG > 2)
-	{
-		printf("memory usage during sieving:\n");
-	}
+	//various things used during sieving.  see siqs_memory_report
+	//for an accounting of what this costs per thread.
+	uint32 i;
 
 	//workspace bigints
 	mpz_init(dconf->gmptmp1); //, sconf->bits);
@@ -1456,175 +1549,72 @@ int siqs_dynamic_init(dynamic_conf_t *dconf, static_conf_t *sconf)
 	mpz_init(dconf->curr_poly->mpz_poly_b);
 	mpz_init(dconf->curr_poly->mpz_poly_c);
 	dconf->curr_poly->qlisort = (int *)malloc(MAX_A_FACTORS*sizeof(int));
-	dconf->curr_poly->gray = (char *) malloc( 65536 * sizeof(char));
-	dconf->curr_poly->nu = (char *) malloc( 65536 * sizeof(char));
-	if (VFLAG > 2)
-	{
-		memsize = MAX_A_FACTORS * sizeof(int);
-		memsize += 65536 * sizeof(char);
-		memsize += 65536 * sizeof(char);
-		printf("\tcurr_poly structure: %d bytes\n",memsize);
-	}
-
-	//initialize temporary storage of relations
-	dconf->relation_buf = (siqs_r *)malloc(32768 * sizeof(siqs_r));
-	dconf->buffered_rel_alloc = 32768;
+	dconf->curr_poly->gray = (char *) malloc( GRAY_CODE_ALLOC * sizeof(char));
+	dconf->curr_poly->nu = (char *) malloc( GRAY_CODE_ALLOC * sizeof(char));
+
+	//initialize temporary storage of relations.  save_relation doubles
+	//it whenever one poly a yields more than it can hold, so it ends up
+	//sized to what this job needs.
+	dconf->relation_buf = (siqs_r *)malloc(QS_INIT_RELATION_BUF * sizeof(siqs_r));
+	dconf->buffered_rel_alloc = QS_INIT_RELATION_BUF;
 	dconf->buffered_rels = 0;
+	dconf->batch_q = (uint64 *)malloc(QS_INIT_RELATION_BUF * sizeof(uint64));
+	dconf->batch_id = (uint32 *)malloc(QS_INIT_RELATION_BUF * sizeof(uint32));
+	dconf->num_batch = 0;
 #ifdef HAVE_CUDA
-	dconf->squfof_candidates = (uint64 *)malloc(32768 * sizeof(uint64));
-	dconf->buf_id = (uint32 *)malloc(32768 * sizeof(uint32));
+	dconf->squfof_candidates = (uint64 *)malloc(QS_INIT_RELATION_BUF * sizeof(uint64));
+	dconf->buf_id = (uint32 *)malloc(QS_INIT_RELATION_BUF * sizeof(uint32));
 	dconf->num_squfof_cand = 0;
 #endif
 
-	if (VFLAG > 2)
-	{
-		memsize = 32768 * sizeof(siqs_r);
-		printf("\trelation buffer: %d bytes\n",memsize);
-	}
-
-	//allocate the sieving factor bases
+	//the sieving factor bases.  the logps never change and are shared 
+	//by all threads.  the primes and roots are allocated with the sieve.
 
 	dconf->comp_sieve_p = (sieve_fb_compressed *)malloc(sizeof(sieve_fb_compressed));
 	dconf->comp_sieve_n = (sieve_fb_compressed *)malloc(sizeof(sieve_fb_compressed));
-
-	dconf->comp_sieve_p->prime = (uint16 *)xmalloc_align(
-		(size_t)(sconf->factor_base->med_B * sizeof(uint16)));
-	dconf->comp_sieve_p->root1 = (uint16 *)xmalloc_align(
-		(size_t)(sconf->factor_base->med_B * sizeof(uint16)));
-	dconf->comp_sieve_p->root2 = (uint16 *)xmalloc_align(
-		(size_t)(sconf->factor_base->med_B * sizeof(uint16)));
-	dconf->comp_sieve_p->logp = (uint16 *)xmalloc_align(
-		(size_t)(sconf->factor_base->med_B * sizeof(uint16)));
-
-	dconf->comp_sieve_n->prime = (uint16 *)xmalloc_align(
-		(size_t)(sconf->factor_base->med_B * sizeof(uint16)));
-	dconf->comp_sieve_n->root1 = (uint16 *)xmalloc_align(
-		(size_t)(sconf->factor_base->med_B * sizeof(uint16)));
-	dconf->comp_sieve_n->root2 = (uint16 *)xmalloc_align(
-		(size_t)(sconf->factor_base->med_B * sizeof(uint16)));
-	dconf->comp_sieve_n->logp = (uint16 *)xmalloc_align(
-		(size_t)(sconf->factor_base->med_B * sizeof(uint16)));
-
-	dconf->fb_sieve_p = (sieve_fb *)xmalloc_align(
-		(size_t)(sconf->factor_base->B * sizeof(sieve_fb)));
-	dconf->fb_sieve_n = (sieve_fb *)xmalloc_align(
-		(size_t)(sconf->factor_base->B * sizeof(sieve_fb)));
+	dconf->comp_sieve_p->logp = sconf->sieve_logp;
+	dconf->comp_sieve_n->logp = sconf->sieve_logp;
+	dconf->update_data.prime = sconf->factor_base->list->prime;
+	dconf->update_data.logp = sconf->update_logp;
+
+	//room for the root updates of one more poly a factor than we expect
+	//to need.  process_poly makes more if an A ever comes out bigger.
+	dconf->rootupdates = NULL;
+	dconf->sm_rootupdates = NULL;
+	dconf->rootupdate_rows = 0;
+	siqs_alloc_rootupdates(sconf, dconf, 
+		(uint32)mpz_sizeinbase(sconf->target_a, 2) / 11 + 1);
 	
-	dconf->update_data.sm_firstroots1 = (uint16 *)xmalloc_align(
-		(size_t)(sconf->factor_base->med_B * sizeof(uint16)));
-	dconf->update_data.sm_firstroots2 = (uint16 *)xmalloc_align(
-		(size_t)(sconf->factor_base->med_B * sizeof(uint16)));
-	dconf->update_data.firstroots1 = (int *)xmalloc_align(
-		(size_t)(sconf->factor_base->B * sizeof(int)));
-	dconf->update_data.firstroots2 = (int *)xmalloc_align(
-		(size_t)(sconf->factor_base->B * sizeof(int)));
-	dconf->update_data.prime = (uint32 *)xmalloc_align(
-		(size_t)(sconf->factor_base->B * sizeof(uint32)));
-	dconf->update_data.logp = (uint8 *)xmalloc_align(
-		(size_t)(sconf->factor_base->B * sizeof(uint8)));
-	dconf->rootupdates = (int *)xmalloc_align(
-		(size_t)(MAX_A_FACTORS * sconf->factor_base->B * sizeof(int)));
-	dconf->sm_rootupdates = (uint16 *)xmalloc_align(
-		(size_t)(MAX_A_FACTORS * sconf->factor_base->B * sizeof(uint16)));
-
-
-	if (VFLAG > 2)
-	{
-		memsize = sconf->factor_base->med_B * sizeof(sieve_fb_compressed) * 2;
-		memsize += sconf->factor_base->B * sizeof(sieve_fb) * 2;
-		printf("\tfactor bases: %d bytes\n",memsize);
-	}
-
-	if (VFLAG > 2)
-	{
-		memsize = sconf->factor_base->B * sizeof(int)  * 2;
-		memsize += sconf->factor_base->B * sizeof(uint32);
-		memsize += sconf->factor_base->B * sizeof(uint8);
-		printf("\tupdate data: %d bytes\n",memsize);
-	}
-	
-	//allocate the sieve
-	dconf->sieve = (uint8 *)xmalloc_align(
-		(size_t) (sconf->qs_blocksize * sizeof(uint8)));
-
-	if (VFLAG > 2)
-	{
-		memsize = sconf->qs_blocksize * sizeof(uint8);
-		printf("\tsieve: %d bytes\n",memsize);
-	}
-
 	//allocate the Bl array, space for MAX_Bl bigint numbers
 	dconf->Bl = (mpz_t *)malloc(MAX_A_FACTORS * sizeof(mpz_t));
 	for (i=0;i<MAX_A_FACTORS;i++)
 		mpz_init(dconf->Bl[i]);
 
-	//copy the unchanging part to the sieving factor bases
-	for (i = 2; i < sconf->factor_base->med_B; i++)
-	{
-		uint32 p = sconf->factor_base->list->prime[i];
-		uint32 lp = sconf->factor_base->list->logprime[i];
-
-		dconf->comp_sieve_p->logp[i] = (uint8)lp;
-		dconf->comp_sieve_p->prime[i] = (uint16)p;
-		dconf->comp_sieve_n->logp[i] = (uint8)lp;
-		dconf->comp_sieve_n->prime[i] = (uint16)p;
-
-		dconf->fb_sieve_p[i].prime = p;
-		dconf->fb_sieve_p[i].logprime = lp;
-		dconf->fb_sieve_n[i].prime = p;
-		dconf->fb_sieve_n[i].logprime = lp;
-		dconf->update_data.prime[i] = p;
-		dconf->update_data.logp[i] = lp;
-	}
-
-	for (; i < sconf->factor_base->B; i++)
-	{
-		dconf->fb_sieve_p[i].prime = sconf->factor_base->list->prime[i];
-		dconf->fb_sieve_p[i].logprime = sconf->factor_base->list->logprime[i];
-		dconf->fb_sieve_n[i].prime = sconf->factor_base->list->prime[i];
-		dconf->fb_sieve_n[i].logprime = sconf->factor_base->list->logprime[i];
-		dconf->update_data.prime[i] = sconf->factor_base->list->prime[i];
-		dconf->update_data.logp[i] = sconf->factor_base->list->logprime[i];
-	}
-
 	//check if we should use bucket sieving, and allocate structures if so
 	if (sconf->factor_base->B > sconf->factor_base->med_B)
 	{
 		dconf->buckets = (lp_bucket *)malloc(sizeof(lp_bucket));
 
 		//test to see how many slices we'll need.
-		testRoots_ptr(sconf,dconf);
+		sconf->testRoots_ptr(sconf,dconf);
 
-		//initialize the bucket lists and auxilary info.
-		dconf->buckets->num = (uint32 *)xmalloc_align(
-			2 * sconf->num_blocks * dconf->buckets->alloc_slices * sizeof(uint32));
+		//initialize the auxilary info.  the bucket lists themselves
+		//go in the arena with the sieve.
 		dconf->buckets->fb_bounds = (uint32 *)malloc(
 			dconf->buckets->alloc_slices * sizeof(uint32));
 		dconf->buckets->logp = (uint8 *)calloc(
 			dconf->buckets->alloc_slices, sizeof(uint8));
 		dconf->buckets->list_size = 2 * sconf->num_blocks * dconf->buckets->alloc_slices;
-		
-		//now allocate the buckets
-		dconf->buckets->list = (uint32 *)xmalloc_align(
-			2 * sconf->num_blocks * dconf->buckets->alloc_slices * 
-			BUCKET_ALLOC * sizeof(uint32));
 	}
 	else
 	{
 		dconf->buckets = (lp_bucket *)malloc(sizeof(lp_bucket));
-		dconf->buckets->list = NULL;
 		dconf->buckets->alloc_slices = 0;
 		dconf->buckets->num_slices = 0;
 	}
 
-	if (VFLAG > 2)
-	{
-		memsize = 2 * sconf->num_blocks * dconf->buckets->alloc_slices * sizeof(uint32);
-		memsize += dconf->buckets->alloc_slices * sizeof(uint32);
-		memsize += dconf->buckets->alloc_slices * sizeof(uint8);
-		memsize += 2 * sconf->num_blocks * dconf->buckets->alloc_slices * BUCKET_ALLOC * sizeof(uint32);
-		printf("\tbucket data: %d bytes\n",memsize);
-	}
+	//allocate the sieve, roots and buckets
+	siqs_alloc_sieve_arrays(sconf, dconf, sconf->obj->qs_obj.hugepages);
 
 	//used in trial division to mask out the fb_index portion of bucket entries, so that
 	//multiple block locations can be searched for in parallel using SSE2 instructions
@@ -1643,22 +1633,21 @@ int siqs_dynamic_init(dynamic_conf_t *dconf, static_conf_t *sconf)
 	dconf->corrections = (uint16 *)xmalloc_align(16 * sizeof(uint16));
 
 	// array of sieve locations scanned from the sieve block that we
-	// will submit to trial division.  make it the size of a sieve block 
-	// in the pathological case that every sieve location is a report
-	dconf->reports = (uint32 *)malloc(MAX_SIEVE_REPORTS * sizeof(uint32));
-	dconf->num_reports = 0;
-		
+	// will submit to trial division, and the per-report trial division
+	// workspace.  the scanners grow these if a block ever has more
+	// reports than they hold, up to MAX_SIEVE_REPORTS.
+	dconf->reports = NULL;
 #ifdef USE_YAFU_TDIV
-	dconf->Qvals32 = (z32 *)malloc(MAX_SIEVE_REPORTS * sizeof(z32));
-	for (i=0; i<MAX_SIEVE_REPORTS; i++)
-		zInit32(&dconf->Qvals32[i]);
+	dconf->Qvals32 = NULL;
 #endif
-	dconf->Qvals = (mpz_t *)malloc(MAX_SIEVE_REPORTS * sizeof(mpz_t));
-	for (i=0; i<MAX_SIEVE_REPORTS; i++)
-		mpz_init(dconf->Qvals[i]); //, 2*sconf->bits);
-
-	dconf->valid_Qs = (int *)malloc(MAX_SIEVE_REPORTS * sizeof(int));
-	dconf->smooth_num = (int *)malloc(MAX_SIEVE_REPORTS * sizeof(int));
+	dconf->Qvals = NULL;
+	dconf->valid_Qs = NULL;
+	dconf->smooth_num = NULL;
+	dconf->fb_offsets = NULL;
+	dconf->report_alloc = 0;
+	dconf->max_reports = 0;
+	siqs_alloc_reports(dconf, QS_INIT_REPORTS);
+	dconf->num_reports = 0;
 	dconf->failed_squfof = 0;
 	dconf->attempted_squfof = 0;
 	dconf->dlp_outside_range = 0;
@@ -1676,6 +1665,239 @@ int siqs_dynamic_init(dynamic_conf_t *dconf, static_conf_t *sconf)
 	return 0;
 }
 
+void siqs_alloc_sieve_arrays(static_conf_t *sconf, dynamic_conf_t *dconf, 
+	int try_huge)
+{
+	//the arrays touched for every block: the sieve, the compressed
+	//factor base, the first roots and the bucket lists.  they come out
+	//of one arena per thread, in huge pages if we can get them (and
+	//they are big enough to fill a good part of one).  the primes are 
+	//zeroed and restored around each block (set_aprime_roots), so each 
+	//thread needs its own copy of those, but both sides can use it.  
+	//with buckets, dconf->buckets->alloc_slices must already be set.
+	uint32 med_B = sconf->factor_base->med_B;
+	uint32 B = sconf->factor_base->B;
+	size_t num_bucket = 2 * sconf->num_blocks * dconf->buckets->alloc_slices;
+	size_t sizes[13];
+	size_t total = 0;
+	uint32 i;
+
+	sizes[0] = med_B * sizeof(uint16);			//comp_sieve_p->prime
+	sizes[1] = med_B * sizeof(uint16);			//comp_sieve_p->root1
+	sizes[2] = med_B * sizeof(uint16);			//comp_sieve_p->root2
+	sizes[3] = med_B * sizeof(uint16);			//comp_sieve_n->root1
+	sizes[4] = med_B * sizeof(uint16);			//comp_sieve_n->root2
+	sizes[5] = med_B * sizeof(uint16);			//sm_firstroots1
+	sizes[6] = med_B * sizeof(uint16);			//sm_firstroots2
+	sizes[7] = B * sizeof(int);					//firstroots1
+	sizes[8] = B * sizeof(int);					//firstroots2
+	sizes[9] = sconf->qs_blocksize * sizeof(uint8);	//sieve
+	sizes[10] = 2 * sconf->stripe_alloc * sizeof(uint8);	//stripe patterns
+	sizes[11] = num_bucket * sizeof(uint32);				//bucket fill counts
+	sizes[12] = num_bucket * BUCKET_ALLOC * sizeof(uint32);	//bucket lists
+
+	for (i = 0; i < 13; i++)
+		total += (sizes[i] + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1);
+
+	arena_init(&dconf->arena, total, sconf->num_arenas++, 
+		try_huge && (total >= ARENA_HUGE_PAGE / 4));
+
+	dconf->comp_sieve_p->prime = (uint16 *)arena_alloc(&dconf->arena, sizes[0]);
+	dconf->comp_sieve_p->root1 = (uint16 *)arena_alloc(&dconf->arena, sizes[1]);
+	dconf->comp_sieve_p->root2 = (uint16 *)arena_alloc(&dconf->arena, sizes[2]);
+	dconf->comp_sieve_n->prime = dconf->comp_sieve_p->prime;
+	dconf->comp_sieve_n->root1 = (uint16 *)arena_alloc(&dconf->arena, sizes[3]);
+	dconf->comp_sieve_n->root2 = (uint16 *)arena_alloc(&dconf->arena, sizes[4]);
+	dconf->update_data.sm_firstroots1 = (uint16 *)arena_alloc(&dconf->arena, sizes[5]);
+	dconf->update_data.sm_firstroots2 = (uint16 *)arena_alloc(&dconf->arena, sizes[6]);
+	dconf->update_data.firstroots1 = (int *)arena_alloc(&dconf->arena, sizes[7]);
+	dconf->update_data.firstroots2 = (int *)arena_alloc(&dconf->arena, sizes[8]);
+	dconf->sieve = (uint8 *)arena_alloc(&dconf->arena, sizes[9]);
+
+	if (sconf->num_stripes > 0)
+		dconf->stripe_patterns = (uint8 *)arena_alloc(&dconf->arena, sizes[10]);
+	else
+		dconf->stripe_patterns = NULL;
+
+	if (num_bucket > 0)
+	{
+		dconf->buckets->num = (uint32 *)arena_alloc(&dconf->arena, sizes[11]);
+		dconf->buckets->list = (uint32 *)arena_alloc(&dconf->arena, sizes[12]);
+	}
+	else
+		dconf->buckets->list = NULL;
+
+	//copy the primes to the sieving factor base
+	for (i = 2; i < med_B; i++)
+		dconf->comp_sieve_p->prime[i] = (uint16)sconf->factor_base->list->prime[i];
+
+	return;
+}
+
+void siqs_alloc_reports(dynamic_conf_t *dconf, uint32 num_reports)
+{
+	//make room for num_reports sieve reports, keeping whatever is
+	//already there.  the scanners call this when a block fills the
+	//report list, so this only ever grows.
+	uint32 i;
+
+	if (num_reports > MAX_SIEVE_REPORTS)
+		num_reports = MAX_SIEVE_REPORTS;
+
+	if (num_reports <= dconf->report_alloc)
+		return;
+
+	dconf->reports = (uint32 *)realloc(dconf->reports, 
+		num_reports * sizeof(uint32));
+#ifdef USE_YAFU_TDIV
+	dconf->Qvals32 = (z32 *)realloc(dconf->Qvals32, 
+		num_reports * sizeof(z32));
+	for (i=dconf->report_alloc; i<num_reports; i++)
+		zInit32(&dconf->Qvals32[i]);
+#endif
+	dconf->Qvals = (mpz_t *)realloc(dconf->Qvals, 
+		num_reports * sizeof(mpz_t));
+	for (i=dconf->report_alloc; i<num_reports; i++)
+		mpz_init(dconf->Qvals[i]);
+
+	dconf->valid_Qs = (int *)realloc(dconf->valid_Qs, 
+		num_reports * sizeof(int));
+	dconf->smooth_num = (int *)realloc(dconf->smooth_num, 
+		num_reports * sizeof(int));
+	dconf->fb_offsets = (uint32 (*)[MAX_SMOOTH_PRIMES])realloc(dconf->fb_offsets, 
+		num_reports * MAX_SMOOTH_PRIMES * sizeof(uint32));
+
+	if ((dconf->reports == NULL) || (dconf->Qvals == NULL) || 
+		(dconf->valid_Qs == NULL) || (dconf->smooth_num == NULL) ||
+		(dconf->fb_offsets == NULL))
+	{
+		printf("error allocating space for %u sieve reports\n", num_reports);
+		exit(-1);
+	}
+
+	dconf->report_alloc = num_reports;
+
+	return;
+}
+
+void siqs_alloc_rootupdates(static_conf_t *sconf, dynamic_conf_t *dconf, uint32 rows)
+{
+	//the root updates hold one row of B entries per factor of poly a.
+	//the old contents are not kept: they are recomputed for every A.
+	uint32 B = sconf->factor_base->B;
+
+	if (rows > MAX_A_FACTORS)
+		rows = MAX_A_FACTORS;
+
+	if (rows <= dconf->rootupdate_rows)
+		return;
+
+	if (dconf->rootupdates != NULL)
+	{
+		align_free(dconf->rootupdates);
+		align_free(dconf->sm_rootupdates);
+	}
+
+	dconf->rootupdates = (int *)xmalloc_align(
+		(size_t)(rows * B * sizeof(int)));
+	dconf->sm_rootupdates = (uint16 *)xmalloc_align(
+		(size_t)(rows * B * sizeof(uint16)));
+	dconf->rootupdate_rows = rows;
+
+	return;
+}
+
+void siqs_share_fb(static_conf_t *sconf)
+{
+	//the parts of the sieving factor base that never change are kept
+	//once, here, rather than copied into both sides of every thread.
+	fb_list *fb = sconf->factor_base;
+	uint32 i;
+
+	sconf->sieve_logp = (uint16 *)xmalloc_align(
+		(size_t)(fb->med_B * sizeof(uint16)));
+	sconf->update_logp = (uint8 *)xmalloc_align(
+		(size_t)(fb->B * sizeof(uint8)));
+
+	for (i = 2; i < fb->med_B; i++)
+		sconf->sieve_logp[i] = (uint8)fb->list->logprime[i];
+
+	for (i = 2; i < fb->B; i++)
+		sconf->update_logp[i] = (uint8)fb->list->logprime[i];
+
+	//no thread has set up its arena yet
+	sconf->num_arenas = 0;
+
+	return;
+}
+
+size_t siqs_memory_report(static_conf_t *sconf, dynamic_conf_t *dconf, 
+	uint32 num_threads, size_t *shared_bytes, int verbose)
+{
+	//account for the memory a sieving thread holds, structure by 
+	//structure, and for what all threads share.  sizes are as currently
+	//allocated, so buffers that grow with use (reports, relations, root
+	//updates) show what the job has needed so far.  returns the bytes
+	//per thread.
+	fb_list *fb = sconf->factor_base;
+	size_t sizes[9], shared, total;
+	char *names[9] = {"sieve block", "small prime roots", "root updates",
+		"bucket sieve", "sieve reports", "relation buffer", "poly data", 
+		"page rounding", "total"};
+	uint32 i;
+
+	sizes[0] = sconf->qs_blocksize + 2 * sconf->stripe_alloc;
+	sizes[1] = 5 * fb->med_B * sizeof(uint16);
+	sizes[2] = 2 * fb->med_B * sizeof(uint16) + 2 * fb->B * sizeof(int) +
+		dconf->rootupdate_rows * fb->B * (sizeof(int) + sizeof(uint16));
+	sizes[3] = 2 * sconf->num_blocks * dconf->buckets->alloc_slices * 
+		(BUCKET_ALLOC + 1) * sizeof(uint32) + 
+		dconf->buckets->alloc_slices * (sizeof(uint32) + sizeof(uint8));
+	sizes[4] = dconf->report_alloc * (sizeof(uint32) + sizeof(mpz_t) +
+		2 * sizeof(int) + MAX_SMOOTH_PRIMES * sizeof(uint32));
+#ifdef USE_YAFU_TDIV
+	sizes[4] += dconf->report_alloc * sizeof(z32);
+#endif
+	sizes[5] = dconf->buffered_rel_alloc * sizeof(siqs_r);
+	sizes[6] = 2 * GRAY_CODE_ALLOC * sizeof(char) + 
+		MAX_A_FACTORS * (sizeof(int) + sizeof(mpz_t));
+
+	//the arena holding the sieve, roots and buckets is rounded up to 
+	//whole huge pages if it got them
+	sizes[7] = dconf->arena.size - dconf->arena.used;
+
+	total = 0;
+	for (i = 0; i < 8; i++)
+		total += sizes[i];
+	sizes[8] = total;
+
+	//the factor base itself, its square roots, and the shared sieving 
+	//and update copies
+	shared = fb->B * (3 * sizeof(uint32) + sizeof(uint8) +
+		2 * sizeof(fb->list->small_inv[0])) + 
+		fb->med_B * sizeof(uint16);
+
+	if (verbose)
+	{
+		printf("memory use per sieving thread:\n");
+		for (i = 0; i < 9; i++)
+			printf("\t%-20s %" PRIu64 " bytes\n", names[i], (uint64)sizes[i]);
+		printf("\t%-20s %u (%u in use at most)\n", "reports per block", 
+			dconf->report_alloc, dconf->max_reports);
+		printf("\t%-20s %s\n", "sieve arrays in", 
+			arena_pages_name(&dconf->arena));
+		printf("shared by all threads:\n");
+		printf("\t%-20s %" PRIu64 " bytes\n", "factor base", (uint64)shared);
+		printf("total for %u threads: %1.1f MB\n", num_threads,
+			(double)(shared + num_threads * total) / 1048576.0);
+	}
+
+	if (shared_bytes != NULL)
+		*shared_bytes = shared;
+
+	return total;
+}
+
 int siqs_static_init(static_conf_t *sconf, int is_tiny)
 {
 	//find the best parameters, multiplier, and factor base
@@ -1688,8 +1910,9 @@ int siqs_static_init(static_conf_t *sconf, int is_tiny)
 	fact_obj_t *obj = sconf->obj;
 	uint32 i, memsize;
 	uint32 closnuf;
-	double sum, avg, sd;
+	double sum, avg, sd, var_all, var_rest;
 	int nump = 8;		// by default, ensure 8 contiguous primes.  AVX2 requires 16.
+	int use_64k;
 
 	if (VFLAG > 2)
 	{
@@ -1707,21 +1930,43 @@ int siqs_static_init(static_conf_t *sconf, int is_tiny)
 	sconf->small_limit = 256;
 	sconf->use_dlp = 0;
 
-	// sieve core functions
+	// sieve core functions.  64k blocks halve the number of blocks and
+	// bucket slices to process per polynomial, and measure faster than 32k 
+	// blocks once the L1 data cache is at least 48k, even though a block 
+	// then spills out of L1 a little.  -siqsBS overrides the choice.
+	if (obj->qs_obj.gbl_override_blocksize_flag)
+		use_64k = (obj->qs_obj.gbl_override_blocksize == 64);
+	else
+		use_64k = (obj->cache_size1 >= 49152);
+
 	switch (yafu_get_cpu_type())
 	{
-		// after the sse41 improvements, 64k versions ceased to work.
-		// I must have borked something inadvertently, and probably the fix is minor.
-		// however, right now I don't have the energy - so for now, everything will
-		// use the 32k sieve.  It is a lot easier to optimize for anyway, since we don't
-		// have to worry about 16 bit overflow as much.  Which is probably why
-		// the 64k versions no longer work - I've only done the latest assembly
-		// optimizations for 32k.
-
 	//case cpu_core:
 	default:
-		firstRoots_ptr = &firstRoots_32k;
-		nextRoots_ptr = &nextRoots_32k;
+#if !defined(TARGET_MIC)
+		if (use_64k)
+		{
+			sconf->firstRoots_ptr = &firstRoots_64k;
+			sconf->nextRoots_ptr = &nextRoots_64k;
+
+#if defined(USE_SSE41)
+			if (HAS_SSE41)
+				sconf->nextRoots_ptr = &nextRoots_64k_sse41;
+#endif
+
+			sconf->testRoots_ptr = &testfirstRoots_64k;
+			sconf->med_sieve_ptr = &med_sieveblock_64k;
+			sconf->tdiv_med_ptr = &tdiv_medprimes_64k;
+			sconf->resieve_med_ptr = &resieve_medprimes_64k;
+
+			sconf->qs_blocksize = 65536;
+			sconf->qs_blockbits = 16;
+			break;
+		}
+#endif
+
+		sconf->firstRoots_ptr = &firstRoots_32k;
+		sconf->nextRoots_ptr = &nextRoots_32k;
 
 		// if the yafu library was both compiled with SSE41 code (USE_SSE41), and the user's 
 		// machine has SSE41 instructions (HAS_SSE41), then proceed with 4.1.
@@ -1729,24 +1974,24 @@ int siqs_static_init(static_conf_t *sconf, int is_tiny)
 		if (HAS_AVX2)
 		{
 			printf("using avx2 with next_roots\n");
-			nextRoots_ptr = &nextRoots_32k_sse41;
-			//nextRoots_ptr = &nextRoots_32k_avx2;
+			sconf->nextRoots_ptr = &nextRoots_32k_sse41;
+			//sconf->nextRoots_ptr = &nextRoots_32k_avx2;
 		}
 		else if (HAS_SSE41)
 		{
 			printf("using sse4.1 with next_roots\n");
-			nextRoots_ptr = &nextRoots_32k_sse41;
+			sconf->nextRoots_ptr = &nextRoots_32k_sse41;
 		}
 
 #elif defined(USE_SSE41)
 		if (HAS_SSE41)
 		{
 			printf("using sse4.1 with med_sieve\n");
-			nextRoots_ptr = &nextRoots_32k_sse41;
+			sconf->nextRoots_ptr = &nextRoots_32k_sse41;
 		}
 #endif
 		
-		testRoots_ptr = &testfirstRoots_32k;
+		sconf->testRoots_ptr = &testfirstRoots_32k;
 
 		// if the yafu library was both compiled with AVX2 code (USE_AVX2), and the user's 
 		// machine has AVX2 instructions (HAS_AVX2), then proceed with AVX2.
@@ -1754,54 +1999,54 @@ int siqs_static_init(static_conf_t *sconf, int is_tiny)
 		if (HAS_AVX2)
 		{
 			printf("using avx2 with med_sieve\n");
-			med_sieve_ptr = &med_sieveblock_32k_avx2;
-			//med_sieve_ptr = &med_sieveblock_32k_sse41;
+			sconf->med_sieve_ptr = &med_sieveblock_32k_avx2;
+			//sconf->med_sieve_ptr = &med_sieveblock_32k_sse41;
 			nump = 16;
 		}
 		else if (HAS_SSE41)
 		{
 			printf("using sse4.1 with med_sieve\n");
-			med_sieve_ptr = &med_sieveblock_32k_sse41;
+			sconf->med_sieve_ptr = &med_sieveblock_32k_sse41;
 		}
 		else
 		{
 			printf("using sse2 with med_sieve\n");
-			med_sieve_ptr = &med_sieveblock_32k;
+			sconf->med_sieve_ptr = &med_sieveblock_32k;
 		}
 
 #elif defined(USE_SSE41)
 		if (HAS_SSE41)
 		{
 			printf("using sse4.1 with med_sieve\n");
-			med_sieve_ptr = &med_sieveblock_32k_sse41;
+			sconf->med_sieve_ptr = &med_sieveblock_32k_sse41;
 		}
 		else
 		{
 			printf("using sse2 with med_sieve\n");
-			med_sieve_ptr = &med_sieveblock_32k;
+			sconf->med_sieve_ptr = &med_sieveblock_32k;
 		}
 #else
 		printf("using sse2 with med_sieve\n");
-		med_sieve_ptr = &med_sieveblock_32k;
+		sconf->med_sieve_ptr = &med_sieveblock_32k;
 #endif
 
 #if defined(USE_AVX2)
 		if (HAS_AVX2)
 		{
 			printf("using avx2 with tdiv_medprimes\n");
-			tdiv_med_ptr = &tdiv_medprimes_32k_avx2;
-			resieve_med_ptr = &resieve_medprimes_32k_avx2;
+			sconf->tdiv_med_ptr = &tdiv_medprimes_32k_avx2;
+			sconf->resieve_med_ptr = &resieve_medprimes_32k_avx2;
 		}
 		else
 		{
 			printf("using sse2 with tdiv_medprimes\n");
-			tdiv_med_ptr = &tdiv_medprimes_32k;
-			resieve_med_ptr = &resieve_medprimes_32k;
+			sconf->tdiv_med_ptr = &tdiv_medprimes_32k;
+			sconf->resieve_med_ptr = &resieve_medprimes_32k;
 		}
 #else
 		printf("using sse2 with tdiv_medprimes\n");
-		tdiv_med_ptr = &tdiv_medprimes_32k;
-		resieve_med_ptr = &resieve_medprimes_32k;
+		sconf->tdiv_med_ptr = &tdiv_medprimes_32k;
+		sconf->resieve_med_ptr = &resieve_medprimes_32k;
 #endif
 
 		
@@ -1898,8 +2143,11 @@ int siqs_static_init(static_conf_t *sconf, int is_tiny)
 			printf("\tfactor base: %d bytes\n",memsize);
 		}
 
-		//find multiplier
-		sconf->multiplier = (uint32)choose_multiplier_siqs(sconf->factor_base->B, sconf->n);
+		//find multiplier, unless one was picked for us
+		if (sconf->forced_multiplier > 0)
+			sconf->multiplier = sconf->forced_multiplier;
+		else
+			sconf->multiplier = (uint32)choose_multiplier_siqs(sconf->factor_base->B, sconf->n);
 		mpz_mul_ui(sconf->n, sconf->n, sconf->multiplier);
 
 		//sconf holds n*mul, so update its digit count and number of bits
@@ -1978,6 +2226,9 @@ int siqs_static_init(static_conf_t *sconf, int is_tiny)
 	}
 	sconf->sieve_small_fb_start = i;
 
+	//the smallest of those are still sieved, by pattern
+	stripe_init(sconf);
+
 	for (; i < sconf->factor_base->B; i++)
 	{
 		//find the point at which factor base primes exceeds 10 bits.  
@@ -2157,24 +2408,24 @@ int siqs_static_init(static_conf_t *sconf, int is_tiny)
 	if (sconf->digits_n > 81 || sconf->obj->qs_obj.gbl_force_DLP)
 	{
 		sconf->use_dlp = 1;
-		scan_ptr = &check_relations_siqs_16;
+		sconf->scan_ptr = &check_relations_siqs_16;
 		sconf->scan_unrolling = 128;
 	}
 	else
 	{
 		if (sconf->digits_n < 30)
 		{
-			scan_ptr = &check_relations_siqs_1;
+			sconf->scan_ptr = &check_relations_siqs_1;
 			sconf->scan_unrolling = 8;
 		}
 		else if (sconf->digits_n < 60)
 		{
-			scan_ptr = &check_relations_siqs_4;
+			sconf->scan_ptr = &check_relations_siqs_4;
 			sconf->scan_unrolling = 32;
 		}
 		else
 		{
-			scan_ptr = &check_relations_siqs_8;
+			sconf->scan_ptr = &check_relations_siqs_8;
 			sconf->scan_unrolling = 64;
 		}
 		sconf->use_dlp = 0;
@@ -2191,6 +2442,9 @@ int siqs_static_init(static_conf_t *sconf, int is_tiny)
 		sconf->dlp_upper = spBits(sconf->large_prime_max2);
 	}
 
+	//and whether to test those residues in batches (which widens the range)
+	batch_init(sconf);
+
 	//'a' values should be as close as possible to sqrt(2n)/M in order to make
 	//values of g_{a,b}(x) as uniform as possible
 	mpz_mul_2exp(sconf->target_a, sconf->n, 1);
@@ -2235,6 +2489,7 @@ int siqs_static_init(static_conf_t *sconf, int is_tiny)
 	TF_SPECIAL = 0;
 	SIEVE_STG1 = 0;
 	SIEVE_STG2 = 0;
+	SIEVE_STG3 = 0;
 	POLY_STG0 = 0;
 	POLY_STG1 = 0;
 	POLY_STG2 = 0;
@@ -2247,7 +2502,7 @@ int siqs_static_init(static_conf_t *sconf, int is_tiny)
 	//contribution of all small primes we're skipping to a block's
 	//worth of sieving... compute the average per sieve location
 	sum = 0;
-	for (i = 2; i < sconf->sieve_small_fb_start; i++)
+	for (i = sconf->stripe_fb_end; i < sconf->sieve_small_fb_start; i++)
 	{
 		uint32 prime = sconf->factor_base->list->prime[i];
 
@@ -2260,6 +2515,22 @@ int siqs_static_init(static_conf_t *sconf, int is_tiny)
 	//one empirically determined fudge factor...
 	sd = sqrt(28);
 
+	//...which was measured with none of the small primes sieved.  scale
+	//it by the share of their variance that the striped primes don't cover
+	var_all = var_rest = 0;
+	for (i = 2; i < sconf->sieve_small_fb_start; i++)
+	{
+		double p = (double)sconf->factor_base->list->prime[i];
+		double logp = (double)sconf->factor_base->list->logprime[i];
+		double var = logp * logp * (2 / p) * (1 - 2 / p);
+
+		var_all += var;
+		if (i >= sconf->stripe_fb_end)
+			var_rest += var;
+	}
+	if (var_all > 0)
+		sd *= sqrt(var_rest / var_all);
+
 	//this appears to work fairly well... paper mentioned doing it this
 	//way... find out and reference here.
 	sconf->tf_small_cutoff = (uint8)(avg + 2.5*sd);
@@ -2291,11 +2562,17 @@ int siqs_static_init(static_conf_t *sconf, int is_tiny)
 	mpz_init(sconf->curr_poly->mpz_poly_b); //, sconf->bits);
 	mpz_init(sconf->curr_poly->mpz_poly_c); //, sconf->bits);
 	sconf->curr_poly->qlisort = (int *)malloc(MAX_A_FACTORS*sizeof(int));
-	sconf->curr_poly->gray = (char *) malloc( 65536 * sizeof(char));
-	sconf->curr_poly->nu = (char *) malloc( 65536 * sizeof(char));
+	sconf->curr_poly->gray = (char *) malloc( GRAY_CODE_ALLOC * sizeof(char));
+	sconf->curr_poly->nu = (char *) malloc( GRAY_CODE_ALLOC * sizeof(char));
 
 	//initialize a list of all poly_a values used 
 	sconf->poly_a_list = (mpz_t *)malloc(sizeof(mpz_t));
+	sconf->a_hash_table = NULL;
+	sconf->a_hash_alloc = 0;
+	sconf->a_hash_count = 0;
+	sconf->num_a_hashed = 0;
+	sconf->num_a_rejected = 0;
+	sconf->last_a_s = 0;
 
 	//compute how often to check our list of partial relations and update the gui.
 	sconf->check_inc = sconf->factor_base->B/10;
@@ -2308,6 +2585,7 @@ int siqs_static_init(static_conf_t *sconf, int is_tiny)
 	sconf->last_numpartial = 0;
 	sconf->last_numcycles = 0;
 	gettimeofday(&sconf->update_start, NULL);
+	sconf->checkpoint_start = sconf->update_start;
 	//sconf->update_start = clock();
 
 	sconf->failed_squfof = 0;
@@ -2330,6 +2608,9 @@ int siqs_static_init(static_conf_t *sconf, int is_tiny)
 	//no factors so far...
 	sconf->factor_list.num_factors = 0;
 
+	//read-only sieving data for all threads
+	siqs_share_fb(sconf);
+
 	return 0;
 }
 
@@ -2362,8 +2643,11 @@ int update_check(static_conf_t *sconf)
 	if (num_full >= check_total || t_update > update_time)
 	{
 		//watch for an abort
-		if (SIQS_ABORT)
+		if (fobj_aborted(sconf->obj))
 		{
+			//save what we have so the job can be resumed quickly
+			siqs_write_checkpoint(sconf);
+
 			//for fun, compute the total number of locations sieved over
 			mpz_set_ui(tmp1, sconf->tot_poly);					//total number of polys
 			mpz_mul_ui(tmp1, tmp1, sconf->num_blocks);	//number of blocks
@@ -2458,6 +2742,14 @@ int update_check(static_conf_t *sconf)
 
 		gettimeofday(&sconf->update_start, NULL);
 		sconf->t_update = 0;
+
+		//periodically snapshot the cycle graph so that a restart
+		//does not need to replay the whole savefile
+		difference = my_difftime (&sconf->checkpoint_start, &update_stop);
+		if (((double)difference->secs + (double)difference->usecs / 1000000) > 
+			QS_CHECKPOINT_INTERVAL)
+			siqs_write_checkpoint(sconf);
+		free(difference);
 		
 		if (sconf->num_r >= fb->B + sconf->num_extra_relations) 
 		{
@@ -2526,6 +2818,9 @@ int update_final(static_conf_t *sconf)
 				printf("squfof: %u failures, %u attempts, %u outside range, %u prp, %u useful\n", 
 					sconf->failed_squfof, sconf->attempted_squfof, 
 					sconf->dlp_outside_range, sconf->dlp_prp, sconf->dlp_useful);
+			if (sconf->batch_size > 0)
+				printf("batch dlp test: %u residues tested, %u smooth\n",
+					sconf->batch_tested, sconf->batch_smooth);
 		}
 		else
 			printf("\n\n");
@@ -2537,17 +2832,20 @@ int update_final(static_conf_t *sconf)
 				logprint(sieve_log, "squfof: %u failures, %u attempts, %u outside range, %u prp, %u useful\n", 
 					sconf->failed_squfof, sconf->attempted_squfof, 
 					sconf->dlp_outside_range, sconf->dlp_prp, sconf->dlp_useful);
+		if (sconf->batch_size > 0)
+			logprint(sieve_log, "batch dlp test: %u residues tested, %u smooth\n",
+				sconf->batch_tested, sconf->batch_smooth);
 
 #ifdef QS_TIMING
 
 		printf("sieve time = %6.4f, relation time = %6.4f, poly_time = %6.4f\n",
-			SIEVE_STG1+SIEVE_STG2,
+			SIEVE_STG1+SIEVE_STG2+SIEVE_STG3,
 			TF_STG1+TF_STG2+TF_STG3+TF_STG4+TF_STG5+TF_STG6,
 			POLY_STG0+POLY_STG1+POLY_STG2+POLY_STG3+POLY_STG4);
 
 		if (sieve_log != NULL)
 			logprint(sieve_log,"sieve time = %6.4f, relation time = %6.4f, poly_time = %6.4f\n",
-				SIEVE_STG1+SIEVE_STG2,
+				SIEVE_STG1+SIEVE_STG2+SIEVE_STG3,
 				TF_STG1+TF_STG2+TF_STG3+TF_STG4+TF_STG5+TF_STG6,
 				POLY_STG0+POLY_STG1+POLY_STG2+POLY_STG3+POLY_STG4);
 
@@ -2564,6 +2862,7 @@ int update_final(static_conf_t *sconf)
 		printf("timing for poly sieve large primes = %1.3f\n",POLY_STG4);
 		printf("timing for sieving small/medium primes = %1.3f\n",SIEVE_STG1);
 		printf("timing for sieving large primes = %1.3f\n",SIEVE_STG2);
+		printf("timing for small prime pattern sieving = %1.3f\n",SIEVE_STG3);
 
 		if (sieve_log != NULL)
 		{
@@ -2579,6 +2878,7 @@ int update_final(static_conf_t *sconf)
 			logprint(sieve_log,"timing for poly sieve large primes = %1.3f\n",POLY_STG4);
 			logprint(sieve_log,"timing for sieving small/medium primes = %1.3f\n",SIEVE_STG1);
 			logprint(sieve_log,"timing for sieving large primes = %1.3f\n",SIEVE_STG2);
+			logprint(sieve_log,"timing for small prime pattern sieving = %1.3f\n",SIEVE_STG3);
 		}
 		
 		
@@ -2628,38 +2928,22 @@ int free_sieve(dynamic_conf_t *dconf)
 {
 	uint32 i;
 
-	//can free sieving structures now
-	align_free(dconf->sieve);
-	align_free(dconf->fb_sieve_p);
-	align_free(dconf->fb_sieve_n);
-
-	align_free(dconf->comp_sieve_p->prime);
-	align_free(dconf->comp_sieve_p->root1);
-	align_free(dconf->comp_sieve_p->root2);
-	align_free(dconf->comp_sieve_p->logp);
-	align_free(dconf->comp_sieve_n->prime);
-	align_free(dconf->comp_sieve_n->root1);
-	align_free(dconf->comp_sieve_n->root2);
-	align_free(dconf->comp_sieve_n->logp);
+	//can free sieving structures now.  the sieve, roots and
+	//bucket lists all live in the arena.  the logps belong to 
+	//the static conf.
+	arena_free(&dconf->arena);
 	free(dconf->comp_sieve_p);
 	free(dconf->comp_sieve_n);
 
 	align_free(dconf->rootupdates);
 	align_free(dconf->sm_rootupdates);
-
-	align_free(dconf->update_data.sm_firstroots1);
-	align_free(dconf->update_data.sm_firstroots2);
-	align_free(dconf->update_data.firstroots1);
-	align_free(dconf->update_data.firstroots2);
-	align_free(dconf->update_data.prime);
-	align_free(dconf->update_data.logp);
+	free(dconf->batch_q);
+	free(dconf->batch_id);
 
 	if (dconf->buckets->list != NULL)
 	{
-		align_free(dconf->buckets->list);
 		free(dconf->buckets->fb_bounds);
 		free(dconf->buckets->logp);
-		align_free(dconf->buckets->num);
 		free(dconf->buckets);
 	}
 	else
@@ -2688,7 +2972,7 @@ int free_sieve(dynamic_conf_t *dconf)
 	//free sieve scan report stuff
 	free(dconf->reports);
 #ifdef USE_YAFU_TDIV
-	for (i=0; i<MAX_SIEVE_REPORTS; i++)
+	for (i=0; i<dconf->report_alloc; i++)
 		zFree32(&dconf->Qvals32[i]);
 	free(dconf->Qvals32);
 #endif
@@ -2699,7 +2983,7 @@ int free_sieve(dynamic_conf_t *dconf)
 	// by neglecting to free these, but I can't debug the cause of the crash and this
 	// fix works.  note: it starts working once the input becomes large enough to use
 	// bucket sieving... clue for debug...
-	for (i=0; i<MAX_SIEVE_REPORTS; i++)
+	for (i=0; i<dconf->report_alloc; i++)
 	{
 		//printf("freeing Qval %d\n", i); fflush(stdout);
 		mpz_clear(dconf->Qvals[i]);
@@ -2707,6 +2991,7 @@ int free_sieve(dynamic_conf_t *dconf)
 	free(dconf->Qvals);	
 	free(dconf->valid_Qs);
 	free(dconf->smooth_num);
+	free(dconf->fb_offsets);
 
 	align_free(dconf->bl_locs);
 	align_free(dconf->bl_sizes);
@@ -2770,6 +3055,15 @@ int free_siqs(static_conf_t *sconf)
 {
 	uint32 i;
 
+	//fingerprints of the 'a' values used while sieving
+	free(sconf->a_hash_table);
+	free(sconf->stripes);
+
+	//sieving data shared by the threads
+	align_free(sconf->sieve_logp);
+	align_free(sconf->update_logp);
+	batch_free(sconf);
+
 	//current poly info used during filtering
 	free(sconf->curr_poly->gray);
 	free(sconf->curr_poly->nu);
@@ -2824,13 +3118,10 @@ int free_siqs(static_conf_t *sconf)
 	return 0;
 }
 
-uint8 choose_multiplier_siqs(uint32 B, mpz_t n) 
+static uint32 score_multipliers_siqs(uint32 B, mpz_t n, double *scores) 
 {
 	uint32 i, j;
 	uint32 num_primes = MIN(2 * B, NUM_TEST_PRIMES);
-	double best_score;
-	uint8 best_mult;
-	double scores[NUM_MULTIPLIERS];
 	uint32 num_multipliers;
 	double log2n = zlog(n);
 
@@ -2911,6 +3202,19 @@ uint8 choose_multiplier_siqs(uint32 B, mpz_t n)
 
 	}
 
+	return num_multipliers;
+}
+
+uint8 choose_multiplier_siqs(uint32 B, mpz_t n) 
+{
+	uint32 i;
+	double best_score;
+	uint8 best_mult;
+	double scores[NUM_MULTIPLIERS];
+	uint32 num_multipliers;
+
+	num_multipliers = score_multipliers_siqs(B, n, scores);
+
 	/* use the multiplier that generates the best score */
 
 	best_score = 1000.0;
@@ -2925,3 +3229,175 @@ uint8 choose_multiplier_siqs(uint32 B, mpz_t n)
 	return best_mult;
 }
 
+uint32 rank_multipliers_siqs(uint32 B, mpz_t n, uint8 *mults, uint32 max_mults)
+{
+	/* fill mults[] with up to max_mults multipliers in order
+	   of increasing (better) score, and return how many */
+
+	uint32 i, j, best;
+	double scores[NUM_MULTIPLIERS];
+	uint8 used[NUM_MULTIPLIERS];
+	uint32 num_multipliers;
+
+	num_multipliers = score_multipliers_siqs(B, n, scores);
+	memset(used, 0, sizeof(used));
+
+	for (j = 0; j < max_mults && j < num_multipliers; j++) {
+		best = num_multipliers;
+		for (i = 0; i < num_multipliers; i++) {
+			if (used[i])
+				continue;
+			if (best == num_multipliers || scores[i] < scores[best])
+				best = i;
+		}
+		used[best] = 1;
+		mults[j] = mult_list[best];
+	}
+	return j;
+}
+
+uint32 siqs_test_multipliers(fact_obj_t *fobj, uint32 num_test)
+{
+	//the Knuth-Schroeppel score is only a model of how well each 
+	//multiplier sieves.  when asked to, take the best few candidates
+	//by that score, set each one up for real and sieve a fixed number 
+	//of B-polys with it, then return the one that found relations 
+	//fastest.  relations found here stay in the sieving buffers and 
+	//are thrown away, so nothing touches the savefile.  returns 0
+	//if no choice was made.
+	static_conf_t *sconf;
+	dynamic_conf_t *dconf;
+	thread_sievedata_t tdata;
+	uint8 mults[QS_MAX_MULT_TEST];
+	uint32 i, j, num_mults, num_rels, num_polys, num_a;
+	uint32 num_factors, *factor_counts;
+	uint32 best_mult = 0;
+	double t_time, rate, best_rate = 0.0;
+	struct timeval start, stop;
+	TIME_DIFF *	difference;
+	int found;
+
+	if (num_test > QS_MAX_MULT_TEST)
+		num_test = QS_MAX_MULT_TEST;
+
+	num_mults = rank_multipliers_siqs(NUM_TEST_PRIMES, 
+		fobj->qs_obj.gmp_n, mults, num_test);
+	if (num_mults < 2)
+		return 0;
+
+	//building a factor base adds any factor of the input it trips
+	//over to the global list.  the real setup will find it again, 
+	//so remember the list as it is now in order to undo that.
+	num_factors = fobj->num_factors;
+	factor_counts = (uint32 *)malloc((num_factors + 1) * sizeof(uint32));
+	for (i = 0; i < num_factors; i++)
+		factor_counts[i] = fobj->fobj_factors[i].count;
+
+	if (VFLAG > 0)
+		printf("test sieving %u multipliers\n", num_mults);
+
+	for (i = 0; i < num_mults; i++)
+	{
+		sconf = (static_conf_t *)malloc(sizeof(static_conf_t));
+		sconf->obj = fobj;
+		sconf->scan_ptr = NULL;
+		sconf->forced_multiplier = mults[i];
+		gettimeofday(&sconf->totaltime_start, NULL);
+		siqs_static_init(sconf, 0);
+		sconf->in_mem = 0;
+
+		found = (fobj->num_factors != num_factors);
+		for (j = 0; j < num_factors; j++)
+		{
+			if (fobj->fobj_factors[j].count != factor_counts[j])
+				found = 1;
+		}
+
+		num_a = 0;
+		if (!found)
+		{
+			dconf = (dynamic_conf_t *)malloc(sizeof(dynamic_conf_t));
+			siqs_dynamic_init(dconf, sconf);
+			tdata.sconf = sconf;
+			tdata.dconf = dconf;
+			tdata.tindex = 0;
+
+			sconf->total_poly_a = -1;
+			num_rels = num_polys = 0;
+			gettimeofday(&start, NULL);
+			while (num_polys < QS_MULT_TEST_BPOLYS)
+			{
+				sconf->total_poly_a++;
+				new_poly_a(sconf, dconf);
+				process_poly(&tdata);
+
+				num_polys += dconf->tot_poly;
+				num_rels += dconf->buffered_rels;
+				for (j=0; j<dconf->buffered_rels; j++)
+					free(dconf->relation_buf[j].fb_offsets);
+				dconf->num = 0;
+				dconf->tot_poly = 0;
+				dconf->buffered_rels = 0;
+				dconf->num_batch = 0;
+				dconf->attempted_squfof = 0;
+				dconf->failed_squfof = 0;
+				dconf->dlp_outside_range = 0;
+				dconf->dlp_prp = 0;
+				dconf->dlp_useful = 0;
+			}
+			gettimeofday(&stop, NULL);
+			difference = my_difftime(&start, &stop);
+			t_time = ((double)difference->secs + (double)difference->usecs / 1000000);
+			free(difference);
+			num_a = sconf->total_poly_a + 1;
+
+			rate = (double)num_rels / t_time;
+			if (VFLAG > 0)
+				printf("multiplier %u: %u rels from %u polys in %1.2f sec "
+					"(%1.2f rels/sec)\n", mults[i], num_rels, num_polys, 
+					t_time, rate);
+
+			if (rate > best_rate)
+			{
+				best_rate = rate;
+				best_mult = mults[i];
+			}
+
+			free_sieve(dconf);
+			free(dconf->relation_buf);
+			free(dconf);
+		}
+
+		for (j = 0; j < num_a; j++)
+			mpz_clear(sconf->poly_a_list[j]);
+		free(sconf->poly_a_list);
+		free(sconf->cycle_hashtable);
+		free(sconf->cycle_table);
+		free_siqs(sconf);
+		free(sconf);
+
+		if (found)
+		{
+			//let the real setup deal with the factor
+			while (fobj->num_factors > num_factors)
+			{
+				fobj->num_factors--;
+				mpz_clear(fobj->fobj_factors[fobj->num_factors].factor);
+			}
+			for (j = 0; j < num_factors; j++)
+				fobj->fobj_factors[j].count = factor_counts[j];
+			best_mult = 0;
+			break;
+		}
+	}
+
+	free(factor_counts);
+
+	if ((VFLAG > 0) && (best_mult > 0))
+		printf("test sieving selected multiplier %u\n", best_mult);
+	if ((fobj->logfile != NULL) && (best_mult > 0))
+		logprint(fobj->logfile, "test sieving selected multiplier %u\n", best_mult);
+
+	return best_mult;
+}
+
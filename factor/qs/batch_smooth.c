@@ -0,0 +1,353 @@
+/*----------------------------------------------------------------------
+This source distribution is placed in the public domain by its author,
+Ben Buhrow. You may use it for any purpose, free of charge,
+without having to notify anyone. I disclaim any responsibility for any
+errors.
+
+Optionally, please be nice and tell me if you find this source to be
+useful. Again optionally, if you add to the functionality present here
+please consider making those additions public too, so that others may
+benefit from your work.
+
+Some parts of the code (and also this header), included in this
+distribution have been reused from other sources. In particular I
+have benefitted greatly from the work of Jason Papadopoulos's msieve @
+www.boo.net/~jasonp, Scott Contini's mpqs implementation, and Tom St.
+Denis Tom's Fast Math library.  Many thanks to their kind donation of
+code to the public domain.
+       				   --bbuhrow@gmail.com 11/24/09
+----------------------------------------------------------------------*/
+
+#include "yafu.h"
+#include "qs.h"
+#include "factor.h"
+#include "util.h"
+#include "soe.h"
+
+/*
+a dlp residue left over after trial division has no factors below pmax,
+the largest factor base prime, so it is only useful if it is the product
+of two primes below large_prime_max.  normally each one that isn't a
+probable prime is split with squfof as soon as it is found, and only
+those below large_prime_max^1.8 are tried at all, since squfof is mostly
+wasted on the bigger ones.
+
+with -siqsBT the residues are instead collected from every poly a the
+threads finish and tested together, as in Bernstein's batch smoothness
+test: with P the product of all primes between pmax and large_prime_max,
+a residue q is useful exactly when P mod q is 0.  P mod q for every q in
+a batch comes from one product tree over the residues and one remainder
+tree back down it, so the big reduction of P is paid for once per batch.
+only the residues that pass are split with squfof.  failures being
+cheap, residues all the way up to large_prime_max^2 are tested.
+
+a relation can only be saved once its residue has been tested, by which
+time the savefile has moved on to other poly a's, so the poly a of each
+group of relations is written again ahead of them.
+*/
+
+#define BATCH_LEAF 16
+
+static void batch_prime_product(mpz_t prod, uint64 *primes, uint32 lo, uint32 hi)
+{
+	//the product of primes[lo..hi), built as a tree so that the
+	//multiplies stay balanced.  the primes all fit in 32 bits.
+	mpz_t tmp;
+	uint32 i, mid;
+
+	if (hi - lo <= BATCH_LEAF)
+	{
+		mpz_set_ui(prod, 1);
+		for (i = lo; i < hi; i++)
+			mpz_mul_ui(prod, prod, (uint32)primes[i]);
+		return;
+	}
+
+	mid = lo + (hi - lo) / 2;
+	mpz_init(tmp);
+	batch_prime_product(prod, primes, lo, mid);
+	batch_prime_product(tmp, primes, mid, hi);
+	mpz_mul(prod, prod, tmp);
+	mpz_clear(tmp);
+	return;
+}
+
+void batch_init(static_conf_t *sconf)
+{
+	//set up for batch testing if it was asked for.  the product of
+	//primes is only built the first time a batch is tested, so that
+	//setups that never get that far (test sieving multipliers) don't
+	//pay for it.
+	sconf->batch_size = 0;
+	if (sconf->use_dlp)
+		sconf->batch_size = sconf->obj->qs_obj.batch_size;
+
+	sconf->batch_ready = 0;
+	sconf->batch_rels = NULL;
+	sconf->batch_q = NULL;
+	sconf->batch_group = NULL;
+	sconf->num_batch = 0;
+	sconf->batch_alloc = 0;
+	sconf->batch_a = NULL;
+	sconf->num_batch_a = 0;
+	sconf->batch_a_alloc = 0;
+	sconf->batch_tested = 0;
+	sconf->batch_smooth = 0;
+
+	if (sconf->batch_size == 0)
+		return;
+
+	//anything up to large_prime_max^2 can split usefully, but squfof
+	//only takes 62 bits
+	sconf->large_prime_max2 = (uint64)sconf->large_prime_max *
+		(uint64)sconf->large_prime_max;
+	if (sconf->large_prime_max2 >= (1ULL << 62))
+		sconf->large_prime_max2 = (1ULL << 62) - 1;
+	sconf->dlp_upper = spBits(sconf->large_prime_max2);
+
+	return;
+}
+
+static void batch_build(static_conf_t *sconf)
+{
+	uint64 *primes;
+	uint64 num_p;
+	struct timeval start, stop;
+	TIME_DIFF *	difference;
+	double t;
+
+	gettimeofday(&start, NULL);
+
+	primes = soe_wrapper(spSOEprimes, szSOEp, (uint64)sconf->pmax + 1,
+		(uint64)sconf->large_prime_max, 0, &num_p);
+	mpz_init(sconf->batch_prod);
+	batch_prime_product(sconf->batch_prod, primes, 0, (uint32)num_p);
+	free(primes);
+	sconf->batch_ready = 1;
+
+	gettimeofday(&stop, NULL);
+	difference = my_difftime(&start, &stop);
+	t = (double)difference->secs + (double)difference->usecs / 1000000;
+	free(difference);
+
+	if (VFLAG > 0)
+		printf("\nbatch dlp test: product of %u primes up to %u is %u bits, "
+			"built in %1.2f sec\n", (uint32)num_p, sconf->large_prime_max,
+			(uint32)mpz_sizeinbase(sconf->batch_prod, 2), t);
+	if (sconf->obj->logfile != NULL)
+		logprint(sconf->obj->logfile, "batch dlp test: product of %u primes "
+			"up to %u is %u bits, built in %1.2f sec\n", (uint32)num_p,
+			sconf->large_prime_max,
+			(uint32)mpz_sizeinbase(sconf->batch_prod, 2), t);
+
+	return;
+}
+
+void batch_add(static_conf_t *sconf, dynamic_conf_t *dconf)
+{
+	//take the relations of this thread's last poly a that are waiting
+	//on their residues.  they stay in relation_buf, but without
+	//factors, so that siqs_merge_data doesn't save them.
+	siqs_r *rel;
+	uint32 i;
+
+	if (dconf->num_batch == 0)
+		return;
+
+	if (sconf->num_batch + dconf->num_batch > sconf->batch_alloc)
+	{
+		sconf->batch_alloc = 2 * (sconf->num_batch + dconf->num_batch);
+		sconf->batch_rels = (siqs_r *)xrealloc(sconf->batch_rels,
+			sconf->batch_alloc * sizeof(siqs_r));
+		sconf->batch_q = (uint64 *)xrealloc(sconf->batch_q,
+			sconf->batch_alloc * sizeof(uint64));
+		sconf->batch_group = (uint32 *)xrealloc(sconf->batch_group,
+			sconf->batch_alloc * sizeof(uint32));
+	}
+
+	if (sconf->num_batch_a == sconf->batch_a_alloc)
+	{
+		sconf->batch_a_alloc = 2 * sconf->batch_a_alloc + 16;
+		sconf->batch_a = (mpz_t *)xrealloc(sconf->batch_a,
+			sconf->batch_a_alloc * sizeof(mpz_t));
+	}
+	mpz_init_set(sconf->batch_a[sconf->num_batch_a],
+		dconf->curr_poly->mpz_poly_a);
+
+	for (i = 0; i < dconf->num_batch; i++)
+	{
+		rel = dconf->relation_buf + dconf->batch_id[i];
+
+		sconf->batch_rels[sconf->num_batch] = *rel;
+		sconf->batch_q[sconf->num_batch] = dconf->batch_q[i];
+		sconf->batch_group[sconf->num_batch] = sconf->num_batch_a;
+		sconf->num_batch++;
+
+		//the factor list belongs to the waiting copy now
+		rel->fb_offsets = NULL;
+		rel->num_factors = 0;
+	}
+
+	sconf->num_batch_a++;
+	dconf->num_batch = 0;
+	return;
+}
+
+void batch_test(static_conf_t *sconf)
+{
+	//test every waiting residue and save the relations that come
+	//good.  the product tree over the residues is kept level by
+	//level, and the remainders overwrite it on the way back down
+	//so that in the end each leaf holds P mod its residue.
+	mpz_t *tree[32];
+	uint32 size[32];
+	uint32 levels, i, j, n = sconf->num_batch;
+	int last_group = -1;
+	uint32 num_smooth = 0, num_useful = 0;
+	fact_obj_t *obj = sconf->obj;
+	struct timeval start, stop;
+	TIME_DIFF *	difference;
+	double t;
+	char buf[1024];
+	mpz_t tmp;
+
+	if (n == 0)
+		return;
+
+	if (!sconf->batch_ready)
+		batch_build(sconf);
+
+	gettimeofday(&start, NULL);
+
+	tree[0] = (mpz_t *)xmalloc(n * sizeof(mpz_t));
+	size[0] = n;
+	for (i = 0; i < n; i++)
+	{
+		mpz_init(tree[0][i]);
+		mpz_set_64(tree[0][i], sconf->batch_q[i]);
+	}
+
+	for (levels = 1; size[levels - 1] > 1; levels++)
+	{
+		size[levels] = (size[levels - 1] + 1) / 2;
+		tree[levels] = (mpz_t *)xmalloc(size[levels] * sizeof(mpz_t));
+		for (j = 0; j < size[levels]; j++)
+		{
+			mpz_init(tree[levels][j]);
+			if (2 * j + 1 < size[levels - 1])
+				mpz_mul(tree[levels][j], tree[levels - 1][2 * j],
+					tree[levels - 1][2 * j + 1]);
+			else
+				mpz_set(tree[levels][j], tree[levels - 1][2 * j]);
+		}
+	}
+
+	mpz_tdiv_r(tree[levels - 1][0], sconf->batch_prod, tree[levels - 1][0]);
+	for (i = levels - 1; i > 0; i--)
+	{
+		for (j = 0; j < size[i - 1]; j++)
+			mpz_tdiv_r(tree[i - 1][j], tree[i][j / 2], tree[i - 1][j]);
+	}
+
+	mpz_init(tmp);
+	for (i = 0; i < n; i++)
+	{
+		siqs_r *rel = sconf->batch_rels + i;
+		uint64 q64 = sconf->batch_q[i];
+		uint64 f64;
+
+		if (mpz_sgn(tree[0][i]) != 0)
+			continue;
+
+		//every prime factor is below large_prime_max, and there are
+		//two of them since the residue is bigger than pmax^2 and isn't
+		//a probable prime
+		num_smooth++;
+		sconf->attempted_squfof++;
+		mpz_set_64(tmp, q64);
+		f64 = sp_shanks_loop(tmp, obj);
+		if ((f64 <= 1) || (f64 == q64) || ((q64 % f64) != 0))
+		{
+			sconf->failed_squfof++;
+			continue;
+		}
+
+		rel->large_prime[0] = (uint32)f64;
+		rel->large_prime[1] = (uint32)(q64 / f64);
+		if (rel->large_prime[0] == rel->large_prime[1])
+			continue;
+
+		num_useful++;
+		sconf->dlp_useful++;
+
+		//the poly a goes ahead of the first relation saved from it
+		if ((int)sconf->batch_group[i] != last_group)
+		{
+			last_group = sconf->batch_group[i];
+			if (!sconf->in_mem)
+			{
+				gmp_sprintf(buf,"A 0x%Zx\n", sconf->batch_a[last_group]);
+				qs_savefile_write_line(&obj->qs_obj.savefile,buf);
+			}
+		}
+
+		save_relation_siqs(rel->sieve_offset, rel->large_prime,
+			rel->num_factors, rel->fb_offsets, rel->poly_idx,
+			rel->parity, sconf);
+	}
+	mpz_clear(tmp);
+
+	for (i = 0; i < levels; i++)
+	{
+		for (j = 0; j < size[i]; j++)
+			mpz_clear(tree[i][j]);
+		free(tree[i]);
+	}
+
+	for (i = 0; i < n; i++)
+		free(sconf->batch_rels[i].fb_offsets);
+	for (i = 0; i < sconf->num_batch_a; i++)
+		mpz_clear(sconf->batch_a[i]);
+	sconf->num_batch = 0;
+	sconf->num_batch_a = 0;
+	sconf->batch_tested += n;
+	sconf->batch_smooth += num_smooth;
+
+	sconf->num_r = sconf->num_relations +
+		sconf->num_cycles +
+		sconf->components - sconf->vertices;
+
+	gettimeofday(&stop, NULL);
+	difference = my_difftime(&start, &stop);
+	t = (double)difference->secs + (double)difference->usecs / 1000000;
+	free(difference);
+
+	if (VFLAG > 1)
+		printf("\nbatch dlp test: %u residues, %u smooth, %u useful "
+			"in %1.2f sec\n", n, num_smooth, num_useful, t);
+
+	return;
+}
+
+void batch_free(static_conf_t *sconf)
+{
+	uint32 i;
+
+	for (i = 0; i < sconf->num_batch; i++)
+		free(sconf->batch_rels[i].fb_offsets);
+	for (i = 0; i < sconf->num_batch_a; i++)
+		mpz_clear(sconf->batch_a[i]);
+
+	free(sconf->batch_rels);
+	free(sconf->batch_q);
+	free(sconf->batch_group);
+	free(sconf->batch_a);
+
+	if (sconf->batch_ready)
+		mpz_clear(sconf->batch_prod);
+
+	sconf->num_batch = 0;
+	sconf->num_batch_a = 0;
+	sconf->batch_ready = 0;
+	return;
+}
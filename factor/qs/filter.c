@@ -310,18 +310,289 @@ int process_rel(char *substr, fb_list *fb, mpz_t n,
 	return err_code;	//error code, if there is one.
 }
 
+#define QS_HASH_MULT ((uint32)(2654435761UL))
+#define QS_HASH(a) (((a) * QS_HASH_MULT) >> (32 - QS_LOG2_CYCLE_HASH))
+
+/**********************************************************
+Restart checkpoints.  Replaying a large savefile on restart
+means re-reading every relation just to rebuild the cycle
+graph and the relation counts.  Periodically we instead dump
+that state, together with the list of poly A values used so
+far and the savefile length at which it was valid, to
+<savefile>.chk.  On restart the snapshot is loaded and only
+the part of the savefile written after it is replayed.
+The checkpoint is a native-endian binary file meant to be
+read back on the machine that wrote it.
+**********************************************************/
+#define QS_CHECKPOINT_MAGIC 0x4b434853
+#define QS_CHECKPOINT_VERSION 1
+
+enum {
+	CHK_MAGIC = 0,
+	CHK_VERSION,
+	CHK_USE_DLP,
+	CHK_PMAX,
+	CHK_NUM_RELATIONS,
+	CHK_NUM_CYCLES,
+	CHK_COMPONENTS,
+	CHK_VERTICES,
+	CHK_NUM_DISCARDED,
+	CHK_TABLE_SIZE,
+	CHK_NUM_POLY_A,
+	CHK_HDR_WORDS
+};
+
+#if defined(WIN32) || defined(_WIN64)
+#define qs_fseek _fseeki64
+#define qs_ftell _ftelli64
+#else
+#define qs_fseek fseeko
+#define qs_ftell ftello
+#endif
+
+static void get_checkpoint_name(static_conf_t *sconf, char *name)
+{
+	sprintf(name, "%s.chk", sconf->obj->qs_obj.siqs_savefile);
+}
+
+void siqs_write_checkpoint(static_conf_t *sconf)
+{
+	fact_obj_t *obj = sconf->obj;
+	char name[1040], tmpname[1048];
+	uint32 hdr[CHK_HDR_WORDS];
+	uint32 num_a, i, ok;
+	uint64 offset;
+	FILE *out;
+
+	if (sconf->in_mem)
+		return;
+
+	// the snapshot is only valid for relations that have made it
+	// to disk, so push out anything still buffered first and 
+	// record where the savefile ends.
+	qs_savefile_flush(&obj->qs_obj.savefile);
+	out = fopen(obj->qs_obj.siqs_savefile, "rb");
+	if (out == NULL)
+		return;
+	qs_fseek(out, 0, SEEK_END);
+	offset = (uint64)qs_ftell(out);
+	fclose(out);
+
+	get_checkpoint_name(sconf, name);
+	sprintf(tmpname, "%s.tmp", name);
+	out = fopen(tmpname, "wb");
+	if (out == NULL)
+	{
+		if (VFLAG > 0)
+			printf("could not open %s for writing\n", tmpname);
+		return;
+	}
+
+	// while sieving, the poly_a_list holds total_poly_a + 1 entries
+	// (total_poly_a starts at -1 and is bumped before each new A)
+	num_a = sconf->total_poly_a + 1;
+
+	hdr[CHK_MAGIC] = QS_CHECKPOINT_MAGIC;
+	hdr[CHK_VERSION] = QS_CHECKPOINT_VERSION;
+	hdr[CHK_USE_DLP] = sconf->use_dlp;
+	hdr[CHK_PMAX] = sconf->large_prime_max / sconf->large_mult;
+	hdr[CHK_NUM_RELATIONS] = sconf->num_relations;
+	hdr[CHK_NUM_CYCLES] = sconf->num_cycles;
+	hdr[CHK_COMPONENTS] = sconf->components;
+	hdr[CHK_VERTICES] = sconf->vertices;
+	hdr[CHK_NUM_DISCARDED] = sconf->num_discarded;
+	hdr[CHK_TABLE_SIZE] = sconf->cycle_table_size;
+	hdr[CHK_NUM_POLY_A] = num_a;
+
+	ok = (fwrite(hdr, sizeof(uint32), CHK_HDR_WORDS, out) == CHK_HDR_WORDS);
+	ok = ok && (fwrite(&offset, sizeof(uint64), 1, out) == 1);
+	ok = ok && (mpz_out_raw(out, obj->qs_obj.gmp_n) > 0);
+
+	// the hashtable is not saved: it is a pure index into the
+	// cycle table and is rebuilt from the table entries on load
+	ok = ok && (fwrite(sconf->cycle_table, sizeof(qs_cycle_t), 
+		sconf->cycle_table_size, out) == sconf->cycle_table_size);
+
+	for (i = 0; ok && (i < num_a); i++)
+		ok = (mpz_out_raw(out, sconf->poly_a_list[i]) > 0);
+
+	// trailing magic lets the loader reject truncated files
+	ok = ok && (fwrite(hdr, sizeof(uint32), 1, out) == 1);
+	ok = (fclose(out) == 0) && ok;
+
+	if (ok)
+	{
+		remove(name);
+		ok = (rename(tmpname, name) == 0);
+	}
+
+	if (!ok)
+	{
+		remove(tmpname);
+		if (VFLAG > 0)
+			printf("failed to write siqs checkpoint %s\n", name);
+	}
+
+	gettimeofday(&sconf->checkpoint_start, NULL);
+	return;
+}
+
+void siqs_remove_checkpoint(static_conf_t *sconf)
+{
+	char name[1040];
+
+	get_checkpoint_name(sconf, name);
+	remove(name);
+	return;
+}
+
+static int siqs_load_checkpoint(static_conf_t *sconf, FILE *data)
+{
+	// try to restore the cycle graph, relation counts and poly A list
+	// from a checkpoint.  on success, 'data' is left positioned
+	// at the first savefile byte not covered by the checkpoint and
+	// 1 is returned.  sconf is not modified unless the whole
+	// checkpoint checks out.
+	char name[1040];
+	uint32 hdr[CHK_HDR_WORDS];
+	uint32 pmax = sconf->large_prime_max / sconf->large_mult;
+	uint32 i, num_a = 0, table_alloc, trailer, ok;
+	qs_cycle_t *table = NULL;
+	mpz_t *alist = NULL;
+	mpz_t n;
+	uint64 offset;
+	FILE *in;
+
+	get_checkpoint_name(sconf, name);
+	in = fopen(name, "rb");
+	if (in == NULL)
+		return 0;
+
+	mpz_init(n);
+	ok = (fread(hdr, sizeof(uint32), CHK_HDR_WORDS, in) == CHK_HDR_WORDS);
+	ok = ok && (hdr[CHK_MAGIC] == QS_CHECKPOINT_MAGIC);
+	ok = ok && (hdr[CHK_VERSION] == QS_CHECKPOINT_VERSION);
+	ok = ok && (fread(&offset, sizeof(uint64), 1, in) == 1);
+	ok = ok && (mpz_inp_raw(n, in) > 0);
+
+	// the snapshot has to belong to this input and to have been
+	// made with the same large prime rules, otherwise the counts
+	// it holds do not match what a replay would produce
+	ok = ok && (mpz_cmp(n, sconf->obj->qs_obj.gmp_n) == 0);
+	ok = ok && (hdr[CHK_USE_DLP] == (uint32)sconf->use_dlp);
+	ok = ok && (hdr[CHK_PMAX] == pmax);
+	ok = ok && (hdr[CHK_TABLE_SIZE] >= 1);
+
+	// and the savefile has to still hold everything the snapshot
+	// accounts for, ending on a line boundary at that point.
+	ok = ok && (offset > 0);
+	ok = ok && (qs_fseek(data, (int64)offset - 1, SEEK_SET) == 0);
+	ok = ok && (fgetc(data) == '\n');
+
+	if (ok)
+	{
+		table_alloc = sconf->cycle_table_alloc;
+		while (hdr[CHK_TABLE_SIZE] + 2 >= table_alloc)
+			table_alloc *= 2;
+		table = (qs_cycle_t *)xmalloc(table_alloc * sizeof(qs_cycle_t));
+		ok = (fread(table, sizeof(qs_cycle_t), hdr[CHK_TABLE_SIZE], in) == 
+			hdr[CHK_TABLE_SIZE]);
+	}
+
+	if (ok)
+	{
+		alist = (mpz_t *)xmalloc((hdr[CHK_NUM_POLY_A] + 1) * sizeof(mpz_t));
+		for (num_a = 0; num_a < hdr[CHK_NUM_POLY_A]; num_a++)
+		{
+			mpz_init(alist[num_a]);
+			if (mpz_inp_raw(alist[num_a], in) == 0)
+			{
+				num_a++;
+				ok = 0;
+				break;
+			}
+		}
+		ok = ok && (fread(&trailer, sizeof(uint32), 1, in) == 1);
+		ok = ok && (trailer == QS_CHECKPOINT_MAGIC);
+	}
+
+	fclose(in);
+	mpz_clear(n);
+
+	if (!ok)
+	{
+		for (i = 0; i < num_a; i++)
+			mpz_clear(alist[i]);
+		free(alist);
+		free(table);
+		return 0;
+	}
+
+	// install the snapshot
+	free(sconf->cycle_table);
+	sconf->cycle_table = table;
+	sconf->cycle_table_alloc = table_alloc;
+	sconf->cycle_table_size = hdr[CHK_TABLE_SIZE];
+	sconf->num_relations = hdr[CHK_NUM_RELATIONS];
+	sconf->num_cycles = hdr[CHK_NUM_CYCLES];
+	sconf->components = hdr[CHK_COMPONENTS];
+	sconf->vertices = hdr[CHK_VERTICES];
+	sconf->num_discarded = hdr[CHK_NUM_DISCARDED];
+
+	// rebuild the hashtable chains.  the chain order may differ 
+	// from the one the sieving run had, but every prime still has
+	// exactly one entry so lookups are unaffected.
+	memset(sconf->cycle_hashtable, 0, 
+		(size_t)(1 << QS_LOG2_CYCLE_HASH) * sizeof(uint32));
+	for (i = 1; i < sconf->cycle_table_size; i++)
+	{
+		uint32 h = QS_HASH(table[i].prime);
+		table[i].next = sconf->cycle_hashtable[h];
+		sconf->cycle_hashtable[h] = i;
+	}
+
+	for (i = 0; i < sconf->total_poly_a; i++)
+		mpz_clear(sconf->poly_a_list[i]);
+	free(sconf->poly_a_list);
+	sconf->poly_a_list = alist;
+	sconf->total_poly_a = num_a;
+
+	if (VFLAG > 1)
+		printf("loaded checkpoint %s: %u vertices, %u poly A values, "
+			"%" PRIu64 " savefile bytes\n", 
+			name, sconf->cycle_table_size - 1, num_a, offset);
+
+	return 1;
+}
+
+static void restart_add_poly_a(static_conf_t *sconf, char *substr, uint32 *alloc)
+{
+	// remember an A value found in the savefile so that new_poly_a 
+	// does not pick it again after the restart.
+	if (sconf->total_poly_a + 1 >= *alloc)
+	{
+		*alloc = 2 * (sconf->total_poly_a + 1);
+		sconf->poly_a_list = (mpz_t *)xrealloc(sconf->poly_a_list,
+			*alloc * sizeof(mpz_t));
+	}
+	mpz_init(sconf->poly_a_list[sconf->total_poly_a]);
+	mpz_set_str(sconf->poly_a_list[sconf->total_poly_a], substr, 0);
+	sconf->total_poly_a++;
+	return;
+}
+
 int restart_siqs(static_conf_t *sconf, dynamic_conf_t *dconf)
 {
-	int i,j;
 	char *str, *substr;
 	FILE *data;
 	uint32 lp[2],pmax = sconf->large_prime_max / sconf->large_mult;
+	uint32 alloc;
+	int64 body_start;
 	//fact_obj_t *obj = sconf->obj;
 
 	str = (char *)malloc(GSTR_MAXSIZE*sizeof(char));
 	data = fopen(sconf->obj->qs_obj.siqs_savefile,"r");
-	i=0;
-	j=0;
+	sconf->num_discarded = 0;
 	
 	if (data != NULL)
 	{	
@@ -336,12 +607,16 @@ int restart_siqs(static_conf_t *sconf, dynamic_conf_t *dconf)
 				printf("restarting siqs from saved data set\n");
 			fflush(stdout);
 			fflush(stderr);
-			while (1)
+
+			// if a checkpoint is usable, pick up from where it left off;
+			// otherwise replay everything following the N line.
+			body_start = qs_ftell(data);
+			if (!siqs_load_checkpoint(sconf, data))
+				qs_fseek(data, body_start, SEEK_SET);
+			alloc = sconf->total_poly_a;
+
+			while (fgets(str,1024,data) != NULL)
 			{
-				//read a line
-				if (feof(data))
-					break;
-				fgets(str,1024,data);
 				substr = str + 2;
 
 				if (str[0] == 'R')
@@ -355,12 +630,12 @@ int restart_siqs(static_conf_t *sconf, dynamic_conf_t *dconf)
 					{
 						if ((lp[0] > 1) && (lp[0] < pmax))
 						{
-							j++;
+							sconf->num_discarded++;
 							continue;
 						}
 						if ((lp[1] > 1) && (lp[1] < pmax))
 						{
-							j++;
+							sconf->num_discarded++;
 							continue;
 						}
 					}
@@ -375,7 +650,7 @@ int restart_siqs(static_conf_t *sconf, dynamic_conf_t *dconf)
 				}
 				else if (str[0] == 'A')
 				{
-					i++;
+					restart_add_poly_a(sconf, substr, &alloc);
 				}
 			}
 
@@ -391,7 +666,8 @@ int restart_siqs(static_conf_t *sconf, dynamic_conf_t *dconf)
 					sconf->num_cycles +
 					sconf->components - sconf->vertices,
 					sconf->num_cycles);
-				printf("threw away %d relations with large primes too small\n",j);
+				printf("threw away %d relations with large primes too small\n",
+					sconf->num_discarded);
 				fflush(stdout);
 				sconf->last_numfull = sconf->num_relations;
 				sconf->last_numcycles = sconf->num_cycles;
@@ -405,9 +681,6 @@ int restart_siqs(static_conf_t *sconf, dynamic_conf_t *dconf)
 	return 0;
 }
 
-#define QS_HASH_MULT ((uint32)(2654435761UL))
-#define QS_HASH(a) (((a) * QS_HASH_MULT) >> (32 - QS_LOG2_CYCLE_HASH))
-
 /**********************************************************
 These 3 routines are used to add a relation to the cycle
 tree every time one is found after sieving
@@ -86,6 +86,10 @@ void med_sieveblock_64k(uint8 *sieve, sieve_fb_compressed *fb, fb_list *full_fb,
 		root2 = fb->root2[i];
 		logp = fb->logp[i];
 
+		// invalid root (part of poly->a)
+		if (prime == 0) 
+			continue;
+
 		CHECK_2X_DONE;
 
 		SIEVE_2X;
@@ -102,6 +106,10 @@ void med_sieveblock_64k(uint8 *sieve, sieve_fb_compressed *fb, fb_list *full_fb,
 		root2 = fb->root2[i];
 		logp = fb->logp[i];
 
+		// invalid root (part of poly->a)
+		if (prime == 0) 
+			continue;
+
 		CHECK_1X_DONE;
 
 		SIEVE_1X;
@@ -118,6 +126,10 @@ void med_sieveblock_64k(uint8 *sieve, sieve_fb_compressed *fb, fb_list *full_fb,
 		root2 = fb->root2[i];
 		logp = fb->logp[i];
 
+		// invalid root (part of poly->a)
+		if (prime == 0) 
+			continue;
+
 		SIEVE_BIG;
 		UPDATE_ROOTS;
 
@@ -24,18 +24,6 @@ typedef struct {
 	uint32 index;
 } qs_row_count_t;
 
-static int yafu_compare_row_count(const void *x, const void *y) {
-	qs_row_count_t *xx = (qs_row_count_t *)x;
-	qs_row_count_t *yy = (qs_row_count_t *)y;
-	return yy->count - xx->count;
-}
-
-static int yafu_compare_row_index(const void *x, const void *y) {
-	qs_row_count_t *xx = (qs_row_count_t *)x;
-	qs_row_count_t *yy = (qs_row_count_t *)y;
-	return xx->index - yy->index;
-}
-
 static int yafu_compare_uint32(const void *x, const void *y) {
 	uint32 *xx = (uint32 *)x;
 	uint32 *yy = (uint32 *)y;
@@ -225,6 +213,186 @@ static void yafu_combine_cliques(uint32 num_dense_rows,
 	*ncols_out = j;
 }
 
+/*------------------------------------------------------------------*/
+#define QS_MAX_MERGE_ROW_WEIGHT 4
+#define QS_MAX_MERGE_RELATIONS 64
+#define QS_MERGE_TARGET_DENSITY 50
+
+static uint32 yafu_merge_light_rows(uint32 nrows, uint32 num_dense_rows, 
+			uint32 *ncols_out, qs_la_col_t *cols, 
+			qs_row_count_t *counts) {
+
+	/* One pass of structured Gaussian elimination. A row
+	   with only a few nonzero entries is eliminated by
+	   picking the lightest column that contains it as a
+	   pivot, adding the pivot into every other column
+	   containing the row, and then deleting the pivot.
+	   Each merge removes one row and one column, at the
+	   cost of some fill-in; merging stops once the average
+	   column weight reaches QS_MERGE_TARGET_DENSITY, since
+	   past that point the extra weight costs the Lanczos
+	   iteration more than the smaller dimension saves.
+
+	   The row-to-column index is built once per pass with a
+	   counting sort. Columns modified during the pass make
+	   every row they touch 'dirty', and dirty rows are left
+	   for the next pass because their index entries may be
+	   stale. Returns the number of rows eliminated */
+
+	uint32 i, j, k, w;
+	uint32 ncols = *ncols_out;
+	uint32 dense_row_words = (num_dense_rows + 31) / 32;
+	uint32 num_merged = 0;
+	uint32 total_weight, alive_cols;
+	uint32 *row_start, *row_cols;
+	uint8 *dirty;
+	uint32 merge_array[QS_MAX_COL_WEIGHT];
+
+	for (i = total_weight = 0; i < ncols; i++)
+		total_weight += cols[i].weight;
+
+	if (total_weight >= QS_MERGE_TARGET_DENSITY * ncols)
+		return 0;
+
+	/* bucket the column indices of every nonzero by row */
+
+	row_start = (uint32 *)xmalloc((nrows + 1) * sizeof(uint32));
+	row_cols = (uint32 *)xmalloc((total_weight + 1) * sizeof(uint32));
+	dirty = (uint8 *)xcalloc((size_t)nrows, sizeof(uint8));
+
+	for (i = j = 0; i < nrows; i++) {
+		row_start[i] = j;
+		j += counts[i].count;
+	}
+	row_start[nrows] = j;
+
+	for (i = 0; i < nrows; i++)
+		counts[i].index = row_start[i];
+
+	for (i = 0; i < ncols; i++) {
+		qs_la_col_t *c = cols + i;
+		qsort(c->data, (size_t)c->weight, 
+				sizeof(uint32), yafu_compare_uint32);
+		for (j = 0; j < c->weight; j++)
+			row_cols[counts[c->data[j]].index++] = i;
+	}
+
+	/* eliminate the lightest rows first */
+
+	alive_cols = ncols;
+	for (w = 2; w <= QS_MAX_MERGE_ROW_WEIGHT; w++) {
+		for (i = num_dense_rows; i < nrows; i++) {
+			uint32 *rc = row_cols + row_start[i];
+			qs_la_col_t *pivot;
+			uint32 pivot_idx;
+
+			if (counts[i].count != w || dirty[i])
+				continue;
+
+			if (total_weight >= QS_MERGE_TARGET_DENSITY * alive_cols)
+				goto done;
+
+			/* choose the lightest column as the pivot, and
+			   make sure the merged columns stay in bounds */
+
+			pivot_idx = 0;
+			for (j = 1; j < w; j++) {
+				if (cols[rc[j]].weight < cols[rc[pivot_idx]].weight)
+					pivot_idx = j;
+			}
+			pivot = cols + rc[pivot_idx];
+
+			for (j = 0; j < w; j++) {
+				qs_la_col_t *c = cols + rc[j];
+				if (j == pivot_idx)
+					continue;
+				if (c->weight + pivot->weight + 
+						dense_row_words >= QS_MAX_COL_WEIGHT ||
+				    c->cycle.num_relations + 
+				    		pivot->cycle.num_relations > 
+						QS_MAX_MERGE_RELATIONS)
+					break;
+			}
+			if (j < w)
+				continue;
+
+			/* add the pivot into the other columns */
+
+			for (j = 0; j < w; j++) {
+				qs_la_col_t *c = cols + rc[j];
+				uint32 merged;
+
+				if (j == pivot_idx)
+					continue;
+
+				for (k = 0; k < c->weight; k++) {
+					counts[c->data[k]].count--;
+					dirty[c->data[k]] = 1;
+				}
+
+				merged = qs_merge_relations(merge_array, 
+							c->data, c->weight,
+							pivot->data, pivot->weight);
+				for (k = 0; k < dense_row_words; k++) {
+					merge_array[merged + k] = 
+						c->data[c->weight + k] ^
+						pivot->data[pivot->weight + k];
+				}
+
+				total_weight += merged - c->weight;
+				free(c->data);
+				c->data = (uint32 *)xmalloc((merged + 
+						dense_row_words + 1) * sizeof(uint32));
+				memcpy(c->data, merge_array, (merged + 
+						dense_row_words) * sizeof(uint32));
+				c->weight = merged;
+
+				for (k = 0; k < c->weight; k++) {
+					counts[c->data[k]].count++;
+					dirty[c->data[k]] = 1;
+				}
+
+				c->cycle.list = (uint32 *)xrealloc(c->cycle.list, 
+						(c->cycle.num_relations +
+						 pivot->cycle.num_relations) *
+						sizeof(uint32));
+				memcpy(c->cycle.list + c->cycle.num_relations,
+					pivot->cycle.list, 
+					pivot->cycle.num_relations * sizeof(uint32));
+				c->cycle.num_relations += pivot->cycle.num_relations;
+			}
+
+			/* and kill off the pivot */
+
+			for (k = 0; k < pivot->weight; k++) {
+				counts[pivot->data[k]].count--;
+				dirty[pivot->data[k]] = 1;
+			}
+			total_weight -= pivot->weight;
+			free(pivot->data);
+			pivot->data = NULL;
+			free(pivot->cycle.list);
+			pivot->cycle.list = NULL;
+			alive_cols--;
+			num_merged++;
+		}
+	}
+
+done:
+	free(row_start);
+	free(row_cols);
+	free(dirty);
+
+	/* squeeze out the pivot columns from the list */
+
+	for (i = j = 0; i < ncols; i++) {
+		if (cols[i].data != NULL)
+			cols[j++] = cols[i];
+	}
+	*ncols_out = j;
+	return num_merged;
+}
+
 /*------------------------------------------------------------------*/
 void reduce_qs_matrix(fact_obj_t *obj, uint32 *nrows, 
 		uint32 num_dense_rows, uint32 *ncols, 
@@ -246,10 +414,17 @@ void reduce_qs_matrix(fact_obj_t *obj, uint32 *nrows,
 	   to find any nontrivial dependencies. I've also seen cases
 	   where cliques *must* be merged in order to find nontrivial
 	   dependencies; this seems to happen for matrices that are large
-	   and very sparse */
+	   and very sparse.
+
+	   Large matrices also get rows of small weight eliminated
+	   by merging columns, which shrinks both dimensions ahead of
+	   the Lanczos iteration */
 
 	uint32 r, c, i, j, k;
 	uint32 passes;
+	uint32 num_merged = 0;
+	uint32 max_count;
+	uint32 *row_hist;
 	qs_row_count_t *counts;
 	uint32 reduced_rows;
 	uint32 reduced_cols;
@@ -312,6 +487,15 @@ void reduce_qs_matrix(fact_obj_t *obj, uint32 *nrows,
 						cols, counts);
 			}
 		} while (c != reduced_cols);
+
+		/* eliminate light rows; this can leave new 
+		   singletons behind, so it forces another pass */
+
+		if (reduced_cols >= QS_MIN_NCOLS_TO_PACK) {
+			num_merged += yafu_merge_light_rows(*nrows, 
+						num_dense_rows, &reduced_cols,
+						cols, counts);
+		}
 	
 		/* count the number of rows that contain a
 		   nonzero entry. Ignore the row indices associated
@@ -370,6 +554,16 @@ void reduce_qs_matrix(fact_obj_t *obj, uint32 *nrows,
 
 	if (obj->logfile != NULL)
 		logprint(obj->logfile, "filtering completed in %u passes\n", passes);
+
+	if (num_merged > 0) {
+		if (VFLAG > 0)
+			printf("merged away %u rows of weight <= %u\n", 
+				num_merged, QS_MAX_MERGE_ROW_WEIGHT);
+		if (obj->logfile != NULL)
+			logprint(obj->logfile, "merged away %u rows of weight <= %u\n", 
+				num_merged, QS_MAX_MERGE_ROW_WEIGHT);
+	}
+
 	count_qs_matrix_nonzero(obj, reduced_rows, num_dense_rows,
 				reduced_cols, cols);
 
@@ -378,14 +572,25 @@ void reduce_qs_matrix(fact_obj_t *obj, uint32 *nrows,
 	   and put each column in sorted order. The first
 	   num_dense_rows rows are not affected */
 	
+	/* the new position of each row comes from a counting 
+	   sort on the row weights, heaviest first; ties keep
+	   their original order */
+
+	for (i = num_dense_rows, max_count = 0; i < *nrows; i++) {
+		if (counts[i].count > max_count)
+			max_count = counts[i].count;
+	}
+	row_hist = (uint32 *)xcalloc((size_t)max_count + 1, sizeof(uint32));
 	for (i = num_dense_rows; i < *nrows; i++)
-		counts[i].index = i;
-	qsort(counts + num_dense_rows, (size_t)(*nrows - num_dense_rows), 
-			sizeof(qs_row_count_t), yafu_compare_row_count);
+		row_hist[counts[i].count]++;
+	for (i = max_count + 1, j = num_dense_rows; i > 0; i--) {
+		k = row_hist[i - 1];
+		row_hist[i - 1] = j;
+		j += k;
+	}
 	for (i = num_dense_rows; i < *nrows; i++)
-		counts[i].count = i;
-	qsort(counts + num_dense_rows, (size_t)(*nrows - num_dense_rows), 
-			sizeof(qs_row_count_t), yafu_compare_row_index);
+		counts[i].count = row_hist[counts[i].count]++;
+	free(row_hist);
 
 	for (i = 0; i < reduced_cols; i++) {
 		qs_la_col_t *col = cols + i;
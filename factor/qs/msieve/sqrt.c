@@ -17,6 +17,153 @@ Purpose:	Port into Yafu-1.14.
 
 #include "qs.h"
 
+#define SQRT_MAX_LP 200
+
+typedef struct {
+	/* shared, read only */
+	mpz_ptr n;
+	fb_element_siqs *factor_base;
+	uint32 fb_size;
+	qs_la_col_t *vectors;
+	uint32 vsize;
+	siqs_r *relation_list;
+	uint64 *null_vectors;
+	mpz_t *poly_a_list;
+	poly_t *poly_list;
+	uint64 *planes;			/* exponent bit planes of every fb prime */
+	uint32 *plane_start;	/* first plane of fb prime i */
+
+	/* per thread */
+	int dep;				/* dependency to run */
+	mpz_t x, y, gcd, sum;
+
+#if defined(WIN32) || defined(_WIN64)
+	HANDLE thread_id;
+#else
+	pthread_t thread_id;
+#endif
+} sqrt_thread_t;
+
+/*--------------------------------------------------------------------*/
+#if defined(WIN32) || defined(_WIN64)
+DWORD WINAPI sqrt_worker(LPVOID thread_data) {
+#else
+void *sqrt_worker(void *thread_data) {
+#endif
+
+	/* form X and Y for one dependency and compute gcd(X+Y, n) */
+
+	sqrt_thread_t *t = (sqrt_thread_t *)thread_data;
+	uint64 mask = (uint64)1 << t->dep;
+	uint32 i, j, k, m, b;
+	uint32 large_primes[2 * SQRT_MAX_LP], num_large_primes;
+	uint32 num_relations, prime;
+	siqs_r *relation;
+
+	mpz_set_ui(t->x, 1);
+	mpz_set_ui(t->y, 1);
+
+	/* For each sieve relation in the dependency */
+	for (i = 0; i < t->vsize; i++) {
+
+		if (!(t->null_vectors[i] & mask))
+			continue;
+
+		num_large_primes = 0;
+		num_relations = t->vectors[i].cycle.num_relations;
+
+		for (j = 0; j < num_relations; j++) {
+			mpz_ptr a, bp;
+			poly_t *poly;
+
+			relation = &t->relation_list[t->vectors[i].cycle.list[j]];
+			poly = t->poly_list + relation->poly_idx;
+			bp = poly->b;
+			a = t->poly_a_list[poly->a_idx];
+
+			/* Form (a * sieve_offset + b). sieve_offset can 
+			   be negative; in that case the minus sign is 
+			   implicit. We don't have to normalize mod n 
+			   because there are an even number of negative 
+			   values to multiply together */
+
+			mpz_mul_ui(t->sum, a, relation->sieve_offset);
+			if (relation->parity == POSITIVE)
+				mpz_add(t->sum, t->sum, bp);
+			else
+				mpz_sub(t->sum, t->sum, bp);
+
+			mpz_mul(t->x, t->x, t->sum);
+			mpz_tdiv_r(t->x, t->x, t->n);
+
+			/* accumulate large primes in a dedicated table; 
+			   they pair up within the relation's cycle */
+
+			for (k = 0; k < 2; k++) {
+				prime = relation->large_prime[k];
+				if (prime == 1)
+					continue;
+
+				for (m = 0; m < num_large_primes; m++) {
+					if (prime == large_primes[2*m]){
+						large_primes[2*m+1]++;
+						break;
+					}
+				}
+				if (m == num_large_primes) {
+					large_primes[2*m] = prime;
+					large_primes[2*m+1] = 1;
+					num_large_primes++;
+				}
+			}
+		}
+
+		for (j = 0; j < num_large_primes; j++) {
+			for (k = 0; k < large_primes[2*j+1]/2; k++) {
+				mpz_mul_ui(t->y, t->y, large_primes[2 * j]);
+				mpz_tdiv_r(t->y, t->y, t->n);
+			}
+		}
+	}
+
+	/* For each factor base prime p, read its count in this
+	   dependency out of the bit planes and multiply
+	   p ^ (count / 2) mod n into y */
+
+	for (i = MIN_FB_OFFSET; i < t->fb_size; i++) {
+		uint32 exponent = 0;
+
+		for (b = t->plane_start[i]; b < t->plane_start[i+1]; b++) {
+			exponent |= (uint32)((t->planes[b] >> t->dep) & 1) << 
+						(b - t->plane_start[i]);
+		}
+
+		if (exponent & 0x1)
+			printf("odd exponent found\n");
+
+		exponent /= 2;
+		if (exponent == 0)
+			continue;
+
+		mpz_set_ui(t->sum, t->factor_base->prime[i]);
+		mpz_powm_ui(t->sum, t->sum, exponent, t->n);
+		mpz_mul(t->y, t->y, t->sum);
+		mpz_tdiv_r(t->y, t->y, t->n);
+	}
+
+	/* See the comments in Pari's MPQS code for a proof 
+	   that it isn't necessary to also check gcd(x-y, n) */
+
+	mpz_add(t->gcd, t->x, t->y);
+	mpz_gcd(t->gcd, t->gcd, t->n);
+
+#if defined(WIN32) || defined(_WIN64)
+	return 0;
+#else
+	return NULL;
+#endif
+}
+
 /*--------------------------------------------------------------------*/
 uint32 yafu_find_factors(fact_obj_t *obj, mpz_t n, 
 		fb_element_siqs *factor_base, uint32 fb_size,
@@ -58,190 +205,164 @@ uint32 yafu_find_factors(fact_obj_t *obj, mpz_t n,
 	   Note that the code doesn't stop with one nontrivial
 	   factor; it prints them all. If you go to so much work
 	   and the other dependencies are there for free, why not
-	   use them? */
-
-	mpz_t factor, x, y, tmp, tmp2, sum, tmpn;
-	uint32 i, j, k, m;
-	uint64 mask;
-	uint32 *fb_counts;
-	uint32 large_primes[200], num_large_primes;
-	uint32 num_relations, prime;
+	   use them? 
+	   
+	   The dependencies are independent, so batches of them are 
+	   run on obj->num_threads threads. The factor base exponents 
+	   of all 64 dependencies are counted in a single pass over 
+	   the relations, with the counts of each prime kept in bit 
+	   planes (bit j of plane b is bit b of dependency j's count),
+	   and dependencies stop being run as soon as the 
+	   factorization is complete. */
+
+	mpz_t tmp, tmp2, tmpn;
+	uint32 i, j, k, b, d;
+	uint64 deps, carry, sum;
+	uint32 *fb_counts, *plane_start;
+	uint64 *planes;
+	uint32 num_relations, nthreads, batch;
 	siqs_r *relation;
+	sqrt_thread_t *threads;
 	uint32 factor_found = 0;
-	int bits;
+	int bits, done = 0;
 
-	mpz_init(factor);
-	mpz_init(x);
-	mpz_init(y);
 	mpz_init(tmp);
 	mpz_init(tmp2);
-	mpz_init(sum);
 	mpz_init(tmpn);
-	
-	fb_counts = (uint32 *)malloc(fb_size * sizeof(uint32));
 	mpz_set(tmpn, n);
 
-	bits = 0;
-	/* For each dependency */
-	for (mask = 1; mask; mask <<= 1) {
-		memset(fb_counts, 0, fb_size * sizeof(uint32));
-		mpz_set_ui(x, 1);
-		mpz_set_ui(y, 1);
-
-		/* For each sieve relation */
-		for (i = 0; i < vsize; i++) {
-
-			/* If the relation is not scheduled to
-			   contribute to x and y, skip it */
-
-			if (!(null_vectors[i] & mask))
-				continue;
-			
-			/* compute the number of sieve_values */
-
-			num_large_primes = 0;
-			num_relations = vectors[i].cycle.num_relations;
-
-			/* for all sieve values */
-
-			for (j = 0; j < num_relations; j++) {
-				mpz_ptr a, b;
-				poly_t *poly;
-				uint32 sieve_offset;
-				uint32 sign_of_index;
-
-				relation = &relation_list[vectors[i].cycle.list[j]];
-				
-				/* reconstruct a[i], b[i], x[i] and
-				   the sign of x[i]. Drop the subscript
-				   from here on. */
-
-				poly = poly_list + relation->poly_idx;
-				b = poly->b;
-				a = poly_a_list[poly->a_idx];
-				//sieve_offset = relation->sieve_offset & 
-				//				0x7fffffff;
-				//sign_of_index = relation->sieve_offset >> 31;
-				sieve_offset = relation->sieve_offset;
-				sign_of_index = relation->parity;
-
-				/* Form (a * sieve_offset + b). Note that 
-				   sieve_offset can be negative; in that
-				   case the minus sign is implicit. We don't
-				   have to normalize mod n because there
-				   are an even number of negative values
-				   to multiply together */
-	
-				mpz_mul_ui(sum, a, sieve_offset); //zShortMul(a,sieve_offset,&sum);
-
-				if (sign_of_index == POSITIVE)
-					mpz_add(sum, sum, b); //zAdd(&sum,b,&tmp);
-				else
-					mpz_sub(sum, sum, b); //zSub(&sum,b,&tmp);
-	
-				/* multiply the sum into x */	
-				mpz_mul(x, x, sum); //zModMul(&x,&sum,n,&x);
-				mpz_tdiv_r(x, x, n); 
-	
-				/* do not multiply the factors associated 
-				   with this relation into y; instead, just 
-				   update the count for each factor base 
-				   prime. Unlike ordinary MPQS, the list
-				   of factors is for the complete factor-
-				   ization of a*(a*x^2+b*x+c), so the 'a' 
-				   in front need not be treated separately */
-	
-				for (k = 0; k < relation->num_factors; k++)
-					fb_counts[relation->fb_offsets[k]]++;
-					
-				/* if the sieve value contains one or more
-				   large primes, accumulate them in a 
-				   dedicated table. Do not multiply them
-				   into y until all of the sieve values
-				   for this relation have been processed */
-
-				for (k = 0; k < 2; k++) {
-					prime = relation->large_prime[k];
-					if (prime == 1)
-						continue;
-
-					for (m = 0; m < num_large_primes; m++) {
-						if (prime == large_primes[2*m]){
-							large_primes[2*m+1]++;
-							break;
-						}
-					}
-					if (m == num_large_primes) {
-						large_primes[2*m] = prime;
-						large_primes[2*m+1] = 1;
-						num_large_primes++;
-					}
-				}
-			}
+	/* size the bit planes of each factor base prime by the 
+	   number of times it occurs in any dependency, then 
+	   count all the dependencies at once: each occurrence 
+	   adds the relation's dependency mask into the prime's 
+	   planes, with a carry ripple across planes */
+
+	fb_counts = (uint32 *)xcalloc((size_t)fb_size, sizeof(uint32));
+	deps = 0;
+	for (i = 0; i < vsize; i++) {
+		if (null_vectors[i] == 0)
+			continue;
+
+		deps |= null_vectors[i];
+		num_relations = vectors[i].cycle.num_relations;
+		for (j = 0; j < num_relations; j++) {
+			relation = &relation_list[vectors[i].cycle.list[j]];
+			for (k = 0; k < relation->num_factors; k++)
+				fb_counts[relation->fb_offsets[k]]++;
+		}
+	}
 
-			for (j = 0; j < num_large_primes; j++) {
-				for (k = 0; k < large_primes[2*j+1]/2; k++) {
-					mpz_set_ui(factor, large_primes[2 * j]); //factor.val[0] = large_primes[2*j];
-					mpz_mul(y, y, factor); //zModMul(&y,&factor,n,&y);  
-					mpz_tdiv_r(y, y, n);
+	plane_start = (uint32 *)xmalloc((fb_size + 1) * sizeof(uint32));
+	plane_start[0] = 0;
+	for (i = 0; i < fb_size; i++) {
+		for (b = 0; (b < 32) && (fb_counts[i] >> b); b++)
+			;
+		plane_start[i+1] = plane_start[i] + b;
+	}
+	planes = (uint64 *)xcalloc((size_t)plane_start[fb_size] + 1, 
+				sizeof(uint64));
+
+	for (i = 0; i < vsize; i++) {
+		if (null_vectors[i] == 0)
+			continue;
+
+		num_relations = vectors[i].cycle.num_relations;
+		for (j = 0; j < num_relations; j++) {
+			relation = &relation_list[vectors[i].cycle.list[j]];
+			for (k = 0; k < relation->num_factors; k++) {
+				uint64 *p = planes + 
+					plane_start[relation->fb_offsets[k]];
+
+				carry = null_vectors[i];
+				for (b = 0; carry; b++) {
+					sum = p[b] ^ carry;
+					carry &= p[b];
+					p[b] = sum;
 				}
 			}
 		}
+	}
+	free(fb_counts);
 
-		/* For each factor base prime p, compute 
-			p ^ ((number of times p occurs in y) / 2) mod n
-		   then multiply it into y. This is enormously
-		   more efficient than multiplying by one p at a time */
+	nthreads = obj->num_threads;
+	if (nthreads < 1)
+		nthreads = 1;
+	if (nthreads > 64)
+		nthreads = 64;
+
+	threads = (sqrt_thread_t *)xmalloc(nthreads * sizeof(sqrt_thread_t));
+	for (i = 0; i < nthreads; i++) {
+		sqrt_thread_t *t = threads + i;
+
+		t->n = n;
+		t->factor_base = factor_base;
+		t->fb_size = fb_size;
+		t->vectors = vectors;
+		t->vsize = vsize;
+		t->relation_list = relation_list;
+		t->null_vectors = null_vectors;
+		t->poly_a_list = poly_a_list;
+		t->poly_list = poly_list;
+		t->planes = planes;
+		t->plane_start = plane_start;
+		mpz_init(t->x);
+		mpz_init(t->y);
+		mpz_init(t->gcd);
+		mpz_init(t->sum);
+	}
 
-		for (i = MIN_FB_OFFSET; i < fb_size; i++) {
-			uint32 mask2 = 0x80000000;
-			uint32 exponent = fb_counts[i] / 2;
-			uint32 prime = factor_base->prime[i];
+	bits = 0;
+	/* For each batch of dependencies */
+	for (d = 0; (d < 64) && !done; ) {
 
-			
-			if (fb_counts[i] &0x1)
-				printf("odd exponent found\n");
-				
+		for (batch = 0; (batch < nthreads) && (d < 64); d++) {
+			if (deps & ((uint64)1 << d))
+				threads[batch++].dep = d;
+		}
+		if (batch == 0)
+			break;
+
+		/* the main thread takes the first dependency itself */
+		for (i = 1; i < batch; i++) {
+#if defined(WIN32) || defined(_WIN64)
+			threads[i].thread_id = CreateThread(NULL, 0, 
+					sqrt_worker, &threads[i], 0, NULL);
+#else
+			pthread_create(&threads[i].thread_id, NULL, 
+					sqrt_worker, &threads[i]);
+#endif
+		}
 
-			if (exponent == 0)
-				continue;
+		sqrt_worker(&threads[0]);
 
-			mpz_set_ui(tmp, prime); 
-			mpz_set_ui(factor, prime);
-
-			while (!(exponent & mask2))
-				mask2 >>= 1;
-			for (mask2 >>= 1; mask2; mask2 >>= 1) {
-				mpz_mul(tmp, tmp, tmp); //zModMul(&tmp,&tmp,n,&tmp2);
-				mpz_tdiv_r(tmp, tmp, n);
-				
-				if (exponent & mask2) {
-					mpz_mul(tmp, tmp, factor); //zModMul(&tmp,&factor,n,&tmp); 
-					mpz_tdiv_r(tmp, tmp, n);
-				}
-			}
-			mpz_mul(y, tmp, y); //zModMul(&tmp,&y,n,&y);  
-			mpz_tdiv_r(y, y, n);
+		for (i = 1; i < batch; i++) {
+#if defined(WIN32) || defined(_WIN64)
+			WaitForSingleObject(threads[i].thread_id, INFINITE);
+			CloseHandle(threads[i].thread_id);
+#else
+			pthread_join(threads[i].thread_id, NULL);
+#endif
 		}
 
-		/* compute gcd(x+y, n). If it's not 1 or n, save it 
-		   (and stop processing dependencies if the product 
-		   of all the probable prime factors found so far equals 
-		   n). See the comments in Pari's MPQS code for a proof 
-		   that it isn't necessary to also check gcd(x-y, n) */
+		/* look at the gcds in dependency order. If one is not 
+		   1 or n, save it (and stop processing dependencies if 
+		   the product of all the probable prime factors found 
+		   so far equals n) */
 
-		mpz_add(tmp, x, y); //zAdd(&x,&y,&tmp);
-		mpz_gcd(tmp, tmp, n); //zLEGCD(&tmp,n,&tmp2);
-		if ((mpz_cmp(tmp, n) != 0) && (mpz_cmp_ui(tmp, 1) != 0)) {
+		for (i = 0; i < batch; i++) {
+
+			mpz_set(tmp, threads[i].gcd);
+			if ((mpz_cmp(tmp, n) == 0) || (mpz_cmp_ui(tmp, 1) == 0))
+				continue;
 
 			/* remove any factors of the multiplier 
 			   before saving tmp, and don't save at all
 			   if tmp contains *only* multiplier factors */
 			if (multiplier > 1) {
 				uint32 ignore_me = spGCD(multiplier,
-						mpz_tdiv_ui(tmp, multiplier)); //zShortMod(&tmp, multiplier));
+						mpz_tdiv_ui(tmp, multiplier));
 				if (ignore_me > 1) {
-					mpz_tdiv_q_ui(tmp, tmp, ignore_me); //zShortDiv(&tmp, ignore_me, &tmp2);
+					mpz_tdiv_q_ui(tmp, tmp, ignore_me);
 					if (mpz_cmp_ui(tmp, 1) == 0)
 						continue;
 				}
@@ -255,11 +376,13 @@ uint32 yafu_find_factors(fact_obj_t *obj, mpz_t n,
 			bits = yafu_factor_list_add(obj, factor_list, tmp);
 
 			//check if only the multiplier remains
-			if (abs(bits) < 8)
+			if (abs(bits) < 8) {
+				done = 1;
 				break;
+			}
 
 			//divide the factor out of our number
-			mpz_tdiv_q(tmp2, tmpn, tmp); //zDiv(&tmpn, &tmp, &tmp2, &tmp3);
+			mpz_tdiv_q(tmp2, tmpn, tmp);
 
 			//check if the remaining number is prime
 			if (is_mpz_prp(tmp2))
@@ -269,6 +392,7 @@ uint32 yafu_find_factors(fact_obj_t *obj, mpz_t n,
 				bits = yafu_factor_list_add(obj, factor_list, tmp2);
 
 				//then bail
+				done = 1;
 				break;
 			}
 
@@ -287,6 +411,7 @@ uint32 yafu_find_factors(fact_obj_t *obj, mpz_t n,
 						bits = yafu_factor_list_add(obj, factor_list, tmp);
 
 						//then bail
+						done = 1;
 						break;
 					}
 				}
@@ -294,14 +419,17 @@ uint32 yafu_find_factors(fact_obj_t *obj, mpz_t n,
 		}
 	}
 
-	free(fb_counts);
-	mpz_clear(factor);
-	mpz_clear(x);
-	mpz_clear(y);
+	for (i = 0; i < nthreads; i++) {
+		mpz_clear(threads[i].x);
+		mpz_clear(threads[i].y);
+		mpz_clear(threads[i].gcd);
+		mpz_clear(threads[i].sum);
+	}
+	free(threads);
+	free(planes);
+	free(plane_start);
 	mpz_clear(tmp);
 	mpz_clear(tmp2);
 	mpz_clear(tmpn);
-	mpz_clear(sum);
 	return factor_found;
 }
-
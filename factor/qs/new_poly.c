@@ -26,6 +26,204 @@ code to the public domain.
 
 //#define POLYA_DEBUG
 
+// every 'a' used so far is remembered by a fingerprint of its set of
+// factor base indices, and by fingerprints of each of the s subsets
+// that leave one factor out.  a new 'a' that hits one of the subsets
+// shares s-1 factors with an earlier 'a', and the two would find many
+// of the same relations.
+static uint64 a_factor_hash(int *qli, int s, int skip)
+{
+	uint64 h = 14695981039346656037ULL + (skip < 0);
+	int i;
+
+	for (i=0; i<s; i++)
+	{
+		if (i == skip)
+			continue;
+		h ^= (uint64)qli[i];
+		h *= 1099511628211ULL;
+	}
+
+	// zero marks an empty slot
+	return h | 1;
+}
+
+static int a_hash_find(static_conf_t *sconf, uint64 h)
+{
+	uint32 mask = sconf->a_hash_alloc - 1;
+	uint32 i;
+
+	if (sconf->a_hash_alloc == 0)
+		return 0;
+
+	for (i = (uint32)(h >> 32) & mask; sconf->a_hash_table[i] != 0; 
+		i = (i + 1) & mask)
+	{
+		if (sconf->a_hash_table[i] == h)
+			return 1;
+	}
+	return 0;
+}
+
+static void a_hash_insert(static_conf_t *sconf, uint64 h)
+{
+	uint32 mask, i;
+
+	if (2 * (sconf->a_hash_count + 1) > sconf->a_hash_alloc)
+	{
+		uint64 *old = sconf->a_hash_table;
+		uint32 old_alloc = sconf->a_hash_alloc;
+
+		sconf->a_hash_alloc = (old_alloc == 0) ? 1024 : 2 * old_alloc;
+		sconf->a_hash_table = (uint64 *)xcalloc(sconf->a_hash_alloc, 
+			sizeof(uint64));
+		sconf->a_hash_count = 0;
+		for (i=0; i<old_alloc; i++)
+		{
+			if (old[i] != 0)
+				a_hash_insert(sconf, old[i]);
+		}
+		free(old);
+	}
+
+	mask = sconf->a_hash_alloc - 1;
+	for (i = (uint32)(h >> 32) & mask; sconf->a_hash_table[i] != 0; 
+		i = (i + 1) & mask)
+	{
+		if (sconf->a_hash_table[i] == h)
+			return;
+	}
+	sconf->a_hash_table[i] = h;
+	sconf->a_hash_count++;
+}
+
+// returns 2 if this set of factors was used before, 1 if it shares
+// all but one factor with an earlier 'a', and 0 otherwise
+static int a_hash_check(static_conf_t *sconf, int *qli, int s)
+{
+	int sorted[MAX_A_FACTORS];
+	int i;
+
+	memcpy(sorted, qli, s * sizeof(int));
+	qsort(sorted, s, sizeof(int), &qcomp_int);
+
+	if (a_hash_find(sconf, a_factor_hash(sorted, s, -1)))
+		return 2;
+
+	for (i=0; i<s; i++)
+	{
+		if (a_hash_find(sconf, a_factor_hash(sorted, s, i)))
+			return 1;
+	}
+	return 0;
+}
+
+static void a_hash_add(static_conf_t *sconf, int *qli, int s)
+{
+	int sorted[MAX_A_FACTORS];
+	int i;
+
+	memcpy(sorted, qli, s * sizeof(int));
+	qsort(sorted, s, sizeof(int), &qcomp_int);
+
+	a_hash_insert(sconf, a_factor_hash(sorted, s, -1));
+	for (i=0; i<s; i++)
+		a_hash_insert(sconf, a_factor_hash(sorted, s, i));
+}
+
+// the range of factor base indices new_poly_a draws the factors of
+// 'a' from, for inputs of this size
+static void a_polypool_bounds(static_conf_t *sconf, uint32 *lo, uint32 *hi)
+{
+	fb_list *fb = sconf->factor_base;
+	uint32 i;
+
+	if (sconf->bits < 115)
+	{
+		*lo = sconf->sieve_small_fb_start;
+		*hi = fb->B - 1;
+	}
+	else if (sconf->bits < 130)
+	{
+		*lo = (fb->B - 1) / 4;
+		*hi = fb->B - 1;
+	}
+	else
+	{
+		// the last factor may go one past the pool
+		*lo = 2;
+		for (i=0; i<fb->small_B; i++)
+		{
+			if (fb->list->prime[i] > 1000)
+			{
+				*lo = i;
+				break;
+			}
+		}
+		*hi = MIN(fb->small_B, fb->B - 1);
+	}
+
+	return;
+}
+
+// 'a' values restored from a savefile come without their factors.
+// recover them by trial division over the primes 'a's are made of, 
+// so that the new 'a's stay clear of the old ones as well.
+static void a_hash_seed(static_conf_t *sconf)
+{
+	fb_list *fb = sconf->factor_base;
+	int qli[MAX_A_FACTORS];
+	mpz_t a;
+	uint32 i, k, lo, hi;
+	int s;
+
+	a_polypool_bounds(sconf, &lo, &hi);
+
+	mpz_init(a);
+	for (k = sconf->num_a_hashed; k < sconf->total_poly_a; k++)
+	{
+		mpz_set(a, sconf->poly_a_list[k]);
+		s = 0;
+		for (i=lo; (i <= hi) && (mpz_cmp_ui(a, 1) > 0); i++)
+		{
+			if (mpz_tdiv_ui(a, fb->list->prime[i]) == 0)
+			{
+				if (s == MAX_A_FACTORS)
+					break;
+				mpz_tdiv_q_ui(a, a, fb->list->prime[i]);
+				qli[s++] = i;
+			}
+		}
+
+		if (mpz_cmp_ui(a, 1) == 0)
+			a_hash_add(sconf, qli, s);
+	}
+	sconf->num_a_hashed = sconf->total_poly_a;
+	mpz_clear(a);
+
+	return;
+}
+
+// how many of the factors of a candidate 'a' the previous 'a' had
+static int a_shared_with_last(static_conf_t *sconf, int *qli, int s)
+{
+	int i, j, shared = 0;
+
+	for (i=0; i<s; i++)
+	{
+		for (j=0; j<sconf->last_a_s; j++)
+		{
+			if (qli[i] == sconf->last_a_qli[j])
+			{
+				shared++;
+				break;
+			}
+		}
+	}
+
+	return shared;
+}
+
 void new_poly_a(static_conf_t *sconf, dynamic_conf_t *dconf)
 {
 	/*the goal of this routine is to generate a new poly_a value from elements of the factor base
@@ -84,10 +282,23 @@ void new_poly_a(static_conf_t *sconf, dynamic_conf_t *dconf)
 	int too_close, min_ratio;
 	FILE *sieve_log = sconf->obj->logfile;
 	uint32 upper_polypool_index, lower_polypool_index;
+	uint32 num_rejects = 0;
+
+	// the best of the candidates so far
+	mpz_t best_a;
+	int best_qli[MAX_A_FACTORS], best_s = 0, best_shared = 0, num_cand = 0;
+	int shared;
+	double best_dist = 0., dist, target_log;
+
+	//pick up any 'a' values restored from a savefile
+	if (sconf->num_a_hashed < sconf->total_poly_a)
+		a_hash_seed(sconf);
 
 	mpz_init(tmp);
 	mpz_init(tmp2);
 	mpz_init(tmp3);
+	mpz_init(best_a);
+	target_log = zlog(target_a);
 
 	//determine polypool indexes.  
 	//this really should be done once after generating the factor base
@@ -433,18 +644,10 @@ void new_poly_a(static_conf_t *sconf, dynamic_conf_t *dconf)
 
 		if ((uint32)mpz_sizeinbase(tmp, 2) < target_bits)
 		{ 
-			// if not a duplicate
-			found_a_factor = 0;
-			for (j=0; j< (int)sconf->total_poly_a; j++)
-			{
-				if (mpz_cmp(poly_a,sconf->poly_a_list[j]) == 0)
-				{
-					found_a_factor = 1;
-					break;
-				}
-			}
+			// if not a duplicate, and not too close to a previous 'a'
+			found_a_factor = a_hash_check(sconf, qli, *s);
 
-			if (found_a_factor)
+			if (found_a_factor == 2)
 			{
 				//increase the target bound, so it is easier to find a factor.
 				//very rarely, inputs seem to generate many duplicates, and
@@ -458,9 +661,8 @@ void new_poly_a(static_conf_t *sconf, dynamic_conf_t *dconf)
 				}
 
 				target_bits++;
-				printf("poly %s is a duplicate of #%d = %s\n",
-					mpz_conv2str(&gstr1.s, 10, poly_a), j, 
-					mpz_conv2str(&gstr2.s, 10, sconf->poly_a_list[j]));
+				printf("poly %s is a duplicate\n",
+					mpz_conv2str(&gstr1.s, 10, poly_a));
 				printf("rejecting duplicate poly_a, new target = %d\n",target_bits);
 				printf("primes in a: ");
 				for (i=0;i<*s;i++)
@@ -469,14 +671,36 @@ void new_poly_a(static_conf_t *sconf, dynamic_conf_t *dconf)
 				logprint(sieve_log,"rejecting duplicate poly_a, new target = %d\n",target_bits);
 				continue;
 			}
-			else break;
-			
-			//check that this poly has at least 2 factors different from all
-			//previous polys.  this requires all previous polys to be factored, since
-			//we don't store the factors, just the polya coefficient, but trial
-			//division is fast.
+			else if ((found_a_factor == 1) && (num_rejects < QS_MAX_A_REJECTS))
+			{
+				//shares all but one factor with an earlier 'a'
+				num_rejects++;
+				sconf->num_a_rejected++;
+				continue;
+			}
+
+			//a usable 'a'.  random picks from the pool rarely repeat a
+			//factor of the previous 'a', so choosing among a few
+			//candidates mostly buys one closer to the target.
+			shared = a_shared_with_last(sconf, qli, *s);
+			dist = fabs(zlog(poly_a) - target_log);
+			if ((num_cand == 0) || (shared < best_shared) ||
+				((shared == best_shared) && (dist < best_dist)))
+			{
+				mpz_set(best_a, poly_a);
+				memcpy(best_qli, qli, *s * sizeof(int));
+				best_s = *s;
+				best_shared = shared;
+				best_dist = dist;
+			}
 
+			if (++num_cand < QS_A_CANDIDATES)
+				continue;
 
+			mpz_set(poly_a, best_a);
+			memcpy(qli, best_qli, best_s * sizeof(int));
+			*s = best_s;
+			break;
 		}
 	}
 
@@ -485,6 +709,7 @@ done:
 	mpz_clear(tmp);
 	mpz_clear(tmp2);
 	mpz_clear(tmp3);
+	mpz_clear(best_a);
 
 	//record this a in the list
 	sconf->poly_a_list = (mpz_t *)realloc(sconf->poly_a_list,
@@ -496,6 +721,11 @@ done:
 	qsort(poly->qlisort,poly->s,sizeof(int),&qcomp_int);
 	memset(&poly->qlisort[poly->s], 255, (MAX_A_FACTORS - poly->s) * sizeof(int));	
 
+	a_hash_add(sconf, poly->qlisort, poly->s);
+	sconf->num_a_hashed = sconf->total_poly_a + 1;
+	memcpy(sconf->last_a_qli, poly->qlisort, poly->s * sizeof(int));
+	sconf->last_a_s = poly->s;
+
 #ifdef POLYA_DEBUG
 		printf("done generating poly_a\n");
 #endif
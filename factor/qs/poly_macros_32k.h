@@ -1,5 +1,8 @@
 
 
+// log2 of the sieve block size, 32768 bytes
+#define POLY_BLOCK_SHIFT 15
+
 #define FILL_ONE_PRIME_P(i)					\
 	if (root1 < interval)					\
 	{										\
@@ -1,6 +1,9 @@
 
 
 
+// log2 of the sieve block size, 65536 bytes
+#define POLY_BLOCK_SHIFT 16
+
 #define FILL_ONE_PRIME_P(i)					\
 	if (root1 < interval)					\
 	{										\
@@ -37,8 +37,9 @@ uint32 make_fb_siqs(static_conf_t *sconf)
 	uint32 prime, root1, root2;
 	uint8 logp;
 	uint32 urange = 10000000;
-	uint32 lrange = 0;
 	fp_digit f;
+	uint64 *primes;
+	uint64 num_p;
 #ifdef USE_8X_MOD_ASM
 	uint32 shift = 24;
 #endif
@@ -49,27 +50,19 @@ uint32 make_fb_siqs(static_conf_t *sconf)
 	uint32 mul = sconf->multiplier;
 	uint32 *modsqrt = sconf->modsqrt_array;
 
-	free(PRIMES);
-	PRIMES = soe_wrapper(spSOEprimes, szSOEp, lrange, urange, 0, &NUM_P);
-	P_MIN = PRIMES[0];
-	P_MAX = PRIMES[NUM_P-1];
+	primes = get_prime_cache(urange, &num_p);
 
 	//the 0th and 1st elements in the fb are always 1 and 2, so start searching with 3
 	j=2; i=1;
 	while (j<fb->B)
 	{
-		if ((uint32)i >= NUM_P)
+		if ((uint32)i >= num_p)
 		{
-			lrange = urange + 1;
-			urange = lrange + 10000000;
-			free(PRIMES);
-			PRIMES = soe_wrapper(spSOEprimes, szSOEp, lrange, urange, 0, &NUM_P);
-			P_MIN = PRIMES[0];
-			P_MAX = PRIMES[NUM_P-1];
-			i=0;
+			urange += 10000000;
+			primes = get_prime_cache(urange, &num_p);
 		}
 
-		prime = (uint32)PRIMES[i];
+		prime = (uint32)primes[i];
 		r = mpz_tdiv_ui(n, prime);
 		if (r == 0)
 		{
@@ -511,6 +504,6 @@ uint32 yafu_factor_list_add(fact_obj_t *obj, factor_list_t *list,
 void siqsexit(int sig)
 {
 	printf("\nAborting...\n");
-	SIQS_ABORT = 1;
+	SIGINT_COUNT++;
 	return;
 }
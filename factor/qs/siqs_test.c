@@ -24,6 +24,16 @@ code to the public domain.
 #include "util.h"
 #include "gmp_xface.h"
 
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#if defined(__NR_perf_event_open)
+#define BENCH_TLB_COUNTERS
+#endif
+#endif
+
 int check_relation(mpz_t a, mpz_t b, siqs_r *r, fb_list *fb, mpz_t n)
 {
 	int offset, lp[2], parity, num_factors;
@@ -238,15 +248,95 @@ int checkBl(mpz_t n, uint32 *qli, fb_list *fb, mpz_t *Bl, int s)
 	return 0;
 }
 
+#if defined(BENCH_TLB_COUNTERS)
+static int open_tlb_counter(uint32 op)
+{
+	//count dtlb misses of one kind (loads or stores) in this process 
+	//and in the threads it starts from here on.  returns -1 if the 
+	//kernel or the cpu won't count them for us.
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HW_CACHE;
+	attr.size = sizeof(attr);
+	attr.config = PERF_COUNT_HW_CACHE_DTLB | (op << 8) |
+		(PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+	attr.disabled = 1;
+	attr.inherit = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static uint64 read_tlb_counter(int fd)
+{
+	uint64 count;
+
+	if ((fd < 0) || (read(fd, &count, sizeof(uint64)) != sizeof(uint64)))
+		return 0;
+
+	return count;
+}
+#endif
+
+static double bench_one(fact_obj_t *fobj, uint32 hugepages, 
+	uint64 *load_misses, uint64 *store_misses)
+{
+	//factor fobj->qs_obj.gmp_n with the sieve arrays in huge pages or 
+	//not, returning the time it took and the dtlb misses along the way
+	struct timeval start, stop;
+	TIME_DIFF *difference;
+	double t;
+#if defined(BENCH_TLB_COUNTERS)
+	int loads = open_tlb_counter(PERF_COUNT_HW_CACHE_OP_READ);
+	int stores = open_tlb_counter(PERF_COUNT_HW_CACHE_OP_WRITE);
+
+	if (loads >= 0)
+		ioctl(loads, PERF_EVENT_IOC_ENABLE, 0);
+	if (stores >= 0)
+		ioctl(stores, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+
+	fobj->qs_obj.hugepages = hugepages;
+	gettimeofday(&start, NULL);
+	SIQS(fobj);
+	gettimeofday(&stop, NULL);
+	clear_factor_list(fobj);
+
+	difference = my_difftime(&start, &stop);
+	t = (double)difference->secs + (double)difference->usecs / 1000000;
+	free(difference);
+
+	*load_misses = *store_misses = 0;
+#if defined(BENCH_TLB_COUNTERS)
+	*load_misses = read_tlb_counter(loads);
+	*store_misses = read_tlb_counter(stores);
+	if (loads >= 0)
+		close(loads);
+	if (stores >= 0)
+		close(stores);
+#endif
+
+	return t;
+}
+
 void siqsbench(fact_obj_t *fobj)
 {
-	//run through the list of benchmark siqs factorizations
+	//run through the list of benchmark siqs factorizations.  where
+	//the sieve arrays can get huge pages, each one is run first 
+	//without them and then with them, to compare time and dtlb misses.
 
 	char list[10][200];
 	char oldflogname[80];
 	enum cpu_type cpu;
 	FILE *log;
-	int i;
+	int i, j, compare;
+	uint32 oldhugepages = fobj->qs_obj.hugepages;
+	mem_arena_t probe;
+	double t[2];
+	uint64 loads[2], stores[2];
+	char *pages[2] = {"4k pages", "huge pages"};
 
 	strcpy(oldflogname,fobj->flogname);
 
@@ -280,15 +370,59 @@ void siqsbench(fact_obj_t *fobj)
 	fprintf(log,"Initialized as (x86-32 generic)...\n\n");
 #endif
 
+	//the smallest jobs don't use huge pages even when they can get them 
+	//(see siqs_alloc_sieve_arrays), but are quick to run both ways
+	arena_init(&probe, ARENA_HUGE_PAGE, 0, 1);
+	compare = oldhugepages && 
+		((probe.pages == ARENA_PAGES_THP) || (probe.pages == ARENA_PAGES_HUGETLB));
+	fprintf(log,"siqs sieve arrays can use %s\n", arena_pages_name(&probe));
+#if !defined(BENCH_TLB_COUNTERS)
+	fprintf(log,"dtlb miss counters are not available on this platform\n");
+#endif
+	fprintf(log,"\n");
+	arena_free(&probe);
+
 	fclose(log);
 
 	for (i=0; i<10; i++)
 	{
-		mpz_set_str(fobj->qs_obj.gmp_n, list[i], 10); //str2hexz(list[i],&n);
-		SIQS(fobj);
-		clear_factor_list(fobj);
+		for (j = (compare ? 0 : 1); j < 2; j++)
+		{
+			//the second pass mustn't restart from the first one's savefile
+			if (compare && (j == 1))
+				remove(fobj->qs_obj.siqs_savefile);
+
+			mpz_set_str(fobj->qs_obj.gmp_n, list[i], 10); //str2hexz(list[i],&n);
+			t[j] = bench_one(fobj, compare ? j : oldhugepages, 
+				&loads[j], &stores[j]);
+		}
+
+		if (!compare)
+			continue;
+
+		log = fopen(fobj->flogname,"a");
+		for (j = 0; j < 2; j++)
+		{
+			char misses[80];
+
+			//nothing runs without a tlb miss, so zeros mean no counters
+			if ((loads[j] == 0) && (stores[j] == 0))
+				strcpy(misses, "not counted");
+			else
+				sprintf(misses, "%" PRIu64 " loads, %" PRIu64 " stores",
+					loads[j], stores[j]);
+
+			printf("c%d with %s: %1.4f sec, dtlb misses: %s\n", 
+				(int)strlen(list[i]), pages[j], t[j], misses);
+			if (log != NULL)
+				fprintf(log,"c%d with %s: %1.4f sec, dtlb misses: %s\n", 
+					(int)strlen(list[i]), pages[j], t[j], misses);
+		}
+		if (log != NULL)
+			fclose(log);
 	}
 
+	fobj->qs_obj.hugepages = oldhugepages;
 	strcpy(fobj->flogname,oldflogname);
 
 	return;
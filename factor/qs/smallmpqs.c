@@ -91,6 +91,8 @@ typedef struct
 	int poly_d_idn;
 	int side;
 	int use_only_p;
+	uint64 *primes;		//the shared prime cache, from which poly_d is chosen
+	uint64 num_p;
 } sm_mpqs_poly;
 
 static void smpqs_sieve_block(uint8 *sieve, smpqs_sieve_fb *fb, uint32 start_prime, 
@@ -732,10 +734,11 @@ void smallmpqs(fact_obj_t *fobj)
 	mpz_nextprime(tmp, tmp); //zNextPrime_1(polyd, &fpt, &tmp, 1);
 	poly->poly_d = (uint64)mpz_get_ui(tmp); //.val[0];
 
-	if (spSOEprimes[szSOEp - 1] <= poly->poly_d)
+	poly->primes = get_prime_cache(0, &poly->num_p);
+	if (poly->primes[poly->num_p - 1] <= poly->poly_d)
 		smpqs_get_more_primes(poly);
 
-	pindex = bin_search_uint32(szSOEp, 0, poly->poly_d, spSOEprimes);
+	pindex = bin_search_uint64((int)poly->num_p, 0, poly->poly_d, poly->primes);
 	if (pindex < 0)
 	{
 		printf("prime not found in binary search\n");
@@ -980,31 +983,16 @@ done:
 
 void smpqs_get_more_primes(sm_mpqs_poly *poly)
 {
-	uint64 num_p;
-	int i;
-
 	if (VFLAG > 1)
 		printf("smallmpqs getting more primes: poly_d = %u\n",
 		poly->poly_d);
 
-	PRIMES = GetPRIMESRange(spSOEprimes, szSOEp, NULL, 0, 
-		(uint64)((double)poly->poly_d * 1.25), &num_p);
-
-	//save a batch of sieve primes too.
-	spSOEprimes = (uint32 *)realloc(spSOEprimes, 
-		(size_t) (num_p * sizeof(uint32)));
-
-	for (i=0;i<num_p;i++)
-		spSOEprimes[i] = (uint32)PRIMES[i];
-
-	szSOEp = num_p;
-	NUM_P = num_p;
-	P_MIN = 0; 
-	P_MAX = PRIMES[(uint32)NUM_P-1];
+	poly->primes = get_prime_cache((uint64)((double)poly->poly_d * 1.25), 
+		&poly->num_p);
 
 	if (VFLAG > 1)
 		printf("prime finding complete, cached %u primes. pmax = %u\n",
-		(uint32)NUM_P, (uint32)P_MAX);
+		(uint32)poly->num_p, (uint32)poly->primes[poly->num_p - 1]);
 
 	return;
 }
@@ -1631,9 +1619,9 @@ void smpqs_nextD(sm_mpqs_poly *poly, mpz_t n)
 		do 
 		{
 			poly->poly_d_idp++;
-			if (poly->poly_d_idp >= szSOEp)
+			if (poly->poly_d_idp >= poly->num_p)
 				smpqs_get_more_primes(poly);
-			poly->poly_d = spSOEprimes[poly->poly_d_idp];
+			poly->poly_d = (uint32)poly->primes[poly->poly_d_idp];
 			r = mpz_tdiv_ui(n,poly->poly_d); //zShortMod(n,*polyd);
 		} while ((jacobi_1(r,poly->poly_d) != 1) || ((poly->poly_d & 3) != 3));
 	}
@@ -1648,7 +1636,7 @@ void smpqs_nextD(sm_mpqs_poly *poly, mpz_t n)
 				smpqs_nextD(poly, n);
 				return;
 			}
-			poly->poly_d = spSOEprimes[poly->poly_d_idn];			
+			poly->poly_d = (uint32)poly->primes[poly->poly_d_idn];			
 			r = mpz_tdiv_ui(n,poly->poly_d); //zShortMod(n,*polyd);
 		} while ((jacobi_1(r,poly->poly_d) != 1) || ((poly->poly_d & 3) != 3));
 	}
@@ -0,0 +1,312 @@
+/*----------------------------------------------------------------------
+This source distribution is placed in the public domain by its author,
+Ben Buhrow. You may use it for any purpose, free of charge,
+without having to notify anyone. I disclaim any responsibility for any
+errors.
+
+Optionally, please be nice and tell me if you find this source to be
+useful. Again optionally, if you add to the functionality present here
+please consider making those additions public too, so that others may
+benefit from your work.
+
+Some parts of the code (and also this header), included in this
+distribution have been reused from other sources. In particular I
+have benefitted greatly from the work of Jason Papadopoulos's msieve @
+www.boo.net/~jasonp, Scott Contini's mpqs implementation, and Tom St.
+Denis Tom's Fast Math library.  Many thanks to their kind donation of
+code to the public domain.
+       				   --bbuhrow@gmail.com 11/24/09
+----------------------------------------------------------------------*/
+
+#include "yafu.h"
+#include "qs.h"
+
+#if defined(GCC_ASM64X) || defined(__MINGW64__) || defined(_WIN64)
+	#include <emmintrin.h>
+	#define SSE2_STRIPES
+#endif
+
+#if defined(USE_AVX2)
+	#include <immintrin.h>
+#endif
+
+/*
+the smallest factor base primes hit a block so often that sieving them
+one location at a time costs more than they are worth, so they are left
+out of med_sieve (the small prime variation) and their average
+contribution is folded into the sieve threshold instead.  that
+costs accuracy: we scan more locations that don't pan out, and miss a
+few that would have.
+
+with -siqsSP the primes below a bound are sieved after all, but not
+one at a time.  they are grouped into stripes, and the pattern of a stripe
+repeats with a period equal to the product of its primes.  once per poly
+(and side) we write logp at every root in one period of each stripe's
+pattern.  sieving a block is then just subtracting the patterns from it a
+vector at a time, starting at the block's phase within each period.  the
+patterns are one vector longer than the period so that a load starting
+anywhere in the period never has to wrap.
+*/
+
+void stripe_init(static_conf_t *sconf)
+{
+	fb_list *fb = sconf->factor_base;
+	sieve_stripe_t *stripe = NULL;
+	uint32 bound = sconf->obj->qs_obj.stripe_bound;
+	uint32 i, prime;
+
+	sconf->stripes = (sieve_stripe_t *)xmalloc(
+		QS_MAX_STRIPES * sizeof(sieve_stripe_t));
+	sconf->num_stripes = 0;
+	sconf->stripe_alloc = 0;
+
+	for (i = 2; i < sconf->sieve_small_fb_start; i++)
+	{
+		prime = fb->list->prime[i];
+		if (prime >= bound)
+			break;
+
+		//start a new stripe if this prime won't fit in the current one
+		if ((stripe == NULL) ||
+			(stripe->num_primes == QS_STRIPE_MAX_PRIMES) ||
+			(stripe->period * prime > QS_STRIPE_MAX_PERIOD))
+		{
+			if (sconf->num_stripes == QS_MAX_STRIPES)
+				break;
+
+			stripe = &sconf->stripes[sconf->num_stripes++];
+			stripe->period = 1;
+			stripe->num_primes = 0;
+		}
+
+		stripe->period *= prime;
+		stripe->fb_index[stripe->num_primes++] = i;
+	}
+	sconf->stripe_fb_end = i;
+
+	//lay the patterns out back to back, each on a cache line boundary.
+	//they are built 16 bytes at a time, so leave room to round up
+	for (i = 0; i < sconf->num_stripes; i++)
+	{
+		stripe = &sconf->stripes[i];
+		stripe->offset = sconf->stripe_alloc;
+		sconf->stripe_alloc += (stripe->period + 32 + 63) & (~63);
+	}
+
+	return;
+}
+
+void stripe_build_patterns(static_conf_t *sconf, dynamic_conf_t *dconf)
+{
+	//called after the roots for a new poly are computed.  the roots
+	//of the small primes are not updated block by block, so they
+	//are relative to the start of block 0 on either side.
+	//each stripe's pattern is itself built a vector at a time, as the
+	//sum of the (much shorter) patterns of its primes.
+	fb_list *fb = sconf->factor_base;
+	sieve_fb_compressed *fbc;
+	sieve_stripe_t *stripe;
+	uint8 base[QS_STRIPE_MAX_PRIMES][QS_STRIPE_MAX_PRIME + 32];
+	uint32 phase[QS_STRIPE_MAX_PRIMES];
+	uint32 step[QS_STRIPE_MAX_PRIMES];
+	uint8 *pattern;
+	uint32 i, j, k, x, side, prime, root1, root2, len;
+	uint8 logp;
+
+#ifdef QS_TIMING
+	gettimeofday(&qs_timing_start, NULL);
+#endif
+
+	for (side = 0; side < 2; side++)
+	{
+		if (side == 0)
+			fbc = dconf->comp_sieve_p;
+		else
+			fbc = dconf->comp_sieve_n;
+
+		for (i = 0; i < sconf->num_stripes; i++)
+		{
+			stripe = &sconf->stripes[i];
+			pattern = dconf->stripe_patterns +
+				side * sconf->stripe_alloc + stripe->offset;
+			len = stripe->period + 32;
+
+			for (j = 0; j < stripe->num_primes; j++)
+			{
+				k = stripe->fb_index[j];
+				prime = fb->list->prime[k];
+				logp = (uint8)fb->list->logprime[k];
+				root1 = fbc->root1[k];
+				root2 = fbc->root2[k];
+				if (root1 >= prime)
+					root1 -= prime;
+				if (root2 >= prime)
+					root2 -= prime;
+
+				//primes dividing the multiplier have one root, listed
+				//twice with half the logp, just as med_sieve treats them
+				memset(base[j], 0, prime);
+				base[j][root1] += logp;
+				base[j][root2] += logp;
+				for (x = prime; x < prime + 32; x++)
+					base[j][x] = base[j][x - prime];
+
+				phase[j] = 0;
+				step[j] = 16 % prime;
+			}
+
+#if defined(SSE2_STRIPES)
+			for (x = 0; x < len; x += 16)
+			{
+				__m128i s = _mm_setzero_si128();
+
+				for (j = 0; j < stripe->num_primes; j++)
+				{
+					prime = fb->list->prime[stripe->fb_index[j]];
+					s = _mm_add_epi8(s,
+						_mm_loadu_si128((__m128i *)(base[j] + phase[j])));
+					phase[j] += step[j];
+					if (phase[j] >= prime)
+						phase[j] -= prime;
+				}
+
+				_mm_store_si128((__m128i *)(pattern + x), s);
+			}
+#else
+			memset(pattern, 0, len);
+			for (j = 0; j < stripe->num_primes; j++)
+			{
+				prime = fb->list->prime[stripe->fb_index[j]];
+				for (x = 0; x < len; x++)
+					pattern[x] += base[j][x % prime];
+			}
+#endif
+		}
+	}
+
+#ifdef QS_TIMING
+	gettimeofday (&qs_timing_stop, NULL);
+	qs_timing_diff = my_difftime (&qs_timing_start, &qs_timing_stop);
+	SIEVE_STG3 += ((double)qs_timing_diff->secs + (double)qs_timing_diff->usecs / 1000000);
+	free(qs_timing_diff);
+#endif
+
+	return;
+}
+
+void stripe_sieveblock(uint8 *sieve, uint8 *patterns, static_conf_t *sconf,
+		uint32 bnum)
+{
+	uint8 *pat[QS_MAX_STRIPES];
+	uint32 phase[QS_MAX_STRIPES];
+	uint32 period[QS_MAX_STRIPES];
+	uint32 num_stripes = sconf->num_stripes;
+	uint32 blocksize = sconf->qs_blocksize;
+	uint32 i, j;
+
+	//QS_TIMING: med_sieve restarted the clock on its way out
+
+	for (i = 0; i < num_stripes; i++)
+	{
+		pat[i] = patterns + sconf->stripes[i].offset;
+		period[i] = sconf->stripes[i].period;
+		phase[i] = (bnum << sconf->qs_blockbits) % period[i];
+	}
+
+	//each vector of the block is loaded and stored once, with all of
+	//the stripes subtracted from it in between
+#if defined(USE_AVX2)
+	if (HAS_AVX2)
+	{
+		uint32 step[QS_MAX_STRIPES];
+
+		for (i = 0; i < num_stripes; i++)
+			step[i] = 32 % period[i];
+
+		for (j = 0; j < blocksize; j += 32)
+		{
+			__m256i s = _mm256_load_si256((__m256i *)(sieve + j));
+
+			for (i = 0; i < num_stripes; i++)
+			{
+				s = _mm256_sub_epi8(s,
+					_mm256_loadu_si256((__m256i *)(pat[i] + phase[i])));
+				phase[i] += step[i];
+				if (phase[i] >= period[i])
+					phase[i] -= period[i];
+			}
+
+			_mm256_store_si256((__m256i *)(sieve + j), s);
+		}
+		goto done;
+	}
+#endif
+
+#if defined(SSE2_STRIPES)
+	{
+		uint32 step[QS_MAX_STRIPES];
+
+		for (i = 0; i < num_stripes; i++)
+			step[i] = 16 % period[i];
+
+		for (j = 0; j < blocksize; j += 16)
+		{
+			__m128i s = _mm_load_si128((__m128i *)(sieve + j));
+
+			for (i = 0; i < num_stripes; i++)
+			{
+				s = _mm_sub_epi8(s,
+					_mm_loadu_si128((__m128i *)(pat[i] + phase[i])));
+				phase[i] += step[i];
+				if (phase[i] >= period[i])
+					phase[i] -= period[i];
+			}
+
+			_mm_store_si128((__m128i *)(sieve + j), s);
+		}
+	}
+#else
+	for (i = 0; i < num_stripes; i++)
+	{
+		uint32 p = phase[i];
+
+		for (j = 0; j < blocksize; j++)
+		{
+			sieve[j] -= pat[i][p];
+			if (++p == period[i])
+				p = 0;
+		}
+	}
+#endif
+
+#if defined(USE_AVX2)
+done:
+#endif
+
+#ifdef QS_TIMING
+	gettimeofday (&qs_timing_stop, NULL);
+	qs_timing_diff = my_difftime (&qs_timing_start, &qs_timing_stop);
+	SIEVE_STG3 += ((double)qs_timing_diff->secs + (double)qs_timing_diff->usecs / 1000000);
+	free(qs_timing_diff);
+
+	gettimeofday(&qs_timing_start, NULL);
+#endif
+
+	return;
+}
+
+uint32 stripe_logp(uint8 *patterns, static_conf_t *sconf, uint32 offset)
+{
+	//the total logp the stripes put at a sieve offset (measured from
+	//the start of block 0 on the side the patterns belong to)
+	uint32 i, logp = 0;
+
+	for (i = 0; i < sconf->num_stripes; i++)
+	{
+		sieve_stripe_t *stripe = &sconf->stripes[i];
+
+		logp += patterns[stripe->offset + offset % stripe->period];
+	}
+
+	return logp;
+}
@@ -68,7 +68,7 @@ void trial_divide_Q_siqs(uint32 report_num,  uint8 parity,
 	int smooth_num;
 	uint32 *fb_offsets;
 	uint32 polya_factors[20];
-	sieve_fb *fb;
+	uint32 *fb_primes = sconf->factor_base->list->prime;
 	uint32 offset, block_loc;
 	fb_offsets = &dconf->fb_offsets[report_num][0];
 	smooth_num = dconf->smooth_num[report_num];
@@ -80,11 +80,6 @@ void trial_divide_Q_siqs(uint32 report_num,  uint8 parity,
 
 	offset = (bnum << sconf->qs_blockbits) + block_loc;
 
-	if (parity)
-		fb = dconf->fb_sieve_n;
-	else
-		fb = dconf->fb_sieve_p;
-
 #ifdef USE_YAFU_TDIV
 	z32_to_mpz(&dconf->Qvals32[report_num], dconf->Qvals[report_num]);
 #endif
@@ -96,7 +91,7 @@ void trial_divide_Q_siqs(uint32 report_num,  uint8 parity,
 	{
 		//fbptr = fb + dconf->curr_poly->qlisort[j];
 		//prime = fbptr->prime;
-		prime = fb[dconf->curr_poly->qlisort[j]].prime;
+		prime = fb_primes[dconf->curr_poly->qlisort[j]];
 
 		while ((mpz_tdiv_ui(dconf->Qvals[report_num],prime) == 0) && (it < 20))
 		{
@@ -198,30 +193,44 @@ void trial_divide_Q_siqs(uint32 report_num,  uint8 parity,
 		}
 #else
 
-		dconf->attempted_squfof++;
-		mpz_set_64(dconf->gmptmp1, q64);
-		f64 = sp_shanks_loop(dconf->gmptmp1, sconf->obj);
-		if (f64 > 1 && f64 != q64)
+		if (sconf->batch_size > 0)
 		{
-			uint32 large_prime[2];
-
-			large_prime[0] = (uint32)f64;
-			large_prime[1] = (uint32)(q64 / f64);
+			uint32 large_prime[2] = {1,1};
 
-			if (large_prime[0] < sconf->large_prime_max 
-				&& large_prime[1] < sconf->large_prime_max)
-			{
-				//add this one
-				dconf->dlp_useful++;
-				buffer_relation(offset,large_prime,smooth_num+1,
-					fb_offsets,poly_id,parity,dconf,polya_factors,it);
-			}
-				
+			// leave the residue for a batch smoothness test (batch_smooth.c)
+			// and buffer the relation until then
+			dconf->batch_id[dconf->num_batch] = dconf->buffered_rels;
+			dconf->batch_q[dconf->num_batch++] = q64;
+			buffer_relation(offset,large_prime,smooth_num+1,
+				fb_offsets,poly_id,parity,dconf,polya_factors,it);
 		}
 		else
 		{
-			dconf->failed_squfof++;
-			//printf("squfof failure: %" PRIu64 "\n", q64);
+			dconf->attempted_squfof++;
+			mpz_set_64(dconf->gmptmp1, q64);
+			f64 = sp_shanks_loop(dconf->gmptmp1, sconf->obj);
+			if (f64 > 1 && f64 != q64)
+			{
+				uint32 large_prime[2];
+
+				large_prime[0] = (uint32)f64;
+				large_prime[1] = (uint32)(q64 / f64);
+
+				if (large_prime[0] < sconf->large_prime_max 
+					&& large_prime[1] < sconf->large_prime_max)
+				{
+					//add this one
+					dconf->dlp_useful++;
+					buffer_relation(offset,large_prime,smooth_num+1,
+						fb_offsets,poly_id,parity,dconf,polya_factors,it);
+				}
+					
+			}
+			else
+			{
+				dconf->failed_squfof++;
+				//printf("squfof failure: %" PRIu64 "\n", q64);
+			}
 		}
 #endif
 
@@ -254,9 +263,15 @@ void buffer_relation(uint32 offset, uint32 *large_prime, uint32 num_factors,
 	//first check that this relation won't overflow the buffer
 	if (conf->buffered_rels >= conf->buffered_rel_alloc)
 	{
-		printf("reallocating relation buffer\n");
+		if (VFLAG > 1)
+			printf("growing relation buffer to %u\n", 
+				conf->buffered_rel_alloc * 2);
 		conf->relation_buf = (siqs_r *)realloc(conf->relation_buf, 
 			conf->buffered_rel_alloc * 2 * sizeof(siqs_r));
+		conf->batch_id = (uint32 *)realloc(conf->batch_id, 
+			conf->buffered_rel_alloc * 2 * sizeof(uint32));
+		conf->batch_q = (uint64 *)realloc(conf->batch_q, 
+			conf->buffered_rel_alloc * 2 * sizeof(uint64));
 #ifdef HAVE_CUDA
 		conf->buf_id = (uint32 *)realloc(conf->buf_id, 
 			conf->buffered_rel_alloc * 2 * sizeof(uint32));
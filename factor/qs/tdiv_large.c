@@ -279,7 +279,7 @@ void tdiv_LP(uint32 report_num,  uint8 parity, uint32 bnum,
 	int smooth_num;
 	uint32 *fb_offsets;
 	uint32 *bptr;
-	sieve_fb *fb;
+	uint32 *fb_primes = sconf->factor_base->list->prime;
 	uint32 block_loc;
 	uint16 *mask = dconf->mask;
 
@@ -300,11 +300,6 @@ void tdiv_LP(uint32 report_num,  uint8 parity, uint32 bnum,
 	mask[4] = block_loc;
 	mask[6] = block_loc;
 	
-	if (parity)
-		fb = dconf->fb_sieve_n;
-	else
-		fb = dconf->fb_sieve_p;
-
 	//primes bigger than med_B are bucket sieved, so we need
 	//only search through the bucket and see if any locations match the
 	//current block index.
@@ -339,25 +334,25 @@ void tdiv_LP(uint32 report_num,  uint8 parity, uint32 bnum,
 				if ((bptr[j] & 0x0000ffff) == block_loc)
 				{
 					i = fb_bound + (bptr[j] >> 16);
-					prime = fb[i].prime;
+					prime = fb_primes[i];
 					DIVIDE_ONE_PRIME;
 				}
 				if ((bptr[j+4] & 0x0000ffff) == block_loc)
 				{
 					i = fb_bound + (bptr[j+4] >> 16);
-					prime = fb[i].prime;
+					prime = fb_primes[i];
 					DIVIDE_ONE_PRIME;
 				}
 				if ((bptr[j+8] & 0x0000ffff) == block_loc)
 				{
 					i = fb_bound + (bptr[j+8] >> 16);
-					prime = fb[i].prime;
+					prime = fb_primes[i];
 					DIVIDE_ONE_PRIME;
 				}
 				if ((bptr[j+12] & 0x0000ffff) == block_loc)
 				{
 					i = fb_bound + (bptr[j+12] >> 16);
-					prime = fb[i].prime;
+					prime = fb_primes[i];
 					DIVIDE_ONE_PRIME;
 				}
 			}
@@ -367,25 +362,25 @@ void tdiv_LP(uint32 report_num,  uint8 parity, uint32 bnum,
 				if ((bptr[j+1] & 0x0000ffff) == block_loc)
 				{
 					i = fb_bound + (bptr[j+1] >> 16);
-					prime = fb[i].prime;
+					prime = fb_primes[i];
 					DIVIDE_ONE_PRIME;
 				}
 				if ((bptr[j+5] & 0x0000ffff) == block_loc)
 				{
 					i = fb_bound + (bptr[j+5] >> 16);
-					prime = fb[i].prime;
+					prime = fb_primes[i];
 					DIVIDE_ONE_PRIME;
 				}
 				if ((bptr[j+9] & 0x0000ffff) == block_loc)
 				{
 					i = fb_bound + (bptr[j+9] >> 16);
-					prime = fb[i].prime;
+					prime = fb_primes[i];
 					DIVIDE_ONE_PRIME;
 				}
 				if ((bptr[j+13] & 0x0000ffff) == block_loc)
 				{
 					i = fb_bound + (bptr[j+13] >> 16);
-					prime = fb[i].prime;
+					prime = fb_primes[i];
 					DIVIDE_ONE_PRIME;
 				}
 			}
@@ -395,25 +390,25 @@ void tdiv_LP(uint32 report_num,  uint8 parity, uint32 bnum,
 				if ((bptr[j+2] & 0x0000ffff) == block_loc)
 				{
 					i = fb_bound + (bptr[j+2] >> 16);
-					prime = fb[i].prime;
+					prime = fb_primes[i];
 					DIVIDE_ONE_PRIME;
 				}
 				if ((bptr[j+6] & 0x0000ffff) == block_loc)
 				{
 					i = fb_bound + (bptr[j+6] >> 16);
-					prime = fb[i].prime;
+					prime = fb_primes[i];
 					DIVIDE_ONE_PRIME;
 				}
 				if ((bptr[j+10] & 0x0000ffff) == block_loc)
 				{
 					i = fb_bound + (bptr[j+10] >> 16);
-					prime = fb[i].prime;
+					prime = fb_primes[i];
 					DIVIDE_ONE_PRIME;
 				}
 				if ((bptr[j+14] & 0x0000ffff) == block_loc)
 				{
 					i = fb_bound + (bptr[j+14] >> 16);
-					prime = fb[i].prime;
+					prime = fb_primes[i];
 					DIVIDE_ONE_PRIME;
 				}
 			}
@@ -423,25 +418,25 @@ void tdiv_LP(uint32 report_num,  uint8 parity, uint32 bnum,
 				if ((bptr[j+3] & 0x0000ffff) == block_loc)
 				{
 					i = fb_bound + (bptr[j+3] >> 16);
-					prime = fb[i].prime;
+					prime = fb_primes[i];
 					DIVIDE_ONE_PRIME;
 				}
 				if ((bptr[j+7] & 0x0000ffff) == block_loc)
 				{
 					i = fb_bound + (bptr[j+7] >> 16);
-					prime = fb[i].prime;
+					prime = fb_primes[i];
 					DIVIDE_ONE_PRIME;
 				}
 				if ((bptr[j+11] & 0x0000ffff) == block_loc)
 				{
 					i = fb_bound + (bptr[j+11] >> 16);
-					prime = fb[i].prime;
+					prime = fb_primes[i];
 					DIVIDE_ONE_PRIME;
 				}
 				if ((bptr[j+15] & 0x0000ffff) == block_loc)
 				{
 					i = fb_bound + (bptr[j+15] >> 16);
-					prime = fb[i].prime;
+					prime = fb_primes[i];
 					DIVIDE_ONE_PRIME;
 				}
 			}
@@ -452,7 +447,7 @@ void tdiv_LP(uint32 report_num,  uint8 parity, uint32 bnum,
 			if ((bptr[j] & 0x0000ffff) == block_loc)
 			{
 				i = fb_bound + (bptr[j] >> 16);
-				prime = fb[i].prime;
+				prime = fb_primes[i];
 				//printf("block_loc = %u, bptr = %u, fb_bound = %u, fb_index = %u, prime = %u, Q mod prime = %u\n",
 				//	block_loc, bptr[j].loc, fb_bound, bptr[j].fb_index, prime, zShortMod32(Q,prime));
 				DIVIDE_ONE_PRIME;
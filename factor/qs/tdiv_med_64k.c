@@ -65,7 +65,6 @@ void tdiv_medprimes_64k(uint8 parity, uint32 poly_id, uint32 bnum,
 	uint32 bound, tmp, prime, root1, root2, report_num;
 	int smooth_num;
 	uint32 *fb_offsets;
-	sieve_fb *fb;
 	sieve_fb_compressed *fbc;
 	fb_element_siqs *fullfb_ptr, *fullfb = sconf->factor_base->list;
 	uint32 block_loc;
@@ -81,15 +80,9 @@ void tdiv_medprimes_64k(uint8 parity, uint32 poly_id, uint32 bnum,
 
 	fullfb_ptr = fullfb;
 	if (parity)
-	{
-		fb = dconf->fb_sieve_n;
 		fbc = dconf->comp_sieve_n;
-	}
 	else
-	{
-		fb = dconf->fb_sieve_p;
 		fbc = dconf->comp_sieve_p;
-	}
 
 #ifdef QS_TIMING
 	gettimeofday(&qs_timing_start, NULL);
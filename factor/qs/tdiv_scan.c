@@ -361,6 +361,8 @@ int check_relations_siqs_1(uint32 blocknum, uint8 parity,
 	uint64 mask = SCAN_MASK;
 
 	sieveblock = (uint64 *)dconf->sieve;
+
+rescan:
 	dconf->num_reports = 0;
 
 	//check for relations
@@ -383,7 +385,7 @@ int check_relations_siqs_1(uint32 blocknum, uint8 parity,
 				continue;
 
 			// log this report
-			if (dconf->num_reports < MAX_SIEVE_REPORTS)
+			if (dconf->num_reports < dconf->report_alloc)
 				dconf->reports[dconf->num_reports++] = thisloc;			
 		}
 	}
@@ -394,13 +396,25 @@ int check_relations_siqs_1(uint32 blocknum, uint8 parity,
 	////	exit(-1);
 	//}
 
-	if (dconf->num_reports >= MAX_SIEVE_REPORTS)
-		dconf->num_reports = MAX_SIEVE_REPORTS-1;
+	//if the block filled the report list, make the list bigger and scan
+	//again.  the sieve is untouched until trial division, so this is safe.
+	if ((dconf->num_reports >= dconf->report_alloc) && 
+		(dconf->report_alloc < MAX_SIEVE_REPORTS))
+	{
+		siqs_alloc_reports(dconf, 2 * dconf->report_alloc);
+		goto rescan;
+	}
+
+	if (dconf->num_reports >= dconf->report_alloc)
+		dconf->num_reports = dconf->report_alloc-1;
+
+	if (dconf->num_reports > dconf->max_reports)
+		dconf->max_reports = dconf->num_reports;
 
 	//remove small primes, and test if its worth continuing for each report
 	filter_SPV(parity, dconf->sieve, dconf->numB-1,blocknum,sconf,dconf);
-	tdiv_med_ptr(parity, dconf->numB-1,blocknum,sconf,dconf);
-	resieve_med_ptr(parity, dconf->numB-1,blocknum,sconf,dconf);
+	sconf->tdiv_med_ptr(parity, dconf->numB-1,blocknum,sconf,dconf);
+	sconf->resieve_med_ptr(parity, dconf->numB-1,blocknum,sconf,dconf);
 
 	// factor all reports in this block
 	for (j=0; j<dconf->num_reports; j++)
@@ -425,6 +439,8 @@ int check_relations_siqs_4(uint32 blocknum, uint8 parity,
 	uint64 *sieveblock;
 
 	sieveblock = (uint64 *)dconf->sieve;
+
+rescan:
 	dconf->num_reports = 0;
 
 #ifdef SIMD_SIEVE_SCAN_VEC
@@ -450,7 +466,7 @@ int check_relations_siqs_4(uint32 blocknum, uint8 parity,
 				continue;
 
 			// log this report
-			if (dconf->num_reports < MAX_SIEVE_REPORTS)
+			if (dconf->num_reports < dconf->report_alloc)
 				dconf->reports[dconf->num_reports++] = thisloc;
 		}
 	}
@@ -491,7 +507,7 @@ int check_relations_siqs_4(uint32 blocknum, uint8 parity,
 					continue;
 
 				// log this report
-				if (dconf->num_reports < MAX_SIEVE_REPORTS)
+				if (dconf->num_reports < dconf->report_alloc)
 					dconf->reports[dconf->num_reports++] = thisloc;
 			}
 		}
@@ -529,7 +545,7 @@ int check_relations_siqs_4(uint32 blocknum, uint8 parity,
 					continue;
 
 				// log this report
-				if (dconf->num_reports < MAX_SIEVE_REPORTS)
+				if (dconf->num_reports < dconf->report_alloc)
 					dconf->reports[dconf->num_reports++] = thisloc;
 			}
 		}
@@ -544,13 +560,25 @@ int check_relations_siqs_4(uint32 blocknum, uint8 parity,
 	////	exit(-1);
 	//}
 
-	if (dconf->num_reports >= MAX_SIEVE_REPORTS)
-		dconf->num_reports = MAX_SIEVE_REPORTS-1;
+	//if the block filled the report list, make the list bigger and scan
+	//again.  the sieve is untouched until trial division, so this is safe.
+	if ((dconf->num_reports >= dconf->report_alloc) && 
+		(dconf->report_alloc < MAX_SIEVE_REPORTS))
+	{
+		siqs_alloc_reports(dconf, 2 * dconf->report_alloc);
+		goto rescan;
+	}
+
+	if (dconf->num_reports >= dconf->report_alloc)
+		dconf->num_reports = dconf->report_alloc-1;
+
+	if (dconf->num_reports > dconf->max_reports)
+		dconf->max_reports = dconf->num_reports;
 
 	//remove small primes, and test if its worth continuing for each report
 	filter_SPV(parity, dconf->sieve,dconf->numB-1,blocknum,sconf,dconf);
-	tdiv_med_ptr(parity, dconf->numB-1,blocknum,sconf,dconf);
-	resieve_med_ptr(parity, dconf->numB-1,blocknum,sconf,dconf);
+	sconf->tdiv_med_ptr(parity, dconf->numB-1,blocknum,sconf,dconf);
+	sconf->resieve_med_ptr(parity, dconf->numB-1,blocknum,sconf,dconf);
 
 	// factor all reports in this block
 	for (j=0; j<dconf->num_reports; j++)
@@ -574,6 +602,8 @@ int check_relations_siqs_8(uint32 blocknum, uint8 parity,
 	uint64 *sieveblock;
 
 	sieveblock = (uint64 *)dconf->sieve;
+
+rescan:
 	dconf->num_reports = 0;
 
 #ifdef SIMD_SIEVE_SCAN_VEC
@@ -599,7 +629,7 @@ int check_relations_siqs_8(uint32 blocknum, uint8 parity,
 				continue;
 
 			// log this report
-			if (dconf->num_reports < MAX_SIEVE_REPORTS)
+			if (dconf->num_reports < dconf->report_alloc)
 				dconf->reports[dconf->num_reports++] = thisloc;
 		}
 	}
@@ -640,7 +670,7 @@ int check_relations_siqs_8(uint32 blocknum, uint8 parity,
 					continue;
 
 				// log this report
-				if (dconf->num_reports < MAX_SIEVE_REPORTS)
+				if (dconf->num_reports < dconf->report_alloc)
 					dconf->reports[dconf->num_reports++] = thisloc;
 			}
 		}
@@ -679,7 +709,7 @@ int check_relations_siqs_8(uint32 blocknum, uint8 parity,
 					continue;
 
 				// log this report
-				if (dconf->num_reports < MAX_SIEVE_REPORTS)
+				if (dconf->num_reports < dconf->report_alloc)
 					dconf->reports[dconf->num_reports++] = thisloc;
 			}
 		}
@@ -694,15 +724,27 @@ int check_relations_siqs_8(uint32 blocknum, uint8 parity,
 	////	exit(-1);
 	//}
 
-	if (dconf->num_reports >= MAX_SIEVE_REPORTS)
-		dconf->num_reports = MAX_SIEVE_REPORTS-1;
+	//if the block filled the report list, make the list bigger and scan
+	//again.  the sieve is untouched until trial division, so this is safe.
+	if ((dconf->num_reports >= dconf->report_alloc) && 
+		(dconf->report_alloc < MAX_SIEVE_REPORTS))
+	{
+		siqs_alloc_reports(dconf, 2 * dconf->report_alloc);
+		goto rescan;
+	}
+
+	if (dconf->num_reports >= dconf->report_alloc)
+		dconf->num_reports = dconf->report_alloc-1;
+
+	if (dconf->num_reports > dconf->max_reports)
+		dconf->max_reports = dconf->num_reports;
 
 	//printf("block %d found %d reports\n", blocknum, dconf->num_reports);
 
 	//remove small primes, and test if its worth continuing for each report
 	filter_SPV(parity, dconf->sieve, dconf->numB-1, blocknum,sconf,dconf);
-	tdiv_med_ptr(parity, dconf->numB-1,blocknum,sconf,dconf);
-	resieve_med_ptr(parity, dconf->numB-1,blocknum,sconf,dconf);
+	sconf->tdiv_med_ptr(parity, dconf->numB-1,blocknum,sconf,dconf);
+	sconf->resieve_med_ptr(parity, dconf->numB-1,blocknum,sconf,dconf);
 
 	// factor all reports in this block
 	for (j=0; j<dconf->num_reports; j++)
@@ -727,6 +769,8 @@ int check_relations_siqs_16(uint32 blocknum, uint8 parity,
 	uint64 *sieveblock;
 
 	sieveblock = (uint64 *)dconf->sieve;
+
+rescan:
 	dconf->num_reports = 0;
 
 #ifdef SIMD_SIEVE_SCAN_VEC
@@ -753,7 +797,7 @@ int check_relations_siqs_16(uint32 blocknum, uint8 parity,
 				continue;
 
 			// log this report
-			if (dconf->num_reports < MAX_SIEVE_REPORTS)
+			if (dconf->num_reports < dconf->report_alloc)
 				dconf->reports[dconf->num_reports++] = thisloc;
 		}
 	}
@@ -794,7 +838,7 @@ int check_relations_siqs_16(uint32 blocknum, uint8 parity,
 					continue;
 
 				// log this report
-				if (dconf->num_reports < MAX_SIEVE_REPORTS)
+				if (dconf->num_reports < dconf->report_alloc)
 					dconf->reports[dconf->num_reports++] = thisloc;
 			}
 		}
@@ -835,7 +879,7 @@ int check_relations_siqs_16(uint32 blocknum, uint8 parity,
 					continue;
 
 				// log this report
-				if (dconf->num_reports < MAX_SIEVE_REPORTS)
+				if (dconf->num_reports < dconf->report_alloc)
 					dconf->reports[dconf->num_reports++] = thisloc;
 			}
 		}
@@ -850,13 +894,25 @@ int check_relations_siqs_16(uint32 blocknum, uint8 parity,
 	//	exit(-1);
 	//}
 
-	if (dconf->num_reports >= MAX_SIEVE_REPORTS)
-		dconf->num_reports = MAX_SIEVE_REPORTS-1;
+	//if the block filled the report list, make the list bigger and scan
+	//again.  the sieve is untouched until trial division, so this is safe.
+	if ((dconf->num_reports >= dconf->report_alloc) && 
+		(dconf->report_alloc < MAX_SIEVE_REPORTS))
+	{
+		siqs_alloc_reports(dconf, 2 * dconf->report_alloc);
+		goto rescan;
+	}
+
+	if (dconf->num_reports >= dconf->report_alloc)
+		dconf->num_reports = dconf->report_alloc-1;
+
+	if (dconf->num_reports > dconf->max_reports)
+		dconf->max_reports = dconf->num_reports;
 
 	//remove small primes, and test if its worth continuing for each report
 	filter_SPV(parity, dconf->sieve, dconf->numB-1,blocknum,sconf,dconf);
-	tdiv_med_ptr(parity, dconf->numB-1,blocknum,sconf,dconf);
-	resieve_med_ptr(parity, dconf->numB-1,blocknum,sconf,dconf);
+	sconf->tdiv_med_ptr(parity, dconf->numB-1,blocknum,sconf,dconf);
+	sconf->resieve_med_ptr(parity, dconf->numB-1,blocknum,sconf,dconf);
 
 	// factor all reports in this block
 	for (j=0; j<dconf->num_reports; j++)
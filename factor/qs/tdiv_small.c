@@ -79,7 +79,6 @@ void filter_SPV(uint8 parity, uint8 *sieve, uint32 poly_id, uint32 bnum,
 	int i;
 	uint32 bound, tmp, prime, root1, root2;
 	int smooth_num;
-	sieve_fb *fb;
 	sieve_fb_compressed *fbc;
 	tiny_fb_element_siqs *fullfb_ptr, *fullfb = sconf->factor_base->tinylist;
 	uint8 logp, bits;
@@ -87,15 +86,9 @@ void filter_SPV(uint8 parity, uint8 *sieve, uint32 poly_id, uint32 bnum,
 
 	fullfb_ptr = fullfb;
 	if (parity)
-	{
-		fb = dconf->fb_sieve_n;
 		fbc = dconf->comp_sieve_n;
-	}
 	else
-	{
-		fb = dconf->fb_sieve_p;
 		fbc = dconf->comp_sieve_p;
-	}
 
 	//the minimum value for the current poly_a and poly_b occur at offset (-b + sqrt(N))/a
 	//make it slightly easier for a number to go through full trial division for
@@ -165,6 +158,12 @@ void filter_SPV(uint8 parity, uint8 *sieve, uint32 poly_id, uint32 bnum,
 		bits = sieve[dconf->reports[report_num]];
 		bits = (255 - bits) + sconf->tf_closnuf + 1;
 
+		//the striped primes were sieved, but will be counted again below
+		//as they are divided out.  take out what the patterns put here.
+		if (sconf->num_stripes > 0)
+			bits -= stripe_logp(dconf->stripe_patterns + 
+				parity * sconf->stripe_alloc, sconf, offset);
+
 #ifdef USE_YAFU_TDIV
 		mpz_to_z32(dconf->Qvals[report_num], tmp32);
 
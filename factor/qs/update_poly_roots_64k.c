@@ -243,12 +243,15 @@ void nextRoots_64k(static_conf_t *sconf, dynamic_conf_t *dconf)
 		// boundary before we switch to using update_data.firstroots1/2.
 		// this should only run a few iterations, if any.
 		ptr = &dconf->rootupdates[(v-1) * bound + j];
-		for ( ; j < sconf->factor_base->fb_15bit_B; j++, ptr++)
+		for ( ; j < med_B; j++, ptr++)
 		{
 			prime = update_data.prime[j];
 			root1 = (uint16)update_data.sm_firstroots1[j];
 			root2 = (uint16)update_data.sm_firstroots2[j];
 
+			if ((prime > 32768) && ((j&7) == 0))
+				break;
+
 			COMPUTE_NEXT_ROOTS_P;
 
 			if (root2 < root1)
@@ -278,15 +281,15 @@ void nextRoots_64k(static_conf_t *sconf, dynamic_conf_t *dconf)
 		for ( ; j < med_B; j++, ptr++)
 		{
 			prime = update_data.prime[j];
-			root1 = update_data.firstroots1[j];
-			root2 = update_data.firstroots2[j];
+			root1 = update_data.sm_firstroots1[j];
+			root2 = update_data.sm_firstroots2[j];
 
 			COMPUTE_NEXT_ROOTS_P;
 
 			if (root2 < root1)
 			{
-				update_data.firstroots1[j] = root2;
-				update_data.firstroots2[j] = root1;
+				update_data.sm_firstroots1[j] = (uint16)root2;
+				update_data.sm_firstroots2[j] = (uint16)root1;
 
 				fb_p->root1[j] = (uint16)root2;
 				fb_p->root2[j] = (uint16)root1;
@@ -295,15 +298,15 @@ void nextRoots_64k(static_conf_t *sconf, dynamic_conf_t *dconf)
 			}
 			else
 			{
-				update_data.firstroots1[j] = root1;
-				update_data.firstroots2[j] = root2;
+				update_data.sm_firstroots1[j] = (uint16)root1;
+				update_data.sm_firstroots2[j] = (uint16)root2;
 
 				fb_p->root1[j] = (uint16)root1;
 				fb_p->root2[j] = (uint16)root2;
 				fb_n->root1[j] = (uint16)(prime - root2);
 				fb_n->root2[j] = (uint16)(prime - root1);
 			}
-		}	
+		}
 
 #ifdef QS_TIMING
 		gettimeofday (&qs_timing_stop, NULL);
@@ -1140,12 +1143,15 @@ void nextRoots_64k(static_conf_t *sconf, dynamic_conf_t *dconf)
 		// boundary before we switch to using update_data.firstroots1/2.
 		// this should only run a few iterations, if any.
 		ptr = &dconf->rootupdates[(v-1) * bound + j];
-		for ( ; j < sconf->factor_base->fb_15bit_B; j++, ptr++)
+		for ( ; j < med_B; j++, ptr++)
 		{
 			prime = update_data.prime[j];
 			root1 = (uint16)update_data.sm_firstroots1[j];
 			root2 = (uint16)update_data.sm_firstroots2[j];
 
+			if ((prime > 32768) && ((j&7) == 0))
+				break;
+
 			COMPUTE_NEXT_ROOTS_N;
 
 			if (root2 < root1)
@@ -1175,15 +1181,15 @@ void nextRoots_64k(static_conf_t *sconf, dynamic_conf_t *dconf)
 		for ( ; j < med_B; j++, ptr++)
 		{
 			prime = update_data.prime[j];
-			root1 = update_data.firstroots1[j];
-			root2 = update_data.firstroots2[j];
+			root1 = update_data.sm_firstroots1[j];
+			root2 = update_data.sm_firstroots2[j];
 
 			COMPUTE_NEXT_ROOTS_N;
 
 			if (root2 < root1)
 			{
-				update_data.firstroots1[j] = root2;
-				update_data.firstroots2[j] = root1;
+				update_data.sm_firstroots1[j] = (uint16)root2;
+				update_data.sm_firstroots2[j] = (uint16)root1;
 
 				fb_p->root1[j] = (uint16)root2;
 				fb_p->root2[j] = (uint16)root1;
@@ -1192,8 +1198,8 @@ void nextRoots_64k(static_conf_t *sconf, dynamic_conf_t *dconf)
 			}
 			else
 			{
-				update_data.firstroots1[j] = root1;
-				update_data.firstroots2[j] = root2;
+				update_data.sm_firstroots1[j] = (uint16)root1;
+				update_data.sm_firstroots2[j] = (uint16)root2;
 
 				fb_p->root1[j] = (uint16)root1;
 				fb_p->root2[j] = (uint16)root2;
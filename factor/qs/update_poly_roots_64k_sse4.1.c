@@ -0,0 +1,36 @@
+/*----------------------------------------------------------------------
+This source distribution is placed in the public domain by its author,
+Ben Buhrow. You may use it for any purpose, free of charge,
+without having to notify anyone. I disclaim any responsibility for any
+errors.
+
+Optionally, please be nice and tell me if you find this source to be
+useful. Again optionally, if you add to the functionality present here
+please consider making those additions public too, so that others may 
+benefit from your work.	
+
+Some parts of the code (and also this header), included in this 
+distribution have been reused from other sources. In particular I 
+have benefitted greatly from the work of Jason Papadopoulos's msieve @ 
+www.boo.net/~jasonp, Scott Contini's mpqs implementation, and Tom St. 
+Denis Tom's Fast Math library.  Many thanks to their kind donation of 
+code to the public domain.
+       				   --bbuhrow@gmail.com 11/24/09
+----------------------------------------------------------------------*/
+
+#include "yafu.h"
+#include "qs.h"
+#include "util.h"
+#include "common.h"
+#include "poly_macros_64k.h"
+#include "poly_macros_common.h"
+#include "poly_macros_common_sse4.1.h"
+
+// protect sse41 code under MSVC builds.  USE_SSE41 should be manually
+// enabled at the top of qs.h for MSVC builds on supported hardware
+#ifdef USE_SSE41
+
+#define NEXTROOTS_SSE41 nextRoots_64k_sse41
+#include "update_poly_roots_common_sse4.1.h"
+
+#endif // USE_SSE41
@@ -182,6 +182,8 @@ int free_tiny(static_conf_t *sconf, dynamic_conf_t *dconf)
 	free(sconf->curr_poly);
 	mpz_clear(sconf->curr_a);	
 	free(sconf->modsqrt_array);
+	align_free(sconf->sieve_logp);
+	align_free(sconf->update_logp);
 	align_free(sconf->factor_base->list->prime);
 	align_free(sconf->factor_base->list->small_inv);
 	align_free(sconf->factor_base->list->correction);
@@ -727,12 +729,12 @@ int tiny_static_init(static_conf_t *sconf, mpz_t n)
 	sconf->use_dlp = 0;
 
 	// sieve core functions are fixed
-	firstRoots_ptr = &firstRoots_32k;
-	nextRoots_ptr = &nextRoots_32k;
-	testRoots_ptr = &testfirstRoots_32k;
-	med_sieve_ptr = &med_sieveblock_32k;
-	tdiv_med_ptr = &tdiv_medprimes_32k;
-	resieve_med_ptr = &resieve_medprimes_32k;
+	sconf->firstRoots_ptr = &firstRoots_32k;
+	sconf->nextRoots_ptr = &nextRoots_32k;
+	sconf->testRoots_ptr = &testfirstRoots_32k;
+	sconf->med_sieve_ptr = &med_sieveblock_32k;
+	sconf->tdiv_med_ptr = &tdiv_medprimes_32k;
+	sconf->resieve_med_ptr = &resieve_medprimes_32k;
 	sconf->qs_blocksize = 32768;
 	sconf->qs_blockbits = 15;
 
@@ -823,6 +825,11 @@ int tiny_static_init(static_conf_t *sconf, mpz_t n)
 	}
 	sconf->sieve_small_fb_start = i;
 
+	//tiny jobs don't pattern sieve the small primes
+	sconf->stripes = NULL;
+	sconf->num_stripes = 0;
+	sconf->stripe_fb_end = 2;
+
 	for (; i < sconf->factor_base->B; i++)
 	{
 		//find the point at which factor base primes exceeds 13 bits.  
@@ -946,9 +953,10 @@ int tiny_static_init(static_conf_t *sconf, mpz_t n)
 	sconf->large_prime_max = sconf->pmax * sconf->large_mult;
 
 	//based on the size of the input, determine how to proceed.
-	scan_ptr = &check_relations_siqs_1;
+	sconf->scan_ptr = &check_relations_siqs_1;
 	sconf->scan_unrolling = 8;
 	sconf->use_dlp = 0;
+	sconf->batch_size = 0;
 
 	//'a' values should be as close as possible to sqrt(2n)/M in order to make
 	//values of g_{a,b}(x) as uniform as possible
@@ -1009,6 +1017,9 @@ int tiny_static_init(static_conf_t *sconf, mpz_t n)
 	//no factors so far...
 	sconf->factor_list.num_factors = 0;
 
+	//read-only sieving data
+	siqs_share_fb(sconf);
+
 	return 0;
 }
 
@@ -1039,95 +1050,37 @@ int tiny_dynamic_init(dynamic_conf_t *dconf, static_conf_t *sconf)
 	dconf->relation_buf = (siqs_r *)malloc(32768 * sizeof(siqs_r));
 	dconf->buffered_rel_alloc = 32768;
 	dconf->buffered_rels = 0;
+	dconf->batch_q = NULL;
+	dconf->batch_id = NULL;
+	dconf->num_batch = 0;
 
 	//allocate the sieving factor bases
 	dconf->comp_sieve_p = (sieve_fb_compressed *)malloc(sizeof(sieve_fb_compressed));
 	dconf->comp_sieve_n = (sieve_fb_compressed *)malloc(sizeof(sieve_fb_compressed));
-
-	dconf->comp_sieve_p->prime = (uint16 *)xmalloc_align(
-		(size_t)(sconf->factor_base->med_B * sizeof(uint16)));
-	dconf->comp_sieve_p->root1 = (uint16 *)xmalloc_align(
-		(size_t)(sconf->factor_base->med_B * sizeof(uint16)));
-	dconf->comp_sieve_p->root2 = (uint16 *)xmalloc_align(
-		(size_t)(sconf->factor_base->med_B * sizeof(uint16)));
-	dconf->comp_sieve_p->logp = (uint16 *)xmalloc_align(
-		(size_t)(sconf->factor_base->med_B * sizeof(uint16)));
-
-	dconf->comp_sieve_n->prime = (uint16 *)xmalloc_align(
-		(size_t)(sconf->factor_base->med_B * sizeof(uint16)));
-	dconf->comp_sieve_n->root1 = (uint16 *)xmalloc_align(
-		(size_t)(sconf->factor_base->med_B * sizeof(uint16)));
-	dconf->comp_sieve_n->root2 = (uint16 *)xmalloc_align(
-		(size_t)(sconf->factor_base->med_B * sizeof(uint16)));
-	dconf->comp_sieve_n->logp = (uint16 *)xmalloc_align(
-		(size_t)(sconf->factor_base->med_B * sizeof(uint16)));
-
-	dconf->fb_sieve_p = (sieve_fb *)xmalloc_align(
-		(size_t)(sconf->factor_base->B * sizeof(sieve_fb)));
-	dconf->fb_sieve_n = (sieve_fb *)xmalloc_align(
-		(size_t)(sconf->factor_base->B * sizeof(sieve_fb)));
-	
-	dconf->update_data.sm_firstroots1 = (uint16 *)xmalloc_align(
-		(size_t)(sconf->factor_base->med_B * sizeof(uint16)));
-	dconf->update_data.sm_firstroots2 = (uint16 *)xmalloc_align(
-		(size_t)(sconf->factor_base->med_B * sizeof(uint16)));
-	dconf->update_data.firstroots1 = (int *)xmalloc_align(
-		(size_t)(sconf->factor_base->B * sizeof(int)));
-	dconf->update_data.firstroots2 = (int *)xmalloc_align(
-		(size_t)(sconf->factor_base->B * sizeof(int)));
-	dconf->update_data.prime = (uint32 *)xmalloc_align(
-		(size_t)(sconf->factor_base->B * sizeof(uint32)));
-	dconf->update_data.logp = (uint8 *)xmalloc_align(
-		(size_t)(sconf->factor_base->B * sizeof(uint8)));
+	dconf->comp_sieve_p->logp = sconf->sieve_logp;
+	dconf->comp_sieve_n->logp = sconf->sieve_logp;
+	dconf->update_data.prime = sconf->factor_base->list->prime;
+	dconf->update_data.logp = sconf->update_logp;
 	dconf->rootupdates = (int *)xmalloc_align(
 		(size_t)(MAX_A_FACTORS * sconf->factor_base->B * sizeof(int)));
 	dconf->sm_rootupdates = (uint16 *)xmalloc_align(
 		(size_t)(MAX_A_FACTORS * sconf->factor_base->B * sizeof(uint16)));
+	dconf->rootupdate_rows = MAX_A_FACTORS;
 	
-	//allocate the sieve
-	dconf->sieve = (uint8 *)xmalloc_align(
-		(size_t) (sconf->qs_blocksize * sizeof(uint8)));
-
 	//allocate the Bl array, space for MAX_Bl bigint numbers
 	dconf->Bl = (mpz_t *)malloc(MAX_A_FACTORS * sizeof(mpz_t));
 	for (i=0;i<MAX_A_FACTORS;i++)
 		mpz_init(dconf->Bl[i]);
 
-	//copy the unchanging part to the sieving factor bases
-	for (i = 2; i < sconf->factor_base->med_B; i++)
-	{
-		uint32 p = sconf->factor_base->list->prime[i];
-		uint32 lp = sconf->factor_base->list->logprime[i];
-
-		dconf->comp_sieve_p->logp[i] = (uint8)lp;
-		dconf->comp_sieve_p->prime[i] = (uint16)p;
-		dconf->comp_sieve_n->logp[i] = (uint8)lp;
-		dconf->comp_sieve_n->prime[i] = (uint16)p;
-
-		dconf->fb_sieve_p[i].prime = p;
-		dconf->fb_sieve_p[i].logprime = lp;
-		dconf->fb_sieve_n[i].prime = p;
-		dconf->fb_sieve_n[i].logprime = lp;
-		dconf->update_data.prime[i] = p;
-		dconf->update_data.logp[i] = lp;
-	}
-
-	for (; i < sconf->factor_base->B; i++)
-	{
-		dconf->fb_sieve_p[i].prime = sconf->factor_base->list->prime[i];
-		dconf->fb_sieve_p[i].logprime = sconf->factor_base->list->logprime[i];
-		dconf->fb_sieve_n[i].prime = sconf->factor_base->list->prime[i];
-		dconf->fb_sieve_n[i].logprime = sconf->factor_base->list->logprime[i];
-		dconf->update_data.prime[i] = sconf->factor_base->list->prime[i];
-		dconf->update_data.logp[i] = sconf->factor_base->list->logprime[i];
-	}
-
 	// we will not be using bucket sieving
 	dconf->buckets = (lp_bucket *)malloc(sizeof(lp_bucket));
-	dconf->buckets->list = NULL;
 	dconf->buckets->alloc_slices = 0;
 	dconf->buckets->num_slices = 0;
 
+	//allocate the sieve and roots.  tiny jobs are far too small for
+	//huge pages to be worth it.
+	siqs_alloc_sieve_arrays(sconf, dconf, 0);
+
 	//used in trial division to mask out the fb_index portion of bucket entries, so that
 	//multiple block locations can be searched for in parallel using SSE2 instructions
 	dconf->mask = (uint16 *)xmalloc_align(8 * sizeof(uint16));
@@ -1142,22 +1095,19 @@ int tiny_dynamic_init(dynamic_conf_t *dconf, static_conf_t *sconf)
 #endif
 
 	// array of sieve locations scanned from the sieve block that we
-	// will submit to trial division.  make it the size of a sieve block 
-	// in the pathological case that every sieve location is a report
-	dconf->reports = (uint32 *)malloc(MAX_SIEVE_REPORTS * sizeof(uint32));
-	dconf->num_reports = 0;
-		
+	// will submit to trial division, grown by the scanner as needed
+	dconf->reports = NULL;
 #ifdef USE_YAFU_TDIV
-	dconf->Qvals32 = (z32 *)malloc(MAX_SIEVE_REPORTS * sizeof(z32));
-	for (i=0; i<MAX_SIEVE_REPORTS; i++)
-		zInit32(&dconf->Qvals32[i]);
+	dconf->Qvals32 = NULL;
 #endif
-	dconf->Qvals = (mpz_t *)malloc(MAX_SIEVE_REPORTS * sizeof(mpz_t));
-	for (i=0; i<MAX_SIEVE_REPORTS; i++)
-		mpz_init(dconf->Qvals[i]);
-
-	dconf->valid_Qs = (int *)malloc(MAX_SIEVE_REPORTS * sizeof(int));
-	dconf->smooth_num = (int *)malloc(MAX_SIEVE_REPORTS * sizeof(int));
+	dconf->Qvals = NULL;
+	dconf->valid_Qs = NULL;
+	dconf->smooth_num = NULL;
+	dconf->fb_offsets = NULL;
+	dconf->report_alloc = 0;
+	dconf->max_reports = 0;
+	siqs_alloc_reports(dconf, QS_INIT_REPORTS);
+	dconf->num_reports = 0;
 
 	//initialize some counters
 	dconf->tot_poly = 0;		//track total number of polys
@@ -1200,7 +1150,7 @@ void *tiny_process_poly(void *ptr)
 	dconf->numB = 1;
 	computeBl(sconf,dconf);
 
-	firstRoots_ptr(sconf,dconf);
+	sconf->firstRoots_ptr(sconf,dconf);
 
 	//loop over each possible b value, for the current a value
 	for ( ; dconf->numB < dconf->maxB; dconf->numB++, dconf->tot_poly++)
@@ -1215,24 +1165,24 @@ void *tiny_process_poly(void *ptr)
 			//set the roots for the factors of a such that
 			//they will not be sieved.  we haven't found roots for them
 			set_aprime_roots(sconf, invalid_root_marker, poly->qlisort, poly->s, fb_sieve_p, 1);
-			med_sieve_ptr(sieve, fb_sieve_p, fb, start_prime, blockinit);
+			sconf->med_sieve_ptr(sieve, fb_sieve_p, fb, start_prime, blockinit);
 			lp_sieveblock(sieve, i, num_blocks, buckets, 0);
 
 			//set the roots for the factors of a to force the following routine
 			//to explicitly trial divide since we haven't found roots for them
 			set_aprime_roots(sconf, invalid_root_marker, poly->qlisort, poly->s, fb_sieve_p, 0);
-			scan_ptr(i,0,sconf,dconf);
+			sconf->scan_ptr(i,0,sconf,dconf);
 
 			//set the roots for the factors of a such that
 			//they will not be sieved.  we haven't found roots for them
 			set_aprime_roots(sconf, invalid_root_marker, poly->qlisort, poly->s, fb_sieve_n, 1);
-			med_sieve_ptr(sieve, fb_sieve_n, fb, start_prime, blockinit);
+			sconf->med_sieve_ptr(sieve, fb_sieve_n, fb, start_prime, blockinit);
 			lp_sieveblock(sieve, i, num_blocks, buckets, 1);
 
 			//set the roots for the factors of a to force the following routine
 			//to explicitly trial divide since we haven't found roots for them
 			set_aprime_roots(sconf, invalid_root_marker, poly->qlisort, poly->s, fb_sieve_n, 0);
-			scan_ptr(i,1,sconf,dconf);			
+			sconf->scan_ptr(i,1,sconf,dconf);			
 
 		}
 
@@ -1240,7 +1190,7 @@ void *tiny_process_poly(void *ptr)
 		//use the stored Bl's and the gray code to find the next b
 		nextB(dconf,sconf);
 		//and update the roots
-		nextRoots_ptr(sconf, dconf);
+		sconf->nextRoots_ptr(sconf, dconf);
 
 	}
 
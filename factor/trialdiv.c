@@ -32,6 +32,8 @@ void zTrial(fact_obj_t *fobj)
 	int print = fobj->div_obj.print;
 	FILE *flog;
 	fp_digit q;
+	uint64 *primes;
+	uint64 num_p;
 	mpz_t tmp;
 	mpz_init(tmp);
 
@@ -43,19 +45,13 @@ void zTrial(fact_obj_t *fobj)
 		return;
 	}
 
-	if (P_MAX < limit)
-	{
-		free(PRIMES);
-		PRIMES = soe_wrapper(spSOEprimes, szSOEp, 0, limit, 0, &NUM_P);
-		P_MIN = PRIMES[0];
-		P_MAX = PRIMES[NUM_P-1];
-	}
+	primes = get_prime_cache(limit, &num_p);
 
 	while ((mpz_cmp_ui(fobj->div_obj.gmp_n, 1) > 0) && 
-		(PRIMES[k] < limit) && 
-		(k < (uint32)NUM_P))
+		(k < (uint32)num_p) &&
+		(primes[k] < limit))
 	{
-		q = (fp_digit)PRIMES[k];
+		q = (fp_digit)primes[k];
 		r = mpz_tdiv_ui(fobj->div_obj.gmp_n, q);
 		
 		if (r != 0)
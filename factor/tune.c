@@ -34,7 +34,7 @@ void factor_tune(fact_obj_t *inobj)
 	char siqslist[9][200];
 	char nfslist[6][200];
 	z n;
-	int i, tmpT;
+	int i;
 	struct timeval stop;	// stop time of this job
 	struct timeval start;	// start time of this job
 	TIME_DIFF *	difference;
@@ -60,11 +60,8 @@ void factor_tune(fact_obj_t *inobj)
 
 	zInit(&n);	
 
-	tmpT = THREADS;
-
-	if (THREADS != 1)
+	if (inobj->num_threads != 1)
 		printf("Setting THREADS = 1 for tuning\n");
-	THREADS = 1;
 
 	//siqs: start with c60, increment by 5 digits, up to a c100
 	//this will allow determination of NFS/QS crossover as well as provide enough
@@ -94,6 +91,7 @@ void factor_tune(fact_obj_t *inobj)
 	{
 		fact_obj_t *fobj = (fact_obj_t *)malloc(sizeof(fact_obj_t));
 		init_factobj(fobj);		
+		fobj->num_threads = 1;
 
 		//measure how long it takes to gather a fixed number of relations 		
 		str2hexz(siqslist[i],&n);
@@ -209,9 +207,6 @@ void factor_tune(fact_obj_t *inobj)
 		
 	}
 
-	// set THREADS back the way it was
-	THREADS = tmpT;
-
 	fit = best_linear_fit(gnfs_sizes, gnfs_extraptime, NUM_GNFS_PTS, &a2, &b2);
 	printf("best linear fit is ln(y) = %g * x + %g\nR^2 = %g\n",a2,b2,fit);
 	printf("best exponential fit is y = %g * exp(%g * x)\n",pow(BASE_e,b2),a2);
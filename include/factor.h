@@ -292,6 +292,9 @@ typedef struct
 
 	char ecm_path[1024];
 	int use_external;
+	int use_tinyecm;			//small input, run the built-in ecm
+	struct tinyecm_plan *tiny_plan;	//built-in ecm's stage 1/2 setup for this run
+	int num_threads;			//threads used by the current run
 	uint32 B1;
 	uint64 B2;
 	int stg2_is_default;
@@ -355,6 +358,11 @@ typedef struct
 	double qs_multiplier;
 	double qs_tune_freq;
 	int no_small_cutoff_opt;	//1 is true - perform no optimization.  0 is false.
+	uint32 mult_test;			//test sieve this many of the best multipliers (0 = off)
+	uint32 stripe_bound;		//pattern sieve factor base primes below this (0 = off)
+	uint32 mem_budget;			//MB of memory siqs sieving may use (0 = no limit)
+	uint32 hugepages;			//back the hot sieve arrays with 2MB pages (1 = yes)
+	uint32 batch_size;			//dlp residues per batch smoothness test (0 = off)
 
 	int gbl_override_B_flag;
 	uint32 gbl_override_B;			//override the # of factor base primes
@@ -366,6 +374,8 @@ typedef struct
 	uint32 gbl_override_rel;		//stop after collecting this many relations
 	int gbl_override_blocks_flag;
 	uint32 gbl_override_blocks;		//override the # of blocks used
+	int gbl_override_blocksize_flag;
+	uint32 gbl_override_blocksize;	//override the sieve block size (32 or 64 kB)
 	int gbl_override_lpmult_flag;
 	uint32 gbl_override_lpmult;		//override the large prime multiplier
 	int gbl_force_DLP;
@@ -404,6 +414,7 @@ typedef struct
 	char fbfile[GSTR_MAXSIZE];
 	uint32 timeout;
 	char job_infile[GSTR_MAXSIZE];
+	char cachefile[GSTR_MAXSIZE];	// cache of finished jobs, "" if disabled
 	int poly_option;
 	int restart_flag;
 	uint32 polybatch;
@@ -472,9 +483,19 @@ typedef struct
 	int only_pretest;
 	int autofact_active;
 
+	// run pm1/pp1 in a helper thread while ecm uses the rest
+	int portfolio;
+	// set in the private object of such a helper, which must leave the
+	// SIGINT handler to the main thread
+	int portfolio_helper;
+
 	// user supplied value indicating prior pretesting work
 	double initial_work;
 
+	// record of pm1/pp1/ecm progress, for resuming an interrupted factor()
+	char pretest_savefile[1024];
+	void *active_work;			// factor_work_t of the running factor(), if any
+
 	double ttime;
 
 } autofact_obj_t;
@@ -523,8 +544,25 @@ typedef struct
 	int do_logging;
 	int refactor_depth;
 
+	// ecm, pm1 and pp1 give up once *stop is set; factor()'s portfolio
+	// ends a round that way at the first split.  stop points to stop_flag,
+	// except in the portfolio helpers, which share their job's flag.
+	volatile int stop_flag;
+	volatile int *stop;
+
+	// the job is abandoned once abort is set (by the caller), or once 
+	// SIGINT_COUNT moves past sigint_mark (see fobj_aborted)
+	volatile int abort;
+	int sigint_mark;
+
 } fact_obj_t;
 
+// a ctrl-c aborts every job in the process.  the SIGINT handlers only
+// count it, so jobs running concurrently don't reset each other's state.
+volatile int SIGINT_COUNT;
+void fobj_watch_sigint(fact_obj_t *fobj);
+int fobj_aborted(fact_obj_t *fobj);
+
 void init_factobj(fact_obj_t *fobj);
 void free_factobj(fact_obj_t *fobj);
 void reset_factobj(fact_obj_t *fobj);
@@ -600,6 +638,8 @@ void spfactorlist(uint64 nstart, uint64 nrange);
 
 //auto factor routine
 void factor(fact_obj_t *fobj);
+void checkpoint_pretest_work(fact_obj_t *fobj, int curves_run);
+double get_gnfs_time_estimate(fact_obj_t *fobj, mpz_t b);
 
 // factoring related utility
 int resume_check_input_match(mpz_t file_n, mpz_t input_n, mpz_t common_fact);
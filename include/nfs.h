@@ -119,9 +119,24 @@ typedef struct
 	enum special_q_e side;
 } mpz_polys_t;
 
+// scores for a polynomial pair, computed in memory by nfs_score_poly
+typedef struct
+{
+	double size;	// murphy E with both alphas taken as zero
+	double alpha;	// algebraic side root property
+	double murphy;	// murphy E
+	int rroots;		// real roots of the algebraic poly
+} nfs_polyscore_t;
+
 #define NUM_SNFS_POLYS 3
 #define MAX_SNFS_BITS 1024
 
+// -siever value selecting the in-process lattice siever (nfs_lasieve.c),
+// which is also used when the ggnfs binaries can't be found for inputs
+// up to NFS_BUILTIN_MAXDIGITS digits
+#define NFS_BUILTIN_SIEVER 1
+#define NFS_BUILTIN_MAXDIGITS 120
+
 typedef struct
 {
 	// input integer
@@ -153,6 +168,40 @@ typedef struct
 	int siever;
 } snfs_t;
 
+typedef struct
+{
+	// running tally of the relations in the .dat file, kept up to date
+	// as sieving output is appended, so that we can guess whether
+	// filtering will succeed without running it.
+
+	// unique relations, as a hash set of (a,b)
+	uint64 *rel_hash;
+	uint32 rel_hash_size;			// power of 2
+	uint32 num_rels;
+	uint32 num_dups;
+	uint32 num_bad;
+
+	// distinct large ideals (prime above the factor base bound), 
+	// as a hash map from ideal to index, and the number of unique 
+	// relations each one appears in
+	uint32 *ideal_hash;				// index + 1, or 0 if empty
+	uint32 ideal_hash_size;			// power of 2
+	uint64 *ideal_keys;
+	uint32 *ideal_counts;
+	uint32 num_ideals;
+	uint32 alloc_ideals;
+
+	// the large ideals of each unique relation, back to back
+	uint8 *rel_num_ideals;
+	uint32 alloc_rels;
+	uint32 *rel_ideals;
+	uint32 num_rel_ideals;
+	uint32 alloc_rel_ideals;
+
+	uint32 filtmin_r, filtmin_a;
+	uint32 small_ideals;			// approx. number of ideals below the bounds
+} nfs_relstats_t;
+
 typedef struct
 {
 	mpz_polys_t* poly; // the idea is that job->snfs->poly == job->poly
@@ -168,6 +217,12 @@ typedef struct
 	uint32 poly_time;
 	uint32 last_leading_coeff;
 	uint32 use_max_rels;
+	nfs_relstats_t *relstats; // NULL until sieving or filtering starts
+
+	// sieving feedback (nfs_adapt_batch)
+	uint32 base_qrange;		// q-range from the parameter table
+	double first_yield;		// rels/q of the first batch on this side
+	int side_switched;		// at most once per job, kept in the job file
 
 	snfs_t* snfs; // NULL if GNFS
 } nfs_job_t;
@@ -223,6 +278,9 @@ void ggnfs_to_msieve(fact_obj_t *fobj, nfs_job_t *job);
 void get_ggnfs_params(fact_obj_t *fobj, nfs_job_t *job);
 int check_for_sievers(fact_obj_t *fobj, int revert_to_siqs);
 void print_poly(mpz_polys_t* poly, FILE *out);
+int parse_poly_line(char *line, mpz_polys_t *poly);
+int read_job_poly(char *filename, mpz_polys_t *poly);
+void update_job_side(fact_obj_t *fobj, nfs_job_t *job);
 void print_job(nfs_job_t *job, FILE *out);
 uint32 parse_job_file(fact_obj_t *fobj, nfs_job_t *job);
 void fill_job_file(fact_obj_t *fobj, nfs_job_t *job, uint32 missing_params);
@@ -236,9 +294,15 @@ void get_polysearch_params(fact_obj_t *fobj, uint64 *start, uint64 *range);
 void init_poly_threaddata(nfs_threaddata_t *t, msieve_obj *obj, 
 	mp_t *mpN, factor_list_t *factor_list, int tid, uint32 flags, uint64 start, uint64 stop);
 void do_sieving(fact_obj_t *fobj, nfs_job_t *job);
+void nfs_adapt_batch(fact_obj_t *fobj, nfs_job_t *job, uint32 batch_rels,
+	uint32 batch_q, double batch_time);
 void trial_sieve(fact_obj_t* fobj); // external test sieve frontend
 int test_sieve(fact_obj_t* fobj, void* args, int njobs, int are_files);
-void savefile_concat(char *filein, char *fileout, msieve_obj *mobj);
+uint32 nfs_lasieve(fact_obj_t *fobj, nfs_job_t *job, uint32 startq, uint32 qrange,
+	char *outfile);
+int nfs_cache_lookup(fact_obj_t *fobj, nfs_job_t *job);
+void nfs_cache_store(fact_obj_t *fobj, nfs_job_t *job, mpz_t n, double yield, uint32 rels);
+void savefile_concat(char *filein, char *fileout, msieve_obj *mobj, nfs_relstats_t *stats);
 void win_file_concat(char *filein, char *fileout);
 void nfs_stop_worker_thread(nfs_threaddata_t *t,
 				uint32 is_master_thread);
@@ -264,6 +328,7 @@ void snfs_copy_poly(snfs_t *src, snfs_t *dest);
 void approx_norms(snfs_t *poly);
 void snfs_scale_difficulty(snfs_t *polys, int npoly);
 int snfs_rank_polys(fact_obj_t *fobj, snfs_t *polys, int npoly);
+void snfs_score_polys(fact_obj_t *fobj, snfs_t *polys, int npoly);
 int qcomp_snfs_sdifficulty(const void *x, const void *y);
 int qcomp_snfs_murphy(const void *x, const void *y);
 nfs_job_t *snfs_test_sieve(fact_obj_t *fobj, snfs_t *polys, int npoly, nfs_job_t *jobs);
@@ -273,9 +338,15 @@ void snfs_clear(snfs_t* poly);
 void skew_snfs_params(fact_obj_t *fobj, nfs_job_t *job);
 void find_primitive_factor(snfs_t *poly);
 void nfs_set_min_rels(nfs_job_t *job);
+nfs_relstats_t *nfs_relstats_load(fact_obj_t *fobj, nfs_job_t *job);
+void nfs_relstats_free(nfs_relstats_t *s);
+int nfs_relstats_add(nfs_relstats_t *s, char *line);
+int64 nfs_relstats_excess(nfs_relstats_t *s, uint32 *rels_left, uint32 *ideals_left);
 void copy_job(nfs_job_t *src, nfs_job_t *dest);
 void copy_mpz_polys_t(mpz_polys_t *src, mpz_polys_t *dest);
 void analyze_one_poly_xface(snfs_t *poly);
+void nfs_polyscore_init(void);
+void nfs_score_poly(mpz_polys_t *poly, nfs_polyscore_t *score);
 int est_gnfs_size(nfs_job_t *job);
 int est_gnfs_size_via_poly(snfs_t *job);
 snfs_t * snfs_find_form(fact_obj_t *fobj);
@@ -69,6 +69,7 @@ double POLY_STG3;
 double POLY_STG4;
 double SIEVE_STG1;
 double SIEVE_STG2;
+double SIEVE_STG3;
 double COUNT;
 double TF_SPECIAL;
 #endif
@@ -78,9 +79,12 @@ double TF_SPECIAL;
 
 #define MAX_SMOOTH_PRIMES 100	//maximum number of factors for a smooth, including duplicates
 #define MAX_SIEVE_REPORTS 2048
+#define QS_INIT_REPORTS 256		//report buffers start here and double as needed, up to MAX_SIEVE_REPORTS
+#define QS_INIT_RELATION_BUF 2048	//per-thread relation buffers start here and double as needed
 #define MIN_FB_OFFSET 1
 #define NUM_EXTRA_QS_RELATIONS 64
 #define MAX_A_FACTORS 20
+#define GRAY_CODE_ALLOC 65536	//entries in a poly's gray code and nu arrays
 //hold all the elements in a bucket of large primes
 //1 bucket = 1 block
 #define BUCKET_ALLOC 2048
@@ -284,6 +288,38 @@ typedef struct
 
 #define QS_LOG2_CYCLE_HASH 22
 
+/* seconds between snapshots of the cycle graph written next to
+   the savefile (see siqs_write_checkpoint) */
+#define QS_CHECKPOINT_INTERVAL 300
+
+/* a new poly 'a' may share at most s-2 of its s factors with any
+   previous 'a'.  After this many rejections in a row that rule is
+   dropped for the current 'a' and only exact duplicates are refused */
+#define QS_MAX_A_REJECTS 10000
+
+/* of this many poly 'a' candidates that pass the checks above, keep
+   the one sharing the fewest factors with the previous 'a', and of
+   those the one closest to target_a */
+#define QS_A_CANDIDATES 4
+
+/* with -siqsSP, factor base primes below the given bound (at most
+   QS_STRIPE_MAX_PRIME) are sieved by subtracting a periodic byte pattern 
+   from each block (see stripe_sieve.c).  They are grouped into at most 
+   QS_MAX_STRIPES stripes, each holding primes whose product is no more 
+   than QS_STRIPE_MAX_PERIOD */
+#define QS_STRIPE_MAX_PRIME 64
+#define QS_STRIPE_MAX_PERIOD 32768
+#define QS_STRIPE_MAX_PRIMES 8
+#define QS_MAX_STRIPES 8
+
+typedef struct
+{
+	uint32 period;				// product of the primes in the stripe
+	uint32 offset;				// of its pattern in the pattern buffer
+	uint32 num_primes;
+	uint32 fb_index[QS_STRIPE_MAX_PRIMES];
+} sieve_stripe_t;
+
 typedef struct {
 	uint32 next;
 	uint32 prime;
@@ -291,7 +327,9 @@ typedef struct {
 	uint32 count;
 } qs_cycle_t;
 
-typedef struct {
+struct dynamic_conf;
+
+typedef struct static_conf {
 	fact_obj_t *obj;			// passed in with info from 'outside'
 
 	// the stuff in this structure is written once, then is read only
@@ -303,11 +341,19 @@ typedef struct {
 
 	uint32 *modsqrt_array;		// a square root of n mod each FB prime
 	uint32 multiplier;			// small multiplier for n (may be composite) 
+	uint32 forced_multiplier;	// if nonzero, use this multiplier instead of choosing one
 	mpz_t n;					// the number to factor (scaled by multiplier)
 	mpz_t sqrt_n;				// sqrt of n
 	fb_list *factor_base;       // the factor base to use
 	uint32 num_sieve_blocks;	// number of sieve blocks in sieving interval
 	uint32 sieve_small_fb_start;// starting FB offset for sieving
+	sieve_stripe_t *stripes;	// smallest primes, sieved by pattern
+	uint32 num_stripes;
+	uint32 stripe_fb_end;		// FB offset past the last striped prime
+	uint32 stripe_alloc;		// bytes of patterns for one side
+	uint16 *sieve_logp;			// read-only parts of the sieving factor base,
+	uint8 *update_logp;			// shared by every thread
+	uint32 num_arenas;			// dynamic confs set up so far, to color their arenas
 	mpz_t target_a;				// optimal value of 'a' 
 
 	double fudge_factor;		// used to compute the closnuf value
@@ -343,6 +389,21 @@ typedef struct {
 	uint64 max_fb2;					// the square of the largest factor base prime 
 	uint64 large_prime_max2;			// the cutoff value for factoring partials 
 
+	//batch smoothness testing of dlp residues (see batch_smooth.c)
+	uint32 batch_size;			// residues per batch (0 = squfof each one as found)
+	int batch_ready;			// batch_prod has been computed
+	mpz_t batch_prod;			// product of the primes between pmax and large_prime_max
+	siqs_r *batch_rels;			// relations waiting on their residue's test,
+	uint64 *batch_q;			// the residues,
+	uint32 *batch_group;		// and the poly a each relation belongs to
+	uint32 num_batch;
+	uint32 batch_alloc;
+	mpz_t *batch_a;				// poly a values of the waiting relations
+	uint32 num_batch_a;
+	uint32 batch_a_alloc;
+	uint32 batch_tested;		// residues tested so far
+	uint32 batch_smooth;		// and those that were large_prime_max smooth
+
 	//master list of cycles
 	qs_cycle_t *cycle_table;		/* list of all the vertices in the graph */
 	uint32 cycle_table_size;	/* number of vertices filled in the table */
@@ -364,6 +425,8 @@ typedef struct {
 	uint32 last_numfull;		// relations found since the last update as a guide
 	uint32 last_numpartial;		// to when to assess the situation
 	uint32 last_numcycles;		// used in computing rels/sec
+	struct timeval checkpoint_start;	// time at which we last wrote a restart checkpoint
+	uint32 num_discarded;		// savefile relations dropped on restart (large primes too small)
 	uint32 num_needed;
 	uint32 num_expected;
 	int charcount;				// characters on the screen
@@ -386,6 +449,13 @@ typedef struct {
 	//these are used during linear algebra and sqrt root
 	uint32 total_poly_a;		// total number of polynomial 'a' values 
 	mpz_t *poly_a_list;			// list of 'a' values for MPQS polys 
+	uint64 *a_hash_table;		// fingerprints of the factor sets of used 'a's
+	uint32 a_hash_alloc;		// and of each subset missing one factor
+	uint32 a_hash_count;
+	uint32 num_a_hashed;		// poly_a_list entries already in the table
+	uint32 num_a_rejected;		// 'a's rejected as too close to a previous one
+	int last_a_qli[MAX_A_FACTORS];	// sorted factor indices of the last 'a'
+	int last_a_s;
 	poly_t *poly_list;			// list of MPQS polynomials 
 	uint32 poly_list_alloc; 
 	uint32 apoly_alloc;
@@ -401,6 +471,18 @@ typedef struct {
 	int is_tiny;
 	int in_mem;
 
+	// sieve core routines for this job, chosen at init time according
+	// to cpu capability and the size of the job
+	void (*firstRoots_ptr)(struct static_conf *, struct dynamic_conf *);
+	void (*nextRoots_ptr)(struct static_conf *, struct dynamic_conf *);
+	void (*testRoots_ptr)(struct static_conf *, struct dynamic_conf *);
+	void (*med_sieve_ptr)(uint8 *, sieve_fb_compressed *, fb_list *, uint32 , uint8 );
+	int (*scan_ptr)(uint32, uint8, struct static_conf *, struct dynamic_conf *);
+	void (*tdiv_med_ptr)(uint8 , uint32 , uint32 , 
+		struct static_conf *, struct dynamic_conf *);
+	void (*resieve_med_ptr)(uint8 , uint32 , uint32 , 
+		struct static_conf *, struct dynamic_conf *);
+
 	//storage of relations found during in-mem sieving
 	uint32 buffered_rels;
 	uint32 buffered_rel_alloc;
@@ -415,23 +497,25 @@ typedef struct {
 
 } static_conf_t;
 
-typedef struct {
+typedef struct dynamic_conf {
 	// the stuff in this structure is continuously being updated
 	// during the course of the factorization, but we want it all
 	// in one place so the data can be passed around easily
 
+	mem_arena_t arena;			// backs the sieve, roots and bucket lists
+
 	//small prime sieving
 	uint8 *sieve;				// scratch space used for one sieve block 
+	uint8 *stripe_patterns;		// stripe patterns for the current poly, +/- sides
 	sieve_fb_compressed *comp_sieve_p;		// scratch space for a packed versions of fb
 	sieve_fb_compressed *comp_sieve_n;		// for use during sieving smallish primes
-	sieve_fb *fb_sieve_p;		// scratch space for a packed versions of fb
-	sieve_fb *fb_sieve_n;		// for use during sieving smallish primes
 
 	//large prime sieving
 	update_t update_data;		// data for updating root values
 	lp_bucket *buckets;			// bins holding sieve updates
 	int *rootupdates;			// updates to apply to roots of primes
 	uint16 *sm_rootupdates;			// updates to apply to roots of primes
+	uint32 rootupdate_rows;		// poly a factors the root updates have room for
 	
 	//scratch
 	mpz_t gmptmp1;
@@ -442,12 +526,14 @@ typedef struct {
 	uint16 *mask;
 	uint32 *reports;			//sieve locations to submit to trial division
 	uint32 num_reports;	
+	uint32 report_alloc;		//room in reports and the arrays below
+	uint32 max_reports;			//most reports seen in one block
 #ifdef USE_YAFU_TDIV
 	z32 *Qvals32;
 #endif
 	mpz_t *Qvals;
 	int *valid_Qs;				//which of the report are still worth persuing after SPV check
-	uint32 fb_offsets[MAX_SIEVE_REPORTS][MAX_SMOOTH_PRIMES];
+	uint32 (*fb_offsets)[MAX_SMOOTH_PRIMES];
 	int *smooth_num;			//how many factors are there for each valid Q
 	uint32 failed_squfof;
 	uint32 attempted_squfof;
@@ -470,6 +556,12 @@ typedef struct {
 	uint32 buffered_rel_alloc;
 	siqs_r *relation_buf;
 
+	//dlp residues waiting for a batch smoothness test, and the 
+	//relations in relation_buf they belong to
+	uint64 *batch_q;
+	uint32 *batch_id;
+	uint32 num_batch;
+
 #ifdef HAVE_CUDA
 	uint64 *squfof_candidates;
 	uint32 *buf_id;
@@ -520,6 +612,13 @@ typedef struct {
 
 // used in multiplier selection
 #define NUM_TEST_PRIMES 300
+
+// test sieving the best few multipliers (-siqsMT): the most candidates
+// tried, the number of B-polys sieved with each, and the smallest
+// input for which it is done
+#define QS_MAX_MULT_TEST 8
+#define QS_MULT_TEST_BPOLYS 1000
+#define QS_MULT_TEST_MIN_DIGITS 80
 #define NUM_MULTIPLIERS (sizeof(mult_list)/sizeof(uint8))
   
 static const uint8 mult_list[] =
@@ -537,11 +636,16 @@ void med_sieveblock_32k_avx2(uint8 *sieve, sieve_fb_compressed *fb, fb_list *ful
 		uint32 start_prime, uint8 s_init);
 void med_sieveblock_64k(uint8 *sieve, sieve_fb_compressed *fb, fb_list *full_fb, 
 		uint32 start_prime, uint8 s_init);
-void (*med_sieve_ptr)(uint8 *, sieve_fb_compressed *, fb_list *, uint32 , uint8 );
 
 void lp_sieveblock(uint8 *sieve, uint32 bnum, uint32 numblocks,
 		lp_bucket *lp, int side);
 
+void stripe_init(static_conf_t *sconf);
+void stripe_build_patterns(static_conf_t *sconf, dynamic_conf_t *dconf);
+void stripe_sieveblock(uint8 *sieve, uint8 *patterns, static_conf_t *sconf, 
+		uint32 bnum);
+uint32 stripe_logp(uint8 *patterns, static_conf_t *sconf, uint32 offset);
+
 // trial division
 int check_relations_siqs_1(uint32 blocknum, uint8 parity, 
 						   static_conf_t *sconf, dynamic_conf_t *dconf);
@@ -551,7 +655,6 @@ int check_relations_siqs_8(uint32 blocknum, uint8 parity,
 						   static_conf_t *sconf, dynamic_conf_t *dconf);
 int check_relations_siqs_16(uint32 blocknum, uint8 parity, 
 						   static_conf_t *sconf, dynamic_conf_t *dconf);
-int (*scan_ptr)(uint32, uint8, static_conf_t *, dynamic_conf_t *);
 
 void filter_SPV(uint8 parity, uint8 *sieve, uint32 poly_id, uint32 bnum, 
 				static_conf_t *sconf, dynamic_conf_t *dconf);
@@ -565,8 +668,6 @@ void tdiv_medprimes_32k_avx2(uint8 parity, uint32 poly_id, uint32 bnum,
 						 static_conf_t *sconf, dynamic_conf_t *dconf);
 void tdiv_medprimes_64k(uint8 parity, uint32 poly_id, uint32 bnum, 
 						 static_conf_t *sconf, dynamic_conf_t *dconf);
-void (*tdiv_med_ptr)(uint8 , uint32 , uint32 , 
-						 static_conf_t *, dynamic_conf_t *);
 
 void resieve_medprimes_32k(uint8 parity, uint32 poly_id, uint32 bnum, 
 						 static_conf_t *sconf, dynamic_conf_t *dconf);
@@ -574,8 +675,6 @@ void resieve_medprimes_32k_avx2(uint8 parity, uint32 poly_id, uint32 bnum,
 						 static_conf_t *sconf, dynamic_conf_t *dconf);
 void resieve_medprimes_64k(uint8 parity, uint32 poly_id, uint32 bnum, 
 						 static_conf_t *sconf, dynamic_conf_t *dconf);
-void (*resieve_med_ptr)(uint8 , uint32 , uint32 , 
-						 static_conf_t *, dynamic_conf_t *);
 
 void trial_divide_Q_siqs(uint32 report_num, 
 						  uint8 parity, uint32 poly_id, uint32 blocknum, 
@@ -590,6 +689,12 @@ void save_relation_siqs(uint32 offset, uint32 *large_prime, uint32 num_factors,
 						  uint32 *fb_offsets, uint32 poly_id, uint32 parity,
 						  static_conf_t *conf);
 
+//batch smoothness testing of dlp residues
+void batch_init(static_conf_t *sconf);
+void batch_add(static_conf_t *sconf, dynamic_conf_t *dconf);
+void batch_test(static_conf_t *sconf);
+void batch_free(static_conf_t *sconf);
+
 void stop_worker_thread(thread_sievedata_t *t);
 void start_worker_thread(thread_sievedata_t *t);
 
@@ -613,17 +718,15 @@ void nextB(dynamic_conf_t *dconf, static_conf_t *sconf);
 
 void firstRoots_32k(static_conf_t *sconf, dynamic_conf_t *dconf);
 void firstRoots_64k(static_conf_t *sconf, dynamic_conf_t *dconf);
-void (*firstRoots_ptr)(static_conf_t *, dynamic_conf_t *);
 
 void nextRoots_32k(static_conf_t *sconf, dynamic_conf_t *dconf);
 void nextRoots_32k_sse41(static_conf_t *sconf, dynamic_conf_t *dconf);
 void nextRoots_32k_avx2(static_conf_t *sconf, dynamic_conf_t *dconf);
 void nextRoots_64k(static_conf_t *sconf, dynamic_conf_t *dconf);
-void (*nextRoots_ptr)(static_conf_t *, dynamic_conf_t *);
+void nextRoots_64k_sse41(static_conf_t *sconf, dynamic_conf_t *dconf);
 		   
 void testfirstRoots_32k(static_conf_t *sconf, dynamic_conf_t *dconf);
 void testfirstRoots_64k(static_conf_t *sconf, dynamic_conf_t *dconf);
-void (*testRoots_ptr)(static_conf_t *, dynamic_conf_t *);
 
 void batch_roots(int *rootupdates, int *firstroots1, int *firstroots2,
 				 siqs_poly *poly, uint32 start_prime, fb_list *fb, uint32 *primes);
@@ -635,6 +738,8 @@ void generate_bpolys(static_conf_t *sconf, dynamic_conf_t *dconf, int maxB);
 int process_rel(char *substr, fb_list *fb, mpz_t n,
 				 static_conf_t *sconf, fact_obj_t *obj, siqs_r *rel);
 int restart_siqs(static_conf_t *sconf, dynamic_conf_t *dconf);
+void siqs_write_checkpoint(static_conf_t *sconf);
+void siqs_remove_checkpoint(static_conf_t *sconf);
 uint32 qs_purge_singletons(fact_obj_t *obj, siqs_r *list, 
 				uint32 num_relations,
 				qs_cycle_t *table, uint32 *hashtable);
@@ -650,8 +755,16 @@ int yafu_sort_cycles(const void *x, const void *y);
 
 //aux
 uint8 choose_multiplier_siqs(uint32 B, mpz_t n);
+uint32 rank_multipliers_siqs(uint32 B, mpz_t n, uint8 *mults, uint32 max_mults);
+uint32 siqs_test_multipliers(fact_obj_t *fobj, uint32 num_test);
 int siqs_static_init(static_conf_t *sconf, int is_tiny);
 int siqs_dynamic_init(dynamic_conf_t *dconf, static_conf_t *sconf);
+void siqs_share_fb(static_conf_t *sconf);
+void siqs_alloc_sieve_arrays(static_conf_t *sconf, dynamic_conf_t *dconf, int try_huge);
+void siqs_alloc_reports(dynamic_conf_t *dconf, uint32 num_reports);
+void siqs_alloc_rootupdates(static_conf_t *sconf, dynamic_conf_t *dconf, uint32 rows);
+size_t siqs_memory_report(static_conf_t *sconf, dynamic_conf_t *dconf, 
+	uint32 num_threads, size_t *shared_bytes, int verbose);
 int siqs_check_restart(dynamic_conf_t *dconf, static_conf_t *sconf);
 uint32 siqs_merge_data(dynamic_conf_t *dconf, static_conf_t *sconf);
 
@@ -763,14 +876,6 @@ void yafu_add_to_cycles(static_conf_t *conf, uint32 flags, uint32 prime1, uint32
 /* perform postprocessing on a list of relations */
 void yafu_qs_filter_relations(static_conf_t *sconf);
 
-#define SAVEFILE_BUF_SIZE 2048
-char savebuf[2048];
-int savefile_buf_off;
-
-qs_params sieve_params;
-
-int SIQS_ABORT;
-
 
 #endif /* _SIQS_H_ */
 
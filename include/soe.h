@@ -202,6 +202,11 @@ uint64 *soe_wrapper(uint32 *sieve_p, uint32 num_sp,
 uint64 *sieve_to_depth(uint32 *seed_p, uint32 num_sp, 
 	mpz_t lowlimit, mpz_t highlimit, int count, int num_witnesses, uint64 *num_p);
 
+// the shared cache of primes in PRIMES/NUM_P/P_MAX
+void init_prime_cache(uint64 *primes, uint64 num_p, uint64 limit);
+uint64 *get_prime_cache(uint64 limit, uint64 *num_p);
+void free_prime_cache(void);
+
 // misc and helper functions
 uint64 estimate_primes_in_range(uint64 lowlimit, uint64 highlimit);
 void get_numclasses(uint64 highlimit, uint64 lowlimit, soe_staticdata_t *sdata);
@@ -225,8 +230,6 @@ void primesum_check3(uint64 lower, uint64 upper, uint64 startmod, z *sum);
 static const uint8 masks[8] = {0xfe, 0xfd, 0xfb, 0xf7, 0xef, 0xdf, 0xbf, 0x7f};
 uint8 nmasks[8];
 uint32 max_bucket_usage;
-uint64 GLOBAL_OFFSET;
-int NO_STORE;
 
 //progression of residue classes. each row
 //is for a different prime mod prodN
@@ -45,6 +45,12 @@ extern "C" {
 	#define PREFETCH(addr) /* nothing */
 #endif
 
+#if defined(_MSC_VER)
+	#define THREAD_LOCAL __declspec(thread)
+#else
+	#define THREAD_LOCAL __thread
+#endif
+
 #define MIN(a,b) ((a) < (b)? (a) : (b))
 #define MAX(a,b) ((a) > (b)? (a) : (b))
 
@@ -97,8 +103,39 @@ static INLINE void * xrealloc(void *iptr, size_t len) {
 	return ptr;
 }
 
+// a block of memory that a group of hot arrays is carved out of, backed
+// by huge pages where possible.  in top/utils.c
+#define ARENA_ALIGN 128
+#define ARENA_HUGE_PAGE (2 * 1024 * 1024)
+
+enum arena_pages {
+	ARENA_PAGES_SMALL,		// from xmalloc_align
+	ARENA_PAGES_MAPPED,		// mmapped, but the os won't do huge pages
+	ARENA_PAGES_THP,		// mmapped and advised to use transparent huge pages
+	ARENA_PAGES_HUGETLB		// mmapped from the reserved huge page pool
+};
+
+typedef struct
+{
+	uint8 *base;
+	size_t size;
+	size_t used;
+	enum arena_pages pages;
+} mem_arena_t;
+
+void arena_init(mem_arena_t *arena, size_t size, uint32 color, int try_huge);
+void * arena_alloc(mem_arena_t *arena, size_t len);
+void arena_free(mem_arena_t *arena);
+const char * arena_pages_name(mem_arena_t *arena);
+
 void get_random_seeds(rand_t *r);
 
+// process-wide setup and teardown, in top/init.c
+void set_default_globals(void);
+void free_globals(void);
+void get_computer_info(char *idstr);
+void init_global_rand(void);
+
 static INLINE uint32 
 get_rand(uint32 *rand_seed, uint32 *rand_carry) {
    
@@ -159,6 +196,7 @@ int qcomp_double(const void *x, const void *y);
 void generate_pseudoprime_list(int num, int bits);
 void yafu_set_idle_priority(void);
 int bin_search_uint32(int idp, int idm, uint32 q, uint32 *input);
+int bin_search_uint64(int idp, int idm, uint64 q, uint64 *input);
 
 //routines for testing various aspects of code
 void test_dlp_composites(void);
@@ -146,6 +146,7 @@ int LATHREADS;
 int USEBATCHFILE;
 int USERSEED;
 int CMD_LINE_REPEAT;
+int BATCHJOBS;
 char batchfilename[1024];
 char sessionname[1024];
 
@@ -182,9 +183,10 @@ z zZero, zOne, zTwo, zThree, zFive;
 uint32 *spSOEprimes;	//the primes	
 uint32 szSOEp;			//count of primes
 
-//this array holds NUM_P primes in the range P_MIN to P_MAX, and
-//can change as needed - always check the range and size to see
-//if the primes you need are in there before using it
+//this array holds all NUM_P primes from 2 to P_MAX.  it is shared by
+//every factorization in the process and grows as needed, so don't 
+//resize it directly: call get_prime_cache() for the primes up to some 
+//limit.  P_MIN is always 0.
 uint64 *PRIMES;
 uint64 NUM_P;
 uint64 P_MIN;
@@ -38,6 +38,22 @@ enum ecm_thread_command {
 	ECM_COMMAND_END
 };
 
+// the built-in ecm (tinyecm.c) takes over from gmp-ecm for inputs up to
+// TINYECM_MAXBITS.  its default B2 is the one gmp-ecm would choose for the
+// same B1, so the curve counts of factor() hold for it.  bounds that 
+// would put B2 above TINYECM_MAXB2 still go to gmp-ecm.
+#define TINYECM_MAXBITS 200
+#define TINYECM_MAXB2 200000000
+
+typedef struct {
+	mp_limb_t *n;			//modulus
+	mp_limb_t rho;			//-1/n mod b, for montgomery reduction
+	int nd;					//limbs in n
+	mp_limb_t *t;			//double width product
+	mp_limb_t *r;			//residues: temporaries, then baby step points
+	int nr;
+} tinyecm_t;
+
 typedef struct {
 	mpz_t gmp_n, gmp_factor;
 	ecm_params params;
@@ -47,6 +63,20 @@ typedef struct {
 	int thread_num;
 	int curves_run;
 	char tmp_output[80];
+	tinyecm_t *tiny;
+
+#if !defined(WIN32)
+	// a long-lived external ecm process for this thread (ext_pid > 0),
+	// fed one input line per curve.  its output is read into ext_buf
+	// (ext_len bytes, the first ext_used of them already handed out).
+	// ext_sigma is the sigma of the last curve, for a factor reported late.
+	pid_t ext_pid;
+	FILE *ext_in;
+	int ext_fd;
+	char *ext_buf;
+	int ext_len, ext_used, ext_alloc;
+	uint32 ext_sigma;
+#endif
 
 	/* fields for thread pool synchronization */
 	volatile enum ecm_thread_command command;
@@ -76,6 +106,17 @@ void ecm_stop_worker_thread(ecm_thread_data_t *t, uint32 is_master_thread);
 void ecm_start_worker_thread(ecm_thread_data_t *t, uint32 is_master_thread);
 void ecm_thread_free(ecm_thread_data_t *tdata);
 void ecm_thread_init(ecm_thread_data_t *tdata);
+#if !defined(WIN32)
+int ecm_ext_start(ecm_thread_data_t *tdata);
+void ecm_ext_stop(ecm_thread_data_t *tdata);
+void ecm_ext_curve(ecm_thread_data_t *tdata);
+#endif
+int tinyecm_plan(fact_obj_t *fobj, uint32 B1, uint64 B2);
+void tinyecm_plan_free(fact_obj_t *fobj);
+uint64 tinyecm_B2(fact_obj_t *fobj);
+tinyecm_t *tinyecm_init(void);
+void tinyecm_free(tinyecm_t *t);
+int tinyecm_curve(tinyecm_t *t, struct tinyecm_plan *plan, mpz_t f, mpz_t n, uint32 sigma);
 
 #if defined(WIN32) || defined(_WIN64)
 DWORD WINAPI ecm_worker_thread_main(LPVOID thread_data);
@@ -83,10 +124,9 @@ DWORD WINAPI ecm_worker_thread_main(LPVOID thread_data);
 void *ecm_worker_thread_main(void *thread_data);
 #endif
 
-// "local" globals
-int ECM_ABORT;
-int PM1_ABORT;
-int PP1_ABORT;
+// gmp-ecm's stop_asap callback takes no arguments, so a thread running
+// curves points this at the stop flag of the job they belong to 
+// (fobj->stop), for the duration of the curve
+extern THREAD_LOCAL volatile int *ecm_stop;
+int ecm_stop_asap(void);
 
-int TMP_THREADS;
-uint64 TMP_STG2_MAX;
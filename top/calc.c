@@ -1624,17 +1624,18 @@ int feval(int func, int nargs, fact_obj_t *fobj)
 			break;
 		}
 
-		lower = mpz_get_64(operands[0]);
-		upper = mpz_get_64(operands[1]);
-		free(PRIMES);
-		PRIMES = soe_wrapper(spSOEprimes, szSOEp, lower, upper, mpz_get_ui(operands[2]), &NUM_P);
-		if (PRIMES != NULL)
 		{
-			P_MIN = PRIMES[0];
-			P_MAX = PRIMES[NUM_P-1];
-		}
-		mpz_set_64(operands[0], NUM_P);
+			// the sieve prints or saves the primes as configured; we 
+			// only keep the count.  the range is sieved separately 
+			// so that PRIMES always holds the primes from 2.
+			uint64 *primes;
 
+			lower = mpz_get_64(operands[0]);
+			upper = mpz_get_64(operands[1]);
+			primes = soe_wrapper(spSOEprimes, szSOEp, lower, upper, mpz_get_ui(operands[2]), &n64);
+			free(primes);
+			mpz_set_64(operands[0], n64);
+		}
 		break;
 	case 29:
 		//ispow - one argument
@@ -2919,3 +2920,155 @@ void free_uvars()
 	free(uvars.vars);
 }
 
+int invalid_dest(char *dest)
+{
+	//return 1 if invalid, 0 otherwise
+	int i;
+
+	if (getFunc(dest,&i) >= 0)
+		return 1;	//is a function name
+
+	//global vars are ok
+	if (strcmp(dest,"POLLARD_STG1_MAX") == 0) {
+		return 0;}
+	else if (strcmp(dest,"POLLARD_STG2_MAX") == 0) {
+		return 0;}
+	else if (strcmp(dest,"WILL_STG1_MAX") == 0) {
+		return 0;}
+	else if (strcmp(dest,"WILL_STG2_MAX") == 0) {
+		return 0;}
+	else if (strcmp(dest,"ECM_STG1_MAX") == 0) {
+		return 0;}
+	else if (strcmp(dest,"ECM_STG2_MAX") == 0) {
+		return 0;}
+	else if (strcmp(dest,"BRENT_MAX_IT") == 0) {
+		return 0;}
+	else if (strcmp(dest,"IBASE") == 0) {
+		return 0;}
+	else if (strcmp(dest,"OBASE") == 0) {
+		return 0;}
+	else if (strcmp(dest,"QS_DUMP_CUTOFF") == 0) {
+		return 0;}
+	else if (strcmp(dest,"NUM_WITNESSES") == 0) {
+		return 0;}
+	else if (strcmp(dest,"LOGFLAG") == 0) {
+		return 0;}
+	else if (strcmp(dest,"VFLAG") == 0) {
+		return 0;}
+	else if (strcmp(dest,"PRIMES_TO_FILE") == 0) {
+		return 0;}
+	else if (strcmp(dest,"PRIMES_TO_SCREEN") == 0) {
+		return 0;}
+
+	//check starting char not lower case letter or _ or `
+	if (dest[0] < 95 || dest[0] > 122) return 1;
+
+	return 0;
+}
+
+int invalid_num(char *num)
+{
+	//check that num consists of only numeric or alphanumeric characters
+	int i=0;
+	int nchars = strlen(num);
+	
+	if (nchars == 0) return 1;
+
+	if (num[0] == '-')
+		i++;
+	
+	//check for 0x, 0d, 0b, or 0o.  nchars must be > 3-i in this case
+	if (num[i] == '0' && num[i+1] == 'x' && ((nchars-i) > 2))
+	{
+		//num is hex, and can have lower or upper case alpha characters
+		i += 2;
+		for (;i<nchars;i++)
+		{ 
+			if (num[i] > 102)	//102 == f
+				return 1;
+			else if (num[i] < 48) 
+				return 1;
+			else if (num[i] > 57 && num[i] < 65)
+				return 1;
+			else if (num[i] > 70 && num[i] < 97)	//97 == a
+				return 1;
+		}
+	}
+	else if (num[i] == '0' && num[i+1] == 'd' && ((nchars-i) > 2))
+	{
+		//num is dec, and can have only digits 0 - 9
+		i += 2;
+		for (;i<nchars;i++)
+		{ 
+			if (num[i] < 48 || num[i] > 57) 
+				return 1;
+		}
+	}
+	else if (num[i] == '0' && num[i+1] == 'b' && ((nchars-i) > 2))
+	{
+		//num is bin, and can have only digits 0 - 1
+		i += 2;
+		for (;i<nchars;i++)
+		{ 
+			if (num[i] < 48 || num[i] > 49) 
+				return 1;
+		}
+	}
+	else if (num[i] == '0' && num[i+1] == 'o' && ((nchars-i) > 2))
+	{
+		//num is oct, and can have only digits 0 - 7
+		i += 2;
+		for (;i<nchars;i++)
+		{ 
+			if (num[i] < 48 || num[i] > 55) 
+				return 1;
+		}
+	}
+	else
+	{
+		//no base designator, go by IBASE
+		if (IBASE == HEX)
+		{
+			//num is hex, and can have only upper case alpha characters
+			for (;i<nchars;i++)
+			{ 
+				if (num[i] < 48) 
+					return 1;
+				else if (num[i] > 57 && num[i] < 65)
+					return 1;
+				else if (num[i] > 70)	//70 == F
+					return 1;
+			}
+		}
+		else if (IBASE == DEC)
+		{
+			//num is dec, and can have only digits 0 - 9
+			for (;i<nchars;i++)
+			{ 
+				if (num[i] < 48 || num[i] > 57) 
+					return 1;
+			}
+		}
+		else if (IBASE == BIN)
+		{
+			//num is bin, and can have only digits 0 - 1
+			for (;i<nchars;i++)
+			{ 
+				if (num[i] < 48 || num[i] > 49) 
+					return 1;
+			}
+		}
+		else if (IBASE == OCT)
+		{
+			//num is oct, and can have only digits 0 - 7
+			for (;i<nchars;i++)
+			{ 
+				if (num[i] < 48 || num[i] > 55) 
+					return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
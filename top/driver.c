@@ -26,6 +26,12 @@ code to the public domain.
 #include "factor.h"
 #include "gmp.h"
 
+#if !defined(WIN32)
+	#include <sys/wait.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
 //#if defined(_MSC_VER)
 //	#include <gmp-ecm\config.h>
 //#else
@@ -43,7 +49,7 @@ following if linking against 2345+ (all 6.* versions are the old way) */
 #endif
 
 // the number of recognized command line options
-#define NUMOPTIONS 71
+#define NUMOPTIONS 81
 // maximum length of command line option strings
 #define MAXOPTIONLEN 20
 
@@ -63,7 +69,9 @@ char OptionArray[NUMOPTIONS][MAXOPTIONLEN] = {
 	"nc2", "nc3", "p", "work", "nprp",
 	"ext_ecm", "testsieve", "nt", "aprcl_p", "aprcl_d",
 	"filt_bump", "nc1", "gnfs", "e", "repeat",
-	"ecmtime"};
+	"ecmtime", "portfolio", "batchjobs", "pretestsave", "nfscache",
+	"siqsBS", "siqsMT", "siqsSP", "siqsMEM", "siqsHP",
+	"siqsBT"};
 
 // indication of whether or not an option needs a corresponding argument
 // 0 = no argument
@@ -84,27 +92,26 @@ int needsArg[NUMOPTIONS] = {
 	0,0,0,1,1,
 	1,1,1,1,1,
 	1,0,0,1,1,
+	1,0,1,1,1,
+	1,1,1,1,1,
 	1};
 
 // function to read the .ini file and populate options
 void readINI(fact_obj_t *fobj);
 void apply_tuneinfo(fact_obj_t *fobj, char *arg);
 
-// functions to populate the global options with default values, and to free
-// those which allocate memory
-void set_default_globals(void);
-void free_globals(void);
-
-// function containing system commands to get the computer name
-void get_computer_info(char *idstr);
-
 // function to print the splash screen to file/screen
 void print_splash(int is_cmdline_run, FILE *logfile, char *idstr);
 
 // functions to make a batchfile ready to execute, and to process batchfile lines
 void prepare_batchfile(char *input_exp);
 char * process_batchline(char *input_exp, char *indup, int *code);
+char * substitute_batchline(char *input_exp, char *indup, char *line);
 void finalize_batchline();
+#if !defined(WIN32)
+void process_batchfile_parallel(char *input_exp, char *indup, fact_obj_t *fobj);
+void batchjob_parent_path(char *path, size_t size, int is_program);
+#endif
 
 // functions to process all incoming arguments
 int process_arguments(int argc, char **argv, char *input_exp, fact_obj_t *fobj);
@@ -134,6 +141,11 @@ int main(int argc, char *argv[])
 	fobj = (fact_obj_t *)malloc(sizeof(fact_obj_t));
 	init_factobj(fobj);
 
+	// this object uses g_rand's seeds as they are: those are the ones 
+	// logged below (or given with -seed), so the run can be reproduced
+	fobj->seed1 = g_rand.low;
+	fobj->seed2 = g_rand.hi;
+
 	//get the computer name, cache sizes, etc.  store in globals
 	get_computer_info(CPU_ID_STR);	
 
@@ -205,15 +217,7 @@ int main(int argc, char *argv[])
 	//printf("WARNING: constant seed is set\n");
 	//g_rand.hi = 123;
 	//g_rand.low = 123;
-	srand(g_rand.low);
-	gmp_randinit_default(gmp_randstate);
-	gmp_randseed_ui(gmp_randstate, g_rand.low);
-
-#if BITS_PER_DIGIT == 64
-	LCGSTATE = (uint64)g_rand.hi << 32 | (uint64)g_rand.low;
-#else
-	LCGSTATE = g_rand.low;
-#endif	
+	init_global_rand();
 
 
 	// command line
@@ -225,6 +229,16 @@ int main(int argc, char *argv[])
 		if (USEBATCHFILE)
 		{
 			int code;
+
+#if !defined(WIN32)
+			if (BATCHJOBS > 1)
+			{
+				// work on several lines at once, each in its own process
+				process_batchfile_parallel(input_exp, indup, fobj);
+				break;
+			}
+#endif
+
 			input_exp = process_batchline(input_exp, indup, &code);
 			if (code == 1)
 			{
@@ -465,158 +479,6 @@ void helpfunc(char *s)
 	return;
 }
 
-int invalid_dest(char *dest)
-{
-	//return 1 if invalid, 0 otherwise
-	int i;
-
-	if (getFunc(dest,&i) >= 0)
-		return 1;	//is a function name
-
-	//global vars are ok
-	if (strcmp(dest,"POLLARD_STG1_MAX") == 0) {
-		return 0;}
-	else if (strcmp(dest,"POLLARD_STG2_MAX") == 0) {
-		return 0;}
-	else if (strcmp(dest,"WILL_STG1_MAX") == 0) {
-		return 0;}
-	else if (strcmp(dest,"WILL_STG2_MAX") == 0) {
-		return 0;}
-	else if (strcmp(dest,"ECM_STG1_MAX") == 0) {
-		return 0;}
-	else if (strcmp(dest,"ECM_STG2_MAX") == 0) {
-		return 0;}
-	else if (strcmp(dest,"BRENT_MAX_IT") == 0) {
-		return 0;}
-	else if (strcmp(dest,"IBASE") == 0) {
-		return 0;}
-	else if (strcmp(dest,"OBASE") == 0) {
-		return 0;}
-	else if (strcmp(dest,"QS_DUMP_CUTOFF") == 0) {
-		return 0;}
-	else if (strcmp(dest,"NUM_WITNESSES") == 0) {
-		return 0;}
-	else if (strcmp(dest,"LOGFLAG") == 0) {
-		return 0;}
-	else if (strcmp(dest,"VFLAG") == 0) {
-		return 0;}
-	else if (strcmp(dest,"PRIMES_TO_FILE") == 0) {
-		return 0;}
-	else if (strcmp(dest,"PRIMES_TO_SCREEN") == 0) {
-		return 0;}
-
-	//check starting char not lower case letter or _ or `
-	if (dest[0] < 95 || dest[0] > 122) return 1;
-
-	return 0;
-}
-
-int invalid_num(char *num)
-{
-	//check that num consists of only numeric or alphanumeric characters
-	int i=0;
-	int nchars = strlen(num);
-	
-	if (nchars == 0) return 1;
-
-	if (num[0] == '-')
-		i++;
-	
-	//check for 0x, 0d, 0b, or 0o.  nchars must be > 3-i in this case
-	if (num[i] == '0' && num[i+1] == 'x' && ((nchars-i) > 2))
-	{
-		//num is hex, and can have lower or upper case alpha characters
-		i += 2;
-		for (;i<nchars;i++)
-		{ 
-			if (num[i] > 102)	//102 == f
-				return 1;
-			else if (num[i] < 48) 
-				return 1;
-			else if (num[i] > 57 && num[i] < 65)
-				return 1;
-			else if (num[i] > 70 && num[i] < 97)	//97 == a
-				return 1;
-		}
-	}
-	else if (num[i] == '0' && num[i+1] == 'd' && ((nchars-i) > 2))
-	{
-		//num is dec, and can have only digits 0 - 9
-		i += 2;
-		for (;i<nchars;i++)
-		{ 
-			if (num[i] < 48 || num[i] > 57) 
-				return 1;
-		}
-	}
-	else if (num[i] == '0' && num[i+1] == 'b' && ((nchars-i) > 2))
-	{
-		//num is bin, and can have only digits 0 - 1
-		i += 2;
-		for (;i<nchars;i++)
-		{ 
-			if (num[i] < 48 || num[i] > 49) 
-				return 1;
-		}
-	}
-	else if (num[i] == '0' && num[i+1] == 'o' && ((nchars-i) > 2))
-	{
-		//num is oct, and can have only digits 0 - 7
-		i += 2;
-		for (;i<nchars;i++)
-		{ 
-			if (num[i] < 48 || num[i] > 55) 
-				return 1;
-		}
-	}
-	else
-	{
-		//no base designator, go by IBASE
-		if (IBASE == HEX)
-		{
-			//num is hex, and can have only upper case alpha characters
-			for (;i<nchars;i++)
-			{ 
-				if (num[i] < 48) 
-					return 1;
-				else if (num[i] > 57 && num[i] < 65)
-					return 1;
-				else if (num[i] > 70)	//70 == F
-					return 1;
-			}
-		}
-		else if (IBASE == DEC)
-		{
-			//num is dec, and can have only digits 0 - 9
-			for (;i<nchars;i++)
-			{ 
-				if (num[i] < 48 || num[i] > 57) 
-					return 1;
-			}
-		}
-		else if (IBASE == BIN)
-		{
-			//num is bin, and can have only digits 0 - 1
-			for (;i<nchars;i++)
-			{ 
-				if (num[i] < 48 || num[i] > 49) 
-					return 1;
-			}
-		}
-		else if (IBASE == OCT)
-		{
-			//num is oct, and can have only digits 0 - 7
-			for (;i<nchars;i++)
-			{ 
-				if (num[i] < 48 || num[i] > 55) 
-					return 1;
-			}
-		}
-	}
-
-	return 0;
-}
-
 void prepare_batchfile(char *input_exp)
 {
 	char *ptr;
@@ -812,151 +674,6 @@ _MSC_MPIR_VERSION);
 	return;
 }
 
-void get_computer_info(char *idstr)
-{
-	int ret;
-
-	//figure out cpu freq in order to scale qs time estimations
-	//0.1 seconds won't be very accurate, but hopefully close
-	//enough for the rough scaling we'll be doing anyway.
-    MEAS_CPU_FREQUENCY = measure_processor_speed() / 1.0e5;
-	
-#ifdef __APPLE__
-	// something in extended cpuid causes a segfault on mac builds.
-	// just disable it for now - this information is not critical for
-	// program operation.
-	strcpy(idstr, "N/A");
-	CLSIZE = 0;
-	L1CACHE = DEFAULT_L1_CACHE_SIZE;
-	L2CACHE = DEFAULT_L2_CACHE_SIZE;
-	HAS_SSE41 = 0;
-
-#else
-	//read cache sizes
-	yafu_get_cache_sizes(&L1CACHE,&L2CACHE);
-
-	// run an extended cpuid command to get the cache line size, and
-	// optionally print a bunch of info to the screen
-	extended_cpuid(idstr, &CLSIZE, &HAS_SSE41, &HAS_AVX, &HAS_AVX2, 
-		VERBOSE_PROC_INFO);
-
-	#if defined(WIN32)
-
-		sysname_sz = MAX_COMPUTERNAME_LENGTH + 1;
-		GetComputerName(sysname,&sysname_sz);
-	
-	#else
-
-		ret = gethostname(sysname,sizeof(sysname) / sizeof(*sysname));
-		sysname[(sizeof(sysname)-1)/sizeof(*sysname)] = 0;	// null terminate
-		if (ret != 0)
-		{
-			printf("error occured when getting host name\n");
-			strcpy(sysname, "N/A");
-		}
-		sysname_sz = strlen(sysname);
-	
-	#endif
-
-#endif
-	return;
-}
-
-void yafu_set_idle_priority(void) {
-
-#if defined(WIN32) || defined(_WIN64)
-	SetPriorityClass(GetCurrentProcess(),
-			IDLE_PRIORITY_CLASS);
-#else
-	nice(100);
-#endif
-}
-
-void set_default_globals(void)
-{
-	uint64 limit, i;
-	uint32 seed_p[6542], num_sp;
-	
-	VFLAG = 0;
-	VERBOSE_PROC_INFO = 0;
-	LOGFLAG = 1;
-
-	NUM_WITNESSES = 1;
-	
-	PRIMES_TO_FILE = 0;
-	PRIMES_TO_SCREEN = 0;
-	GLOBAL_OFFSET = 0;
-	
-	USEBATCHFILE = 0;
-	USERSEED = 0;
-	THREADS = 1;
-	LATHREADS = 0;
-	CMD_LINE_REPEAT = 0;
-
-	strcpy(sessionname,"session.log");	
-
-	// initial limit of cache of primes.
-	szSOEp = 1000000;	
-
-	//set some useful globals
-	zInit(&zZero);
-	zInit(&zOne);
-	zInit(&zTwo);
-	zInit(&zThree);
-	zInit(&zFive);
-	zOne.val[0] = 1;
-	zTwo.val[0] = 2;
-	zThree.val[0] = 3;
-	zFive.val[0] = 5;
-
-	//global strings, used mostly for logprint stuff
-	sInit(&gstr1);
-	sInit(&gstr2);
-	sInit(&gstr3);
-
-	//global i/o base
-	IBASE = DEC;
-	OBASE = DEC;
-
-	//find, and hold globally, primes less than some N
-	//bootstrap the process by finding some initial sieve primes.
-	//if the requested offset+range is large we may need to find more - 
-	//we can use these primes to accomplish that.
-	num_sp = tiny_soe(65537, seed_p);
-	PRIMES = GetPRIMESRange(seed_p, num_sp, NULL, 0, szSOEp, &limit);
-
-	//save a batch of sieve primes too.
-	spSOEprimes = (uint32 *)malloc((size_t) (limit * sizeof(uint32)));
-	for (i=0;i<limit;i++)
-		spSOEprimes[i] = (uint32)PRIMES[i];
-
-	szSOEp = limit;
-	NUM_P = limit;
-	P_MIN = 0; 
-	P_MAX = PRIMES[(uint32)NUM_P-1];
-
-	// random seeds
-	get_random_seeds(&g_rand);	
-
-	return;
-}
-
-void free_globals()
-{
-	zFree(&zZero);
-	zFree(&zOne);
-	zFree(&zTwo);
-	zFree(&zThree);
-	zFree(&zFive);
-	free(spSOEprimes);
-	free(PRIMES);
-	sFree(&gstr1);
-	sFree(&gstr2);
-	sFree(&gstr3);
-
-	return;
-}
-
 void finalize_batchline()
 {
 	if (USEBATCHFILE == 1)
@@ -972,7 +689,7 @@ void finalize_batchline()
 
 char * process_batchline(char *input_exp, char *indup, int *code)
 {
-	int nChars, j, i;
+	int nChars, j;
 	char *line, tmpline[GSTR_MAXSIZE], *ptr, *ptr2;
 	FILE *batchfile, *tmpfile;
 
@@ -1100,6 +817,25 @@ char * process_batchline(char *input_exp, char *indup, int *code)
 	}
 
 	//substitute the batchfile line into the '@' symbol in the input expression
+	input_exp = substitute_batchline(input_exp, indup, line);
+
+	if (VFLAG >= 0)
+	{
+		printf("=== Starting work on batchfile expression ===\n");
+		printf("%s\n",input_exp);
+		printf("=============================================\n");
+		fflush(stdout);
+	}
+
+	free(line);
+	*code = 0;
+	return input_exp;;
+}
+
+char * substitute_batchline(char *input_exp, char *indup, char *line)
+{
+	int nChars, i, j;
+
 	nChars = 0;
 	if ((strlen(indup) + strlen(line)) >= GSTR_MAXSIZE)
 		input_exp = (char *)realloc(input_exp, strlen(indup) + strlen(line) + 2);
@@ -1116,19 +852,395 @@ char * process_batchline(char *input_exp, char *indup, int *code)
 	}
 	input_exp[nChars++] = '\0';
 
+	return input_exp;
+}
+
+#if !defined(WIN32)
+
+enum batchjob_state {
+	BATCHJOB_RUNNING,
+	BATCHJOB_DONE,
+	BATCHJOB_FAILED,
+	BATCHJOB_SKIPPED
+};
+
+typedef struct
+{
+	pid_t pid;
+	enum batchjob_state state;
+	long end_offset;		// end of this job's line in the original batchfile
+	uint32 hash;			// with repeat, names the line's scratch directory
+	int repeat;				// earlier lines of this run with the same text
+} batchjob_t;
+
+int BATCH_ABORT;
+
+void batchexit(int sig)
+{
+	printf("\nAborting batchfile: waiting for running lines to finish...\n");
+	BATCH_ABORT = 1;
+	return;
+}
+
+char *read_batchline(FILE *fid)
+{
+	// read one line of any length, less its line ending.  NULL at eof.
+	char tmpline[GSTR_MAXSIZE];
+	char *line = (char *)malloc(GSTR_MAXSIZE * sizeof(char));
+	int len;
+
+	strcpy(line, "");
+	while (fgets(tmpline, GSTR_MAXSIZE, fid) != NULL)
+	{
+		line = (char *)realloc(line, (strlen(line) + strlen(tmpline) + 1) * sizeof(char));
+		strcat(line, tmpline);
+		len = strlen(line);
+		if ((line[len-1] == 0xa) || (line[len-1] == 0xd))
+			break;
+	}
+
+	if (strlen(line) == 0)
+	{
+		free(line);
+		return NULL;
+	}
+
+	len = strlen(line);
+	while ((len > 0) && ((line[len-1] == 0xa) || (line[len-1] == 0xd)))
+		line[--len] = '\0';
+
+	return line;
+}
+
+void append_file(char *src, FILE *dest)
+{
+	FILE *in;
+	char buf[4096];
+	size_t n;
+
+	in = fopen(src, "rb");
+	if (in == NULL)
+		return;
+
+	while ((n = fread(buf, 1, 4096, in)) > 0)
+		fwrite(buf, 1, n, dest);
+	fclose(in);
+
+	return;
+}
+
+void drop_batchfile_prefix(long nbytes)
+{
+	// rewrite the batchfile without its first nbytes.  Lines appended
+	// to the file while we've been running are kept.
+	FILE *batchfile, *tmpfile;
+	char buf[4096];
+	size_t n;
+
+	batchfile = fopen(batchfilename,"r");
+	if (batchfile == NULL)
+		return;
+
+	tmpfile = fopen("__tmpbatchfile", "w");
+	if (tmpfile == NULL)
+	{
+		printf("fopen error: %s\n", strerror(errno));
+		printf("couldn't open __tmpbatchfile for writing\n");
+		fclose(batchfile);
+		return;
+	}
+
+	fseek(batchfile, nbytes, SEEK_SET);
+	while ((n = fread(buf, 1, 4096, batchfile)) > 0)
+		fwrite(buf, 1, n, tmpfile);
+	fclose(tmpfile);
+	fclose(batchfile);
+
+	finalize_batchline();
+
+	return;
+}
+
+void batchjob_parent_path(char *path, size_t size, int is_program)
+{
+	// a relative path from the command line names something beside the
+	// batchfile, one level above the scratch directory a line runs in.
+	// a program named without a directory is found on the PATH instead.
+	size_t len = strlen(path);
+
+	if ((len == 0) || (path[0] == '/'))
+		return;
+
+	if (is_program && (strchr(path, '/') == NULL))
+		return;
+
+	if (len + 4 > size)
+	{
+		printf("*** path %s too long to use from a batch job, ignoring ***\n", path);
+		return;
+	}
+
+	memmove(path + 3, path, len + 1);
+	memcpy(path, "../", 3);
+
+	return;
+}
+
+void process_batchfile_parallel(char *input_exp, char *indup, fact_obj_t *fobj)
+{
+	// work on up to BATCHJOBS batchfile lines at once, each in a forked copy
+	// of this process running with THREADS / BATCHJOBS threads.  Children
+	// inherit our settings and sieve primes, and send their screen output and
+	// logfile entries to temporary files that we replay in batchfile order.  
+	// Lines are removed from the batchfile only once they and every line 
+	// before them have finished, so an interrupted batch resumes with at most
+	// a few finished lines done over.  A line that fails (e.g., a ctrl-c'ed 
+	// siqs) stops new work, as it would stop a sequential batch.
+	// Each line runs in its own scratch directory, so the savefiles, nfs job
+	// files, and external tool files of different lines don't collide.
+	batchjob_t *jobs = NULL;
+	int alloc_jobs = 0, num_jobs = 0, next_flush = 0, running = 0;
+	int stop = 0, keep_lines = 0, eof = 0;
+	int i, status, share;
+	long offset = 0, removed = 0;
+	char *line, tmpname[1100];
+	FILE *batchfile, *flog;
+	pid_t pid;
+	uint32 hash;
+	int repeat;
+
+	share = THREADS / BATCHJOBS;
+	if (share < 1)
+		share = 1;
+
 	if (VFLAG >= 0)
+		printf("working on %d batchfile lines at once with %d thread(s) each\n",
+			BATCHJOBS, share);
+
+	BATCH_ABORT = 0;
+	signal(SIGINT, batchexit);
+
+	while (1)
 	{
-		printf("=== Starting work on batchfile expression ===\n");
-		printf("%s\n",input_exp);
-		printf("=============================================\n");
-		fflush(stdout);
+		// start lines while there is room
+		while (!stop && !BATCH_ABORT && (running < BATCHJOBS))
+		{
+			if (USEBATCHFILE == 2)
+			{
+				line = read_batchline(stdin);
+			}
+			else
+			{
+				batchfile = fopen(batchfilename,"r");
+				if (batchfile == NULL)
+				{
+					printf("fopen error: %s\n", strerror(errno));
+					printf("couldn't open %s for reading\n",batchfilename);
+					exit(-1);
+				}
+				fseek(batchfile, offset - removed, SEEK_SET);
+				line = read_batchline(batchfile);
+				offset = ftell(batchfile) + removed;
+				fclose(batchfile);
+			}
+
+			if (line == NULL)
+			{
+				eof = 1;
+				stop = 1;
+				break;
+			}
+
+			if ((strcmp(line,"quit") == 0) || (strcmp(line,"exit") == 0))
+			{
+				// left in the batchfile, as in sequential mode
+				free(line);
+				stop = 1;
+				break;
+			}
+
+			if (num_jobs == alloc_jobs)
+			{
+				alloc_jobs += 256;
+				jobs = (batchjob_t *)realloc(jobs, alloc_jobs * sizeof(batchjob_t));
+			}
+			jobs[num_jobs].end_offset = offset;
+
+			//ignore blank and comment lines
+			if ((strlen(line) == 0) || 
+				((line[0] == '/') && (line[1] == '/')) || (line[0] == '%'))
+			{
+				jobs[num_jobs++].state = BATCHJOB_SKIPPED;
+				free(line);
+				continue;
+			}
+
+			input_exp = substitute_batchline(input_exp, indup, line);
+
+			// the scratch directory name depends only on the line, so that
+			// an interrupted line can resume on a restart whatever its position.
+			// repeats of a line are numbered, so that each gets its own.
+			hash = 5381;
+			for (i = 0; i < strlen(line); i++)
+				hash = hash * 33 + (uint8)line[i];
+			free(line);
+
+			repeat = 0;
+			for (i = 0; i < num_jobs; i++)
+			{
+				if ((jobs[i].state != BATCHJOB_SKIPPED) && (jobs[i].hash == hash))
+					repeat++;
+			}
+
+			fflush(NULL);
+			pid = fork();
+			if (pid < 0)
+			{
+				printf("fork error: %s\n", strerror(errno));
+				exit(-1);
+			}
+			else if (pid == 0)
+			{
+				// child: run this line to completion, then quit
+				signal(SIGINT, SIG_DFL);
+
+				sprintf(tmpname, "__batchjob%d.out", num_jobs);
+				if (freopen(tmpname, "w", stdout) == NULL)
+					exit(-1);
+				sprintf(fobj->flogname, "../__batchjob%d.log", num_jobs);
+
+				sprintf(tmpname, "__batchjob.%08x.%d", hash, repeat);
+				if ((mkdir(tmpname, 0755) != 0) && (errno != EEXIST))
+				{
+					printf("couldn't create %s: %s\n", tmpname, strerror(errno));
+					exit(-1);
+				}
+				if (chdir(tmpname) != 0)
+				{
+					printf("couldn't enter %s: %s\n", tmpname, strerror(errno));
+					exit(-1);
+				}
+				batchjob_parent_path(fobj->autofact_obj.op_str, 1024, 0);
+				batchjob_parent_path(fobj->autofact_obj.of_str, 1024, 0);
+				batchjob_parent_path(fobj->autofact_obj.ou_str, 1024, 0);
+				batchjob_parent_path(fobj->nfs_obj.cachefile, GSTR_MAXSIZE, 0);
+				batchjob_parent_path(fobj->nfs_obj.ggnfs_dir, GSTR_MAXSIZE, 1);
+				batchjob_parent_path(fobj->ecm_obj.ecm_path, 1024, 1);
+				THREADS = share;
+				fobj->num_threads = share;
+
+				if (VFLAG >= 0)
+				{
+					printf("=== Starting work on batchfile expression ===\n");
+					printf("%s\n",input_exp);
+					printf("=============================================\n");
+				}
+
+				reset_factobj(fobj);
+				process_expression(input_exp, fobj);
+				fflush(NULL);
+				exit(0);
+			}
+
+			jobs[num_jobs].pid = pid;
+			jobs[num_jobs].hash = hash;
+			jobs[num_jobs].repeat = repeat;
+			jobs[num_jobs++].state = BATCHJOB_RUNNING;
+			running++;
+		}
+
+		if (running > 0)
+		{
+			// collect the next child to finish
+			pid = waitpid(-1, &status, 0);
+			if (pid < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				break;
+			}
+
+			for (i = next_flush; i < num_jobs; i++)
+			{
+				if ((jobs[i].state == BATCHJOB_RUNNING) && (jobs[i].pid == pid))
+				{
+					if (WIFEXITED(status) && (WEXITSTATUS(status) == 0))
+						jobs[i].state = BATCHJOB_DONE;
+					else
+					{
+						jobs[i].state = BATCHJOB_FAILED;
+						stop = 1;
+					}
+					running--;
+					break;
+				}
+			}
+		}
+
+		// replay finished lines, in order
+		while ((next_flush < num_jobs) && (jobs[next_flush].state != BATCHJOB_RUNNING))
+		{
+			if (jobs[next_flush].state != BATCHJOB_SKIPPED)
+			{
+				sprintf(tmpname, "__batchjob%d.out", next_flush);
+				append_file(tmpname, stdout);
+				remove(tmpname);
+
+				sprintf(tmpname, "__batchjob%d.log", next_flush);
+				flog = fopen(fobj->flogname, "a");
+				if (flog != NULL)
+				{
+					append_file(tmpname, flog);
+					fclose(flog);
+				}
+				remove(tmpname);
+				fflush(stdout);
+			}
+
+			if (jobs[next_flush].state == BATCHJOB_DONE)
+			{
+				// a finished line's savefiles won't be needed again.  anything
+				// else it left behind (e.g., nfs files) stays, as it would
+				// in a sequential batch, and so does its directory.
+				sprintf(tmpname, "__batchjob.%08x.%d/%s", jobs[next_flush].hash,
+					jobs[next_flush].repeat, fobj->qs_obj.siqs_savefile);
+				remove(tmpname);
+				strcat(tmpname, ".chk");
+				remove(tmpname);
+				sprintf(tmpname, "__batchjob.%08x.%d/%s", jobs[next_flush].hash,
+					jobs[next_flush].repeat, fobj->autofact_obj.pretest_savefile);
+				remove(tmpname);
+				sprintf(tmpname, "__batchjob.%08x.%d", jobs[next_flush].hash,
+					jobs[next_flush].repeat);
+				rmdir(tmpname);
+			}
+			else if (jobs[next_flush].state == BATCHJOB_FAILED)
+				keep_lines = 1;
+
+			if ((USEBATCHFILE == 1) && !keep_lines)
+			{
+				drop_batchfile_prefix(jobs[next_flush].end_offset - removed);
+				removed = jobs[next_flush].end_offset;
+			}
+
+			next_flush++;
+		}
+
+		if ((running == 0) && (stop || BATCH_ABORT))
+			break;
 	}
 
-	free(line);
-	*code = 0;
-	return input_exp;;
+	if (eof)
+		printf("eof; done processing batchfile\n");
+
+	signal(SIGINT, NULL);
+	free(jobs);
+
+	return;
 }
 
+#endif
+
 unsigned process_flags(int argc, char **argv, fact_obj_t *fobj, char *expression)
 {
     int ch = 0, i,j,valid;
@@ -1497,6 +1609,8 @@ void applyOpt(char *opt, char *arg, fact_obj_t *fobj)
 	{
 		USERSEED = 1;
 		sscanf(arg,"%u,%u",&g_rand.hi,&g_rand.low);
+		fobj->seed1 = g_rand.low;
+		fobj->seed2 = g_rand.hi;
 	}
 	else if (strcmp(opt,OptionArray[17]) == 0)
 	{
@@ -1535,6 +1649,7 @@ void applyOpt(char *opt, char *arg, fact_obj_t *fobj)
 		}
 
 		THREADS = strtoul(arg,NULL,10);
+		fobj->num_threads = THREADS;
 	}
 	else if (strcmp(opt,OptionArray[20]) == 0)
 	{
@@ -1717,14 +1832,14 @@ void applyOpt(char *opt, char *arg, fact_obj_t *fobj)
 			if (cptr == NULL)
 			{
 				//no . in provided filename
-				sprintf(fobj->nfs_obj.logfile, "%s.log",fobj->nfs_obj.outputfile);
-				sprintf(fobj->nfs_obj.fbfile, "%s.fb",fobj->nfs_obj.outputfile);
+				snprintf(fobj->nfs_obj.logfile, GSTR_MAXSIZE, "%s.log",fobj->nfs_obj.outputfile);
+				snprintf(fobj->nfs_obj.fbfile, GSTR_MAXSIZE, "%s.fb",fobj->nfs_obj.outputfile);
 			}
 			else
 			{				
 				cptr[0] = '\0';
-				sprintf(fobj->nfs_obj.logfile, "%s.log",tmp);
-				sprintf(fobj->nfs_obj.fbfile, "%s.fb",tmp);
+				snprintf(fobj->nfs_obj.logfile, GSTR_MAXSIZE, "%s.log",tmp);
+				snprintf(fobj->nfs_obj.fbfile, GSTR_MAXSIZE, "%s.fb",tmp);
 			}
 		}
 		else
@@ -2006,6 +2121,83 @@ void applyOpt(char *opt, char *arg, fact_obj_t *fobj)
 		//argument "repeat"
 		CMD_LINE_REPEAT = atoi(arg);
 	}
+	else if (strcmp(opt,OptionArray[71]) == 0)
+	{
+		//argument "portfolio".  run pm1/pp1 alongside ecm in factor()
+		fobj->autofact_obj.portfolio = 1;
+	}
+	else if (strcmp(opt,OptionArray[72]) == 0)
+	{
+		//argument "batchjobs".  number of batchfile lines to work on at once
+		BATCHJOBS = atoi(arg);
+		if (BATCHJOBS < 1)
+			BATCHJOBS = 1;
+	}
+	else if (strcmp(opt,OptionArray[73]) == 0)
+	{
+		//argument "pretestsave".  name of factor()'s pm1/pp1/ecm progress file
+		if (strlen(arg) < 1024)
+			strcpy(fobj->autofact_obj.pretest_savefile,arg);
+		else
+			printf("*** argument to pretestsave too long, ignoring ***\n");
+	}
+	else if (strcmp(opt,OptionArray[74]) == 0)
+	{
+		//argument "nfscache".  name of the nfs job cache, or none
+		if (strcmp(arg, "none") == 0)
+			fobj->nfs_obj.cachefile[0] = '\0';
+		else if (strlen(arg) < GSTR_MAXSIZE)
+			strcpy(fobj->nfs_obj.cachefile,arg);
+		else
+			printf("*** argument to nfscache too long, ignoring ***\n");
+	}
+	else if (strcmp(opt,OptionArray[75]) == 0)
+	{
+		//argument "siqsBS".  siqs sieve block size in kB, 32 or 64
+		fobj->qs_obj.gbl_override_blocksize = strtoul(arg,ptr,10);
+		if ((fobj->qs_obj.gbl_override_blocksize != 32) &&
+			(fobj->qs_obj.gbl_override_blocksize != 64))
+		{
+			printf("expected 32 or 64 for option %s\n",opt);
+			exit(1);
+		}
+		fobj->qs_obj.gbl_override_blocksize_flag = 1;
+	}
+	else if (strcmp(opt,OptionArray[76]) == 0)
+	{
+		//argument "siqsMT".  number of multipliers to test sieve
+		fobj->qs_obj.mult_test = strtoul(arg,ptr,10);
+	}
+	else if (strcmp(opt,OptionArray[77]) == 0)
+	{
+		//argument "siqsSP".  pattern sieve factor base primes below this
+		fobj->qs_obj.stripe_bound = strtoul(arg,ptr,10);
+		if (fobj->qs_obj.stripe_bound > 64)
+		{
+			printf("expected at most 64 for option %s\n",opt);
+			exit(1);
+		}
+	}
+	else if (strcmp(opt,OptionArray[78]) == 0)
+	{
+		//argument "siqsMEM".  memory budget for siqs sieving, in MB
+		fobj->qs_obj.mem_budget = strtoul(arg,ptr,10);
+	}
+	else if (strcmp(opt,OptionArray[79]) == 0)
+	{
+		//argument "siqsHP".  back the siqs sieve arrays with huge pages
+		fobj->qs_obj.hugepages = strtoul(arg,ptr,10);
+		if (fobj->qs_obj.hugepages > 1)
+		{
+			printf("expected 0 or 1 for option %s\n",opt);
+			exit(1);
+		}
+	}
+	else if (strcmp(opt,OptionArray[80]) == 0)
+	{
+		//argument "siqsBT".  batch test this many dlp residues at a time
+		fobj->qs_obj.batch_size = strtoul(arg,ptr,10);
+	}
 	else
 	{
 		printf("invalid option %s\n",opt);
@@ -2100,51 +2292,3 @@ void apply_tuneinfo(fact_obj_t *fobj, char *arg)
 
 	return;
 }
-
-//function get_random_seeds courtesy of Jason Papadopoulos
-void get_random_seeds(rand_t *r) {
-
-	uint32 tmp_seed1, tmp_seed2;
-
-	/* In a multithreaded program, every msieve object
-	   should have two unique, non-correlated seeds
-	   chosen for it */
-
-	//in YAFU, make them available everywhere, by putting them in
-	//a global structure that holds them.
-
-#ifndef WIN32
-
-	FILE *rand_device = fopen("/dev/urandom", "r");
-
-	if (rand_device != NULL) {
-
-		/* Yay! Cryptographic-quality nondeterministic randomness! */
-
-		fread(&tmp_seed1, sizeof(uint32), (size_t)1, rand_device);
-		fread(&tmp_seed2, sizeof(uint32), (size_t)1, rand_device);
-		fclose(rand_device);
-	}
-	else
-
-#endif
-	{
-		/* <Shrug> For everyone else, sample the current time,
-		   the high-res timer (hopefully not correlated to the
-		   current time), and the process ID. Multithreaded
-		   applications should fold in the thread ID too */
-
-		uint64 high_res_time = yafu_read_clock();
-		tmp_seed1 = ((uint32)(high_res_time >> 32) ^
-			     (uint32)time(NULL)) * 
-			    (uint32)getpid();
-		tmp_seed2 = (uint32)high_res_time;
-	}
-
-	/* The final seeds are the result of a multiplicative
-	   hash of the initial seeds */
-
-	r->low = tmp_seed1 * ((uint32)40499 * 65543);
-	r->hi = tmp_seed2 * ((uint32)40499 * 65543);
-}
-
@@ -23,15 +23,6 @@ uint64 primes_from_lineflags(soe_staticdata_t *sdata, thread_soedata_t *thread_d
 	int j;
 	uint32 range, lastid;
 	int pchar = 0;
-	// for testing of parallel approach
-	int do_parallel = 1;
-	int tmpt;
-
-	if (!do_parallel)
-	{
-		tmpt = THREADS;
-		THREADS = 1;
-	}
 
 	// start the threads
 	for (i = 0; i < THREADS - 1; i++)
@@ -186,7 +177,7 @@ uint64 primes_from_lineflags(soe_staticdata_t *sdata, thread_soedata_t *thread_d
 			if (VFLAG > 2)
 				printf("adding %" PRIu64 " primes found in thread %d\n", t->linecount, j);
 
-			memcpy(primes + GLOBAL_OFFSET + pcount, t->ddata.primes, t->linecount * sizeof(uint64));
+			memcpy(primes + pcount, t->ddata.primes, t->linecount * sizeof(uint64));
 
 			pcount += t->linecount;
 			free(t->ddata.primes);
@@ -218,9 +209,6 @@ uint64 primes_from_lineflags(soe_staticdata_t *sdata, thread_soedata_t *thread_d
 			printf("\b");
 	}
 
-	if (!do_parallel)
-		THREADS = tmpt;
-
 	return pcount;
 }
 
@@ -309,12 +297,7 @@ uint32 compute_8_bytes(soe_staticdata_t *sdata,
 				prime = prodN * ((byte_offset << 3) + b) + rclass[current_line] + lowlimit;
 
 				if ((prime >= olow) && (prime <= ohigh))
-				{
-					if (NO_STORE)
-						pcount++;
-					else
-						primes[GLOBAL_OFFSET + pcount++] = prime;
-				}
+					primes[pcount++] = prime;
 			}
 		}
 	}
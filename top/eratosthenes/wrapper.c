@@ -49,15 +49,12 @@ uint64 *GetPRIMESRange(uint32 *sieve_p, uint32 num_sp,
 
 		i = (uint64)((double)(hi_est - lo_est) * 1.25);
 
-		if (1) //(!NO_STORE)
+		primes = (uint64 *)realloc(primes,(size_t) (i * sizeof(uint64)));
+		if (primes == NULL)
 		{
-			primes = (uint64 *)realloc(primes,(size_t) (i * sizeof(uint64)));
-			if (primes == NULL)
-			{
-				printf("unable to allocate %" PRIu64 " bytes for range %" PRIu64 " to %" PRIu64 "\n",
-					(uint64)(i * sizeof(uint64)),lowlimit,highlimit);
-				exit(1);
-			}
+			printf("unable to allocate %" PRIu64 " bytes for range %" PRIu64 " to %" PRIu64 "\n",
+				(uint64)(i * sizeof(uint64)),lowlimit,highlimit);
+			exit(1);
 		}
 	}
 
@@ -70,25 +67,23 @@ uint64 *GetPRIMESRange(uint32 *sieve_p, uint32 num_sp,
 		uint64 remainder = (highlimit - lowlimit) % maxrange;
 		uint32 j;
 				
-		GLOBAL_OFFSET = 0;
+		// each sub-range appends its primes after those already found
 		tmpl = lowlimit;
 		tmph = lowlimit + maxrange;
 		for (j = 0; j < num_ranges; j++)
 		{
-			tmpcount += spSOE(sieve_p, num_sp, offset, tmpl, &tmph, 0, primes);
+			tmpcount += spSOE(sieve_p, num_sp, offset, tmpl, &tmph, 0, primes + tmpcount);
 			tmpl += maxrange;
 			tmph = tmpl + maxrange;
-			GLOBAL_OFFSET = tmpcount;
 		}
 				
 		tmph = tmpl + remainder;
-		tmpcount += spSOE(sieve_p, num_sp, offset, tmpl, &tmph, 0, primes);
+		tmpcount += spSOE(sieve_p, num_sp, offset, tmpl, &tmph, 0, primes + tmpcount);
 		*num_p = tmpcount;
 	}
 	else
 	{
 		//find the primes in the interval
-		GLOBAL_OFFSET = 0;
 		*num_p = spSOE(sieve_p, num_sp, offset, lowlimit, &highlimit, 0, primes);
 	}
 
@@ -130,7 +125,6 @@ uint64 *soe_wrapper(uint32 *seed_p, uint32 num_sp,
 		}
 
 		//find the sieving primes using the seed primes
-		NO_STORE = 0;
 		primes = GetPRIMESRange(seed_p, num_sp, NULL, 0, max_p, &retval);
 		for (i=0; i<retval; i++)
 			sieve_p[i] = (uint32)primes[i];
@@ -138,13 +132,11 @@ uint64 *soe_wrapper(uint32 *seed_p, uint32 num_sp,
 		num_sp = (uint32)retval;
 		free(primes);
 		primes = NULL;
-		//NO_STORE = 1;
 	}
 	else
 	{
 		//seed primes are enough
 		sieve_p = (uint32 *)malloc((size_t) (num_sp * sizeof(uint32)));
-		//NO_STORE = 1;
 
 		if (sieve_p == NULL)
 		{
@@ -651,4 +643,146 @@ uint64 *sieve_to_depth(uint32 *seed_p, uint32 num_sp,
 	return values;
 }
 
+// the shared cache of small primes: PRIMES[0..NUM_P-1] holds every prime
+// up to P_MAX.  it only ever grows, and only at the high end, so readers
+// don't lock.  an extension sieves just the new range, builds the longer
+// list in a new array, and publishes the pointer before the new count, so
+// a reader never sees a count larger than the array it indexes.  the
+// arrays it replaces are kept until free_prime_cache, as a reader may still
+// be walking one of them.
+static uint64 prime_cache_limit = 0;
+static uint64 **retired_primes = NULL;
+static int num_retired = 0;
+#if defined(WIN32) || defined(_WIN64)
+static HANDLE prime_cache_lock = NULL;
+#else
+static pthread_mutex_t prime_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+#if defined(_MSC_VER)
+	#define CACHE_BARRIER() MemoryBarrier()
+#else
+	#define CACHE_BARRIER() __sync_synchronize()
+#endif
+
+void init_prime_cache(uint64 *primes, uint64 num_p, uint64 limit)
+{
+	// take ownership of a list of all primes up to limit
+#if defined(WIN32) || defined(_WIN64)
+	if (prime_cache_lock == NULL)
+		prime_cache_lock = CreateMutex(NULL, FALSE, NULL);
+#endif
+
+	PRIMES = primes;
+	NUM_P = num_p;
+	P_MIN = 0;
+	P_MAX = primes[num_p - 1];
+	prime_cache_limit = limit;
+
+	return;
+}
+
+uint64 *get_prime_cache(uint64 limit, uint64 *num_p)
+{
+	// return the shared list of primes, first extending it if necessary 
+	// so that it holds every prime up to limit.  *num_p gets the number
+	// of primes in the returned list.
+	uint64 *primes, *newp, *oldp;
+	uint64 n, i, j, lo, hi, count;
+
+	if (limit > prime_cache_limit)
+	{
+#if defined(WIN32) || defined(_WIN64)
+		WaitForSingleObject(prime_cache_lock, INFINITE);
+#else
+		pthread_mutex_lock(&prime_cache_lock);
+#endif
 
+		// someone else may have extended it while we waited
+		if (limit > prime_cache_limit)
+		{
+			// grow geometrically, so that a series of slightly larger 
+			// requests doesn't sieve a series of slivers
+			lo = prime_cache_limit + 1;
+			hi = MAX(limit, 2 * prime_cache_limit);
+			if ((hi - lo) < 1000000)
+				hi = lo + 1000000;
+
+			if (VFLAG > 1)
+				printf("extending prime cache from %" PRIu64 " to %" PRIu64 "\n",
+				prime_cache_limit, hi);
+
+			if (hi > (uint64)spSOEprimes[szSOEp - 1] * (uint64)spSOEprimes[szSOEp - 1])
+				newp = soe_wrapper(spSOEprimes, szSOEp, lo, hi, 0, &count);
+			else
+				newp = GetPRIMESRange(spSOEprimes, szSOEp, NULL, lo, hi, &count);
+
+			oldp = PRIMES;
+			n = NUM_P;
+			primes = (uint64 *)malloc((size_t)((n + count) * sizeof(uint64)));
+			if (primes == NULL)
+			{
+				printf("unable to allocate %" PRIu64 " bytes for the prime cache\n",
+					(uint64)((n + count) * sizeof(uint64)));
+				exit(1);
+			}
+			memcpy(primes, oldp, (size_t)(n * sizeof(uint64)));
+
+			// the sieve may hand back a little more or less than asked for
+			for (i = 0, j = n; i < count; i++)
+			{
+				if ((newp[i] >= lo) && (newp[i] <= hi))
+					primes[j++] = newp[i];
+			}
+			free(newp);
+
+			// publish: the array first, then its size
+			PRIMES = primes;
+			CACHE_BARRIER();
+			P_MAX = primes[j - 1];
+			NUM_P = j;
+			CACHE_BARRIER();
+			prime_cache_limit = hi;
+
+			retired_primes = (uint64 **)realloc(retired_primes,
+				(num_retired + 1) * sizeof(uint64 *));
+			retired_primes[num_retired++] = oldp;
+		}
+
+#if defined(WIN32) || defined(_WIN64)
+		ReleaseMutex(prime_cache_lock);
+#else
+		pthread_mutex_unlock(&prime_cache_lock);
+#endif
+	}
+
+	CACHE_BARRIER();
+	n = NUM_P;
+	CACHE_BARRIER();
+	*num_p = n;
+	return PRIMES;
+}
+
+void free_prime_cache(void)
+{
+	int i;
+
+	for (i = 0; i < num_retired; i++)
+		free(retired_primes[i]);
+	free(retired_primes);
+	retired_primes = NULL;
+	num_retired = 0;
+
+	free(PRIMES);
+	PRIMES = NULL;
+	NUM_P = 0;
+	P_MAX = 0;
+	prime_cache_limit = 0;
+
+#if defined(WIN32) || defined(_WIN64)
+	CloseHandle(prime_cache_lock);
+	prime_cache_lock = NULL;
+#endif
+
+	return;
+}
@@ -0,0 +1,248 @@
+/*----------------------------------------------------------------------
+This source distribution is placed in the public domain by its author,
+Ben Buhrow. You may use it for any purpose, free of charge,
+without having to notify anyone. I disclaim any responsibility for any
+errors.
+
+Optionally, please be nice and tell me if you find this source to be
+useful. Again optionally, if you add to the functionality present here
+please consider making those additions public too, so that others may 
+benefit from your work.	
+
+Some parts of the code (and also this header), included in this 
+distribution have been reused from other sources. In particular I 
+have benefitted greatly from the work of Jason Papadopoulos's msieve @ 
+www.boo.net/~jasonp, Scott Contini's mpqs implementation, and Tom St. 
+Denis Tom's Fast Math library.  Many thanks to their kind donation of 
+code to the public domain.
+       				   --bbuhrow@gmail.com 7/28/10
+----------------------------------------------------------------------*/
+
+#include "yafu.h"
+#include "soe.h"
+#include "yafu_string.h"
+#include "util.h"
+#include "factor.h"
+#include "gmp.h"
+
+// process-wide setup for yafu.  the factoring routines themselves take
+// everything that varies per job (thread count, random seeds, sieve routines,
+// prime lists larger than the shared cache) from the fact_obj_t they are
+// handed, so a program linking against libyafu calls these once at startup:
+//
+//	set_default_globals();
+//	get_computer_info(CPU_ID_STR);
+//	init_global_rand();
+//
+// and then can run any number of init_factobj/factor/free_factobj
+// sequences, concurrently if desired, each with its own fact_obj_t.
+// output settings such as VFLAG and LOGFLAG remain process-wide.
+
+void get_computer_info(char *idstr)
+{
+	int ret;
+
+	//figure out cpu freq in order to scale qs time estimations
+	//0.1 seconds won't be very accurate, but hopefully close
+	//enough for the rough scaling we'll be doing anyway.
+    MEAS_CPU_FREQUENCY = measure_processor_speed() / 1.0e5;
+	
+#ifdef __APPLE__
+	// something in extended cpuid causes a segfault on mac builds.
+	// just disable it for now - this information is not critical for
+	// program operation.
+	strcpy(idstr, "N/A");
+	CLSIZE = 0;
+	L1CACHE = DEFAULT_L1_CACHE_SIZE;
+	L2CACHE = DEFAULT_L2_CACHE_SIZE;
+	HAS_SSE41 = 0;
+
+#else
+	//read cache sizes
+	yafu_get_cache_sizes(&L1CACHE,&L2CACHE);
+
+	// run an extended cpuid command to get the cache line size, and
+	// optionally print a bunch of info to the screen
+	extended_cpuid(idstr, &CLSIZE, &HAS_SSE41, &HAS_AVX, &HAS_AVX2, 
+		VERBOSE_PROC_INFO);
+
+	#if defined(WIN32)
+
+		sysname_sz = MAX_COMPUTERNAME_LENGTH + 1;
+		GetComputerName(sysname,&sysname_sz);
+	
+	#else
+
+		ret = gethostname(sysname,sizeof(sysname) / sizeof(*sysname));
+		sysname[(sizeof(sysname)-1)/sizeof(*sysname)] = 0;	// null terminate
+		if (ret != 0)
+		{
+			printf("error occured when getting host name\n");
+			strcpy(sysname, "N/A");
+		}
+		sysname_sz = strlen(sysname);
+	
+	#endif
+
+#endif
+	return;
+}
+
+void yafu_set_idle_priority(void) {
+
+#if defined(WIN32) || defined(_WIN64)
+	SetPriorityClass(GetCurrentProcess(),
+			IDLE_PRIORITY_CLASS);
+#else
+	nice(100);
+#endif
+}
+
+void set_default_globals(void)
+{
+	uint64 limit, i;
+	uint64 *primes;
+	uint32 seed_p[6542], num_sp;
+	
+	VFLAG = 0;
+	VERBOSE_PROC_INFO = 0;
+	LOGFLAG = 1;
+
+	NUM_WITNESSES = 1;
+	
+	PRIMES_TO_FILE = 0;
+	PRIMES_TO_SCREEN = 0;
+	
+	USEBATCHFILE = 0;
+	USERSEED = 0;
+	THREADS = 1;
+	LATHREADS = 0;
+	CMD_LINE_REPEAT = 0;
+	BATCHJOBS = 1;
+
+	strcpy(sessionname,"session.log");	
+
+	// initial limit of cache of primes.
+	szSOEp = 1000000;	
+
+	//set some useful globals
+	zInit(&zZero);
+	zInit(&zOne);
+	zInit(&zTwo);
+	zInit(&zThree);
+	zInit(&zFive);
+	zOne.val[0] = 1;
+	zTwo.val[0] = 2;
+	zThree.val[0] = 3;
+	zFive.val[0] = 5;
+
+	//global strings, used mostly for logprint stuff
+	sInit(&gstr1);
+	sInit(&gstr2);
+	sInit(&gstr3);
+
+	//global i/o base
+	IBASE = DEC;
+	OBASE = DEC;
+
+	//find, and hold globally, primes less than some N
+	//bootstrap the process by finding some initial sieve primes.
+	//if the requested offset+range is large we may need to find more - 
+	//we can use these primes to accomplish that.
+	num_sp = tiny_soe(65537, seed_p);
+	primes = GetPRIMESRange(seed_p, num_sp, NULL, 0, szSOEp, &limit);
+
+	//save a batch of sieve primes too.
+	spSOEprimes = (uint32 *)malloc((size_t) (limit * sizeof(uint32)));
+	for (i=0;i<limit;i++)
+		spSOEprimes[i] = (uint32)primes[i];
+
+	//the same list starts off the shared prime cache, which grows on demand
+	init_prime_cache(primes, limit, szSOEp);
+	szSOEp = limit;
+
+	// random seeds
+	get_random_seeds(&g_rand);	
+
+	return;
+}
+
+void free_globals()
+{
+	zFree(&zZero);
+	zFree(&zOne);
+	zFree(&zTwo);
+	zFree(&zThree);
+	zFree(&zFive);
+	free(spSOEprimes);
+	free_prime_cache();
+	sFree(&gstr1);
+	sFree(&gstr2);
+	sFree(&gstr3);
+
+	return;
+}
+
+void init_global_rand(void)
+{
+	// seed the generators that are shared by the whole process from
+	// g_rand, which by now has either the random or the user's seed
+	srand(g_rand.low);
+	gmp_randinit_default(gmp_randstate);
+	gmp_randseed_ui(gmp_randstate, g_rand.low);
+
+#if BITS_PER_DIGIT == 64
+	LCGSTATE = (uint64)g_rand.hi << 32 | (uint64)g_rand.low;
+#else
+	LCGSTATE = g_rand.low;
+#endif	
+
+	return;
+}
+
+//function get_random_seeds courtesy of Jason Papadopoulos
+void get_random_seeds(rand_t *r) {
+
+	uint32 tmp_seed1, tmp_seed2;
+
+	/* In a multithreaded program, every msieve object
+	   should have two unique, non-correlated seeds
+	   chosen for it */
+
+	//in YAFU, make them available everywhere, by putting them in
+	//a global structure that holds them.
+
+#ifndef WIN32
+
+	FILE *rand_device = fopen("/dev/urandom", "r");
+
+	if (rand_device != NULL) {
+
+		/* Yay! Cryptographic-quality nondeterministic randomness! */
+
+		fread(&tmp_seed1, sizeof(uint32), (size_t)1, rand_device);
+		fread(&tmp_seed2, sizeof(uint32), (size_t)1, rand_device);
+		fclose(rand_device);
+	}
+	else
+
+#endif
+	{
+		/* <Shrug> For everyone else, sample the current time,
+		   the high-res timer (hopefully not correlated to the
+		   current time), and the process ID. Multithreaded
+		   applications should fold in the thread ID too */
+
+		uint64 high_res_time = yafu_read_clock();
+		tmp_seed1 = ((uint32)(high_res_time >> 32) ^
+			     (uint32)time(NULL)) * 
+			    (uint32)getpid();
+		tmp_seed2 = (uint32)high_res_time;
+	}
+
+	/* The final seeds are the result of a multiplicative
+	   hash of the initial seeds */
+
+	r->low = tmp_seed1 * ((uint32)40499 * 65543);
+	r->hi = tmp_seed2 * ((uint32)40499 * 65543);
+}
@@ -839,78 +839,78 @@ double sqrt_acc(int m, int sz)
 void richard_guy_problem_e7(void)
 {
 	uint64 n,j;
+	uint64 *primes, num_p, pmax;
+	uint32 *sieve_p, num_sp;
 	double sum = 0.;
 		
-	free(PRIMES);
-	PRIMES = GetPRIMESRange(spSOEprimes, szSOEp, NULL, 0, 
-		100000000, &NUM_P);
+	// work through the primes in windows of our own; the shared 
+	// cache of primes in PRIMES is left alone.
+	primes = GetPRIMESRange(spSOEprimes, szSOEp, NULL, 0, 
+		100000000, &num_p);
 
-	P_MIN = PRIMES[0]; 
-	P_MAX = PRIMES[(uint32)NUM_P-1];	
+	pmax = primes[(uint32)num_p-1];	
 
-	spSOEprimes = (uint32 *)realloc(spSOEprimes, 
-		(size_t) (NUM_P * sizeof(uint32)));
-	for (n=0; n<NUM_P; n++)
-		spSOEprimes[n] = (uint32)PRIMES[n];
-	szSOEp = NUM_P;
+	sieve_p = (uint32 *)malloc((size_t) (num_p * sizeof(uint32)));
+	for (n=0; n<num_p; n++)
+		sieve_p[n] = (uint32)primes[n];
+	num_sp = (uint32)num_p;
 
 	j=0;
 	for (n=1; n<1000000000000; )
 	{
-		if (j >= NUM_P)
+		if (j >= num_p)
 		{
 			j=0;
 
-			free(PRIMES);
-			PRIMES = GetPRIMESRange(spSOEprimes, szSOEp, NULL, P_MAX+1, 
-				(uint64)P_MAX + 10000000000, &NUM_P);
+			free(primes);
+			primes = GetPRIMESRange(sieve_p, num_sp, NULL, pmax+1, 
+				pmax + 10000000000, &num_p);
 
-			P_MIN = PRIMES[0]; 
-			P_MAX = PRIMES[(uint32)NUM_P-1];	
+			pmax = primes[(uint32)num_p-1];	
 
 			// print the odd iterations
-			printf("%" PRIu64 ", %" PRIu64 ", %1.9f\n", n, PRIMES[j], sum);
+			printf("%" PRIu64 ", %" PRIu64 ", %1.9f\n", n, primes[j], sum);
 
 			if ((n & 0x1) == 0)
-				sum += (double)n++ / (double)PRIMES[j++];
+				sum += (double)n++ / (double)primes[j++];
 			else
-				sum -= (double)n++ / (double)PRIMES[j++];
+				sum -= (double)n++ / (double)primes[j++];
 					
-			printf("%" PRIu64 ", %" PRIu64 ", %1.9f\n", n, PRIMES[j], sum);
+			printf("%" PRIu64 ", %" PRIu64 ", %1.9f\n", n, primes[j], sum);
 	
 		}
 
-		if (j < (NUM_P - 8))
+		if (j < (num_p - 8))
 		{
 			if (n & 0x1)
 			{
-				sum -= (double)n++ / (double)PRIMES[j++];
-				sum += (double)n++ / (double)PRIMES[j++];
-				sum -= (double)n++ / (double)PRIMES[j++];
-				sum += (double)n++ / (double)PRIMES[j++];
-				sum -= (double)n++ / (double)PRIMES[j++];
-				sum += (double)n++ / (double)PRIMES[j++];
-				sum -= (double)n++ / (double)PRIMES[j++];
-				sum += (double)n++ / (double)PRIMES[j++];
+				sum -= (double)n++ / (double)primes[j++];
+				sum += (double)n++ / (double)primes[j++];
+				sum -= (double)n++ / (double)primes[j++];
+				sum += (double)n++ / (double)primes[j++];
+				sum -= (double)n++ / (double)primes[j++];
+				sum += (double)n++ / (double)primes[j++];
+				sum -= (double)n++ / (double)primes[j++];
+				sum += (double)n++ / (double)primes[j++];
 			}
 			else
 			{
-				sum += (double)n++ / (double)PRIMES[j++];
-				sum -= (double)n++ / (double)PRIMES[j++];
-				sum += (double)n++ / (double)PRIMES[j++];
-				sum -= (double)n++ / (double)PRIMES[j++];
-				sum += (double)n++ / (double)PRIMES[j++];
-				sum -= (double)n++ / (double)PRIMES[j++];
-				sum += (double)n++ / (double)PRIMES[j++];
-				sum -= (double)n++ / (double)PRIMES[j++];
+				sum += (double)n++ / (double)primes[j++];
+				sum -= (double)n++ / (double)primes[j++];
+				sum += (double)n++ / (double)primes[j++];
+				sum -= (double)n++ / (double)primes[j++];
+				sum += (double)n++ / (double)primes[j++];
+				sum -= (double)n++ / (double)primes[j++];
+				sum += (double)n++ / (double)primes[j++];
+				sum -= (double)n++ / (double)primes[j++];
 			}
 		}
 		else
 		{
 			if ((n & 0x1) == 0)
-				sum += (double)n++ / (double)PRIMES[j++];
+				sum += (double)n++ / (double)primes[j++];
 			else
-				sum -= (double)n++ / (double)PRIMES[j++];
+				sum -= (double)n++ / (double)primes[j++];
 		}
 	}
 	printf("%" PRIu64 ", %1.9f\n", n-1, sum);
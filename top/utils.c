@@ -30,6 +30,13 @@ code to the public domain.
 #include "yafu_string.h"
 #include "soe.h"
 
+#if defined(__linux__)
+#include <sys/mman.h>
+#if defined(MAP_ANONYMOUS)
+#define ARENA_MMAP
+#endif
+#endif
+
 const char* szFeatures[] =
 {
     "x87 FPU On Chip",
@@ -1985,4 +1992,167 @@ int bin_search_uint32(int idp, int idm, uint32 q, uint32 *input)
 	return next;
 }
 
+int bin_search_uint64(int idp, int idm, uint64 q, uint64 *input)
+{
+	int next = (idp + idm) / 2;
+	
+	while ((idp - idm) > 10)
+	{
+		if (input[next] > q)
+		{
+			idp = next;
+			next = (next + idm) / 2;							
+		}
+		else					
+		{
+			idm = next;
+			next = (idp + next) / 2;							
+		}
+	}
+
+	for (next = idm; next < idm + 10; next++)
+		if (input[next] == q)
+			return next;
+
+	if (input[next] != q)
+		next = -1;
+
+	return next;
+}
+
+
+/* memory arenas ------------------------------------------------------*/
+
+//the sieve, the compressed factor base roots and the bucket lists of a 
+//siqs thread are small enough to stay in cache, but are walked all over 
+//with every block.  with 4k pages they span hundreds of pages, more 
+//than the dtlb holds, so they are carved out of one arena that is 
+//backed by 2MB pages where the os will give us them: explicitly 
+//reserved pages (MAP_HUGETLB) first, then transparent huge pages 
+//(MADV_HUGEPAGE), then ordinary memory.  on windows large pages need 
+//the lock pages in memory privilege, so there we always fall back.
+
+//the arena of every thread would otherwise start on a huge page 
+//boundary, lining up the arrays of all threads on the same cache sets.
+//color staggers the start by a page and one ARENA_ALIGN unit per step,
+//so that every pointer handed out keeps that alignment.
+#define ARENA_COLORS 16
+#define ARENA_COLOR_STRIDE (4096 + ARENA_ALIGN)
+
+void arena_init(mem_arena_t *arena, size_t size, uint32 color, int try_huge)
+{
+	size += (color % ARENA_COLORS) * ARENA_COLOR_STRIDE;
+	size = (size + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1);
+
+	arena->base = NULL;
+	arena->pages = ARENA_PAGES_SMALL;
+
+#if defined(ARENA_MMAP)
+	if (try_huge)
+	{
+		uint8 *map;
+		size_t slop;
+
+		size = (size + ARENA_HUGE_PAGE - 1) & ~((size_t)ARENA_HUGE_PAGE - 1);
+
+#if defined(MAP_HUGETLB)
+		map = (uint8 *)mmap(NULL, size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (map != MAP_FAILED)
+		{
+			arena->base = map;
+			arena->pages = ARENA_PAGES_HUGETLB;
+		}
+#endif
+
+#if defined(MADV_HUGEPAGE)
+		if (arena->base == NULL)
+		{
+			//transparent huge pages only back aligned 2MB ranges, so
+			//map a page extra and trim the ends back to a boundary
+			map = (uint8 *)mmap(NULL, size + ARENA_HUGE_PAGE, 
+				PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (map != MAP_FAILED)
+			{
+				slop = ARENA_HUGE_PAGE - 
+					((size_t)map & (ARENA_HUGE_PAGE - 1));
+				if (slop < ARENA_HUGE_PAGE)
+					munmap(map, slop);
+				else
+					slop = 0;
+				munmap(map + slop + size, ARENA_HUGE_PAGE - slop);
+
+				arena->base = map + slop;
+				if (madvise(arena->base, size, MADV_HUGEPAGE) == 0)
+					arena->pages = ARENA_PAGES_THP;
+				else
+					arena->pages = ARENA_PAGES_MAPPED;
+			}
+		}
+#endif
+	}
+#endif
+
+	if (arena->base == NULL)
+	{
+		arena->base = (uint8 *)xmalloc_align(size);
+		if (arena->base == NULL)
+		{
+			printf("failed to allocate %u bytes\n", (uint32)size);
+			exit(-1);
+		}
+	}
+
+	arena->size = size;
+	arena->used = (color % ARENA_COLORS) * ARENA_COLOR_STRIDE;
+	return;
+}
+
+void * arena_alloc(mem_arena_t *arena, size_t len)
+{
+	//hand out the next len bytes, aligned as xmalloc_align would.
+	//nothing is freed until the whole arena is.
+	uint8 *ptr = arena->base + arena->used;
+
+	len = (len + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1);
+	if (arena->used + len > arena->size)
+	{
+		printf("arena of %u bytes is too small for %u more\n",
+			(uint32)arena->size, (uint32)len);
+		exit(-1);
+	}
+
+	arena->used += len;
+	return ptr;
+}
+
+void arena_free(mem_arena_t *arena)
+{
+#if defined(ARENA_MMAP)
+	if (arena->pages != ARENA_PAGES_SMALL)
+		munmap(arena->base, arena->size);
+	else
+#endif
+		align_free(arena->base);
+
+	arena->base = NULL;
+	arena->size = 0;
+	arena->used = 0;
+	return;
+}
+
+const char * arena_pages_name(mem_arena_t *arena)
+{
+	switch (arena->pages)
+	{
+	case ARENA_PAGES_HUGETLB:
+		return "explicit 2MB pages";
+	case ARENA_PAGES_THP:
+		return "transparent 2MB pages";
+	case ARENA_PAGES_MAPPED:
+		return "4k pages (huge pages declined)";
+	default:
+		return "4k pages";
+	}
+}
 